@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ FBAllocationCandidateSource records recently allocated instances of chosen classes, so they can be used as
+ candidates without registering them by hand.
+
+ It uses fishhook to interpose objc_alloc, objc_alloc_init, objc_allocWithZone and class_createInstance. Allocations
+ of tracked classes are written to a fixed size lock-free ring buffer, which adds a few nanoseconds to them; other
+ allocations only pay for a lookup in a small hash set. Allocations done with a plain +alloc message send (code built
+ for deployment targets that predate objc_alloc) are not seen.
+
+ The buffer does not keep objects alive. When drained, every entry is checked to still point to a live object of the
+ class it was allocated as, and only those objects are returned. The check can't be made completely race free, so
+ like the rest of Retain Cycle Detector this is meant for debug builds only.
+ */
+@interface FBAllocationCandidateSource : NSObject
+
+/**
+ Start recording allocations of given classes (subclasses are not included). Calling it again replaces the set of
+ tracked classes.
+
+ @param classes Classes to track.
+ */
++ (void)hookWithClasses:(nonnull NSArray<Class> *)classes;
+
+/**
+ Stop recording allocations and drop everything recorded so far.
+ */
++ (void)unhook;
+
+/**
+ Returns objects allocated since the previous drain that are still alive, oldest first. If more objects were allocated
+ than the buffer can hold, only the most recent ones are returned.
+ */
++ (nonnull NSArray *)drainCandidates;
+
+@end
@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#if __has_feature(objc_arc)
+#error This file must be compiled with MRR. Use -fno-objc-arc flag.
+#endif
+
+#import "FBAllocationCandidateSource.h"
+
+#import <atomic>
+#import <malloc/malloc.h>
+#import <mutex>
+#import <objc/message.h>
+#import <objc/runtime.h>
+#import <unordered_set>
+#import <vector>
+
+#import "FBAllocationRingBuffer.h"
+#import "FBRetainCycleDetector.h"
+#import "rcd_fishhook.h"
+
+#if _INTERNAL_RCD_ENABLED
+
+namespace FB { namespace AllocationCandidateSource {
+  static const size_t kBufferCapacity = 4096;
+
+  static auto _buffer = new FB::RetainCycleDetector::AllocationRingBuffer(kBufferCapacity);
+  static auto _drainMutex = new std::mutex;
+
+  static auto _hookMutex = new std::mutex;
+  static bool _hookTaken = false;
+
+  /**
+   Open addressing set of tracked classes. It's never modified once published, and never freed, since allocations on
+   other threads may still be looking at it after it has been replaced.
+   */
+  using ClassSet = std::vector<uintptr_t>;
+  static std::atomic<const ClassSet *> _trackedClasses(nullptr);
+
+  static const ClassSet *makeClassSet(NSArray<Class> *classes) {
+    size_t capacity = 8;
+    while (capacity < classes.count * 2) {
+      capacity <<= 1;
+    }
+    auto set = new ClassSet(capacity, 0);
+    for (Class cls in classes) {
+      for (size_t i = ((uintptr_t)cls >> 4) & (capacity - 1); ; i = (i + 1) & (capacity - 1)) {
+        if ((*set)[i] == 0 || (*set)[i] == (uintptr_t)cls) {
+          (*set)[i] = (uintptr_t)cls;
+          break;
+        }
+      }
+    }
+    return set;
+  }
+
+  static inline bool isTracked(Class cls) {
+    const ClassSet *set = _trackedClasses.load(std::memory_order_acquire);
+    if (!set || !cls) {
+      return false;
+    }
+    const size_t mask = set->size() - 1;
+    for (size_t i = ((uintptr_t)cls >> 4) & mask; ; i = (i + 1) & mask) {
+      uintptr_t tracked = (*set)[i];
+      if (tracked == (uintptr_t)cls) {
+        return true;
+      }
+      if (tracked == 0) {
+        return false;
+      }
+    }
+  }
+
+  static inline void record(Class cls, id object) {
+    if (object && isTracked(cls)) {
+      _buffer->push((uintptr_t)object, (uintptr_t)cls);
+    }
+  }
+
+  static id (*fb_orig_objc_alloc)(Class cls);
+  static id (*fb_orig_objc_alloc_init)(Class cls);
+  static id (*fb_orig_objc_allocWithZone)(Class cls);
+  static id (*fb_orig_class_createInstance)(Class cls, size_t extraBytes);
+
+  static id fb_objc_alloc(Class cls) {
+    id object = fb_orig_objc_alloc(cls);
+    record(cls, object);
+    return object;
+  }
+
+  static id fb_objc_alloc_init(Class cls) {
+    id object = fb_orig_objc_alloc_init(cls);
+    // init can return a different object, check what we really got
+    record(object_getClass(object), object);
+    return object;
+  }
+
+  static id fb_objc_allocWithZone(Class cls) {
+    id object = fb_orig_objc_allocWithZone(cls);
+    record(cls, object);
+    return object;
+  }
+
+  static id fb_class_createInstance(Class cls, size_t extraBytes) {
+    id object = fb_orig_class_createInstance(cls, extraBytes);
+    record(cls, object);
+    return object;
+  }
+
+  /**
+   Entry is only trusted if its memory is still allocated, and still holds an object of the class it was allocated
+   as, which isn't being deallocated yet. There is still a tiny window in which the object can be freed between these
+   checks, which is why this is available only in debug builds.
+   */
+  static id retainedObjectForEntry(const FB::RetainCycleDetector::AllocationRingBuffer::Entry &entry) {
+    void *pointer = (void *)entry.address;
+    if (malloc_size(pointer) == 0) {
+      return nil;
+    }
+    id object = (id)pointer;
+    Class cls = object_getClass(object);
+    if ((uintptr_t)cls != entry.tag) {
+      return nil;
+    }
+    static SEL tryRetainSelector = sel_registerName("_tryRetain");
+    if (!class_respondsToSelector(cls, tryRetainSelector)) {
+      return nil;
+    }
+    BOOL retained = ((BOOL (*)(id, SEL))objc_msgSend)(object, tryRetainSelector);
+    return retained ? object : nil;
+  }
+
+  static NSArray *drain() {
+    std::lock_guard<std::mutex> l(*_drainMutex);
+    NSMutableArray *candidates = [NSMutableArray array];
+    std::unordered_set<uintptr_t> seen;
+    _buffer->drain([&](const FB::RetainCycleDetector::AllocationRingBuffer::Entry &entry) {
+      if (!seen.insert(entry.address).second) {
+        return;
+      }
+      id object = retainedObjectForEntry(entry);
+      if (object) {
+        [candidates addObject:object];
+        [object release];
+      }
+    });
+    return candidates;
+  }
+
+  static struct rcd_rebinding _rebindings[4] = {
+    {"objc_alloc", (void *)fb_objc_alloc, (void **)&fb_orig_objc_alloc},
+    {"objc_alloc_init", (void *)fb_objc_alloc_init, (void **)&fb_orig_objc_alloc_init},
+    {"objc_allocWithZone", (void *)fb_objc_allocWithZone, (void **)&fb_orig_objc_allocWithZone},
+    {"class_createInstance", (void *)fb_class_createInstance, (void **)&fb_orig_class_createInstance},
+  };
+} }
+
+#endif
+
+@implementation FBAllocationCandidateSource
+
++ (void)hookWithClasses:(NSArray<Class> *)classes
+{
+#if _INTERNAL_RCD_ENABLED
+  std::lock_guard<std::mutex> l(*FB::AllocationCandidateSource::_hookMutex);
+  FB::AllocationCandidateSource::_trackedClasses.store(FB::AllocationCandidateSource::makeClassSet(classes),
+                                                       std::memory_order_release);
+  if (!FB::AllocationCandidateSource::_hookTaken) {
+    rcd_rebind_symbols(FB::AllocationCandidateSource::_rebindings, 4);
+    FB::AllocationCandidateSource::_hookTaken = true;
+  }
+#endif //_INTERNAL_RCD_ENABLED
+}
+
++ (void)unhook
+{
+#if _INTERNAL_RCD_ENABLED
+  std::lock_guard<std::mutex> l(*FB::AllocationCandidateSource::_hookMutex);
+  if (FB::AllocationCandidateSource::_hookTaken) {
+    // Originals are only known once hooks are in place, so this can't be a static array like _rebindings
+    struct rcd_rebinding originals[4] = {
+      {"objc_alloc", (void *)FB::AllocationCandidateSource::fb_orig_objc_alloc},
+      {"objc_alloc_init", (void *)FB::AllocationCandidateSource::fb_orig_objc_alloc_init},
+      {"objc_allocWithZone", (void *)FB::AllocationCandidateSource::fb_orig_objc_allocWithZone},
+      {"class_createInstance", (void *)FB::AllocationCandidateSource::fb_orig_class_createInstance},
+    };
+    rcd_rebind_symbols(originals, 4);
+    FB::AllocationCandidateSource::_hookTaken = false;
+  }
+  FB::AllocationCandidateSource::_trackedClasses.store(nullptr, std::memory_order_release);
+  std::lock_guard<std::mutex> drainLock(*FB::AllocationCandidateSource::_drainMutex);
+  FB::AllocationCandidateSource::_buffer->drain([](const FB::RetainCycleDetector::AllocationRingBuffer::Entry &) {});
+#endif //_INTERNAL_RCD_ENABLED
+}
+
++ (NSArray *)drainCandidates
+{
+#if _INTERNAL_RCD_ENABLED
+  return FB::AllocationCandidateSource::drain();
+#else
+  return @[];
+#endif //_INTERNAL_RCD_ENABLED
+}
+
+@end
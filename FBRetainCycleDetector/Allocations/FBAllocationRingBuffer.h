@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBAllocationRingBuffer_h
+#define FBAllocationRingBuffer_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Fixed size ring buffer of recent allocations, written from any number of threads without locks and drained by
+   one consumer at a time. When it's full, newest entries overwrite the oldest ones.
+
+   Pushing is wait-free: one fetch_add to claim a position, one compare-and-swap to claim its slot and three stores.
+   A slot is protected by its sequence number, which is odd while a producer writes it and 2 * (position + 1) once
+   the entry at that position is complete. If two producers race for the same slot (the buffer wrapped around while
+   the first one was still writing) the later one gives up instead of waiting, and its entry is lost. The consumer
+   validates sequence numbers around every read, so it never sees a torn entry.
+
+   Entries are plain values; the buffer doesn't own or keep alive anything they point to.
+   */
+  class AllocationRingBuffer {
+  public:
+    struct Entry {
+      uintptr_t address;
+      uintptr_t tag;
+      // Position of the entry in the stream of all pushed entries
+      uint64_t generation;
+    };
+
+    /**
+     @param capacity Rounded up to a power of two.
+     */
+    explicit AllocationRingBuffer(size_t capacity) {
+      _capacity = 1;
+      while (_capacity < capacity) {
+        _capacity <<= 1;
+      }
+      _slots.reset(new Slot[_capacity]);
+    }
+
+    AllocationRingBuffer(const AllocationRingBuffer &) = delete;
+    AllocationRingBuffer &operator=(const AllocationRingBuffer &) = delete;
+
+    /**
+     Can be called from any thread, including signal handlers.
+
+     @return false if the entry was lost because another producer was writing the same slot
+     */
+    bool push(uintptr_t address, uintptr_t tag) {
+      const uint64_t position = _head.fetch_add(1, std::memory_order_relaxed);
+      Slot &slot = _slots[position & (_capacity - 1)];
+
+      uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+      const uint64_t writing = 2 * position + 1;
+      // Older complete entries can be overwritten, anything newer or in progress wins
+      if ((sequence & 1) || sequence > writing ||
+          !slot.sequence.compare_exchange_strong(sequence, writing, std::memory_order_relaxed)) {
+        return false;
+      }
+      // Whoever sees any of the stores below will also see the slot being written
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.address.store(address, std::memory_order_relaxed);
+      slot.tag.store(tag, std::memory_order_relaxed);
+      slot.sequence.store(writing + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     Calls callback with every entry pushed since the previous drain that's still in the buffer, oldest first.
+     Must not be called from more than one thread at a time.
+
+     @return number of entries pushed since the previous drain that were lost, either overwritten or being written
+     while draining.
+     */
+    template <typename Callback>
+    uint64_t drain(Callback &&callback) {
+      const uint64_t head = _head.load(std::memory_order_acquire);
+      uint64_t position = _tail;
+      uint64_t lost = 0;
+      if (head - position > _capacity) {
+        lost += head - position - _capacity;
+        position = head - _capacity;
+      }
+
+      for (; position < head; ++position) {
+        Slot &slot = _slots[position & (_capacity - 1)];
+        const uint64_t complete = 2 * position + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != complete) {
+          lost++;
+          continue;
+        }
+        Entry entry = {
+          slot.address.load(std::memory_order_relaxed),
+          slot.tag.load(std::memory_order_relaxed),
+          position,
+        };
+        // Make sure the slot wasn't overwritten while we were reading it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != complete) {
+          lost++;
+          continue;
+        }
+        callback(entry);
+      }
+      _tail = head;
+      return lost;
+    }
+
+    size_t capacity() const {
+      return _capacity;
+    }
+
+    /**
+     Number of entries ever pushed, including lost ones.
+     */
+    uint64_t pushedCount() const {
+      return _head.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Slot {
+      std::atomic<uint64_t> sequence{0};
+      std::atomic<uintptr_t> address{0};
+      std::atomic<uintptr_t> tag{0};
+    };
+
+    // Producers hammer head, keep it on its own cache line
+    char _padding[64];
+    std::atomic<uint64_t> _head{0};
+    char _headPadding[64 - sizeof(std::atomic<uint64_t>)];
+    uint64_t _tail = 0;
+    size_t _capacity;
+    std::unique_ptr<Slot[]> _slots;
+  };
+} }
+
+#endif /* FBAllocationRingBuffer_h */
@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <functional>
+#import <unordered_map>
+#import <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Tarjan's bookkeeping layered on top of the detector's depth first search. It finds out which nodes were
+   fully explored, do not lie on any strong cycle, and cannot reach one either. Nodes are identified by address,
+   address 0 (deallocated or non-heap objects) is ignored.
+   */
+  class ComponentTracker {
+  public:
+    /**
+     Node is seen for the first time and is going to be expanded.
+     */
+    void discover(size_t address);
+
+    /**
+     Node is seen for the first time, but is known to be acyclic and won't be expanded.
+     */
+    void discoverAcyclic(size_t address);
+
+    /**
+     Node being expanded references given child. Called for every child, before it is visited.
+     */
+    void addChild(size_t address, size_t childAddress);
+
+    /**
+     Edge from a node being expanded to a node that was already discovered (back edge or cross edge).
+     */
+    void addEdgeToDiscoveredNode(size_t fromAddress, size_t toAddress);
+
+    /**
+     Some of the node's references were not followed, for example because of maximum cycle length.
+     */
+    void markIncomplete(size_t address);
+
+    /**
+     All node's references were followed. Parent address is 0 for the root of the search.
+
+     @return true if the node is proven not to reach any cycle
+     */
+    bool finish(size_t address, size_t parentAddress);
+
+    const std::vector<size_t> &childrenOf(size_t address);
+
+  private:
+    struct Node {
+      size_t index;
+      size_t lowlink;
+      bool onStack;
+      bool incomplete;
+      bool reachesCycle;
+      std::vector<size_t> children;
+    };
+
+    std::unordered_map<size_t, Node> _nodes;
+    std::vector<size_t> _stack;
+    size_t _nextIndex = 0;
+  };
+
+  /**
+   Remembers nodes proven acyclic by previous scans, together with the children that were followed from them.
+
+   An entry is only trusted if the object at the address still has the same class and retains the same objects
+   (compared through fingerprint), and the same holds for all remembered nodes reachable from it. Children are
+   reached through the strong references of a parent whose fingerprint matched, so they are guaranteed to be alive
+   while we check them.
+   */
+  class AcyclicNodeMemo {
+  public:
+    /**
+     Computes fingerprint and class of object at the address. Returns 0 if object can't be fingerprinted.
+     */
+    using Fingerprinter = std::function<uint64_t(size_t address, uintptr_t *classAddress)>;
+
+    /**
+     Forgets results of subgraph verification from the previous scan. Call before every scan.
+     */
+    void beginScan();
+
+    /**
+     @return true if the node and everything reachable from it is still the same as when it was remembered
+     */
+    bool containsUnchangedSubgraph(size_t address, const Fingerprinter &fingerprinter);
+
+    /**
+     Remembers node as acyclic, but only if all its children are remembered as well.
+     */
+    void insert(size_t address,
+                uintptr_t classAddress,
+                uint64_t fingerprint,
+                const std::vector<size_t> &children);
+
+    void clear();
+
+  private:
+    struct Entry {
+      uintptr_t classAddress;
+      uint64_t fingerprint;
+      std::vector<size_t> children;
+    };
+
+    enum class Verification {
+      InProgress,
+      Unchanged,
+      Changed,
+    };
+
+    bool _enter(size_t address,
+                const Fingerprinter &fingerprinter,
+                std::vector<std::pair<size_t, size_t>> &stack);
+
+    std::unordered_map<size_t, Entry> _entries;
+    std::unordered_map<size_t, Verification> _verifications;
+  };
+} }
@@ -0,0 +1,216 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBAcyclicNodeMemo.h"
+
+#import <algorithm>
+
+namespace FB { namespace RetainCycleDetector {
+  // Memo is dropped as a whole once it gets this big, so it cannot grow with the heap forever
+  static const size_t kAcyclicNodeMemoMaximumSize = 1 << 18;
+
+  void ComponentTracker::discover(size_t address) {
+    if (!address) {
+      return;
+    }
+    _nodes[address] = {_nextIndex, _nextIndex, true, false, false, {}};
+    _nextIndex++;
+    _stack.push_back(address);
+  }
+
+  void ComponentTracker::discoverAcyclic(size_t address) {
+    if (!address) {
+      return;
+    }
+    _nodes[address] = {_nextIndex, _nextIndex, false, false, false, {}};
+    _nextIndex++;
+  }
+
+  void ComponentTracker::addChild(size_t address, size_t childAddress) {
+    if (!childAddress) {
+      return;
+    }
+    auto node = _nodes.find(address);
+    if (node != _nodes.end()) {
+      node->second.children.push_back(childAddress);
+    }
+  }
+
+  void ComponentTracker::addEdgeToDiscoveredNode(size_t fromAddress, size_t toAddress) {
+    if (!toAddress) {
+      return;
+    }
+    auto from = _nodes.find(fromAddress);
+    if (from == _nodes.end()) {
+      return;
+    }
+
+    auto to = _nodes.find(toAddress);
+    if (to == _nodes.end()) {
+      // We don't know anything about that node, so we can't prove anything about this one either
+      from->second.incomplete = true;
+      return;
+    }
+
+    if (fromAddress == toAddress) {
+      from->second.reachesCycle = true;
+    }
+
+    if (to->second.onStack) {
+      from->second.lowlink = std::min(from->second.lowlink, to->second.index);
+    } else {
+      from->second.incomplete |= to->second.incomplete;
+      from->second.reachesCycle |= to->second.reachesCycle;
+    }
+  }
+
+  void ComponentTracker::markIncomplete(size_t address) {
+    auto node = _nodes.find(address);
+    if (node != _nodes.end()) {
+      node->second.incomplete = true;
+    }
+  }
+
+  bool ComponentTracker::finish(size_t address, size_t parentAddress) {
+    auto found = _nodes.find(address);
+    if (found == _nodes.end()) {
+      return false;
+    }
+    Node &node = found->second;
+
+    bool provenAcyclic = false;
+    if (node.lowlink == node.index) {
+      // Node is a root of strongly connected component, all nodes above it on the stack belong to it
+      auto rootPosition = std::find(_stack.rbegin(), _stack.rend(), address);
+      if (rootPosition != _stack.rend()) {
+        auto begin = std::prev(rootPosition.base());
+        if (std::distance(begin, _stack.end()) > 1) {
+          node.reachesCycle = true;
+        }
+        for (auto member = begin; member != _stack.end(); ++member) {
+          Node &memberNode = _nodes[*member];
+          memberNode.onStack = false;
+          memberNode.reachesCycle |= node.reachesCycle;
+          memberNode.incomplete |= node.incomplete;
+        }
+        _stack.erase(begin, _stack.end());
+      }
+      provenAcyclic = !node.reachesCycle && !node.incomplete;
+    }
+
+    if (parentAddress) {
+      auto parent = _nodes.find(parentAddress);
+      if (parent != _nodes.end()) {
+        parent->second.lowlink = std::min(parent->second.lowlink, node.lowlink);
+        parent->second.incomplete |= node.incomplete;
+        parent->second.reachesCycle |= node.reachesCycle;
+      }
+    }
+
+    return provenAcyclic;
+  }
+
+  const std::vector<size_t> &ComponentTracker::childrenOf(size_t address) {
+    static const std::vector<size_t> noChildren;
+    auto node = _nodes.find(address);
+    return node != _nodes.end() ? node->second.children : noChildren;
+  }
+
+  void AcyclicNodeMemo::beginScan() {
+    _verifications.clear();
+  }
+
+  bool AcyclicNodeMemo::_enter(size_t address,
+                               const Fingerprinter &fingerprinter,
+                               std::vector<std::pair<size_t, size_t>> &stack) {
+    auto entry = _entries.find(address);
+    if (entry == _entries.end()) {
+      _verifications[address] = Verification::Changed;
+      return false;
+    }
+
+    uintptr_t classAddress = 0;
+    uint64_t fingerprint = fingerprinter(address, &classAddress);
+    if (fingerprint == 0 ||
+        entry->second.classAddress != classAddress ||
+        entry->second.fingerprint != fingerprint) {
+      // Object changed since we have seen it (or it's a different object at the same address)
+      _entries.erase(entry);
+      _verifications[address] = Verification::Changed;
+      return false;
+    }
+
+    _verifications[address] = Verification::InProgress;
+    stack.emplace_back(address, 0);
+    return true;
+  }
+
+  bool AcyclicNodeMemo::containsUnchangedSubgraph(size_t address, const Fingerprinter &fingerprinter) {
+    auto verified = _verifications.find(address);
+    if (verified != _verifications.end()) {
+      return verified->second == Verification::Unchanged;
+    }
+
+    // Iterative post-order walk over remembered children, remembered subgraphs can be deep
+    std::vector<std::pair<size_t, size_t>> stack;
+    bool unchanged = _enter(address, fingerprinter, stack);
+
+    while (unchanged && !stack.empty()) {
+      size_t current = stack.back().first;
+      const std::vector<size_t> &children = _entries[current].children;
+
+      if (stack.back().second == children.size()) {
+        _verifications[current] = Verification::Unchanged;
+        stack.pop_back();
+        continue;
+      }
+
+      size_t child = children[stack.back().second++];
+      auto childVerification = _verifications.find(child);
+      if (childVerification != _verifications.end()) {
+        // In progress means entries from different scans form a cycle now
+        unchanged = (childVerification->second == Verification::Unchanged);
+      } else {
+        unchanged = _enter(child, fingerprinter, stack);
+      }
+    }
+
+    // Whole path to the changed node depends on it
+    for (const auto &frame: stack) {
+      _verifications[frame.first] = Verification::Changed;
+    }
+
+    return unchanged;
+  }
+
+  void AcyclicNodeMemo::insert(size_t address,
+                               uintptr_t classAddress,
+                               uint64_t fingerprint,
+                               const std::vector<size_t> &children) {
+    if (!address || fingerprint == 0) {
+      return;
+    }
+    for (size_t child: children) {
+      if (_entries.find(child) == _entries.end()) {
+        return;
+      }
+    }
+    if (_entries.size() >= kAcyclicNodeMemoMaximumSize) {
+      _entries.clear();
+      _verifications.clear();
+      return;
+    }
+    _entries[address] = {classAddress, fingerprint, children};
+    _verifications[address] = Verification::Unchanged;
+  }
+
+  void AcyclicNodeMemo::clear() {
+    _entries.clear();
+    _verifications.clear();
+  }
+} }
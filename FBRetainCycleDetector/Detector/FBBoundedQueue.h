@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBBoundedQueue_h
+#define FBBoundedQueue_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   First in, first out queue between one thread producing work and another consuming it. Holds at most capacity
+   values, so a producer that runs ahead of its consumer is blocked instead of buffering without bound.
+   */
+  template <typename T>
+  class BoundedQueue {
+  public:
+    explicit BoundedQueue(size_t capacity)
+    : _capacity(capacity > 0 ? capacity : 1) {}
+
+    /**
+     Waits until there is room for the value, unless the queue is closed.
+
+     @param waited Set to whether the queue was full and the call had to wait, can be null.
+     @return false if the queue was closed, in which case value was dropped.
+     */
+    bool push(T value, bool *waited = nullptr) {
+      std::unique_lock<std::mutex> l(_mutex);
+      if (waited) {
+        *waited = _values.size() >= _capacity && !_closed;
+      }
+      _notFull.wait(l, [this] { return _values.size() < _capacity || _closed; });
+      if (_closed) {
+        return false;
+      }
+      _values.push_back(std::move(value));
+      _notEmpty.notify_one();
+      return true;
+    }
+
+    /**
+     Waits until a value is available, or the queue is closed and drained.
+
+     @return false once the queue is closed and there are no values left.
+     */
+    bool pop(T &value) {
+      std::unique_lock<std::mutex> l(_mutex);
+      _notEmpty.wait(l, [this] { return !_values.empty() || _closed; });
+      if (_values.empty()) {
+        return false;
+      }
+      value = std::move(_values.front());
+      _values.pop_front();
+      _notFull.notify_one();
+      return true;
+    }
+
+    /**
+     Values pushed before are still popped, later pushes fail.
+     */
+    void close() {
+      std::lock_guard<std::mutex> l(_mutex);
+      _closed = true;
+      _notEmpty.notify_all();
+      _notFull.notify_all();
+    }
+
+    size_t size() const {
+      std::lock_guard<std::mutex> l(_mutex);
+      return _values.size();
+    }
+
+  private:
+    const size_t _capacity;
+    std::deque<T> _values;
+    bool _closed = false;
+    mutable std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+  };
+} }
+
+#endif /* FBBoundedQueue_h */
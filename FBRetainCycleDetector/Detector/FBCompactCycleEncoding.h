@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBCompactCycleEncoding_h
+#define FBCompactCycleEncoding_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Compact binary encoding of retain cycles found by a scan. Every distinct string (class names, block names, names
+   in name paths) is written once to a string table, and cycles refer to strings by their index in it.
+
+   Layout, all integers are unsigned LEB128 varints unless noted otherwise:
+
+     magic         4 bytes, "RCDC"
+     version
+     string count
+     strings       length, UTF-8 bytes
+     cycle count
+     cycles        signature (8 bytes, little endian), element count, elements
+     element       class name index, name path length, name path indices
+
+   Payloads are meant to be decoded away from the device too, by a crash or telemetry backend, so decoding only
+   relies on the standard library.
+   */
+  static const uint8_t kCompactCycleMagic[4] = {'R', 'C', 'D', 'C'};
+  static const uint64_t kCompactCycleVersion = 1;
+
+  struct CompactCycleElement {
+    uint32_t className;
+    std::vector<uint32_t> namePath;
+  };
+
+  struct CompactCycle {
+    uint64_t signature;
+    std::vector<CompactCycleElement> elements;
+  };
+
+  class CompactCycleWriter {
+  public:
+    uint32_t internString(const char *bytes, size_t length) {
+      auto inserted = _stringIndices.emplace(std::string(bytes, length), (uint32_t)_stringIndices.size());
+      if (inserted.second) {
+        _writeVarint(_strings, length);
+        _strings.insert(_strings.end(), (const uint8_t *)bytes, (const uint8_t *)bytes + length);
+      }
+      return inserted.first->second;
+    }
+
+    /**
+     Strings the cycle refers to must have been interned with this writer.
+     */
+    void addCycle(const CompactCycle &cycle) {
+      for (int byte = 0; byte < 8; ++byte) {
+        _cycles.push_back((uint8_t)(cycle.signature >> (byte * 8)));
+      }
+      _writeVarint(_cycles, cycle.elements.size());
+      for (const auto &element: cycle.elements) {
+        _writeVarint(_cycles, element.className);
+        _writeVarint(_cycles, element.namePath.size());
+        for (uint32_t name: element.namePath) {
+          _writeVarint(_cycles, name);
+        }
+      }
+      _cycleCount++;
+    }
+
+    std::vector<uint8_t> finish() const {
+      std::vector<uint8_t> data(kCompactCycleMagic, kCompactCycleMagic + sizeof(kCompactCycleMagic));
+      data.reserve(_strings.size() + _cycles.size() + 16);
+      _writeVarint(data, kCompactCycleVersion);
+      _writeVarint(data, _stringIndices.size());
+      data.insert(data.end(), _strings.begin(), _strings.end());
+      _writeVarint(data, _cycleCount);
+      data.insert(data.end(), _cycles.begin(), _cycles.end());
+      return data;
+    }
+
+  private:
+    static void _writeVarint(std::vector<uint8_t> &data, uint64_t value) {
+      while (value >= 0x80) {
+        data.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+      }
+      data.push_back((uint8_t)value);
+    }
+
+    std::unordered_map<std::string, uint32_t> _stringIndices;
+    std::vector<uint8_t> _strings;
+    std::vector<uint8_t> _cycles;
+    uint64_t _cycleCount = 0;
+  };
+
+  class CompactCycleReader {
+  public:
+    /**
+     @return false if data is not a valid payload, in which case nothing is read
+     */
+    bool read(const uint8_t *data, size_t size) {
+      _strings.clear();
+      _cycles.clear();
+      _position = data;
+      _end = data + size;
+      if (!_read(data, size)) {
+        _strings.clear();
+        _cycles.clear();
+        return false;
+      }
+      return true;
+    }
+
+    const std::vector<std::string> &strings() const {
+      return _strings;
+    }
+
+    const std::vector<CompactCycle> &cycles() const {
+      return _cycles;
+    }
+
+  private:
+    bool _read(const uint8_t *data, size_t size) {
+      if (size < sizeof(kCompactCycleMagic) ||
+          !std::equal(kCompactCycleMagic, kCompactCycleMagic + sizeof(kCompactCycleMagic), data)) {
+        return false;
+      }
+      _position += sizeof(kCompactCycleMagic);
+
+      uint64_t version, stringCount;
+      if (!_readVarint(version) || version != kCompactCycleVersion || !_readCount(stringCount)) {
+        return false;
+      }
+      _strings.reserve(stringCount);
+      for (uint64_t i = 0; i < stringCount; ++i) {
+        uint64_t length;
+        if (!_readVarint(length) || length > (uint64_t)(_end - _position)) {
+          return false;
+        }
+        _strings.emplace_back((const char *)_position, (size_t)length);
+        _position += length;
+      }
+
+      uint64_t cycleCount;
+      if (!_readCount(cycleCount)) {
+        return false;
+      }
+      _cycles.reserve(cycleCount);
+      for (uint64_t i = 0; i < cycleCount; ++i) {
+        CompactCycle cycle = {0, {}};
+        if (_end - _position < 8) {
+          return false;
+        }
+        for (int byte = 0; byte < 8; ++byte) {
+          cycle.signature |= (uint64_t)*_position++ << (byte * 8);
+        }
+        uint64_t elementCount;
+        if (!_readCount(elementCount)) {
+          return false;
+        }
+        cycle.elements.resize(elementCount);
+        for (auto &element: cycle.elements) {
+          uint64_t nameCount;
+          if (!_readIndex(element.className) || !_readCount(nameCount)) {
+            return false;
+          }
+          element.namePath.resize(nameCount);
+          for (uint32_t &name: element.namePath) {
+            if (!_readIndex(name)) {
+              return false;
+            }
+          }
+        }
+        _cycles.push_back(std::move(cycle));
+      }
+      return _position == _end;
+    }
+
+    bool _readVarint(uint64_t &value) {
+      value = 0;
+      for (int shift = 0; shift < 64 && _position < _end; shift += 7) {
+        uint8_t byte = *_position++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Every counted item takes at least one byte, which rules out absurd counts before anything is allocated
+    bool _readCount(uint64_t &count) {
+      return _readVarint(count) && count <= (uint64_t)(_end - _position);
+    }
+
+    bool _readIndex(uint32_t &index) {
+      uint64_t value;
+      if (!_readVarint(value) || value >= _strings.size()) {
+        return false;
+      }
+      index = (uint32_t)value;
+      return true;
+    }
+
+    std::vector<std::string> _strings;
+    std::vector<CompactCycle> _cycles;
+    const uint8_t *_position = nullptr;
+    const uint8_t *_end = nullptr;
+  };
+} }
+
+#endif /* FBCompactCycleEncoding_h */
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBCycleSignature_h
+#define FBCycleSignature_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FB { namespace RetainCycleDetector {
+  static const uint64_t kSignatureOffsetBasis = 14695981039346656037ULL;
+  static const uint64_t kSignaturePrime = 1099511628211ULL;
+
+  /**
+   Hash of a single cycle element: its class name followed by the names of references that led to it. Only names are
+   hashed, never addresses, so the same leak gets the same hash in every run of the app.
+   */
+  class ElementSignature {
+  public:
+    void addString(const char *string) {
+      if (string) {
+        for (const unsigned char *c = (const unsigned char *)string; *c; ++c) {
+          _addByte(*c);
+        }
+      }
+      // Separator keeps "ab" + "c" and "a" + "bc" apart, it can't appear in UTF-8
+      _addByte(0xff);
+    }
+
+    uint64_t value() const {
+      return _hash;
+    }
+
+  private:
+    void _addByte(unsigned char byte) {
+      _hash = (_hash ^ byte) * kSignaturePrime;
+    }
+
+    uint64_t _hash = kSignatureOffsetBasis;
+  };
+
+  /**
+   @return index at which the lexicographically smallest rotation of the sequence starts. O(n).
+   */
+  inline size_t leastRotation(const uint64_t *values, size_t count) {
+    size_t i = 0, j = 1, k = 0;
+    while (i < count && j < count && k < count) {
+      uint64_t a = values[(i + k) % count];
+      uint64_t b = values[(j + k) % count];
+      if (a == b) {
+        k++;
+        continue;
+      }
+      if (a > b) {
+        i += k + 1;
+      } else {
+        j += k + 1;
+      }
+      if (i == j) {
+        j++;
+      }
+      k = 0;
+    }
+    return i < j ? i : j;
+  }
+
+  /**
+   Signature of a whole cycle, given hashes of its elements in cycle order. It doesn't depend on which element the
+   cycle starts with, so it's the same no matter which candidate the cycle was found from.
+   */
+  inline uint64_t cycleSignature(const uint64_t *elementSignatures, size_t count) {
+    uint64_t hash = kSignatureOffsetBasis;
+    auto addValue = [&hash](uint64_t value) {
+      for (int byte = 0; byte < 8; ++byte) {
+        hash = (hash ^ ((value >> (byte * 8)) & 0xff)) * kSignaturePrime;
+      }
+    };
+    addValue(count);
+    const size_t start = count ? leastRotation(elementSignatures, count) : 0;
+    for (size_t i = 0; i < count; ++i) {
+      addValue(elementSignatures[(start + i) % count]);
+    }
+    return hash;
+  }
+} }
+
+#endif /* FBCycleSignature_h */
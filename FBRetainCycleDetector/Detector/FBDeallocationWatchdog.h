@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FBObjectGraphConfiguration;
+@class FBObjectiveCGraphElement;
+
+/**
+ @param survivors Watched objects still alive after the grace period.
+ @param retainCycles Retain cycles found among survivors, possibly empty if something else keeps them alive.
+ */
+typedef void (^FBDeallocationWatchdogResultsHandler)(NSArray *_Nonnull survivors,
+                                                     NSSet<NSArray<FBObjectiveCGraphElement *> *> *_Nonnull retainCycles);
+
+/**
+ FBDeallocationWatchdog
+
+ Scans for retain cycles only when there is a reason to: objects that are expected to be deallocated soon, like
+ dismissed view controllers or popped coordinators, are handed to the watchdog, which holds them weakly. Once their
+ grace period is over, the ones that are still alive are scanned together on a background queue.
+
+ Watching an object is constant time and never waits for the watchdog: only the inbox objects are pushed onto is
+ lock-free. Forming the weak reference takes the runtime's weak table lock, and the inbox node is allocated with
+ malloc, both short critical sections that don't depend on the watchdog, so watching can be done on the main thread
+ in the middle of a transition. Objects wait in a timing wheel, checked a few times per grace period while any are
+ waiting, and not at all otherwise.
+
+ The class is thread safe.
+ */
+@interface FBDeallocationWatchdog : NSObject
+
+/**
+ Designated initializer
+
+ @param configuration Configuration used for every scan.
+ @param gracePeriod How long (in seconds) watched objects have to get deallocated.
+ @param resultsHandler Called on a background queue whenever any watched objects outlived their grace period.
+ */
+- (nonnull instancetype)initWithConfiguration:(nonnull FBObjectGraphConfiguration *)configuration
+                                  gracePeriod:(NSTimeInterval)gracePeriod
+                               resultsHandler:(nonnull FBDeallocationWatchdogResultsHandler)resultsHandler NS_DESIGNATED_INITIALIZER;
+
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/**
+ Expects given object to be deallocated within the grace period. Can be called from any thread.
+ */
+- (void)watchObject:(nonnull id)object;
+
+/**
+ Longest cycle scans will look for. Defaults to 10.
+ */
+@property (atomic, assign) NSUInteger maximumCycleLength;
+
+@end
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBDeallocationWatchdog.h"
+
+#import <atomic>
+#import <chrono>
+#import <cmath>
+#import <memory>
+
+#import "FBRetainCycleDetector.h"
+#import "FBTimingWheel.h"
+
+static const NSUInteger kFBDeallocationWatchdogDefaultMaximumCycleLength = 10;
+// Objects are checked a little after their grace period is over, by at most this fraction of it
+static const double kFBDeallocationWatchdogTicksPerGracePeriod = 8;
+static const NSTimeInterval kFBDeallocationWatchdogMinimumTickInterval = 0.01;
+
+static double FBCurrentTime()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct FBWatchedObject {
+  __weak id object;
+  double watchedAt;
+};
+
+@implementation FBDeallocationWatchdog
+{
+  FBObjectGraphConfiguration *_configuration;
+  FBDeallocationWatchdogResultsHandler _resultsHandler;
+  NSTimeInterval _gracePeriod;
+  NSTimeInterval _tickInterval;
+  dispatch_queue_t _queue;
+
+  FB::RetainCycleDetector::RegistrationInbox<FBWatchedObject> _inbox;
+  // Whether _tick is going to run, so that watching objects doesn't schedule it again
+  std::atomic<bool> _tickScheduled;
+
+  // Accessed only on _queue
+  std::unique_ptr<FB::RetainCycleDetector::TimingWheel<FBWatchedObject>> _wheel;
+  FBRetainCycleDetector *_detector;
+}
+
+- (instancetype)initWithConfiguration:(FBObjectGraphConfiguration *)configuration
+                          gracePeriod:(NSTimeInterval)gracePeriod
+                       resultsHandler:(FBDeallocationWatchdogResultsHandler)resultsHandler
+{
+  if (self = [super init]) {
+    _configuration = configuration;
+    _resultsHandler = [resultsHandler copy];
+    _gracePeriod = MAX(gracePeriod, 0);
+    _tickInterval = MAX(_gracePeriod / kFBDeallocationWatchdogTicksPerGracePeriod,
+                        kFBDeallocationWatchdogMinimumTickInterval);
+    _maximumCycleLength = kFBDeallocationWatchdogDefaultMaximumCycleLength;
+
+    dispatch_queue_attr_t attributes =
+      dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0);
+    _queue = dispatch_queue_create("com.facebook.FBDeallocationWatchdog", attributes);
+
+    _tickScheduled = false;
+    _wheel.reset(new FB::RetainCycleDetector::TimingWheel<FBWatchedObject>([self _tickAtTime:FBCurrentTime()]));
+    _detector = [[FBRetainCycleDetector alloc] initWithConfiguration:configuration];
+  }
+
+  return self;
+}
+
+- (void)watchObject:(id)object
+{
+  if (!object) {
+    return;
+  }
+  // Storing the weak reference takes the runtime's weak table lock. Objects can't be handed over strongly instead,
+  // they would be deallocated on _queue if the caller released the last reference before the next tick.
+  _inbox.push({object, FBCurrentTime()});
+  if (!_tickScheduled.exchange(true)) {
+    [self _scheduleTickAfter:0];
+  }
+}
+
+- (uint64_t)_tickAtTime:(double)time
+{
+  return (uint64_t)std::floor(time / _tickInterval);
+}
+
+- (void)_scheduleTickAfter:(NSTimeInterval)interval
+{
+  __weak FBDeallocationWatchdog *weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), _queue, ^{
+    [weakSelf _tick];
+  });
+}
+
+- (void)_tick
+{
+  _inbox.drain([self](FBWatchedObject &&watchedObject) {
+    if (watchedObject.object) {
+      // First tick starting after the grace period is over
+      uint64_t deadline = [self _tickAtTime:watchedObject.watchedAt + self->_gracePeriod] + 1;
+      self->_wheel->schedule(std::move(watchedObject), deadline);
+    }
+  });
+
+  NSMutableArray *survivors = [NSMutableArray new];
+  _wheel->advance([self _tickAtTime:FBCurrentTime()], [survivors](FBWatchedObject &&watchedObject) {
+    id object = watchedObject.object;
+    if (object) {
+      [survivors addObject:object];
+    }
+  });
+  if ([survivors count] > 0) {
+    [self _scanSurvivors:survivors];
+  }
+
+  if (_wheel->count() > 0) {
+    [self _scheduleTickAfter:_tickInterval];
+    return;
+  }
+  _tickScheduled = false;
+  // Objects watched after the inbox was drained could have seen a tick still scheduled
+  if (!_inbox.empty() && !_tickScheduled.exchange(true)) {
+    [self _scheduleTickAfter:0];
+  }
+}
+
+- (void)_scanSurvivors:(NSArray *)survivors
+{
+  NSSet<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = nil;
+  @autoreleasepool {
+    for (id survivor in survivors) {
+      [_detector addCandidate:survivor];
+    }
+    retainCycles = [_detector findRetainCyclesWithMaxCycleLength:self.maximumCycleLength];
+  }
+  _resultsHandler(survivors, retainCycles);
+}
+
+@end
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBDominatorTree_h
+#define FBDominatorTree_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Dominator tree of a directed graph, computed with the semi-NCA variant of Lengauer-Tarjan algorithm, in
+   O(m log n). Everything is iterative, so it works for graphs with millions of nodes.
+
+   The graph is passed in compressed sparse row form: successors of node v are
+   edgeTargets[edgeOffsets[v]] ... edgeTargets[edgeOffsets[v + 1] - 1].
+   */
+  class DominatorTree {
+  public:
+    // Has no out-of-line definition, so it is copied wherever a function takes it by reference
+    static const uint32_t kNoNode = UINT32_MAX;
+
+    DominatorTree(const std::vector<uint32_t> &edgeOffsets,
+                  const std::vector<uint32_t> &edgeTargets,
+                  uint32_t root) {
+      const uint32_t nodeCount = edgeOffsets.empty() ? 0 : (uint32_t)(edgeOffsets.size() - 1);
+      _immediateDominators.assign(nodeCount, (uint32_t)kNoNode);
+      if (root >= nodeCount) {
+        return;
+      }
+
+      // Semi holds preorder numbers (kNoNode for unreachable nodes) until it becomes the semidominator
+      std::vector<uint32_t> semi(nodeCount, (uint32_t)kNoNode);
+      std::vector<uint32_t> parent(nodeCount, (uint32_t)kNoNode);
+      _preorder.reserve(nodeCount);
+
+      std::vector<std::pair<uint32_t, uint32_t>> stack;
+      stack.emplace_back(root, edgeOffsets[root]);
+      semi[root] = 0;
+      _preorder.push_back(root);
+      while (!stack.empty()) {
+        uint32_t node = stack.back().first;
+        uint32_t &nextEdge = stack.back().second;
+        if (nextEdge == edgeOffsets[node + 1]) {
+          stack.pop_back();
+          continue;
+        }
+        uint32_t successor = edgeTargets[nextEdge++];
+        if (semi[successor] == kNoNode) {
+          semi[successor] = (uint32_t)_preorder.size();
+          parent[successor] = node;
+          _preorder.push_back(successor);
+          stack.emplace_back(successor, edgeOffsets[successor]);
+        }
+      }
+
+      // From now on we work with preorder numbers, which keeps most of the accesses sequential
+      const uint32_t reachableCount = (uint32_t)_preorder.size();
+      std::vector<uint32_t> predecessorOffsets(reachableCount + 1, 0);
+      for (uint32_t node: _preorder) {
+        for (uint32_t edge = edgeOffsets[node]; edge < edgeOffsets[node + 1]; ++edge) {
+          predecessorOffsets[semi[edgeTargets[edge]] + 1]++;
+        }
+      }
+      for (uint32_t number = 0; number < reachableCount; ++number) {
+        predecessorOffsets[number + 1] += predecessorOffsets[number];
+      }
+      std::vector<uint32_t> predecessors(predecessorOffsets[reachableCount]);
+      std::vector<uint32_t> fill(predecessorOffsets.begin(), predecessorOffsets.end() - 1);
+      for (uint32_t number = 0; number < reachableCount; ++number) {
+        uint32_t node = _preorder[number];
+        for (uint32_t edge = edgeOffsets[node]; edge < edgeOffsets[node + 1]; ++edge) {
+          predecessors[fill[semi[edgeTargets[edge]]]++] = number;
+        }
+      }
+
+      std::vector<uint32_t> parentNumbers(reachableCount, 0);
+      for (uint32_t number = 1; number < reachableCount; ++number) {
+        parentNumbers[number] = semi[parent[_preorder[number]]];
+      }
+
+      // Semi-NCA variant: semidominators are computed as in Lengauer-Tarjan, then immediate dominators are found
+      // as nearest common ancestors in a single pass, without buckets.
+      std::vector<uint32_t> semidominators(reachableCount);
+      std::vector<uint32_t> labels(reachableCount);
+      std::vector<uint32_t> ancestors(reachableCount, (uint32_t)kNoNode);
+      for (uint32_t number = 0; number < reachableCount; ++number) {
+        semidominators[number] = number;
+        labels[number] = number;
+      }
+      std::vector<uint32_t> path;
+
+      auto eval = [&](uint32_t number) -> uint32_t {
+        if (ancestors[number] == kNoNode) {
+          return number;
+        }
+        // Compress path from the node to the root of its tree in the forest
+        path.clear();
+        for (uint32_t current = number; ancestors[ancestors[current]] != kNoNode; current = ancestors[current]) {
+          path.push_back(current);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+          uint32_t current = *it;
+          uint32_t ancestor = ancestors[current];
+          if (semidominators[labels[ancestor]] < semidominators[labels[current]]) {
+            labels[current] = labels[ancestor];
+          }
+          ancestors[current] = ancestors[ancestor];
+        }
+        return labels[number];
+      };
+
+      for (uint32_t number = reachableCount - 1; number > 0; --number) {
+        uint32_t semidominator = semidominators[number];
+        for (uint32_t edge = predecessorOffsets[number]; edge < predecessorOffsets[number + 1]; ++edge) {
+          uint32_t predecessor = predecessors[edge];
+          uint32_t candidate = (predecessor < number) ? predecessor : semidominators[eval(predecessor)];
+          if (candidate < semidominator) {
+            semidominator = candidate;
+          }
+        }
+        semidominators[number] = semidominator;
+        ancestors[number] = parentNumbers[number];
+      }
+
+      std::vector<uint32_t> &dominatorNumbers = parentNumbers;
+      for (uint32_t number = 1; number < reachableCount; ++number) {
+        uint32_t dominator = dominatorNumbers[number];
+        while (dominator > semidominators[number]) {
+          dominator = dominatorNumbers[dominator];
+        }
+        dominatorNumbers[number] = dominator;
+        _immediateDominators[_preorder[number]] = _preorder[dominator];
+      }
+    }
+
+    /**
+     @return immediate dominator of the node, kNoNode for the root and nodes unreachable from it
+     */
+    uint32_t immediateDominator(uint32_t node) const {
+      return node < _immediateDominators.size() ? _immediateDominators[node] : kNoNode;
+    }
+
+    /**
+     Sums sizes over dominator subtrees. Retained size of a node is the amount of memory that would be freed if
+     that node was freed. Unreachable nodes retain nothing.
+     */
+    std::vector<uint64_t> retainedSizes(const std::vector<uint64_t> &shallowSizes) const {
+      std::vector<uint64_t> retained(_immediateDominators.size(), 0);
+      for (uint32_t node: _preorder) {
+        retained[node] = node < shallowSizes.size() ? shallowSizes[node] : 0;
+      }
+      // Dominator always comes before the nodes it dominates in preorder
+      for (size_t index = _preorder.size(); index > 1; --index) {
+        uint32_t node = _preorder[index - 1];
+        retained[_immediateDominators[node]] += retained[node];
+      }
+      return retained;
+    }
+
+  private:
+    std::vector<uint32_t> _immediateDominators;
+    std::vector<uint32_t> _preorder;
+  };
+} }
+
+#endif /* FBDominatorTree_h */
@@ -25,4 +25,10 @@
 
 @property (nonatomic, strong, readonly, nonnull) FBObjectiveCGraphElement *object;
 
+/**
+ Address of the object at the time enumerator was created. It stays stable even if the object deallocates while we
+ are still holding the enumerator.
+ */
+@property (nonatomic, readonly) size_t objectAddress;
+
 @end
@@ -12,14 +12,14 @@
 
 @implementation FBNodeEnumerator
 {
-  NSSet *_retainedObjectsSnapshot;
-  NSEnumerator *_enumerator;
+  NSEnumerator<FBObjectiveCGraphElement *> *_enumerator;
 }
 
 - (instancetype)initWithObject:(FBObjectiveCGraphElement *)object
 {
   if (self = [super init]) {
     _object = object;
+    _objectAddress = [object objectAddress];
   }
 
   return self;
@@ -29,9 +29,8 @@
 {
   if (!_object) {
     return nil;
-  } else if (!_retainedObjectsSnapshot) {
-    _retainedObjectsSnapshot = [_object allRetainedObjects];
-    _enumerator = [_retainedObjectsSnapshot objectEnumerator];
+  } else if (!_enumerator) {
+    _enumerator = [_object retainedObjectsEnumerator];
   }
 
   FBObjectiveCGraphElement *next = [_enumerator nextObject];
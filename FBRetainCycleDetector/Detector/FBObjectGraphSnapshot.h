@@ -0,0 +1,311 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBObjectGraphSnapshot_h
+#define FBObjectGraphSnapshot_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Offsets of the strong references stored right in objects of one type, as seen from the start of the object.
+   */
+  struct SnapshotTypeLayout {
+    std::vector<uint32_t> slotOffsets;
+  };
+
+  /**
+   Layouts of all types known before a capture starts. Types are identified by keys chosen by the caller, for
+   example class pointers.
+   */
+  typedef std::unordered_map<uintptr_t, SnapshotTypeLayout> SnapshotLayoutTable;
+
+  /**
+   Frozen copy of the part of the object graph reachable from some roots: every object, and the value of every one of
+   its strong slots, as they were at a single instant.
+
+   Capture is meant to run while all other threads are suspended, so it does not allocate, lock nor call back into
+   anything but the type key reader it is given. All buffers are reserved up front, and the capture stops early once
+   they are full or its deadline passes. Objects of types missing from the layout table are recorded without their
+   references, and their type keys are reported, so the caller can resolve them and capture again.
+
+   Analysis runs afterwards, on the copy only, while the app is running again.
+   */
+  class ObjectGraphSnapshot {
+  public:
+    static const uint32_t kNoIndex = std::numeric_limits<uint32_t>::max();
+
+    enum class Status {
+      Complete,
+      NodeLimitReached,
+      EdgeLimitReached,
+      DeadlineReached,
+    };
+
+    struct Node {
+      size_t address;
+      uintptr_t typeKey;
+      uint32_t firstEdge;
+      uint32_t edgeCount;
+      // Edge this node was first reached through, kNoIndex for roots
+      uint32_t parentEdge;
+      uint32_t depth;
+    };
+
+    struct Edge {
+      uint32_t from;
+      uint32_t to;
+      // Index into slotOffsets of the layout of the source type
+      uint32_t slot;
+      size_t value;
+    };
+
+    ObjectGraphSnapshot(size_t maximumNodeCount, size_t maximumEdgeCount, size_t maximumUnresolvedTypeCount = 1024)
+    : _maximumNodeCount(maximumNodeCount),
+      _maximumEdgeCount(maximumEdgeCount),
+      _maximumUnresolvedTypeCount(maximumUnresolvedTypeCount) {
+      _nodes.reserve(maximumNodeCount);
+      _edges.reserve(maximumEdgeCount);
+      _unresolvedTypeKeys.reserve(maximumUnresolvedTypeCount);
+      size_t indexCapacity = 16;
+      while (indexCapacity < maximumNodeCount * 2) {
+        indexCapacity *= 2;
+      }
+      _index.resize(indexCapacity, IndexEntry{0, kNoIndex});
+    }
+
+    /**
+     Captures everything reachable from roots through at most maximumDepth - 1 edges, and edges between captured
+     objects. Roots become the first nodes, in order; duplicates are captured once.
+
+     @param typeKeyOf size_t address -> uintptr_t, type key of the object at address, 0 for anything that is not an
+     object and should not be followed.
+     @param now void -> uint64_t, monotonic time in any unit; the deadline is checked every few objects.
+     */
+    template <typename TypeKeyReader, typename Clock>
+    Status capture(const std::vector<size_t> &roots,
+                   const SnapshotLayoutTable &layouts,
+                   size_t maximumDepth,
+                   TypeKeyReader typeKeyOf,
+                   Clock now,
+                   uint64_t deadline) {
+      _clear();
+      _status = Status::Complete;
+      for (size_t root: roots) {
+        uintptr_t typeKey = root ? typeKeyOf(root) : 0;
+        if (typeKey && _find(root) == kNoIndex && !_addNode(root, typeKey, kNoIndex, 0)) {
+          return _status;
+        }
+      }
+      _rootCount = (uint32_t)_nodes.size();
+
+      for (uint32_t current = 0; current < _nodes.size(); ++current) {
+        if ((current & 0xFF) == 0 && now() > deadline) {
+          _status = Status::DeadlineReached;
+          return _status;
+        }
+        Node &node = _nodes[current];
+        node.firstEdge = (uint32_t)_edges.size();
+        if (node.depth + 1 > maximumDepth) {
+          continue;
+        }
+        auto layout = layouts.find(node.typeKey);
+        if (layout == layouts.end()) {
+          if (_unresolvedTypeKeys.size() < _maximumUnresolvedTypeCount) {
+            _unresolvedTypeKeys.push_back(node.typeKey);
+          }
+          continue;
+        }
+        // Objects past the depth limit could only close cycles that are too long, they are not added
+        const bool addsNodes = node.depth + 2 <= maximumDepth;
+        const std::vector<uint32_t> &offsets = layout->second.slotOffsets;
+        for (uint32_t slot = 0; slot < offsets.size(); ++slot) {
+          size_t value = *(const size_t *)(_nodes[current].address + offsets[slot]);
+          if (!value) {
+            continue;
+          }
+          uint32_t target = _find(value);
+          if (target == kNoIndex) {
+            if (!addsNodes) {
+              continue;
+            }
+            uintptr_t typeKey = typeKeyOf(value);
+            if (!typeKey) {
+              continue;
+            }
+            target = (uint32_t)_nodes.size();
+            if (!_addNode(value, typeKey, (uint32_t)_edges.size(), _nodes[current].depth + 1)) {
+              return _status;
+            }
+          }
+          if (_edges.size() == _maximumEdgeCount) {
+            _status = Status::EdgeLimitReached;
+            return _status;
+          }
+          _edges.push_back(Edge{current, target, slot, value});
+          _nodes[current].edgeCount++;
+        }
+      }
+      return _status;
+    }
+
+    /**
+     Finds retain cycles in the captured graph the same way the detector does while traversing it: depth first from
+     every root, with objects visited only once, reporting a cycle whenever an edge leads back to the current path.
+
+     @param isEdgeAllowed const Edge & -> bool, edges it rejects are ignored.
+     @return Cycles as lists of edge indices. Every edge leads to the source of the next one, and the last one leads
+     to the source of the first one.
+     */
+    template <typename EdgePredicate>
+    std::vector<std::vector<uint32_t>> findCycles(size_t maximumLength, EdgePredicate isEdgeAllowed) const {
+      std::vector<std::vector<uint32_t>> cycles;
+      std::vector<uint8_t> visited(_nodes.size(), 0);
+      // Position of the node on the current path, kNoIndex if it's not on it
+      std::vector<uint32_t> pathPosition(_nodes.size(), (uint32_t)kNoIndex);
+
+      struct Frame {
+        uint32_t node;
+        uint32_t nextEdge;
+        // Edge that led to this frame
+        uint32_t edge;
+      };
+      std::vector<Frame> path;
+
+      for (uint32_t root = 0; root < _rootCount; ++root) {
+        if (visited[root]) {
+          continue;
+        }
+        visited[root] = 1;
+        pathPosition[root] = 0;
+        path.push_back(Frame{root, _nodes[root].firstEdge, kNoIndex});
+
+        while (!path.empty()) {
+          Frame &top = path.back();
+          const Node &node = _nodes[top.node];
+          if (top.nextEdge == node.firstEdge + node.edgeCount) {
+            pathPosition[top.node] = kNoIndex;
+            path.pop_back();
+            continue;
+          }
+          uint32_t edgeIndex = top.nextEdge++;
+          const Edge &edge = _edges[edgeIndex];
+          if (!isEdgeAllowed(edge)) {
+            continue;
+          }
+          if (pathPosition[edge.to] != kNoIndex) {
+            std::vector<uint32_t> cycle;
+            for (size_t i = pathPosition[edge.to] + 1; i < path.size(); ++i) {
+              cycle.push_back(path[i].edge);
+            }
+            cycle.push_back(edgeIndex);
+            cycles.push_back(std::move(cycle));
+            continue;
+          }
+          if (visited[edge.to] || path.size() >= maximumLength) {
+            continue;
+          }
+          visited[edge.to] = 1;
+          pathPosition[edge.to] = (uint32_t)path.size();
+          path.push_back(Frame{edge.to, _nodes[edge.to].firstEdge, edgeIndex});
+        }
+      }
+      return cycles;
+    }
+
+    Status status() const {
+      return _status;
+    }
+
+    const std::vector<Node> &nodes() const {
+      return _nodes;
+    }
+
+    const std::vector<Edge> &edges() const {
+      return _edges;
+    }
+
+    uint32_t rootCount() const {
+      return _rootCount;
+    }
+
+    /**
+     Type keys of objects that were captured without their references, because their layout was not known. Can
+     contain duplicates.
+     */
+    const std::vector<uintptr_t> &unresolvedTypeKeys() const {
+      return _unresolvedTypeKeys;
+    }
+
+    uint32_t indexOfAddress(size_t address) const {
+      return _find(address);
+    }
+
+  private:
+    struct IndexEntry {
+      size_t address;
+      uint32_t node;
+    };
+
+    static size_t _hash(size_t address) {
+      return (size_t)(((uint64_t)address * 0x9E3779B97F4A7C15ULL) >> 20);
+    }
+
+    void _clear() {
+      _nodes.clear();
+      _edges.clear();
+      _unresolvedTypeKeys.clear();
+      std::fill(_index.begin(), _index.end(), IndexEntry{0, kNoIndex});
+      _rootCount = 0;
+    }
+
+    uint32_t _find(size_t address) const {
+      size_t mask = _index.size() - 1;
+      for (size_t i = _hash(address) & mask;; i = (i + 1) & mask) {
+        if (_index[i].node == kNoIndex) {
+          return kNoIndex;
+        }
+        if (_index[i].address == address) {
+          return _index[i].node;
+        }
+      }
+    }
+
+    bool _addNode(size_t address, uintptr_t typeKey, uint32_t parentEdge, uint32_t depth) {
+      if (_nodes.size() == _maximumNodeCount) {
+        _status = Status::NodeLimitReached;
+        return false;
+      }
+      size_t mask = _index.size() - 1;
+      size_t i = _hash(address) & mask;
+      while (_index[i].node != kNoIndex) {
+        i = (i + 1) & mask;
+      }
+      _index[i] = IndexEntry{address, (uint32_t)_nodes.size()};
+      _nodes.push_back(Node{address, typeKey, 0, 0, parentEdge, depth});
+      return true;
+    }
+
+    std::vector<Node> _nodes;
+    std::vector<Edge> _edges;
+    std::vector<IndexEntry> _index;
+    std::vector<uintptr_t> _unresolvedTypeKeys;
+    uint32_t _rootCount = 0;
+    Status _status = Status::Complete;
+    size_t _maximumNodeCount;
+    size_t _maximumEdgeCount;
+    size_t _maximumUnresolvedTypeCount;
+  };
+} }
+
+#endif /* FBObjectGraphSnapshot_h */
@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FBObjectGraphConfiguration;
+@class FBObjectiveCGraphElement;
+
+/**
+ FBObjectGraphSnapshotter
+
+ Looks for retain cycles in snapshots of the object graph. All other threads are suspended for a short, bounded
+ pause, during which values of strong references of everything reachable from candidates are copied out. Cycles are
+ then searched for in that copy, while the app is running again, and every cycle found is checked against live
+ objects before it is reported.
+
+ Only references stored at fixed offsets in objects can be copied without help from the runtime: ivars, objects in
+ structs, Swift fields holding an object, and objects captured by blocks. Collections, associated objects, timers,
+ __block variables and Swift closure contexts are not followed.
+
+ Layouts of the objects met are resolved between pauses. When a snapshot reaches objects of types it doesn't know
+ yet, they are resolved and another snapshot is taken, a few times at most. Layouts are kept for later searches.
+
+ Not thread safe.
+ */
+@interface FBObjectGraphSnapshotter : NSObject
+
+- (nonnull instancetype)initWithConfiguration:(nonnull FBObjectGraphConfiguration *)configuration;
+
+/**
+ Longest time other threads can stay suspended for a single snapshot. Snapshots that would take longer are cut
+ short, and cycles are searched for in what was copied until then.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumPauseDuration;
+
+/**
+ Buffers snapshots are copied into are allocated up front, before threads are suspended, and take at most that much
+ memory. Snapshots are cut short once they are full.
+ */
+@property (nonatomic, assign) NSUInteger memoryLimit;
+
+/**
+ @return Retain cycles in the same form the detector finds them while traversing the graph, not canonicalized yet.
+ */
+- (nonnull NSArray<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesFromCandidates:(nonnull NSArray<FBObjectiveCGraphElement *> *)candidates
+                                                                           maxCycleLength:(NSUInteger)length;
+
+/**
+ Longest single pause of the most recent search.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastPauseDuration;
+
+/**
+ NO if the most recent snapshot was cut short, or still had objects of unknown types, so some cycles could be
+ missing.
+ */
+@property (nonatomic, readonly) BOOL lastSnapshotWasComplete;
+
+@end
@@ -0,0 +1,439 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBObjectGraphSnapshotter.h"
+
+#import <algorithm>
+#import <mach/mach.h>
+#import <malloc/malloc.h>
+#import <map>
+#import <objc/runtime.h>
+#import <time.h>
+#import <tuple>
+#import <unordered_map>
+#import <vector>
+
+#import "FBBlockInterface.h"
+#import "FBBlockStrongLayout.h"
+#import "FBClassStrongLayout.h"
+#import "FBObjectGraphConfiguration.h"
+#import "FBObjectGraphSnapshot.h"
+#import "FBObjectiveCGraphElement.h"
+#import "FBObjectReferenceWithLayout.h"
+#import "FBRetainCycleDetectorStatistics+Internal.h"
+#import "FBRetainCycleUtils.h"
+#import "FBSwiftABIReference.h"
+
+using FB::RetainCycleDetector::ObjectGraphSnapshot;
+using FB::RetainCycleDetector::SnapshotTypeLayout;
+
+static const NSTimeInterval kFBObjectGraphSnapshotterDefaultMaximumPauseDuration = 0.005;
+static const NSUInteger kFBObjectGraphSnapshotterDefaultMemoryLimit = 32 * 1024 * 1024;
+// Snapshot nodes, their share of the address index and a few edges each
+static const NSUInteger kFBObjectGraphSnapshotterBytesPerNode = 256;
+static const NSUInteger kFBObjectGraphSnapshotterEdgesPerNode = 4;
+static const NSUInteger kFBObjectGraphSnapshotterMaximumRounds = 8;
+static const NSUInteger kFBObjectGraphSnapshotterMaximumBlockCaptures = 64;
+
+/**
+ Blocks with strong captures are told apart by their descriptor rather than their class, since every block literal
+ captures something else. Descriptors are aligned, so the low bits of the type key mark it as a block and carry the
+ flags needed to parse the descriptor.
+ */
+static const uintptr_t kFBSnapshotBlockTypeKeyTag = 1;
+static const uintptr_t kFBSnapshotBlockTypeKeyHasSignature = 2;
+static const uintptr_t kFBSnapshotBlockTypeKeyFlagsMask = sizeof(void *) - 1;
+
+/**
+ What's needed to turn a captured slot back into an edge of the graph.
+ */
+struct FBSnapshotSlot {
+  FBNamePathID namePathID;
+  FBGraphEdgeKind edgeKind;
+};
+
+static uint64_t FBSnapshotNow(void) {
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+/**
+ Called while other threads are suspended, it must not lock, allocate, nor send messages. Addresses come from roots
+ the snapshotter retains and from strong references of objects reached from them, so they point to live objects.
+ */
+static uintptr_t FBSnapshotTypeKeyOfObject(size_t address, uintptr_t mallocBlockClass) {
+  if (address < PAGE_MAX_SIZE || (address & (sizeof(void *) - 1))) {
+    return 0;
+  }
+#if __LP64__
+  if ((intptr_t)address < 0) {
+    // Tagged pointer
+    return 0;
+  }
+#endif
+  uintptr_t objectClass = (uintptr_t)object_getClass((__bridge id)(void *)address);
+  if (objectClass != mallocBlockClass) {
+    return objectClass;
+  }
+  const struct BlockLiteral *block = (const struct BlockLiteral *)address;
+  if (!(block->flags & BLOCK_HAS_EXTENDED_LAYOUT) || !(block->flags & BLOCK_HAS_COPY_DISPOSE)) {
+    // We couldn't tell what it captures anyway
+    return objectClass;
+  }
+  return ((uintptr_t)block->descriptor |
+          kFBSnapshotBlockTypeKeyTag |
+          ((block->flags & BLOCK_HAS_SIGNATURE) ? kFBSnapshotBlockTypeKeyHasSignature : 0));
+}
+
+/**
+ Suspends all threads of the task but the calling one. Ports of threads that were not suspended are released and
+ replaced with MACH_PORT_NULL.
+ */
+static mach_msg_type_number_t FBSuspendOtherThreads(thread_act_array_t *threads) {
+  mach_msg_type_number_t count = 0;
+  if (task_threads(mach_task_self(), threads, &count) != KERN_SUCCESS) {
+    *threads = NULL;
+    return 0;
+  }
+  thread_act_t currentThread = mach_thread_self();
+  for (mach_msg_type_number_t i = 0; i < count; ++i) {
+    if ((*threads)[i] == currentThread || thread_suspend((*threads)[i]) != KERN_SUCCESS) {
+      mach_port_deallocate(mach_task_self(), (*threads)[i]);
+      (*threads)[i] = MACH_PORT_NULL;
+    }
+  }
+  mach_port_deallocate(mach_task_self(), currentThread);
+  return count;
+}
+
+static void FBResumeThreads(thread_act_array_t threads, mach_msg_type_number_t count) {
+  if (!threads) {
+    return;
+  }
+  for (mach_msg_type_number_t i = 0; i < count; ++i) {
+    if (threads[i] != MACH_PORT_NULL) {
+      thread_resume(threads[i]);
+      mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+  }
+  vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+}
+
+/**
+ Stands for a captured object when edges of the snapshot are filtered. Only its class is known, the object itself
+ could be gone by then.
+ */
+@interface FBObjectGraphSnapshotElement : FBObjectiveCGraphElement
+
+- (nonnull instancetype)initWithObjectClass:(nonnull Class)objectClass
+                              configuration:(nonnull FBObjectGraphConfiguration *)configuration;
+
+@end
+
+@implementation FBObjectGraphSnapshotElement
+{
+  Class _objectClass;
+}
+
+- (instancetype)initWithObjectClass:(Class)objectClass
+                      configuration:(FBObjectGraphConfiguration *)configuration
+{
+  if (self = [super initWithObject:nil configuration:configuration namePath:nil]) {
+    _objectClass = objectClass;
+  }
+  return self;
+}
+
+- (Class)objectClass
+{
+  return _objectClass;
+}
+
+@end
+
+@implementation FBObjectGraphSnapshotter
+{
+  FBObjectGraphConfiguration *_configuration;
+  FB::RetainCycleDetector::SnapshotLayoutTable _layouts;
+  std::unordered_map<uintptr_t, std::vector<FBSnapshotSlot>> _slots;
+  uintptr_t _mallocBlockClass;
+}
+
+- (instancetype)initWithConfiguration:(FBObjectGraphConfiguration *)configuration
+{
+  if (self = [super init]) {
+    _configuration = configuration;
+    _maximumPauseDuration = kFBObjectGraphSnapshotterDefaultMaximumPauseDuration;
+    _memoryLimit = kFBObjectGraphSnapshotterDefaultMemoryLimit;
+    _mallocBlockClass = (uintptr_t)objc_getClass("__NSMallocBlock__");
+  }
+  return self;
+}
+
+- (NSArray<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesFromCandidates:(NSArray<FBObjectiveCGraphElement *> *)candidates
+                                                                    maxCycleLength:(NSUInteger)length
+{
+  // Candidates are retained until we are done, so that everything in snapshots can be reached again from them
+  NSMutableArray *rootObjects = [NSMutableArray new];
+  std::unordered_map<size_t, NSUInteger> rootObjectIndices;
+  std::vector<size_t> roots;
+  for (FBObjectiveCGraphElement *candidate in candidates) {
+    id object = candidate.object;
+    if (!object) {
+      void *objectPtr = [candidate objectPtr];
+      if (objectPtr && malloc_zone_from_ptr(objectPtr)) {
+        object = (__bridge id)objectPtr;
+      }
+    }
+    if (object) {
+      size_t address = (size_t)(__bridge void *)object;
+      rootObjectIndices[address] = [rootObjects count];
+      [rootObjects addObject:object];
+      roots.push_back(address);
+      [self _resolveTypeKey:FBSnapshotTypeKeyOfObject(address, _mallocBlockClass)];
+    }
+  }
+
+  const size_t maximumNodeCount = MAX(_memoryLimit / kFBObjectGraphSnapshotterBytesPerNode, 1);
+  ObjectGraphSnapshot snapshot(maximumNodeCount, maximumNodeCount * kFBObjectGraphSnapshotterEdgesPerNode);
+  const uint64_t maximumPause = (uint64_t)(MAX(_maximumPauseDuration, 0) * NSEC_PER_SEC);
+  const uintptr_t mallocBlockClass = _mallocBlockClass;
+  uint64_t longestPause = 0;
+
+  for (NSUInteger round = 0; ; ++round) {
+    FB_RCD_STATS_PHASE_BEGIN(pauseBegin);
+    const uint64_t pauseStart = FBSnapshotNow();
+    thread_act_array_t threads;
+    mach_msg_type_number_t threadCount = FBSuspendOtherThreads(&threads);
+    snapshot.capture(roots,
+                     _layouts,
+                     length,
+                     [mallocBlockClass](size_t address) {
+                       return FBSnapshotTypeKeyOfObject(address, mallocBlockClass);
+                     },
+                     FBSnapshotNow,
+                     pauseStart + maximumPause);
+    FBResumeThreads(threads, threadCount);
+    longestPause = std::max(longestPause, FBSnapshotNow() - pauseStart);
+    FB_RCD_STATS_TRACED_PHASE_END(SnapshotPause, pauseBegin);
+
+    if (snapshot.unresolvedTypeKeys().empty() || round + 1 == kFBObjectGraphSnapshotterMaximumRounds) {
+      break;
+    }
+    for (uintptr_t typeKey: snapshot.unresolvedTypeKeys()) {
+      [self _resolveTypeKey:typeKey];
+    }
+  }
+
+  _lastPauseDuration = (NSTimeInterval)longestPause / NSEC_PER_SEC;
+  _lastSnapshotWasComplete = (snapshot.status() == ObjectGraphSnapshot::Status::Complete &&
+                              snapshot.unresolvedTypeKeys().empty());
+  FB_RCD_STATS_ADD(NodesVisited, snapshot.nodes().size());
+
+  std::vector<uint8_t> allowedEdges = [self _filterEdgesOfSnapshot:snapshot];
+  std::vector<std::vector<uint32_t>> cycles =
+  snapshot.findCycles(length, [&snapshot, &allowedEdges](const ObjectGraphSnapshot::Edge &edge) {
+    return allowedEdges[&edge - snapshot.edges().data()] != 0;
+  });
+
+  NSMutableArray<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = [NSMutableArray new];
+  for (const auto &cycle: cycles) {
+    @autoreleasepool {
+      NSArray<FBObjectiveCGraphElement *> *retainCycle = [self _liveRetainCycleWithEdges:cycle
+                                                                               snapshot:snapshot
+                                                                            rootObjects:rootObjects
+                                                                      rootObjectIndices:rootObjectIndices];
+      if (retainCycle) {
+        [retainCycles addObject:retainCycle];
+      }
+    }
+  }
+  return retainCycles;
+}
+
+#pragma mark - Layouts
+
+- (void)_resolveTypeKey:(uintptr_t)typeKey
+{
+  if (!typeKey || _layouts.count(typeKey)) {
+    return;
+  }
+
+  SnapshotTypeLayout layout;
+  std::vector<FBSnapshotSlot> slots;
+  FBGraphEdgeKind skippedEdgeKinds = _configuration.skippedEdgeKinds;
+
+  if (typeKey & kFBSnapshotBlockTypeKeyTag) {
+    if (!(skippedEdgeKinds & FBGraphEdgeKindBlockCapture)) {
+      int flags = BLOCK_HAS_EXTENDED_LAYOUT | BLOCK_HAS_COPY_DISPOSE;
+      if (typeKey & kFBSnapshotBlockTypeKeyHasSignature) {
+        flags |= BLOCK_HAS_SIGNATURE;
+      }
+      uint32_t offsets[kFBObjectGraphSnapshotterMaximumBlockCaptures];
+      NSUInteger count = FBGetBlockStrongCaptureOffsets(flags,
+                                                        (const void *)(typeKey & ~kFBSnapshotBlockTypeKeyFlagsMask),
+                                                        offsets,
+                                                        kFBObjectGraphSnapshotterMaximumBlockCaptures);
+      for (NSUInteger i = 0; i < count; ++i) {
+        layout.slotOffsets.push_back(offsets[i]);
+        slots.push_back({FBNamePathIDNone, FBGraphEdgeKindBlockCapture});
+      }
+    }
+  } else {
+    Class aCls = (__bridge Class)(void *)typeKey;
+    for (id<FBObjectReference> reference in FBGetClassStrongReferences(aCls, _configuration.shouldIncludeSwiftObjects)) {
+      FBGraphEdgeKind edgeKind = [reference edgeKind];
+      if (skippedEdgeKinds & edgeKind) {
+        continue;
+      }
+      uintptr_t offset;
+      if ([reference conformsToProtocol:@protocol(FBObjectReferenceWithLayout)]) {
+        offset = [(id<FBObjectReferenceWithLayout>)reference indexInIvarLayout] * sizeof(void *);
+      } else if ([reference isKindOfClass:[FBSwiftABIReference class]]) {
+        offset = [(FBSwiftABIReference *)reference offset];
+      } else {
+        // Read through Mirror, there is no slot we could copy
+        continue;
+      }
+      layout.slotOffsets.push_back((uint32_t)offset);
+      slots.push_back({[reference namePathID], edgeKind});
+    }
+  }
+
+  _layouts[typeKey] = std::move(layout);
+  _slots[typeKey] = std::move(slots);
+}
+
+- (Class)_classOfTypeKey:(uintptr_t)typeKey
+{
+  if (typeKey & kFBSnapshotBlockTypeKeyTag) {
+    return (__bridge Class)(void *)_mallocBlockClass;
+  }
+  return (__bridge Class)(void *)typeKey;
+}
+
+#pragma mark - Analysis
+
+/**
+ Filters only get to see classes of objects, which they are mostly interested in anyway. Decisions are cached per
+ source class, slot and target class.
+ */
+- (std::vector<uint8_t>)_filterEdgesOfSnapshot:(const ObjectGraphSnapshot &)snapshot
+{
+  const auto &nodes = snapshot.nodes();
+  const auto &edges = snapshot.edges();
+  std::vector<uint8_t> allowedEdges(edges.size(), 1);
+  NSArray<FBGraphEdgeFilterBlock> *filterBlocks = _configuration.filterBlocks;
+  if ([filterBlocks count] == 0) {
+    return allowedEdges;
+  }
+
+  std::map<std::tuple<uintptr_t, uint32_t, uintptr_t>, bool> decisions;
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const auto &edge = edges[i];
+    const uintptr_t fromTypeKey = nodes[edge.from].typeKey;
+    const uintptr_t toTypeKey = nodes[edge.to].typeKey;
+    auto decision = decisions.find(std::make_tuple(fromTypeKey, edge.slot, toTypeKey));
+    if (decision == decisions.end()) {
+      FBObjectiveCGraphElement *fromObject =
+      [[FBObjectGraphSnapshotElement alloc] initWithObjectClass:[self _classOfTypeKey:fromTypeKey]
+                                                  configuration:_configuration];
+      NSString *byIvar = FBGetInternedNamePathFirstName(_slots[fromTypeKey][edge.slot].namePathID);
+      Class toObjectClass = [self _classOfTypeKey:toTypeKey];
+      bool allowed = true;
+      for (FBGraphEdgeFilterBlock filterBlock in filterBlocks) {
+        if (filterBlock(fromObject, byIvar, toObjectClass) == FBGraphEdgeInvalid) {
+          allowed = false;
+          break;
+        }
+      }
+      decision = decisions.emplace(std::make_tuple(fromTypeKey, edge.slot, toTypeKey), allowed).first;
+    }
+    if (!decision->second) {
+      FB_RCD_STATS_INCREMENT(EdgesRejectedByFilters);
+      allowedEdges[i] = 0;
+    }
+  }
+  return allowedEdges;
+}
+
+/**
+ Follows the captured path from a candidate to the cycle, and around it, through live objects. Every object is
+ retained by the one before it, as long as slots still hold what was captured, so it's as safe as traversing the graph
+ directly.
+
+ @return nil if anything changed since the snapshot was taken
+ */
+- (NSArray<FBObjectiveCGraphElement *> *)_liveRetainCycleWithEdges:(const std::vector<uint32_t> &)cycle
+                                                          snapshot:(const ObjectGraphSnapshot &)snapshot
+                                                       rootObjects:(NSArray *)rootObjects
+                                                 rootObjectIndices:(const std::unordered_map<size_t, NSUInteger> &)rootObjectIndices
+{
+  const auto &nodes = snapshot.nodes();
+  const auto &edges = snapshot.edges();
+
+  std::vector<uint32_t> path;
+  uint32_t node = edges[cycle.front()].from;
+  while (nodes[node].parentEdge != ObjectGraphSnapshot::kNoIndex) {
+    path.push_back(nodes[node].parentEdge);
+    node = edges[nodes[node].parentEdge].from;
+  }
+  std::reverse(path.begin(), path.end());
+
+  auto rootObjectIndex = rootObjectIndices.find(nodes[node].address);
+  if (rootObjectIndex == rootObjectIndices.end()) {
+    return nil;
+  }
+  id object = rootObjects[rootObjectIndex->second];
+  for (uint32_t edge: path) {
+    object = [self _liveTargetOfEdge:edges[edge] inObject:object snapshot:snapshot];
+    if (!object) {
+      return nil;
+    }
+  }
+
+  FBObjectiveCGraphElement *previousElement = FBWrapObjectGraphElement(nil, object, _configuration);
+  NSMutableArray<FBObjectiveCGraphElement *> *retainCycle = [NSMutableArray new];
+  for (uint32_t edge: cycle) {
+    object = [self _liveTargetOfEdge:edges[edge] inObject:object snapshot:snapshot];
+    if (!object || !previousElement) {
+      return nil;
+    }
+    const FBSnapshotSlot &slot = _slots[nodes[edges[edge].from].typeKey][edges[edge].slot];
+    FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithEdgeKind(previousElement,
+                                                                             object,
+                                                                             _configuration,
+                                                                             slot.namePathID,
+                                                                             slot.edgeKind);
+    if (!element) {
+      return nil;
+    }
+    [retainCycle addObject:element];
+    previousElement = element;
+  }
+
+  // Last element closes the cycle, like in cycles found while traversing it goes first
+  FBObjectiveCGraphElement *closingElement = [retainCycle lastObject];
+  [retainCycle removeLastObject];
+  [retainCycle insertObject:closingElement atIndex:0];
+  return retainCycle;
+}
+
+- (id)_liveTargetOfEdge:(const ObjectGraphSnapshot::Edge &)edge
+               inObject:(id)object
+               snapshot:(const ObjectGraphSnapshot &)snapshot
+{
+  const uintptr_t typeKey = snapshot.nodes()[edge.from].typeKey;
+  const uint32_t offset = _layouts[typeKey].slotOffsets[edge.slot];
+  const size_t value = *(const size_t *)((uintptr_t)(__bridge void *)object + offset);
+  if (value != edge.value) {
+    return nil;
+  }
+  return (__bridge id)(void *)value;
+}
+
+@end
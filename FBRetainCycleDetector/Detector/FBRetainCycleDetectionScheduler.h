@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FBObjectGraphConfiguration;
+@class FBObjectiveCGraphElement;
+
+typedef void (^FBRetainCycleDetectionSchedulerResultsHandler)(NSSet<NSArray<FBObjectiveCGraphElement *> *> *_Nonnull retainCycles);
+
+/**
+ FBRetainCycleDetectionScheduler
+
+ Runs retain cycle detection continuously while keeping its overhead under a CPU time budget, so it can be left
+ enabled in builds used by real people.
+
+ Objects are offered to the scheduler as they become interesting (for example when a view controller is dismissed),
+ a random sample of them is remembered weakly, and every few seconds the ones that are still alive are scanned on a
+ background queue. Sample rate and maximum cycle length adapt to the cost of past scans, measured as CPU time of the
+ scanning thread, so that no more than the budget is spent in any minute.
+
+ The class is thread safe.
+ */
+@interface FBRetainCycleDetectionScheduler : NSObject
+
+/**
+ Designated initializer
+
+ @param configuration Configuration used for every scan.
+ @param cpuTimeBudgetPerMinute How much CPU time (in seconds) scans can take in any minute.
+ @param maximumCycleLength Longest cycle scans will look for when budget allows it.
+ @param resultsHandler Called on a background queue with retain cycles found by each scan, if there were any.
+ */
+- (nonnull instancetype)initWithConfiguration:(nonnull FBObjectGraphConfiguration *)configuration
+                       cpuTimeBudgetPerMinute:(NSTimeInterval)cpuTimeBudgetPerMinute
+                           maximumCycleLength:(NSUInteger)maximumCycleLength
+                               resultsHandler:(nonnull FBRetainCycleDetectionSchedulerResultsHandler)resultsHandler NS_DESIGNATED_INITIALIZER;
+
+/**
+ Same as above, looking for cycles up to 10 elements long.
+ */
+- (nonnull instancetype)initWithConfiguration:(nonnull FBObjectGraphConfiguration *)configuration
+                       cpuTimeBudgetPerMinute:(NSTimeInterval)cpuTimeBudgetPerMinute
+                               resultsHandler:(nonnull FBRetainCycleDetectionSchedulerResultsHandler)resultsHandler;
+
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/**
+ Offers an object for detection. It is kept with probability equal to current sample rate.
+
+ @return YES if candidate was sampled and will be scanned if it's still alive at the next scan.
+ */
+- (BOOL)offerCandidate:(nonnull id)candidate;
+
+/**
+ Starts scanning sampled candidates periodically.
+ */
+- (void)start;
+
+- (void)stop;
+
+/**
+ Scans sampled candidates as soon as possible (still within the budget), whether the scheduler is started or not.
+ */
+- (void)scanNow;
+
+/**
+ Probability with which offered candidates are currently sampled.
+ */
+@property (nonatomic, readonly) double sampleRate;
+
+/**
+ Longest cycle the next scan will look for.
+ */
+@property (nonatomic, readonly) NSUInteger currentMaximumCycleLength;
+
+@end
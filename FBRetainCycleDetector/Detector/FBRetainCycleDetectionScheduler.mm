@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBRetainCycleDetectionScheduler.h"
+
+#import <atomic>
+#import <chrono>
+#import <mach/mach.h>
+#import <memory>
+#import <mutex>
+
+#import "FBRetainCycleDetector.h"
+#import "FBScanCostModel.h"
+
+static const NSUInteger kFBRetainCycleDetectionSchedulerDefaultMaximumCycleLength = 10;
+static const NSUInteger kFBRetainCycleDetectionSchedulerMinimumCycleLength = 2;
+static const NSUInteger kFBRetainCycleDetectionSchedulerMaxPendingCandidates = 512;
+static const double kFBRetainCycleDetectionSchedulerMinimumSampleRate = 0.001;
+static const NSTimeInterval kFBRetainCycleDetectionSchedulerScanInterval = 5;
+
+static double FBCurrentTime()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ CPU time consumed by the calling thread so far, in seconds.
+ */
+static double FBCurrentThreadCPUTime()
+{
+  thread_basic_info_data_t info;
+  mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+  mach_port_t thread = mach_thread_self();
+  kern_return_t result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+  mach_port_deallocate(mach_task_self(), thread);
+  if (result != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.user_time.seconds + info.user_time.microseconds / 1e6 +
+         info.system_time.seconds + info.system_time.microseconds / 1e6;
+}
+
+@implementation FBRetainCycleDetectionScheduler
+{
+  FBObjectGraphConfiguration *_configuration;
+  FBRetainCycleDetectionSchedulerResultsHandler _resultsHandler;
+  dispatch_queue_t _queue;
+  dispatch_source_t _timer;
+
+  // Guarded by _mutex
+  std::mutex _mutex;
+  NSHashTable *_pendingCandidates;
+  NSUInteger _sampledCandidates;
+
+  // Accessed only on _queue
+  FBRetainCycleDetector *_detector;
+  std::unique_ptr<FB::RetainCycleDetector::ScanCostModel> _costModel;
+
+  std::atomic<double> _sampleRate;
+  std::atomic<NSUInteger> _currentMaximumCycleLength;
+}
+
+- (instancetype)initWithConfiguration:(FBObjectGraphConfiguration *)configuration
+               cpuTimeBudgetPerMinute:(NSTimeInterval)cpuTimeBudgetPerMinute
+                   maximumCycleLength:(NSUInteger)maximumCycleLength
+                       resultsHandler:(FBRetainCycleDetectionSchedulerResultsHandler)resultsHandler
+{
+  if (self = [super init]) {
+    _configuration = configuration;
+    _resultsHandler = [resultsHandler copy];
+
+    dispatch_queue_attr_t attributes =
+      dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0);
+    _queue = dispatch_queue_create("com.facebook.FBRetainCycleDetectionScheduler", attributes);
+
+    _pendingCandidates = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory |
+                                                         NSPointerFunctionsObjectPointerPersonality];
+    _detector = [[FBRetainCycleDetector alloc] initWithConfiguration:configuration];
+    _costModel.reset(new FB::RetainCycleDetector::ScanCostModel(cpuTimeBudgetPerMinute,
+                                                                kFBRetainCycleDetectionSchedulerMinimumCycleLength,
+                                                                maximumCycleLength,
+                                                                kFBRetainCycleDetectionSchedulerMinimumSampleRate,
+                                                                1.0));
+    _sampleRate = _costModel->sampleRate();
+    _currentMaximumCycleLength = _costModel->cycleLength();
+  }
+
+  return self;
+}
+
+- (instancetype)initWithConfiguration:(FBObjectGraphConfiguration *)configuration
+               cpuTimeBudgetPerMinute:(NSTimeInterval)cpuTimeBudgetPerMinute
+                       resultsHandler:(FBRetainCycleDetectionSchedulerResultsHandler)resultsHandler
+{
+  return [self initWithConfiguration:configuration
+              cpuTimeBudgetPerMinute:cpuTimeBudgetPerMinute
+                  maximumCycleLength:kFBRetainCycleDetectionSchedulerDefaultMaximumCycleLength
+                      resultsHandler:resultsHandler];
+}
+
+- (void)dealloc
+{
+  if (_timer) {
+    dispatch_source_cancel(_timer);
+  }
+}
+
+- (double)sampleRate
+{
+  return _sampleRate;
+}
+
+- (NSUInteger)currentMaximumCycleLength
+{
+  return _currentMaximumCycleLength;
+}
+
+- (BOOL)offerCandidate:(id)candidate
+{
+  if (!candidate) {
+    return NO;
+  }
+
+  double sampleRate = _sampleRate;
+  if (sampleRate < 1.0 && arc4random_uniform(UINT32_MAX) >= sampleRate * UINT32_MAX) {
+    return NO;
+  }
+
+  std::lock_guard<std::mutex> l(_mutex);
+  if ([_pendingCandidates containsObject:candidate]) {
+    return YES;
+  }
+  // Counted even if there's no room left, so that sample rate goes down
+  _sampledCandidates++;
+  if (_pendingCandidates.count >= kFBRetainCycleDetectionSchedulerMaxPendingCandidates) {
+    return NO;
+  }
+  [_pendingCandidates addObject:candidate];
+  return YES;
+}
+
+- (void)start
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  if (_timer) {
+    return;
+  }
+
+  _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+  uint64_t interval = (uint64_t)(kFBRetainCycleDetectionSchedulerScanInterval * NSEC_PER_SEC);
+  // Generous leeway, we don't care when exactly scans happen
+  dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 2);
+  __weak FBRetainCycleDetectionScheduler *weakSelf = self;
+  dispatch_source_set_event_handler(_timer, ^{
+    [weakSelf _scan];
+  });
+  dispatch_resume(_timer);
+}
+
+- (void)stop
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  if (_timer) {
+    dispatch_source_cancel(_timer);
+    _timer = nil;
+  }
+}
+
+- (void)scanNow
+{
+  __weak FBRetainCycleDetectionScheduler *weakSelf = self;
+  dispatch_async(_queue, ^{
+    [weakSelf _scan];
+  });
+}
+
+- (void)_scan
+{
+  NSArray *candidates;
+  NSUInteger sampledCandidates;
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    // Only candidates that are still alive are left in the table
+    candidates = [_pendingCandidates allObjects];
+    [_pendingCandidates removeAllObjects];
+    sampledCandidates = _sampledCandidates;
+    _sampledCandidates = 0;
+  }
+
+  double now = FBCurrentTime();
+  FB::RetainCycleDetector::ScanCostModel::Plan plan = _costModel->plan(now, candidates.count);
+
+  NSSet<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = nil;
+  double cpuTime = 0;
+  if (plan.candidateCount > 0) {
+    double cpuTimeBefore = FBCurrentThreadCPUTime();
+    @autoreleasepool {
+      for (NSUInteger i = 0; i < plan.candidateCount; ++i) {
+        [_detector addCandidate:candidates[i]];
+      }
+      retainCycles = [_detector findRetainCyclesWithMaxCycleLength:plan.maxCycleLength];
+    }
+    cpuTime = FBCurrentThreadCPUTime() - cpuTimeBefore;
+  }
+
+  if (plan.candidateCount < candidates.count) {
+    // Didn't fit into the budget, give them another chance in the next scan
+    std::lock_guard<std::mutex> l(_mutex);
+    for (NSUInteger i = plan.candidateCount; i < candidates.count; ++i) {
+      if (_pendingCandidates.count >= kFBRetainCycleDetectionSchedulerMaxPendingCandidates) {
+        break;
+      }
+      [_pendingCandidates addObject:candidates[i]];
+    }
+  }
+
+  _costModel->record(now, plan, cpuTime, sampledCandidates);
+  _sampleRate = _costModel->sampleRate();
+  _currentMaximumCycleLength = _costModel->cycleLength();
+
+  if (retainCycles.count > 0) {
+    _resultsHandler(retainCycles);
+  }
+}
+
+@end
@@ -14,12 +14,21 @@ FOUNDATION_EXPORT double FBRetainCycleDetectorVersionNumber;
 //! Project version string for FBRetainCycleDetector.
 FOUNDATION_EXPORT const unsigned char FBRetainCycleDetectorVersionString[];
 
+#import <FBRetainCycleDetector/FBAllocationCandidateSource.h>
 #import <FBRetainCycleDetector/FBAssociationManager.h>
+#import <FBRetainCycleDetector/FBClassLayoutPrewarmer.h>
+#import <FBRetainCycleDetector/FBDeallocationWatchdog.h>
+#import <FBRetainCycleDetector/FBGraphEdgeKind.h>
 #import <FBRetainCycleDetector/FBObjectiveCBlock.h>
 #import <FBRetainCycleDetector/FBObjectiveCGraphElement.h>
 #import <FBRetainCycleDetector/FBObjectiveCNSCFTimer.h>
 #import <FBRetainCycleDetector/FBObjectiveCObject.h>
 #import <FBRetainCycleDetector/FBObjectGraphConfiguration.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetectionScheduler.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetectorStatistics.h>
+#import <FBRetainCycleDetector/FBRetainCycleReport.h>
+#import <FBRetainCycleDetector/FBRetainCycleSerializer.h>
+#import <FBRetainCycleDetector/FBRetainCycleSignatureStore.h>
 #import <FBRetainCycleDetector/FBStandardGraphEdgeFilters.h>
 
 /**
@@ -29,6 +38,23 @@ FOUNDATION_EXPORT const unsigned char FBRetainCycleDetectorVersionString[];
  */
 //#define RETAIN_CYCLE_DETECTOR_ENABLED 1
 
+/**
+ Progress of a scan, as reported to progressHandler.
+ */
+typedef struct {
+  // Candidates whose object graph was traversed
+  NSUInteger candidatesGathered;
+  // Candidates whose object graph was searched for cycles
+  NSUInteger candidatesAnalyzed;
+  NSUInteger candidateCount;
+  // Traversed graphs waiting to be searched for cycles, in pipelined scans
+  NSUInteger pendingAnalysisCount;
+  // How many times traversal had to wait for the analysis to catch up, in pipelined scans
+  NSUInteger backpressureStallCount;
+} FBRetainCycleDetectorProgress;
+
+typedef void (^FBRetainCycleDetectorProgressHandler)(FBRetainCycleDetectorProgress progress);
+
 /**
  FBRetainCycleDetector
 
@@ -62,6 +88,13 @@ FOUNDATION_EXPORT const unsigned char FBRetainCycleDetectorVersionString[];
  */
 - (void)addSwiftCandidate:(nonnull void *)candidatePtr;
 
+/**
+ Adds every object recorded by FBAllocationCandidateSource since it was last drained, that is still alive.
+
+ @see FBAllocationCandidateSource
+ */
+- (void)addCandidatesFromRecentAllocations;
+
 /**
  Searches for all retain cycles for all candidates the detector has been
  provided with.
@@ -78,6 +111,179 @@ FOUNDATION_EXPORT const unsigned char FBRetainCycleDetectorVersionString[];
 
 - (nonnull NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesWithMaxCycleLength:(NSUInteger)length;
 
+/**
+ Searches for retain cycles just like findRetainCycles does, and works out how much memory every cycle keeps alive.
+
+ @return Reports sorted by retained memory, biggest first.
+
+ @discussion Traversed object graph is recorded and a dominator tree is computed over it after the search, which
+ takes extra memory and time proportional to the size of the graph. Acyclic node memo is not consulted during this
+ search, since skipped subgraphs would not be counted.
+ @see FBRetainCycleReport
+ */
+- (nonnull NSArray<FBRetainCycleReport *> *)findRetainCycleReports;
+
+- (nonnull NSArray<FBRetainCycleReport *> *)findRetainCycleReportsWithMaxCycleLength:(NSUInteger)length;
+
+/**
+ Checks whether given object, like a view controller that should have been deallocated by now, is kept alive by a
+ retain cycle it is part of. Candidates added to the detector are neither used nor removed.
+
+ @return The shortest retain cycle going through the object, starting with it, or nil if there is none.
+
+ @discussion Objects are expanded breadth first, starting with the given one, and the search ends as soon as a
+ reference back to it is found. Unlike findRetainCycles, no other cycles are enumerated, so it takes a fraction of the
+ work when the object lies on a short cycle. It will not look for cycles longer than 10 elements.
+ */
+- (nullable NSArray<FBObjectiveCGraphElement *> *)findShortestRetainCycleContainingObject:(nonnull id)object;
+
+- (nullable NSArray<FBObjectiveCGraphElement *> *)findShortestRetainCycleContainingObject:(nonnull id)object
+                                                                           maxCycleLength:(NSUInteger)length;
+
+/**
+ Searches for retain cycles in snapshots of the object graph taken while all other threads are briefly suspended,
+ instead of traversing it while the app keeps mutating it. Cycles are returned in the same form findRetainCycles
+ returns them.
+
+ @discussion Only references stored right in objects are followed: ivars, objects in structs, Swift fields and
+ objects captured by blocks. Filters are given graph elements that only know the class of their object. Cycles are
+ checked against live objects before they are returned, and known cycles are dropped, but acyclic node memo and
+ shouldStopExpandingKnownCycles are not used.
+ @see FBObjectGraphSnapshotter
+ */
+- (nonnull NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesInSnapshot;
+
+- (nonnull NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesInSnapshotWithMaxCycleLength:(NSUInteger)length;
+
+/**
+ Longest time other threads can stay suspended while a snapshot is taken. Defaults to 5ms. Snapshots that would take
+ longer are cut short.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumSnapshotPauseDuration;
+
+/**
+ Longest pause of the most recent snapshot search.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastSnapshotPauseDuration;
+
+/**
+ NO if the most recent snapshot search could have missed cycles, because its snapshot was cut short.
+ */
+@property (nonatomic, readonly) BOOL lastSnapshotWasComplete;
+
+/**
+ Remember objects that previous scans proved not to be part of, nor lead to, any retain cycle, and skip expanding
+ them in later scans for as long as nothing changed in the subgraph they retain. Defaults to NO.
+
+ @discussion Remembered subgraphs are checked by hashing ivars and associations of every object in them, which is
+ much cheaper than expanding them, but not free. Collections, blocks, timers and Swift objects (and everything
+ that retains them) are never remembered, neither is anything if configuration uses a transformer block.
+ Memory used by the memo is bounded, call resetAcyclicNodeMemo to release it earlier.
+ */
+@property (nonatomic, assign) BOOL shouldMemoizeAcyclicNodes;
+
+/**
+ Forget all objects remembered as acyclic.
+ */
+- (void)resetAcyclicNodeMemo;
+
+/**
+ Signatures of retain cycles that were already reported. Cycles found in it are dropped as soon as they are found,
+ before any work is done to canonicalize and describe them, and signatures of newly found cycles are added to it after
+ every scan. Defaults to nil, in which case all cycles are reported every time.
+
+ @see FBRetainCycleSignatureStore
+ */
+@property (nonatomic, strong, nullable) FBRetainCycleSignatureStore *knownCycleSignatures;
+
+/**
+ When a known cycle is found, don't follow any more references of the objects on it. Defaults to NO.
+
+ @discussion Cuts the cost of scans in which the same leak is found over and over, but cycles reachable only through
+ objects of a known leak won't be found while it's there.
+ */
+@property (nonatomic, assign) BOOL shouldStopExpandingKnownCycles;
+
+/**
+ After this many instances of retain cycles with the same signature are found in a scan, objects that start another
+ instance of it are only checked for it, instead of being expanded. Defaults to 0, every object is expanded.
+
+ @discussion Meant for screens where every one of hundreds of siblings, like cells of a list, leaks the same way.
+ The first instances are returned as usual, and the rest are only counted in lastScanCycleInstanceCounts. An object
+ is checked by following only the references of the same class and name the found instances went through, and is
+ expanded as usual when that doesn't lead back to it. Other cycles going through objects that were only counted are
+ missed. It doesn't apply to the same scans as shouldPipelineAnalysis, nor to snapshot searches.
+ */
+@property (nonatomic, assign) NSUInteger repeatedCycleInstanceLimit;
+
+/**
+ How many instances of every retain cycle signature the most recent scan found, including the ones that were only
+ counted because of repeatedCycleInstanceLimit. Keys are signatures as returned by FBGetRetainCycleSignature. Empty
+ unless repeatedCycleInstanceLimit is set.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSDictionary<NSNumber *, NSNumber *> *lastScanCycleInstanceCounts;
+
+/**
+ Hard limit, in bytes, on the memory used to remember objects visited during a scan. Defaults to 32MB, which is
+ enough for millions of objects. Objects reached after the limit is hit are not followed, so cycles going through
+ them are missed, but the scan doesn't grow without bound on big heaps.
+ */
+@property (nonatomic, assign) NSUInteger visitedAddressesMemoryLimit;
+
+/**
+ Traverse the object graph of every candidate on the calling thread, while a background thread searches graphs of the
+ previous candidates for cycles. Defaults to NO.
+
+ @discussion Scans find the same cycles either way, pipelined ones finish sooner on devices with more than one core, but
+ hold on to graphs of candidates waiting for analysis. It doesn't apply to scans that memoize acyclic nodes, compute
+ retained memory, or stop expanding known cycles, since those need results of the analysis during traversal.
+ */
+@property (nonatomic, assign) BOOL shouldPipelineAnalysis;
+
+/**
+ How many traversed graphs can wait for analysis in pipelined scans, before traversal stops to let it catch up.
+ Defaults to 2.
+ */
+@property (nonatomic, assign) NSUInteger maximumPendingAnalysisCount;
+
+/**
+ Search all candidates for the shortest cycles first, then for longer ones, up to the maximum cycle length. References
+ from blocks, delegate-like ivars, and the kinds of references cycles found before went through, are followed first.
+ Defaults to NO.
+
+ @discussion Scans find the same cycles either way. Short searches expand every object once, later ones reuse what
+ they retain. What objects retain is kept for the whole scan, up to about visitedAddressesMemoryLimit bytes, past which
+ the objects expanded first are forgotten and expanded again when reached. Combined with expansionBudget, scans return
+ the shortest, most likely cycles instead of running out of time halfway through a long search. It doesn't apply to the same scans as
+ shouldPipelineAnalysis, and takes precedence over it.
+ */
+@property (nonatomic, assign) BOOL shouldSearchShortCyclesFirst;
+
+/**
+ Maximum number of times searches for short cycles first can expand an object in a single scan, counting objects
+ expanded again after they were forgotten. Defaults to 0, no limit.
+ */
+@property (nonatomic, assign) NSUInteger expansionBudget;
+
+/**
+ Whether the most recent scan stopped before searching for cycles of every length, because of expansionBudget.
+ */
+@property (nonatomic, readonly) BOOL lastScanExhaustedExpansionBudget;
+
+/**
+ Called on the thread running the scan after every candidate is traversed. Pipelined scans call it once more, when
+ analysis of all candidates is done, and searches for short cycles first only call it once they are done.
+ */
+@property (nonatomic, copy, nullable) FBRetainCycleDetectorProgressHandler progressHandler;
+
+/**
+ Counters and timings gathered during the most recent scan.
+
+ @discussion Statistics are compiled out by default, in which case this is always nil.
+ @see FBRetainCycleDetectorStatistics
+ */
+@property (nonatomic, strong, readonly, nullable) FBRetainCycleDetectorStatistics *statistics;
+
 /**
  This macro is used across FBRetainCycleDetector to compile out sensitive code.
  If you do not define it anywhere, Retain Cycle Detector will be available in DEBUG builds.
@@ -6,24 +6,107 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#import <algorithm>
+#import <atomic>
+#import <deque>
+#import <malloc/malloc.h>
+#import <memory>
+#import <objc/runtime.h>
 #import <stack>
 #import <unordered_map>
 #import <unordered_set>
+#import <vector>
 
+#import "FBAcyclicNodeMemo.h"
+#import "FBAllocationCandidateSource.h"
+#import "FBBoundedQueue.h"
 #import "FBNodeEnumerator.h"
-#import "FBObjectiveCGraphElement.h"
+#import "FBObjectGraphSnapshotter.h"
+#import "FBObjectiveCBlock.h"
+#import "FBObjectiveCGraphElement+Internal.h"
 #import "FBObjectiveCObject.h"
 #import "FBRetainCycleDetector+Internal.h"
+#import "FBRetainCycleDetectorStatistics+Internal.h"
+#import "FBRetainCycleSignatureStore.h"
 #import "FBRetainCycleUtils.h"
+#import "FBRetainedSizeGraph.h"
 #import "FBStandardGraphEdgeFilters.h"
+#import "FBVisitedAddressSet.h"
 
 static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
+static const NSUInteger kFBRetainCycleDetectorDefaultVisitedAddressesMemoryLimit = 32 * 1024 * 1024;
+static const NSTimeInterval kFBRetainCycleDetectorDefaultMaximumSnapshotPauseDuration = 0.005;
+static const NSUInteger kFBRetainCycleDetectorDefaultMaximumPendingAnalysisCount = 2;
+
+static const size_t kFBRetainCycleDetectorMaximumCycleEdgeHints = 4096;
+
+static uint64_t FBGetCycleEdgeHint(Class fromClass, FBNamePathID namePathID, Class toClass) {
+  uint64_t hint = ((uint64_t)(uintptr_t)fromClass * 0x9E3779B97F4A7C15ULL) ^ namePathID;
+  return (hint * 0x9E3779B97F4A7C15ULL) ^ (uint64_t)(uintptr_t)toClass;
+}
+
+static BOOL FBIsDelegateLikeName(NSString *name) {
+  static NSArray<NSString *> *fragments = @[@"delegate", @"target", @"owner", @"parent", @"handler",
+                                            @"callback", @"completion", @"observer", @"listener", @"block"];
+  for (NSString *fragment in fragments) {
+    if ([name rangeOfString:fragment options:NSCaseInsensitiveSearch].location != NSNotFound) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+/**
+ Object graph of a single candidate, as traversed by the gather stage of a pipelined scan. Nodes are objects first
+ visited from that candidate, in the order they were visited, and edges only lead to them. Edges of every node are
+ kept in the order its references were enumerated, so that analysis can replay the traversal exactly.
+ */
+struct FBGatheredGraph {
+  // Indices of edges leaving every node
+  std::vector<std::vector<uint32_t>> nodeEdges;
+  std::vector<uint32_t> edgeTargets;
+  // Target of every edge, as it was reached through that edge
+  NSMutableArray<FBObjectiveCGraphElement *> *edgeElements;
+};
+
+/**
+ Cycle whose signature was found repeatedCycleInstanceLimit times in the current scan. Every element is described by
+ its class and the name path of the reference leading to it from the previous element, the first one being led to from
+ the last one.
+ */
+struct FBRepeatedCycle {
+  uint64_t signature;
+  std::vector<std::pair<uintptr_t, FBNamePathID>> elements;
+};
+
+/**
+ Retained objects of expanded objects, ordered by priority, shared by all passes of a search for short cycles first.
+ Once their estimated size goes over the limit, the oldest ones are dropped, and expanded again if they are reached.
+ */
+struct FBExpansionCache {
+  std::unordered_map<size_t, NSArray<FBObjectiveCGraphElement *> *> expansions;
+  // Address and estimated size of every cached expansion, oldest first
+  std::deque<std::pair<size_t, size_t>> insertionOrder;
+  size_t estimatedSize;
+  size_t memoryLimit;
+  // Expansions done so far, including repeated ones
+  NSUInteger expansionCount;
+};
 
 @implementation FBRetainCycleDetector
 {
   NSMutableArray *_candidates;
   FBObjectGraphConfiguration *_configuration;
-  NSMutableSet *_objectSet;
+  FB::RetainCycleDetector::VisitedAddressSet _visitedAddresses;
+  FB::RetainCycleDetector::AcyclicNodeMemo _acyclicNodeMemo;
+  std::unique_ptr<FB::RetainCycleDetector::ComponentTracker> _componentTracker;
+  std::unique_ptr<FB::RetainCycleDetector::RetainedSizeGraph> _retainedSizeGraph;
+  FBObjectGraphSnapshotter *_snapshotter;
+  std::unordered_set<uint64_t> _cycleEdgeHints;
+  std::unordered_map<uint64_t, NSUInteger> _cycleInstanceCounts;
+  std::vector<FBRepeatedCycle> _repeatedCycles;
+  // Class of an element to positions in _repeatedCycles it can start an instance from
+  std::unordered_map<uintptr_t, std::vector<std::pair<size_t, size_t>>> _repeatedCycleEntries;
 }
 
 - (instancetype)initWithConfiguration:(FBObjectGraphConfiguration *)configuration
@@ -31,7 +114,10 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
   if (self = [super init]) {
     _configuration = configuration;
     _candidates = [NSMutableArray new];
-    _objectSet = [NSMutableSet new];
+    _visitedAddressesMemoryLimit = kFBRetainCycleDetectorDefaultVisitedAddressesMemoryLimit;
+    _maximumSnapshotPauseDuration = kFBRetainCycleDetectorDefaultMaximumSnapshotPauseDuration;
+    _maximumPendingAnalysisCount = kFBRetainCycleDetectorDefaultMaximumPendingAnalysisCount;
+    _lastScanCycleInstanceCounts = @{};
   }
 
   return self;
@@ -63,6 +149,13 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
   }
 }
 
+- (void)addCandidatesFromRecentAllocations
+{
+  for (id candidate in [FBAllocationCandidateSource drainCandidates]) {
+    [self addCandidate:candidate];
+  }
+}
+
 - (NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCycles
 {
   return [self findRetainCyclesWithMaxCycleLength:kFBRetainCycleDetectorDefaultStackDepth];
@@ -70,17 +163,54 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
 
 - (NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesWithMaxCycleLength:(NSUInteger)length
 {
-  NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *allRetainCycles = [NSMutableSet new];
-  for (FBObjectiveCGraphElement *graphElement in _candidates) {
-    NSSet<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = [self _findRetainCyclesInObject:graphElement
-                                                                                      stackDepth:length];
-    [allRetainCycles unionSet:retainCycles];
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  _statistics = [FBRetainCycleDetectorStatistics new];
+  [_statistics beginScan];
+#endif
+
+  if (_shouldMemoizeAcyclicNodes) {
+    _componentTracker.reset(new FB::RetainCycleDetector::ComponentTracker());
+    _acyclicNodeMemo.beginScan();
+  }
+
+  _visitedAddresses = FB::RetainCycleDetector::VisitedAddressSet(_visitedAddressesMemoryLimit);
+
+  NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *allRetainCycles = nil;
+  _lastScanExhaustedExpansionBudget = NO;
+  const BOOL needsInterleavedTraversal = (_componentTracker || _retainedSizeGraph || _shouldStopExpandingKnownCycles ||
+                                          _repeatedCycleInstanceLimit > 0);
+  if (_shouldSearchShortCyclesFirst && !needsInterleavedTraversal) {
+    allRetainCycles = [self _findShortestRetainCyclesFirstWithMaxCycleLength:length];
+  } else if (_shouldPipelineAnalysis && !needsInterleavedTraversal) {
+    allRetainCycles = [self _findRetainCyclesInPipelineWithStackDepth:length];
+  } else {
+    allRetainCycles = [NSMutableSet new];
+    FBRetainCycleDetectorProgress progress = {0, 0, [_candidates count], 0, 0};
+    for (FBObjectiveCGraphElement *graphElement in _candidates) {
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+      [_statistics beginCandidate:@(class_getName([graphElement objectClass]))];
+#endif
+      NSSet<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = [self _findRetainCyclesInObject:graphElement
+                                                                                        stackDepth:length];
+      [allRetainCycles unionSet:retainCycles];
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+      [_statistics endCandidate];
+#endif
+      progress.candidatesGathered++;
+      progress.candidatesAnalyzed++;
+      if (_progressHandler) {
+        _progressHandler(progress);
+      }
+    }
   }
   [_candidates removeAllObjects];
-  [_objectSet removeAllObjects];
+  _visitedAddresses.clear();
+  _componentTracker.reset();
+  _lastScanCycleInstanceCounts = [self _consumeCycleInstanceCounts];
 
   // Filter cycles that have been broken down since we found them.
   // These are false-positive that were picked-up and are transient cycles.
+  FB_RCD_STATS_PHASE_BEGIN(verifyBegin);
   NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *brokenCycles = [NSMutableSet set];
   for (NSArray<FBObjectiveCGraphElement *> *itemCycle in allRetainCycles) {
     for (FBObjectiveCGraphElement *element in itemCycle) {
@@ -93,10 +223,204 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
     }
   }
   [allRetainCycles minusSet:brokenCycles];
+  FB_RCD_STATS_TRACED_PHASE_END(Verify, verifyBegin);
+
+  [self _rememberSignaturesOfRetainCycles:allRetainCycles];
+  [self _rememberEdgesOfRetainCycles:allRetainCycles];
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  [_statistics endScan];
+#endif
+
+  return allRetainCycles;
+}
+
+- (NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesInSnapshot
+{
+  return [self findRetainCyclesInSnapshotWithMaxCycleLength:kFBRetainCycleDetectorDefaultStackDepth];
+}
+
+- (NSSet<NSArray<FBObjectiveCGraphElement *> *> *)findRetainCyclesInSnapshotWithMaxCycleLength:(NSUInteger)length
+{
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  _statistics = [FBRetainCycleDetectorStatistics new];
+  [_statistics beginScan];
+#endif
+
+  if (!_snapshotter) {
+    // Layouts resolved by the snapshotter are kept with it, for later searches
+    _snapshotter = [[FBObjectGraphSnapshotter alloc] initWithConfiguration:_configuration];
+  }
+  _snapshotter.maximumPauseDuration = _maximumSnapshotPauseDuration;
+  _snapshotter.memoryLimit = _visitedAddressesMemoryLimit;
+
+  NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *allRetainCycles = [NSMutableSet new];
+  for (NSArray<FBObjectiveCGraphElement *> *retainCycle in [_snapshotter findRetainCyclesFromCandidates:_candidates
+                                                                                         maxCycleLength:length]) {
+    if (_knownCycleSignatures &&
+        [_knownCycleSignatures containsSignature:FBGetRetainCycleSignature(retainCycle)]) {
+      FB_RCD_STATS_INCREMENT(KnownCyclesSkipped);
+      continue;
+    }
+    FB_RCD_STATS_PHASE_BEGIN(canonicalizeBegin);
+    [allRetainCycles addObject:[self _shiftToUnifiedCycle:retainCycle]];
+    FB_RCD_STATS_TRACED_PHASE_END(Canonicalize, canonicalizeBegin);
+    FB_RCD_STATS_INCREMENT(CyclesFound);
+  }
+  [_candidates removeAllObjects];
+  _lastScanCycleInstanceCounts = @{};
+  _lastSnapshotPauseDuration = _snapshotter.lastPauseDuration;
+  _lastSnapshotWasComplete = _snapshotter.lastSnapshotWasComplete;
+
+  [self _rememberSignaturesOfRetainCycles:allRetainCycles];
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  [_statistics endScan];
+#endif
 
   return allRetainCycles;
 }
 
+- (NSArray<FBObjectiveCGraphElement *> *)findShortestRetainCycleContainingObject:(id)object
+{
+  return [self findShortestRetainCycleContainingObject:object maxCycleLength:kFBRetainCycleDetectorDefaultStackDepth];
+}
+
+- (NSArray<FBObjectiveCGraphElement *> *)findShortestRetainCycleContainingObject:(id)object
+                                                                  maxCycleLength:(NSUInteger)length
+{
+  FBObjectiveCGraphElement *rootElement = FBWrapObjectGraphElement(nil, object, _configuration);
+  if (!rootElement) {
+    return nil;
+  }
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  _statistics = [FBRetainCycleDetectorStatistics new];
+  [_statistics beginScan];
+#endif
+
+  struct Node {
+    FBObjectiveCGraphElement *element;
+    // Index of the node it was first reached from, following references backwards leads to the object
+    size_t parent;
+  };
+  const size_t rootAddress = [rootElement objectAddress];
+  std::vector<Node> nodes = {{rootElement, 0}};
+  FB::RetainCycleDetector::VisitedAddressSet reachedAddresses(_visitedAddressesMemoryLimit);
+  reachedAddresses.insert(rootAddress);
+
+  NSArray<FBObjectiveCGraphElement *> *retainCycle = nil;
+  // Nodes of the current level are [levelBegin, levelEnd), their depth is the length of a cycle closed from them
+  size_t levelBegin = 0;
+  for (NSUInteger depth = 1; depth <= length && levelBegin < nodes.size() && !retainCycle; ++depth) {
+    const size_t levelEnd = nodes.size();
+    for (size_t index = levelBegin; index < levelEnd && !retainCycle; ++index) {
+      @autoreleasepool {
+        FB_RCD_STATS_INCREMENT(NodesVisited);
+        FB_RCD_STATS_PHASE_BEGIN(expandBegin);
+        NSSet<FBObjectiveCGraphElement *> *retainedObjects = [nodes[index].element allRetainedObjects];
+        FB_RCD_STATS_PHASE_END(Expand, expandBegin);
+
+        for (FBObjectiveCGraphElement *retainedObject in retainedObjects) {
+          const size_t address = [retainedObject objectAddress];
+          if (address == rootAddress) {
+            // Element that closes the cycle goes first, it knows how the object is retained
+            NSMutableArray<FBObjectiveCGraphElement *> *cycle = [NSMutableArray arrayWithObject:retainedObject];
+            for (size_t node = index; node != 0; node = nodes[node].parent) {
+              [cycle insertObject:nodes[node].element atIndex:1];
+            }
+            // Dropped if any of its objects was released while the search was running, same as in findRetainCycles
+            BOOL isAlive = YES;
+            for (FBObjectiveCGraphElement *element in cycle) {
+              isAlive = isAlive && [element objectPtr] != NULL;
+            }
+            if (isAlive) {
+              retainCycle = cycle;
+              break;
+            }
+            continue;
+          }
+          if (depth == length) {
+            // Longer cycles are not searched for, no need to remember anything reached from here
+            continue;
+          }
+          auto inserted = reachedAddresses.insert(address);
+          if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::OverMemoryLimit) {
+            FB_RCD_STATS_INCREMENT(NodesOverMemoryLimit);
+          }
+          if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::Inserted) {
+            nodes.push_back({retainedObject, index});
+          }
+        }
+      }
+    }
+    levelBegin = levelEnd;
+  }
+
+  if (retainCycle) {
+    FB_RCD_STATS_INCREMENT(CyclesFound);
+  }
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  [_statistics endScan];
+#endif
+
+  return retainCycle;
+}
+
+- (void)_rememberSignaturesOfRetainCycles:(NSSet<NSArray<FBObjectiveCGraphElement *> *> *)retainCycles
+{
+  if (!_knownCycleSignatures || [retainCycles count] == 0) {
+    return;
+  }
+  NSMutableArray<NSNumber *> *signatures = [NSMutableArray arrayWithCapacity:[retainCycles count]];
+  for (NSArray<FBObjectiveCGraphElement *> *retainCycle in retainCycles) {
+    [signatures addObject:@(FBGetRetainCycleSignature(retainCycle))];
+  }
+  [_knownCycleSignatures addSignatures:signatures];
+}
+
+- (NSArray<FBRetainCycleReport *> *)findRetainCycleReports
+{
+  return [self findRetainCycleReportsWithMaxCycleLength:kFBRetainCycleDetectorDefaultStackDepth];
+}
+
+- (NSArray<FBRetainCycleReport *> *)findRetainCycleReportsWithMaxCycleLength:(NSUInteger)length
+{
+  _retainedSizeGraph.reset(new FB::RetainCycleDetector::RetainedSizeGraph());
+  NSArray<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = [[self findRetainCyclesWithMaxCycleLength:length] allObjects];
+
+  std::vector<std::vector<size_t>> cycleAddresses;
+  cycleAddresses.reserve([retainCycles count]);
+  for (NSArray<FBObjectiveCGraphElement *> *cycle in retainCycles) {
+    std::vector<size_t> addresses;
+    for (FBObjectiveCGraphElement *element in cycle) {
+      addresses.push_back([element objectAddress]);
+    }
+    cycleAddresses.push_back(std::move(addresses));
+  }
+  std::vector<uint64_t> retainedSizes = _retainedSizeGraph->retainedSizesOfCycles(cycleAddresses);
+  _retainedSizeGraph.reset();
+
+  NSMutableArray<FBRetainCycleReport *> *reports = [NSMutableArray arrayWithCapacity:[retainCycles count]];
+  for (NSUInteger i = 0; i < [retainCycles count]; ++i) {
+    NSUInteger instanceCount = 1;
+    if ([_lastScanCycleInstanceCounts count] > 0) {
+      instanceCount = MAX([_lastScanCycleInstanceCounts[@(FBGetRetainCycleSignature(retainCycles[i]))] unsignedIntegerValue], 1);
+    }
+    [reports addObject:[[FBRetainCycleReport alloc] initWithCycle:retainCycles[i]
+                                                    retainedBytes:(NSUInteger)retainedSizes[i]
+                                                    instanceCount:instanceCount]];
+  }
+  [reports sortUsingComparator:^NSComparisonResult(FBRetainCycleReport *report1, FBRetainCycleReport *report2) {
+    if (report1.retainedBytes == report2.retainedBytes) {
+      return NSOrderedSame;
+    }
+    return report1.retainedBytes > report2.retainedBytes ? NSOrderedAscending : NSOrderedDescending;
+  }];
+  return reports;
+}
+
 - (NSSet<NSArray<FBObjectiveCGraphElement *> *> *)_findRetainCyclesInObject:(FBObjectiveCGraphElement *)graphElement
                                                                  stackDepth:(NSUInteger)stackDepth
 {
@@ -112,8 +436,14 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
   // a set of previously visited nodes.
   NSMutableSet<FBNodeEnumerator *> *objectsOnPath = [NSMutableSet new];
 
+  // Objects of known cycles we stopped expanding
+  std::unordered_set<size_t> exhaustedAddresses;
+
   // Let's start with the root
   [stack addObject:wrappedObject];
+  if (_retainedSizeGraph) {
+    _retainedSizeGraph->addRoot(wrappedObject.objectAddress);
+  }
 
   while ([stack count] > 0) {
     // Algorithm creates many short-living objects. It can contribute to few
@@ -125,13 +455,47 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
 
       // We don't want to retraverse the same subtree
       if (![objectsOnPath containsObject:top]) {
-        if ([_objectSet containsObject:@([top.object objectAddress])]) {
+        // Only the address is remembered, to avoid unnecessarily retaining the object
+        auto inserted = _visitedAddresses.insert([top.object objectAddress]);
+        if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::AlreadyPresent) {
           [stack removeLastObject];
+          if (_componentTracker) {
+            _componentTracker->addEdgeToDiscoveredNode([stack lastObject].objectAddress, top.objectAddress);
+          }
           continue;
         }
-        // Add the object address to the set as an NSNumber to avoid
-        // unnecessarily retaining the object
-        [_objectSet addObject:@([top.object objectAddress])];
+        if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::OverMemoryLimit) {
+          // Out of memory for new nodes, we only finish what's reachable through already visited ones
+          FB_RCD_STATS_INCREMENT(NodesOverMemoryLimit);
+          [stack removeLastObject];
+          if (_componentTracker && [stack count] > 0) {
+            _componentTracker->markIncomplete([stack lastObject].objectAddress);
+          }
+          continue;
+        }
+        FB_RCD_STATS_INCREMENT(NodesVisited);
+
+        if (_retainedSizeGraph) {
+          void *objectPtr = [top.object objectPtr];
+          _retainedSizeGraph->addNode(top.objectAddress, objectPtr ? malloc_size(objectPtr) : 0);
+        }
+
+        if (_componentTracker) {
+          // Object was proven acyclic by one of the previous scans and didn't change since
+          if (!_retainedSizeGraph && [self _isMemoizedAcyclicNode:top]) {
+            FB_RCD_STATS_INCREMENT(AcyclicMemoHits);
+            _componentTracker->discoverAcyclic(top.objectAddress);
+            [stack removeLastObject];
+            _componentTracker->addEdgeToDiscoveredNode([stack lastObject].objectAddress, top.objectAddress);
+            continue;
+          }
+          _componentTracker->discover(top.objectAddress);
+        }
+
+        if (!_repeatedCycleEntries.empty() && [self _countRepeatedCycleInstanceFromElement:top.object]) {
+          FB_RCD_STATS_INCREMENT(RepeatedCyclesCounted);
+          exhaustedAddresses.insert(top.objectAddress);
+        }
       }
 
       [objectsOnPath addObject:top];
@@ -139,9 +503,22 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
       // Take next adjecent node to that child. Wrapper object can
       // persist iteration state. If we see that node again, it will
       // give us new adjacent node unless it runs out of them
-      FBNodeEnumerator *firstAdjacent = [top nextObject];
+      FBNodeEnumerator *firstAdjacent = nil;
+      if (exhaustedAddresses.count(top.objectAddress) == 0) {
+        FB_RCD_STATS_PHASE_BEGIN(expandBegin);
+        firstAdjacent = [top nextObject];
+        FB_RCD_STATS_PHASE_END(Expand, expandBegin);
+      } else if (_componentTracker) {
+        _componentTracker->markIncomplete(top.objectAddress);
+      }
       if (firstAdjacent) {
         // Current node still has some adjacent not-visited nodes
+        if (_componentTracker) {
+          _componentTracker->addChild(top.objectAddress, firstAdjacent.objectAddress);
+        }
+        if (_retainedSizeGraph) {
+          _retainedSizeGraph->addEdge(top.objectAddress, firstAdjacent.objectAddress);
+        }
 
         BOOL shouldPushToStack = NO;
 
@@ -159,16 +536,39 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
             // Object got deallocated between checking if it exists and grabbing its index
             shouldPushToStack = YES;
           } else {
+            if (_componentTracker) {
+              _componentTracker->addEdgeToDiscoveredNode(top.objectAddress, firstAdjacent.objectAddress);
+            }
+
             NSRange cycleRange = NSMakeRange(index, length);
             NSMutableArray<FBNodeEnumerator *> *cycle = [[stack subarrayWithRange:cycleRange] mutableCopy];
             [cycle replaceObjectAtIndex:0 withObject:firstAdjacent];
 
             // 1. Unwrap the cycle
-            // 2. Shift to lowest address (if we omit that, and the cycle is created by same class,
+            // 2. Drop it if it's already known
+            // 3. Shift to lowest address (if we omit that, and the cycle is created by same class,
             //    we might have duplicates)
-            // 3. Shift by class (lexicographically)
+            // 4. Shift by class (lexicographically)
 
-            [retainCycles addObject:[self _shiftToUnifiedCycle:[self _unwrapCycle:cycle]]];
+            NSArray<FBObjectiveCGraphElement *> *unwrappedCycle = [self _unwrapCycle:cycle];
+            const uint64_t signature = (_knownCycleSignatures || _repeatedCycleInstanceLimit > 0) ?
+              FBGetRetainCycleSignature(unwrappedCycle) : 0;
+            if (_knownCycleSignatures && [_knownCycleSignatures containsSignature:signature]) {
+              FB_RCD_STATS_INCREMENT(KnownCyclesSkipped);
+              if (_shouldStopExpandingKnownCycles) {
+                for (FBNodeEnumerator *node in cycle) {
+                  exhaustedAddresses.insert(node.objectAddress);
+                }
+              }
+            } else {
+              FB_RCD_STATS_PHASE_BEGIN(canonicalizeBegin);
+              [retainCycles addObject:[self _shiftToUnifiedCycle:unwrappedCycle]];
+              FB_RCD_STATS_TRACED_PHASE_END(Canonicalize, canonicalizeBegin);
+              FB_RCD_STATS_INCREMENT(CyclesFound);
+              if (_repeatedCycleInstanceLimit > 0) {
+                [self _countInstanceOfRetainCycle:unwrappedCycle withSignature:signature];
+              }
+            }
           }
         } else {
           // Node is clear to check, add it to stack and continue
@@ -178,18 +578,553 @@ static const NSUInteger kFBRetainCycleDetectorDefaultStackDepth = 10;
         if (shouldPushToStack) {
           if ([stack count] < stackDepth) {
             [stack addObject:firstAdjacent];
+          } else if (_componentTracker) {
+            _componentTracker->markIncomplete(top.objectAddress);
           }
         }
       } else {
         // Node has no more adjacent nodes, it itself is done, move on
         [stack removeLastObject];
         [objectsOnPath removeObject:top];
+
+        if (_componentTracker &&
+            _componentTracker->finish(top.objectAddress, [stack lastObject].objectAddress)) {
+          [self _memoizeAcyclicNode:top];
+        }
       }
     }
   }
   return retainCycles;
 }
 
+#pragma mark - Repeated cycles
+
+- (void)_countInstanceOfRetainCycle:(NSArray<FBObjectiveCGraphElement *> *)retainCycle withSignature:(uint64_t)signature
+{
+  if (++_cycleInstanceCounts[signature] != _repeatedCycleInstanceLimit) {
+    return;
+  }
+
+  FBRepeatedCycle repeatedCycle = {signature, {}};
+  for (FBObjectiveCGraphElement *element in retainCycle) {
+    const uintptr_t elementClass = (uintptr_t)[element objectClass];
+    _repeatedCycleEntries[elementClass].emplace_back(_repeatedCycles.size(), repeatedCycle.elements.size());
+    repeatedCycle.elements.emplace_back(elementClass, element.namePathID);
+  }
+  _repeatedCycles.push_back(std::move(repeatedCycle));
+}
+
+/**
+ Checks if the element is part of another instance of a repeated cycle, by following from it only references with the
+ class and name path the next element of that cycle has. Costs an expansion per element of the cycle, instead of
+ expanding everything the element retains.
+
+ @return YES if the instance was counted, and the element doesn't need to be expanded. Other elements of the instance
+ are marked as visited, so that the instance is not counted again from them.
+ */
+- (BOOL)_countRepeatedCycleInstanceFromElement:(FBObjectiveCGraphElement *)element
+{
+  auto entries = _repeatedCycleEntries.find((uintptr_t)[element objectClass]);
+  if (entries == _repeatedCycleEntries.end()) {
+    return NO;
+  }
+
+  const size_t address = [element objectAddress];
+  std::vector<size_t> instanceAddresses;
+  for (const auto &entry: entries->second) {
+    const FBRepeatedCycle &repeatedCycle = _repeatedCycles[entry.first];
+    const size_t length = repeatedCycle.elements.size();
+    FBObjectiveCGraphElement *current = element;
+    instanceAddresses.clear();
+    for (size_t step = 1; step <= length && current; ++step) {
+      const auto &expected = repeatedCycle.elements[(entry.second + step) % length];
+      FBObjectiveCGraphElement *next = nil;
+      FB_RCD_STATS_PHASE_BEGIN(expandBegin);
+      for (FBObjectiveCGraphElement *retainedObject in [current retainedObjectsEnumerator]) {
+        if ((uintptr_t)[retainedObject objectClass] == expected.first && retainedObject.namePathID == expected.second) {
+          next = retainedObject;
+          break;
+        }
+      }
+      FB_RCD_STATS_PHASE_END(Expand, expandBegin);
+      current = next;
+      instanceAddresses.push_back([next objectAddress]);
+    }
+    if (current && [current objectAddress] == address) {
+      for (size_t instanceAddress: instanceAddresses) {
+        _visitedAddresses.insert(instanceAddress);
+      }
+      _cycleInstanceCounts[repeatedCycle.signature]++;
+      return YES;
+    }
+  }
+  return NO;
+}
+
+- (NSDictionary<NSNumber *, NSNumber *> *)_consumeCycleInstanceCounts
+{
+  NSMutableDictionary<NSNumber *, NSNumber *> *instanceCounts =
+    [NSMutableDictionary dictionaryWithCapacity:_cycleInstanceCounts.size()];
+  for (const auto &instanceCount: _cycleInstanceCounts) {
+    instanceCounts[@(instanceCount.first)] = @(instanceCount.second);
+  }
+  _cycleInstanceCounts.clear();
+  _repeatedCycles.clear();
+  _repeatedCycleEntries.clear();
+  return instanceCounts;
+}
+
+#pragma mark - Short cycles first
+
+/**
+ Searches all candidates again and again, allowing one more element on the path every time, until no path was cut
+ short by the limit, the maximum length is reached, or the expansion budget runs out. Every pass is the same traversal
+ _findRetainCyclesInObject: does, with references most likely to close a cycle followed first.
+ */
+- (NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *)_findShortestRetainCyclesFirstWithMaxCycleLength:(NSUInteger)length
+{
+  NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *allRetainCycles = [NSMutableSet new];
+  FBExpansionCache expansions = {{}, {}, 0, _visitedAddressesMemoryLimit, 0};
+
+  for (NSUInteger stackDepth = 1; stackDepth <= length; ++stackDepth) {
+    _visitedAddresses = FB::RetainCycleDetector::VisitedAddressSet(_visitedAddressesMemoryLimit);
+    BOOL reachedDepthLimit = NO;
+    for (FBObjectiveCGraphElement *graphElement in _candidates) {
+      [self _findRetainCyclesFromObject:graphElement
+                             stackDepth:stackDepth
+                             expansions:expansions
+                           retainCycles:allRetainCycles
+                      reachedDepthLimit:&reachedDepthLimit];
+    }
+    if (!reachedDepthLimit || _lastScanExhaustedExpansionBudget) {
+      break;
+    }
+  }
+
+  if (_progressHandler) {
+    NSUInteger candidateCount = [_candidates count];
+    _progressHandler({candidateCount, candidateCount, candidateCount, 0, 0});
+  }
+  return allRetainCycles;
+}
+
+- (void)_findRetainCyclesFromObject:(FBObjectiveCGraphElement *)graphElement
+                         stackDepth:(NSUInteger)stackDepth
+                         expansions:(FBExpansionCache &)expansions
+                       retainCycles:(NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *)retainCycles
+                  reachedDepthLimit:(BOOL *)reachedDepthLimit
+{
+  struct Frame {
+    FBObjectiveCGraphElement *element;
+    size_t address;
+    NSArray<FBObjectiveCGraphElement *> *retainedObjects;
+    NSUInteger nextIndex;
+  };
+
+  size_t rootAddress = [graphElement objectAddress];
+  if (_visitedAddresses.insert(rootAddress) != FB::RetainCycleDetector::VisitedAddressSet::InsertResult::Inserted) {
+    return;
+  }
+  std::vector<Frame> path = {{graphElement, rootAddress, nil, 0}};
+  std::unordered_map<size_t, size_t> pathPositions = {{rootAddress, 0}};
+
+  while (!path.empty()) {
+    @autoreleasepool {
+      Frame &top = path.back();
+      if (!top.retainedObjects) {
+        top.retainedObjects = [self _prioritizedRetainedObjectsOfElement:top.element
+                                                                 address:top.address
+                                                              expansions:expansions];
+      }
+      if (top.nextIndex == [top.retainedObjects count]) {
+        pathPositions.erase(top.address);
+        path.pop_back();
+        continue;
+      }
+      FBObjectiveCGraphElement *adjacent = top.retainedObjects[top.nextIndex++];
+      size_t adjacentAddress = [adjacent objectAddress];
+
+      auto pathPosition = pathPositions.find(adjacentAddress);
+      if (pathPosition != pathPositions.end()) {
+        // Element that closes the cycle goes first, it knows how it was reached
+        NSMutableArray<FBObjectiveCGraphElement *> *cycle = [NSMutableArray arrayWithObject:adjacent];
+        for (size_t i = pathPosition->second + 1; i < path.size(); ++i) {
+          [cycle addObject:path[i].element];
+        }
+        if (_knownCycleSignatures && [_knownCycleSignatures containsSignature:FBGetRetainCycleSignature(cycle)]) {
+          FB_RCD_STATS_INCREMENT(KnownCyclesSkipped);
+        } else {
+          FB_RCD_STATS_PHASE_BEGIN(canonicalizeBegin);
+          NSArray<FBObjectiveCGraphElement *> *unifiedCycle = [self _shiftToUnifiedCycle:cycle];
+          FB_RCD_STATS_TRACED_PHASE_END(Canonicalize, canonicalizeBegin);
+          if (![retainCycles containsObject:unifiedCycle]) {
+            // Shorter passes found it already otherwise
+            [retainCycles addObject:unifiedCycle];
+            FB_RCD_STATS_INCREMENT(CyclesFound);
+          }
+        }
+        continue;
+      }
+
+      if (path.size() >= stackDepth) {
+        if (!_visitedAddresses.contains(adjacentAddress)) {
+          *reachedDepthLimit = YES;
+        }
+        continue;
+      }
+      auto inserted = _visitedAddresses.insert(adjacentAddress);
+      if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::AlreadyPresent) {
+        continue;
+      }
+      if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::OverMemoryLimit) {
+        FB_RCD_STATS_INCREMENT(NodesOverMemoryLimit);
+        continue;
+      }
+      pathPositions[adjacentAddress] = path.size();
+      path.push_back({adjacent, adjacentAddress, nil, 0});
+    }
+  }
+}
+
+- (NSArray<FBObjectiveCGraphElement *> *)_prioritizedRetainedObjectsOfElement:(FBObjectiveCGraphElement *)element
+                                                                      address:(size_t)address
+                                                                   expansions:(FBExpansionCache &)expansions
+{
+  auto expansion = expansions.expansions.find(address);
+  if (expansion != expansions.expansions.end()) {
+    return expansion->second;
+  }
+  if (_expansionBudget > 0 && expansions.expansionCount >= _expansionBudget) {
+    _lastScanExhaustedExpansionBudget = YES;
+    return @[];
+  }
+  expansions.expansionCount++;
+
+  FB_RCD_STATS_INCREMENT(NodesVisited);
+  FB_RCD_STATS_PHASE_BEGIN(expandBegin);
+  NSSet<FBObjectiveCGraphElement *> *retainedObjects = [element allRetainedObjects];
+  FB_RCD_STATS_PHASE_END(Expand, expandBegin);
+
+  Class elementClass = [element objectClass];
+  std::vector<std::pair<NSUInteger, FBObjectiveCGraphElement *>> rankedObjects;
+  for (FBObjectiveCGraphElement *retainedObject in retainedObjects) {
+    rankedObjects.push_back({[self _priorityOfEdgeFromClass:elementClass to:retainedObject], retainedObject});
+  }
+  std::stable_sort(rankedObjects.begin(), rankedObjects.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.first < rhs.first;
+  });
+
+  NSMutableArray<FBObjectiveCGraphElement *> *prioritizedObjects = [NSMutableArray arrayWithCapacity:rankedObjects.size()];
+  size_t estimatedSize = malloc_size((__bridge const void *)prioritizedObjects) + rankedObjects.size() * sizeof(id);
+  for (const auto &rankedObject: rankedObjects) {
+    [prioritizedObjects addObject:rankedObject.second];
+    estimatedSize += malloc_size((__bridge const void *)rankedObject.second);
+  }
+
+  expansions.expansions[address] = prioritizedObjects;
+  expansions.insertionOrder.push_back({address, estimatedSize});
+  expansions.estimatedSize += estimatedSize;
+  // Frames on the path keep their own reference, so dropping an expansion they use is fine
+  while (expansions.estimatedSize > expansions.memoryLimit && expansions.insertionOrder.size() > 1) {
+    const auto &oldest = expansions.insertionOrder.front();
+    expansions.expansions.erase(oldest.first);
+    expansions.estimatedSize -= oldest.second;
+    expansions.insertionOrder.pop_front();
+  }
+  return prioritizedObjects;
+}
+
+/**
+ Lower goes first. Most leaks go through a block capturing its owner, or through a reference that was meant to be
+ weak, like a delegate.
+ */
+- (NSUInteger)_priorityOfEdgeFromClass:(Class)fromClass to:(FBObjectiveCGraphElement *)element
+{
+  if (_cycleEdgeHints.count(FBGetCycleEdgeHint(fromClass, element.namePathID, [element objectClass]))) {
+    return 0;
+  }
+  if (element.edgeKind == FBGraphEdgeKindBlockCapture || [element isKindOfClass:[FBObjectiveCBlock class]]) {
+    return 1;
+  }
+  NSString *name = FBGetInternedNamePathFirstName(element.namePathID);
+  if (name && FBIsDelegateLikeName(name)) {
+    return 2;
+  }
+  return 3;
+}
+
+/**
+ Edges cycles reported by this detector went through, so that later guided searches follow them first.
+ */
+- (void)_rememberEdgesOfRetainCycles:(NSSet<NSArray<FBObjectiveCGraphElement *> *> *)retainCycles
+{
+  for (NSArray<FBObjectiveCGraphElement *> *retainCycle in retainCycles) {
+    FBObjectiveCGraphElement *previousElement = [retainCycle lastObject];
+    for (FBObjectiveCGraphElement *element in retainCycle) {
+      if (_cycleEdgeHints.size() >= kFBRetainCycleDetectorMaximumCycleEdgeHints) {
+        _cycleEdgeHints.clear();
+      }
+      _cycleEdgeHints.insert(FBGetCycleEdgeHint([previousElement objectClass],
+                                                element.namePathID,
+                                                [element objectClass]));
+      previousElement = element;
+    }
+  }
+}
+
+#pragma mark - Pipeline
+
+/**
+ Traversal and analysis of candidates are run as two stages on different threads: while graph of one candidate is
+ searched for cycles, graph of the next one is being traversed. At most maximumPendingAnalysisCount traversed graphs
+ wait for analysis, the traversal waits for it when there are more.
+ */
+- (NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *)_findRetainCyclesInPipelineWithStackDepth:(NSUInteger)stackDepth
+{
+  FB::RetainCycleDetector::BoundedQueue<std::unique_ptr<FBGatheredGraph>> queue(_maximumPendingAnalysisCount);
+  std::atomic<NSUInteger> analyzedCount(0);
+  auto *queuePointer = &queue;
+  auto *analyzedCountPointer = &analyzedCount;
+
+  NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *allRetainCycles = [NSMutableSet new];
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  // Analysis records into its own statistics, added to the ones of the scan once it's done
+  FBRetainCycleDetectorStatistics *analysisStatistics = [FBRetainCycleDetectorStatistics new];
+#endif
+
+  dispatch_group_t analysisGroup = dispatch_group_create();
+  dispatch_group_async(analysisGroup, dispatch_get_global_queue(qos_class_self(), 0), ^{
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+    [analysisStatistics beginScan];
+#endif
+    std::unique_ptr<FBGatheredGraph> graph;
+    while (queuePointer->pop(graph)) {
+      @autoreleasepool {
+        [self _findRetainCyclesInGatheredGraph:*graph stackDepth:stackDepth retainCycles:allRetainCycles];
+        graph.reset();
+      }
+      analyzedCountPointer->fetch_add(1);
+    }
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+    [analysisStatistics endScan];
+#endif
+  });
+
+  FBRetainCycleDetectorProgress progress = {0, 0, [_candidates count], 0, 0};
+  for (FBObjectiveCGraphElement *graphElement in _candidates) {
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+    [_statistics beginCandidate:@(class_getName([graphElement objectClass]))];
+#endif
+    std::unique_ptr<FBGatheredGraph> graph = [self _gatherGraphOfObject:graphElement stackDepth:stackDepth];
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+    [_statistics endCandidate];
+#endif
+
+    bool waited = false;
+    FB_RCD_STATS_PHASE_BEGIN(backpressureBegin);
+    queue.push(std::move(graph), &waited);
+    if (waited) {
+      FB_RCD_STATS_TRACED_PHASE_END(AnalysisBackpressure, backpressureBegin);
+      progress.backpressureStallCount++;
+    } else {
+      FB_RCD_STATS_PHASE_END(AnalysisBackpressure, backpressureBegin);
+    }
+
+    progress.candidatesGathered++;
+    if (_progressHandler) {
+      progress.candidatesAnalyzed = analyzedCount.load();
+      progress.pendingAnalysisCount = queue.size();
+      _progressHandler(progress);
+    }
+  }
+
+  queue.close();
+  dispatch_group_wait(analysisGroup, DISPATCH_TIME_FOREVER);
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+  [_statistics addStatisticsOfOtherThread:analysisStatistics];
+#endif
+  if (_progressHandler) {
+    progress.candidatesAnalyzed = analyzedCount.load();
+    progress.pendingAnalysisCount = 0;
+    _progressHandler(progress);
+  }
+  return allRetainCycles;
+}
+
+/**
+ Gather stage: same traversal _findRetainCyclesInObject: does, only recording edges instead of looking for cycles.
+ */
+- (std::unique_ptr<FBGatheredGraph>)_gatherGraphOfObject:(FBObjectiveCGraphElement *)graphElement
+                                              stackDepth:(NSUInteger)stackDepth
+{
+  std::unique_ptr<FBGatheredGraph> graph(new FBGatheredGraph());
+  graph->edgeElements = [NSMutableArray new];
+
+  FBNodeEnumerator *root = [[FBNodeEnumerator alloc] initWithObject:graphElement];
+  auto inserted = _visitedAddresses.insert(root.objectAddress);
+  if (inserted != FB::RetainCycleDetector::VisitedAddressSet::InsertResult::Inserted) {
+    if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::OverMemoryLimit) {
+      FB_RCD_STATS_INCREMENT(NodesOverMemoryLimit);
+    }
+    return graph;
+  }
+  FB_RCD_STATS_INCREMENT(NodesVisited);
+
+  std::unordered_map<size_t, uint32_t> nodeIndices = {{root.objectAddress, 0}};
+  graph->nodeEdges.emplace_back();
+
+  NSMutableArray<FBNodeEnumerator *> *stack = [NSMutableArray arrayWithObject:root];
+  std::vector<uint32_t> stackNodes = {0};
+
+  while ([stack count] > 0) {
+    @autoreleasepool {
+      FBNodeEnumerator *top = [stack lastObject];
+      FB_RCD_STATS_PHASE_BEGIN(expandBegin);
+      FBNodeEnumerator *adjacent = [top nextObject];
+      FB_RCD_STATS_PHASE_END(Expand, expandBegin);
+      if (!adjacent) {
+        [stack removeLastObject];
+        stackNodes.pop_back();
+        continue;
+      }
+
+      uint32_t target;
+      bool isNewNode = false;
+      auto known = nodeIndices.find(adjacent.objectAddress);
+      if (known != nodeIndices.end()) {
+        target = known->second;
+      } else {
+        if ([stack count] >= stackDepth) {
+          continue;
+        }
+        inserted = _visitedAddresses.insert(adjacent.objectAddress);
+        if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::AlreadyPresent) {
+          // Visited from one of the previous candidates
+          continue;
+        }
+        if (inserted == FB::RetainCycleDetector::VisitedAddressSet::InsertResult::OverMemoryLimit) {
+          FB_RCD_STATS_INCREMENT(NodesOverMemoryLimit);
+          continue;
+        }
+        FB_RCD_STATS_INCREMENT(NodesVisited);
+        target = (uint32_t)graph->nodeEdges.size();
+        nodeIndices[adjacent.objectAddress] = target;
+        graph->nodeEdges.emplace_back();
+        isNewNode = true;
+      }
+
+      graph->nodeEdges[stackNodes.back()].push_back((uint32_t)graph->edgeTargets.size());
+      graph->edgeTargets.push_back(target);
+      [graph->edgeElements addObject:adjacent.object];
+      if (isNewNode) {
+        [stack addObject:adjacent];
+        stackNodes.push_back(target);
+      }
+    }
+  }
+  return graph;
+}
+
+/**
+ Analysis stage: replays the traversal over the gathered graph, reporting cycles the way _findRetainCyclesInObject:
+ does. Runs on its own thread, recording into statistics of the analysis.
+ */
+- (void)_findRetainCyclesInGatheredGraph:(const FBGatheredGraph &)graph
+                              stackDepth:(NSUInteger)stackDepth
+                            retainCycles:(NSMutableSet<NSArray<FBObjectiveCGraphElement *> *> *)retainCycles
+{
+  if (graph.nodeEdges.empty()) {
+    return;
+  }
+
+  static const uint32_t kNotOnPath = UINT32_MAX;
+  std::vector<uint32_t> pathPosition(graph.nodeEdges.size(), kNotOnPath);
+  std::vector<uint8_t> visited(graph.nodeEdges.size(), 0);
+
+  struct Frame {
+    uint32_t node;
+    uint32_t nextEdge;
+    // Edge the node was reached through, UINT32_MAX for the root
+    uint32_t edge;
+  };
+  std::vector<Frame> path = {{0, 0, UINT32_MAX}};
+  pathPosition[0] = 0;
+  visited[0] = 1;
+
+  while (!path.empty()) {
+    Frame &top = path.back();
+    const std::vector<uint32_t> &edges = graph.nodeEdges[top.node];
+    if (top.nextEdge == edges.size()) {
+      pathPosition[top.node] = kNotOnPath;
+      path.pop_back();
+      continue;
+    }
+    uint32_t edge = edges[top.nextEdge++];
+    uint32_t target = graph.edgeTargets[edge];
+
+    if (pathPosition[target] != kNotOnPath) {
+      // Like in regular traversal, the element that closes the cycle goes first, it knows how it was reached
+      NSMutableArray<FBObjectiveCGraphElement *> *cycle = [NSMutableArray arrayWithObject:graph.edgeElements[edge]];
+      for (size_t i = pathPosition[target] + 1; i < path.size(); ++i) {
+        [cycle addObject:graph.edgeElements[path[i].edge]];
+      }
+      if (_knownCycleSignatures && [_knownCycleSignatures containsSignature:FBGetRetainCycleSignature(cycle)]) {
+        FB_RCD_STATS_INCREMENT(KnownCyclesSkipped);
+      } else {
+        FB_RCD_STATS_PHASE_BEGIN(canonicalizeBegin);
+        NSArray<FBObjectiveCGraphElement *> *unifiedCycle = [self _shiftToUnifiedCycle:cycle];
+        FB_RCD_STATS_TRACED_PHASE_END(Canonicalize, canonicalizeBegin);
+        [retainCycles addObject:unifiedCycle];
+        FB_RCD_STATS_INCREMENT(CyclesFound);
+      }
+      continue;
+    }
+    if (visited[target] || path.size() >= stackDepth) {
+      continue;
+    }
+    visited[target] = 1;
+    pathPosition[target] = (uint32_t)path.size();
+    path.push_back({target, 0, edge});
+  }
+}
+
+#pragma mark - Acyclic node memo
+
+- (void)resetAcyclicNodeMemo
+{
+  _acyclicNodeMemo.clear();
+}
+
+- (BOOL)_isMemoizedAcyclicNode:(FBNodeEnumerator *)node
+{
+  // Keeps the node alive while we check it, all other objects we check are retained by it
+  __strong id object = node.object.object;
+  if (!object) {
+    return NO;
+  }
+
+  FBObjectGraphConfiguration *configuration = _configuration;
+  return _acyclicNodeMemo.containsUnchangedSubgraph(node.objectAddress, [configuration](size_t address, uintptr_t *classAddress) {
+    __unsafe_unretained id remembered = (__bridge id)(void *)address;
+    *classAddress = (uintptr_t)object_getClass(remembered);
+    return FBGetObjectRetainedObjectsFingerprint(remembered, configuration);
+  });
+}
+
+- (void)_memoizeAcyclicNode:(FBNodeEnumerator *)node
+{
+  __strong id object = node.object.object;
+  if (!object) {
+    return;
+  }
+
+  _acyclicNodeMemo.insert(node.objectAddress,
+                          (uintptr_t)object_getClass(object),
+                          FBGetObjectRetainedObjectsFingerprint(object, _configuration),
+                          _componentTracker->childrenOf(node.objectAddress));
+}
+
 // Turn all enumerators into object graph elements
 - (NSArray<FBObjectiveCGraphElement *> *)_unwrapCycle:(NSArray<FBNodeEnumerator *> *)cycle
 {
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ Statistics are compiled out by default, so scans do not pay for any of the bookkeeping. You can compile them in
+ by uncommenting the line below, or by defining the macro in your build settings.
+ */
+//#define RETAIN_CYCLE_DETECTOR_STATISTICS_ENABLED 1
+
+/**
+ FBRetainCycleDetectorStatistics
+
+ Counters and timings gathered during a single scan (one call to findRetainCycles). Use them to tune filters and
+ maximum cycle length with data.
+
+ Phase durations are inclusive: edge filtering happens while nodes are expanded, so filterDuration is also part of
+ expandDuration. In pipelined scans, they include work done by the analysis thread, so they can add up to more than
+ totalDuration.
+ */
+@interface FBRetainCycleDetectorStatistics : NSObject
+
+@property (nonatomic, readonly) NSUInteger candidatesScanned;
+@property (nonatomic, readonly) NSUInteger nodesVisited;
+@property (nonatomic, readonly) NSUInteger edgesExamined;
+@property (nonatomic, readonly) NSUInteger edgesRejectedByFilters;
+@property (nonatomic, readonly) NSUInteger layoutCacheHits;
+@property (nonatomic, readonly) NSUInteger layoutCacheMisses;
+@property (nonatomic, readonly) NSUInteger associationLookups;
+@property (nonatomic, readonly) NSUInteger collectionEnumerationRetries;
+@property (nonatomic, readonly) NSUInteger swiftABIResolutions;
+@property (nonatomic, readonly) NSUInteger cyclesFound;
+@property (nonatomic, readonly) NSUInteger acyclicMemoHits;
+@property (nonatomic, readonly) NSUInteger knownCyclesSkipped;
+@property (nonatomic, readonly) NSUInteger nodesOverMemoryLimit;
+/**
+ Cycle instances that were only counted, instead of expanded, because of repeatedCycleInstanceLimit.
+ */
+@property (nonatomic, readonly) NSUInteger repeatedCyclesCounted;
+
+@property (nonatomic, readonly) NSTimeInterval expandDuration;
+@property (nonatomic, readonly) NSTimeInterval filterDuration;
+@property (nonatomic, readonly) NSTimeInterval canonicalizeDuration;
+@property (nonatomic, readonly) NSTimeInterval verifyDuration;
+/**
+ Time other threads spent suspended while snapshots of the object graph were taken, zero for regular scans.
+ */
+@property (nonatomic, readonly) NSTimeInterval snapshotPauseDuration;
+/**
+ Time the traversal spent waiting for analysis of earlier candidates to catch up, in pipelined scans.
+ */
+@property (nonatomic, readonly) NSTimeInterval analysisBackpressureDuration;
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+
+/**
+ @return JSON in Chrome trace event format (load it in chrome://tracing or Perfetto). The scan and every candidate
+ are emitted as complete events, canonicalization and verification as nested events, and all counters as one counter
+ event at the end of the scan. Events of the analysis thread of pipelined scans are on a track of their own.
+ */
+- (nonnull NSData *)chromeTraceJSONData;
+
+@end
+
+/**
+ This macro is used across FBRetainCycleDetector to compile out statistics bookkeeping.
+ */
+#ifdef RETAIN_CYCLE_DETECTOR_STATISTICS_ENABLED
+#define _INTERNAL_RCD_STATISTICS_ENABLED RETAIN_CYCLE_DETECTOR_STATISTICS_ENABLED
+#else
+#define _INTERNAL_RCD_STATISTICS_ENABLED 0
+#endif
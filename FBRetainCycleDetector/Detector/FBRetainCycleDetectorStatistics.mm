@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBRetainCycleDetectorStatistics+Internal.h"
+
+#import <chrono>
+#import <string>
+#import <vector>
+
+namespace FB { namespace RetainCycleDetector { namespace Statistics {
+  struct TraceEvent {
+    std::string name;
+    uint64_t begin;
+    uint64_t duration;
+    // Track of the trace, 1 for the thread running the scan
+    uint32_t thread;
+  };
+
+  struct Scan {
+    uint64_t counters[FBRetainCycleDetectorCounterCount] = {};
+    uint64_t phaseDurations[FBRetainCycleDetectorPhaseCount] = {};
+    uint64_t begin = 0;
+    uint64_t duration = 0;
+    uint64_t candidateBegin = 0;
+    std::string candidateName;
+    std::vector<TraceEvent> events;
+    Scan *previous = nullptr;
+  };
+
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  static thread_local Scan *_currentScan = nullptr;
+} } }
+
+using namespace FB::RetainCycleDetector::Statistics;
+
+void FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounter counter) {
+  if (_currentScan) {
+    _currentScan->counters[counter]++;
+  }
+}
+
+void FBRetainCycleDetectorStatisticsAdd(FBRetainCycleDetectorCounter counter, uint64_t count) {
+  if (_currentScan) {
+    _currentScan->counters[counter] += count;
+  }
+}
+
+uint64_t FBRetainCycleDetectorStatisticsPhaseBegin(void) {
+  return _currentScan ? now() : 0;
+}
+
+void FBRetainCycleDetectorStatisticsPhaseEnd(FBRetainCycleDetectorPhase phase, uint64_t beginTimestamp, BOOL traced) {
+  if (!_currentScan || beginTimestamp == 0) {
+    return;
+  }
+  uint64_t duration = now() - beginTimestamp;
+  _currentScan->phaseDurations[phase] += duration;
+  if (traced) {
+    static const char *const phaseNames[FBRetainCycleDetectorPhaseCount] = {
+      "expand", "filter", "canonicalize", "verify", "snapshot pause", "analysis backpressure",
+    };
+    _currentScan->events.push_back({phaseNames[phase], beginTimestamp, duration, 1});
+  }
+}
+
+static NSTimeInterval FBTimeIntervalFromNanoseconds(uint64_t nanoseconds) {
+  return (NSTimeInterval)nanoseconds / NSEC_PER_SEC;
+}
+
+@implementation FBRetainCycleDetectorStatistics
+{
+  Scan _scan;
+}
+
+- (void)beginScan
+{
+  _scan.begin = now();
+  _scan.previous = _currentScan;
+  _currentScan = &_scan;
+}
+
+- (void)endScan
+{
+  _scan.duration = now() - _scan.begin;
+  if (_currentScan == &_scan) {
+    _currentScan = _scan.previous;
+  }
+  _scan.previous = nullptr;
+}
+
+- (void)beginCandidate:(NSString *)candidateDescription
+{
+  const char *name = [candidateDescription UTF8String];
+  _scan.candidateName = name ? name : "(null)";
+  _scan.candidateBegin = now();
+  _scan.counters[FBRetainCycleDetectorCounterCandidatesScanned]++;
+}
+
+- (void)endCandidate
+{
+  _scan.events.push_back({_scan.candidateName, _scan.candidateBegin, now() - _scan.candidateBegin, 1});
+}
+
+- (void)addStatisticsOfOtherThread:(FBRetainCycleDetectorStatistics *)statistics
+{
+  const Scan &other = statistics->_scan;
+  for (size_t i = 0; i < FBRetainCycleDetectorCounterCount; ++i) {
+    _scan.counters[i] += other.counters[i];
+  }
+  for (size_t i = 0; i < FBRetainCycleDetectorPhaseCount; ++i) {
+    _scan.phaseDurations[i] += other.phaseDurations[i];
+  }
+  for (const auto &event: other.events) {
+    _scan.events.push_back({event.name, event.begin, event.duration, event.thread + 1});
+  }
+}
+
+#pragma mark - Counters
+
+- (NSUInteger)candidatesScanned
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterCandidatesScanned];
+}
+
+- (NSUInteger)nodesVisited
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterNodesVisited];
+}
+
+- (NSUInteger)edgesExamined
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterEdgesExamined];
+}
+
+- (NSUInteger)edgesRejectedByFilters
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterEdgesRejectedByFilters];
+}
+
+- (NSUInteger)layoutCacheHits
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterLayoutCacheHits];
+}
+
+- (NSUInteger)layoutCacheMisses
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterLayoutCacheMisses];
+}
+
+- (NSUInteger)associationLookups
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterAssociationLookups];
+}
+
+- (NSUInteger)collectionEnumerationRetries
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterCollectionEnumerationRetries];
+}
+
+- (NSUInteger)swiftABIResolutions
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterSwiftABIResolutions];
+}
+
+- (NSUInteger)cyclesFound
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterCyclesFound];
+}
+
+- (NSUInteger)acyclicMemoHits
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterAcyclicMemoHits];
+}
+
+- (NSUInteger)knownCyclesSkipped
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterKnownCyclesSkipped];
+}
+
+- (NSUInteger)nodesOverMemoryLimit
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterNodesOverMemoryLimit];
+}
+
+- (NSUInteger)repeatedCyclesCounted
+{
+  return (NSUInteger)_scan.counters[FBRetainCycleDetectorCounterRepeatedCyclesCounted];
+}
+
+#pragma mark - Timings
+
+- (NSTimeInterval)expandDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseExpand]);
+}
+
+- (NSTimeInterval)filterDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseFilter]);
+}
+
+- (NSTimeInterval)canonicalizeDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseCanonicalize]);
+}
+
+- (NSTimeInterval)verifyDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseVerify]);
+}
+
+- (NSTimeInterval)snapshotPauseDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseSnapshotPause]);
+}
+
+- (NSTimeInterval)analysisBackpressureDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseAnalysisBackpressure]);
+}
+
+- (NSTimeInterval)totalDuration
+{
+  return FBTimeIntervalFromNanoseconds(_scan.duration);
+}
+
+#pragma mark - Trace
+
+- (NSData *)chromeTraceJSONData
+{
+  // Chrome trace timestamps are in microseconds
+  double (^microseconds)(uint64_t) = ^double(uint64_t nanoseconds) {
+    return (double)nanoseconds / NSEC_PER_USEC;
+  };
+  uint64_t origin = _scan.begin;
+
+  NSMutableArray *events = [NSMutableArray new];
+  [events addObject:@{@"name": @"findRetainCycles",
+                      @"ph": @"X",
+                      @"pid": @1,
+                      @"tid": @1,
+                      @"ts": @0,
+                      @"dur": @(microseconds(_scan.duration)),
+                      @"args": @{@"expand_us": @(microseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseExpand])),
+                                 @"filter_us": @(microseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseFilter])),
+                                 @"canonicalize_us": @(microseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseCanonicalize])),
+                                 @"verify_us": @(microseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseVerify])),
+                                 @"snapshot_pause_us": @(microseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseSnapshotPause])),
+                                 @"analysis_backpressure_us": @(microseconds(_scan.phaseDurations[FBRetainCycleDetectorPhaseAnalysisBackpressure]))}}];
+
+  for (const auto &event: _scan.events) {
+    NSString *name = [NSString stringWithUTF8String:event.name.c_str()] ?: @"(null)";
+    [events addObject:@{@"name": name,
+                        @"ph": @"X",
+                        @"pid": @1,
+                        @"tid": @(event.thread),
+                        @"ts": @(microseconds(event.begin - origin)),
+                        @"dur": @(microseconds(event.duration))}];
+  }
+
+  [events addObject:@{@"name": @"counters",
+                      @"ph": @"C",
+                      @"pid": @1,
+                      @"tid": @1,
+                      @"ts": @(microseconds(_scan.duration)),
+                      @"args": @{@"candidates": @(self.candidatesScanned),
+                                 @"nodes_visited": @(self.nodesVisited),
+                                 @"edges_examined": @(self.edgesExamined),
+                                 @"edges_rejected_by_filters": @(self.edgesRejectedByFilters),
+                                 @"layout_cache_hits": @(self.layoutCacheHits),
+                                 @"layout_cache_misses": @(self.layoutCacheMisses),
+                                 @"association_lookups": @(self.associationLookups),
+                                 @"collection_enumeration_retries": @(self.collectionEnumerationRetries),
+                                 @"swift_abi_resolutions": @(self.swiftABIResolutions),
+                                 @"cycles_found": @(self.cyclesFound),
+                                 @"acyclic_memo_hits": @(self.acyclicMemoHits),
+                                 @"known_cycles_skipped": @(self.knownCyclesSkipped),
+                                 @"nodes_over_memory_limit": @(self.nodesOverMemoryLimit),
+                                 @"repeated_cycles_counted": @(self.repeatedCyclesCounted)}}];
+
+  NSData *data = [NSJSONSerialization dataWithJSONObject:@{@"traceEvents": events,
+                                                           @"displayTimeUnit": @"ns"}
+                                                 options:0
+                                                   error:nil];
+  return data ?: [NSData data];
+}
+
+- (NSString *)description
+{
+  return [NSString stringWithFormat:@"<%@: candidates=%lu nodes=%lu edges=%lu rejected=%lu "
+          "layoutCache=%lu/%lu associations=%lu collectionRetries=%lu swiftABI=%lu cycles=%lu memoHits=%lu knownCycles=%lu "
+          "overMemoryLimit=%lu repeatedCycles=%lu "
+          "expand=%.3fms filter=%.3fms canonicalize=%.3fms verify=%.3fms snapshotPause=%.3fms analysisBackpressure=%.3fms total=%.3fms>",
+          NSStringFromClass([self class]),
+          (unsigned long)self.candidatesScanned,
+          (unsigned long)self.nodesVisited,
+          (unsigned long)self.edgesExamined,
+          (unsigned long)self.edgesRejectedByFilters,
+          (unsigned long)self.layoutCacheHits,
+          (unsigned long)(self.layoutCacheHits + self.layoutCacheMisses),
+          (unsigned long)self.associationLookups,
+          (unsigned long)self.collectionEnumerationRetries,
+          (unsigned long)self.swiftABIResolutions,
+          (unsigned long)self.cyclesFound,
+          (unsigned long)self.acyclicMemoHits,
+          (unsigned long)self.knownCyclesSkipped,
+          (unsigned long)self.nodesOverMemoryLimit,
+          (unsigned long)self.repeatedCyclesCounted,
+          self.expandDuration * 1000,
+          self.filterDuration * 1000,
+          self.canonicalizeDuration * 1000,
+          self.verifyDuration * 1000,
+          self.snapshotPauseDuration * 1000,
+          self.analysisBackpressureDuration * 1000,
+          self.totalDuration * 1000];
+}
+
+@end
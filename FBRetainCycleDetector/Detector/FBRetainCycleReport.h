@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FBObjectiveCGraphElement;
+
+/**
+ FBRetainCycleReport
+
+ Retain cycle together with the amount of memory it keeps alive.
+ */
+@interface FBRetainCycleReport : NSObject
+
+- (nonnull instancetype)initWithCycle:(nonnull NSArray<FBObjectiveCGraphElement *> *)cycle
+                        retainedBytes:(NSUInteger)retainedBytes
+                        instanceCount:(NSUInteger)instanceCount NS_DESIGNATED_INITIALIZER;
+
+- (nonnull instancetype)initWithCycle:(nonnull NSArray<FBObjectiveCGraphElement *> *)cycle
+                        retainedBytes:(NSUInteger)retainedBytes;
+
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/**
+ Elements of the cycle, in the same form findRetainCycles returns them.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSArray<FBObjectiveCGraphElement *> *cycle;
+
+/**
+ Memory (as reported by malloc_size) of the cycle and of all traversed objects that are reachable from candidates only
+ through the cycle. That's how much would be freed if the cycle was broken.
+
+ @discussion Only objects the detector walked through are counted, so objects deeper than maximum cycle length, memory
+ not owned by objects (like buffers of collections) and objects behind filtered out references are not included.
+ Cycles sharing objects report the memory retained by all of them together.
+ */
+@property (nonatomic, readonly) NSUInteger retainedBytes;
+
+/**
+ How many instances of cycles with the same signature the scan found, this one included. Instances only counted
+ because of repeatedCycleInstanceLimit are not reported on their own, and their memory is not part of retainedBytes.
+
+ @see FBRetainCycleDetector repeatedCycleInstanceLimit
+ */
+@property (nonatomic, readonly) NSUInteger instanceCount;
+
+@end
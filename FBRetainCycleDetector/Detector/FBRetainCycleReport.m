@@ -0,0 +1,41 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBRetainCycleReport.h"
+
+@implementation FBRetainCycleReport
+
+- (instancetype)initWithCycle:(NSArray<FBObjectiveCGraphElement *> *)cycle
+                retainedBytes:(NSUInteger)retainedBytes
+                instanceCount:(NSUInteger)instanceCount
+{
+  if (self = [super init]) {
+    _cycle = [cycle copy];
+    _retainedBytes = retainedBytes;
+    _instanceCount = instanceCount;
+  }
+
+  return self;
+}
+
+- (instancetype)initWithCycle:(NSArray<FBObjectiveCGraphElement *> *)cycle
+                retainedBytes:(NSUInteger)retainedBytes
+{
+  return [self initWithCycle:cycle retainedBytes:retainedBytes instanceCount:1];
+}
+
+- (NSString *)description
+{
+  return [NSString stringWithFormat:@"<%@: %lu bytes, %lu instances, %@>",
+          NSStringFromClass([self class]),
+          (unsigned long)_retainedBytes,
+          (unsigned long)_instanceCount,
+          _cycle];
+}
+
+@end
@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FBObjectiveCGraphElement;
+
+/**
+ FBRetainCycleSerializer
+
+ Turns retain cycles into a compact binary payload, meant for uploading them. Class names, block names and names from
+ name paths are written once into a shared string table and cycles refer to them by index, so payloads stay small
+ even when the same classes show up in many cycles. Every cycle also carries its signature.
+
+ The format is described in FBCompactCycleEncoding.h, which can decode it on any platform.
+ @see FBGetRetainCycleSignature
+ */
+@interface FBRetainCycleSerializer : NSObject
+
+/**
+ @param retainCycles Collection of cycles as returned by findRetainCycles (set or array of arrays of elements).
+ */
++ (nonnull NSData *)dataWithRetainCycles:(nonnull id<NSFastEnumeration>)retainCycles;
+
+/**
+ Decodes a payload back into descriptions of elements, formatted exactly as -[FBObjectiveCGraphElement description].
+
+ @return Array of cycles, each of them being an array of element descriptions, or nil if data is not a valid payload.
+ */
++ (nullable NSArray<NSArray<NSString *> *> *)cycleDescriptionsWithData:(nonnull NSData *)data;
+
+@end
@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBRetainCycleSerializer.h"
+
+#import <objc/runtime.h>
+#import <unordered_map>
+
+#import "FBCompactCycleEncoding.h"
+#import "FBObjectiveCGraphElement.h"
+#import "FBRetainCycleSignatureStore.h"
+
+/**
+ Class names of most elements only depend on their class, so they are looked up (and demangled) once per class.
+ Elements that override classNameOrNull (blocks, which append their code address) or objects that describe
+ themselves with customClassDescription are asked every time.
+ */
+static BOOL FBClassNameDependsOnClassOnly(FBObjectiveCGraphElement *element, IMP baseImplementation)
+{
+  if ([element methodForSelector:@selector(classNameOrNull)] != baseImplementation) {
+    return NO;
+  }
+  id object = element.object;
+  static SEL customClassDescriptionSelector = sel_registerName("customClassDescription");
+  return !object || [object isProxy] || ![object respondsToSelector:customClassDescriptionSelector];
+}
+
+static uint32_t FBInternString(FB::RetainCycleDetector::CompactCycleWriter &writer, NSString *string)
+{
+  const char *bytes = [string UTF8String] ?: "";
+  return writer.internString(bytes, strlen(bytes));
+}
+
+@implementation FBRetainCycleSerializer
+
++ (NSData *)dataWithRetainCycles:(id<NSFastEnumeration>)retainCycles
+{
+  FB::RetainCycleDetector::CompactCycleWriter writer;
+  std::unordered_map<uintptr_t, uint32_t> classNameIndices;
+  IMP baseClassNameImplementation = [FBObjectiveCGraphElement instanceMethodForSelector:@selector(classNameOrNull)];
+
+  for (NSArray<FBObjectiveCGraphElement *> *retainCycle in retainCycles) {
+    FB::RetainCycleDetector::CompactCycle cycle = {FBGetRetainCycleSignature(retainCycle), {}};
+    cycle.elements.reserve([retainCycle count]);
+
+    for (FBObjectiveCGraphElement *element in retainCycle) {
+      FB::RetainCycleDetector::CompactCycleElement compactElement;
+      if (FBClassNameDependsOnClassOnly(element, baseClassNameImplementation)) {
+        uintptr_t aCls = (uintptr_t)[element objectClass];
+        auto classNameIndex = classNameIndices.find(aCls);
+        if (classNameIndex == classNameIndices.end()) {
+          classNameIndex = classNameIndices.emplace(aCls, FBInternString(writer, [element classNameOrNull])).first;
+        }
+        compactElement.className = classNameIndex->second;
+      } else {
+        compactElement.className = FBInternString(writer, [element classNameOrNull]);
+      }
+
+      NSArray<NSString *> *namePath = [element namePath];
+      compactElement.namePath.reserve([namePath count]);
+      for (NSString *name in namePath) {
+        compactElement.namePath.push_back(FBInternString(writer, name));
+      }
+      cycle.elements.push_back(std::move(compactElement));
+    }
+    writer.addCycle(cycle);
+  }
+
+  std::vector<uint8_t> data = writer.finish();
+  return [NSData dataWithBytes:data.data() length:data.size()];
+}
+
++ (NSArray<NSArray<NSString *> *> *)cycleDescriptionsWithData:(NSData *)data
+{
+  FB::RetainCycleDetector::CompactCycleReader reader;
+  if (!reader.read((const uint8_t *)[data bytes], [data length])) {
+    return nil;
+  }
+
+  NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:reader.strings().size()];
+  for (const auto &string: reader.strings()) {
+    [strings addObject:[[NSString alloc] initWithBytes:string.data()
+                                                length:string.size()
+                                              encoding:NSUTF8StringEncoding] ?: @"(null)"];
+  }
+
+  NSMutableArray<NSArray<NSString *> *> *cycles = [NSMutableArray arrayWithCapacity:reader.cycles().size()];
+  for (const auto &cycle: reader.cycles()) {
+    NSMutableArray<NSString *> *descriptions = [NSMutableArray arrayWithCapacity:cycle.elements.size()];
+    for (const auto &element: cycle.elements) {
+      if (element.namePath.empty()) {
+        [descriptions addObject:[NSString stringWithFormat:@"-> %@ ", strings[element.className]]];
+        continue;
+      }
+      NSMutableArray<NSString *> *namePath = [NSMutableArray arrayWithCapacity:element.namePath.size()];
+      for (uint32_t name: element.namePath) {
+        [namePath addObject:strings[name]];
+      }
+      [descriptions addObject:[NSString stringWithFormat:@"-> %@ -> %@ ",
+                               [namePath componentsJoinedByString:@" -> "],
+                               strings[element.className]]];
+    }
+    [cycles addObject:descriptions];
+  }
+  return cycles;
+}
+
+@end
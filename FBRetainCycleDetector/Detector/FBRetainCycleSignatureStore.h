@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FBObjectiveCGraphElement;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ Stable 64-bit signature of a retain cycle, computed from class names and name paths of its elements. It doesn't
+ depend on object addresses nor on which element the cycle starts with, so the same leak has the same signature
+ across scans and app launches.
+ */
+uint64_t FBGetRetainCycleSignature(NSArray<FBObjectiveCGraphElement *> *_Nonnull cycle);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ FBRetainCycleSignatureStore
+
+ Set of signatures of retain cycles that were already reported, optionally persisted to a file so it survives app
+ launches. Give it to the detector to skip cycles it already knows about.
+
+ The class is thread safe.
+ @see FBRetainCycleDetector knownCycleSignatures
+ */
+@interface FBRetainCycleSignatureStore : NSObject
+
+/**
+ Designated initializer
+
+ @param fileURL File signatures are loaded from and saved to. Every change is written through to it. If nil, the
+ store lives only in memory.
+ */
+- (nonnull instancetype)initWithFileURL:(nullable NSURL *)fileURL NS_DESIGNATED_INITIALIZER;
+
+- (BOOL)containsSignature:(uint64_t)signature;
+
+/**
+ @return YES if signature wasn't in the store yet
+ */
+- (BOOL)addSignature:(uint64_t)signature;
+
+/**
+ Adds all signatures and writes the file at most once.
+
+ @return number of signatures that weren't in the store yet
+ */
+- (NSUInteger)addSignatures:(nonnull NSArray<NSNumber *> *)signatures;
+
+- (void)removeAllSignatures;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+@end
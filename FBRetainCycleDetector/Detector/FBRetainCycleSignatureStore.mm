@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBRetainCycleSignatureStore.h"
+
+#import <mutex>
+#import <objc/runtime.h>
+#import <unordered_set>
+#import <vector>
+
+#import "FBCycleSignature.h"
+#import "FBObjectiveCGraphElement.h"
+
+// "RCDS" when read as little endian
+static const uint32_t kFBRetainCycleSignatureStoreMagic = 0x53444352;
+static const uint32_t kFBRetainCycleSignatureStoreVersion = 1;
+// Keeps the file small even if something reports a new "leak" on every scan
+static const NSUInteger kFBRetainCycleSignatureStoreMaxCount = 1 << 16;
+
+uint64_t FBGetRetainCycleSignature(NSArray<FBObjectiveCGraphElement *> *cycle)
+{
+  std::vector<uint64_t> elementSignatures;
+  elementSignatures.reserve([cycle count]);
+  for (FBObjectiveCGraphElement *element in cycle) {
+    FB::RetainCycleDetector::ElementSignature signature;
+    // Runtime name, not classNameOrNull, which demangles and can be customized by the object
+    Class aCls = [element objectClass];
+    signature.addString(aCls ? class_getName(aCls) : "(null)");
+    for (NSString *name in [element namePath]) {
+      signature.addString([name UTF8String]);
+    }
+    elementSignatures.push_back(signature.value());
+  }
+  return FB::RetainCycleDetector::cycleSignature(elementSignatures.data(), elementSignatures.size());
+}
+
+@implementation FBRetainCycleSignatureStore
+{
+  NSURL *_fileURL;
+  std::mutex _mutex;
+  std::unordered_set<uint64_t> _signatures;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+{
+  if (self = [super init]) {
+    _fileURL = [fileURL copy];
+    [self _load];
+  }
+
+  return self;
+}
+
+- (instancetype)init
+{
+  return [self initWithFileURL:nil];
+}
+
+- (BOOL)containsSignature:(uint64_t)signature
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  return _signatures.count(signature) > 0;
+}
+
+- (BOOL)addSignature:(uint64_t)signature
+{
+  return [self addSignatures:@[@(signature)]] > 0;
+}
+
+- (NSUInteger)addSignatures:(NSArray<NSNumber *> *)signatures
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  NSUInteger added = 0;
+  for (NSNumber *signature in signatures) {
+    if (_signatures.size() >= kFBRetainCycleSignatureStoreMaxCount) {
+      break;
+    }
+    if (_signatures.insert([signature unsignedLongLongValue]).second) {
+      added++;
+    }
+  }
+  if (added > 0) {
+    [self _save];
+  }
+  return added;
+}
+
+- (void)removeAllSignatures
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  _signatures.clear();
+  [self _save];
+}
+
+- (NSUInteger)count
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  return _signatures.size();
+}
+
+#pragma mark - File
+
+/**
+ File is a 4 byte magic, 4 byte version and then signatures, all little endian. Anything that doesn't look right is
+ ignored and the store starts empty.
+ */
+- (void)_load
+{
+  if (!_fileURL) {
+    return;
+  }
+  NSData *data = [NSData dataWithContentsOfURL:_fileURL];
+  const size_t headerSize = 2 * sizeof(uint32_t);
+  if ([data length] < headerSize || ([data length] - headerSize) % sizeof(uint64_t) != 0) {
+    return;
+  }
+
+  const uint8_t *bytes = (const uint8_t *)[data bytes];
+  uint32_t header[2];
+  memcpy(header, bytes, headerSize);
+  if (CFSwapInt32LittleToHost(header[0]) != kFBRetainCycleSignatureStoreMagic ||
+      CFSwapInt32LittleToHost(header[1]) != kFBRetainCycleSignatureStoreVersion) {
+    return;
+  }
+
+  const size_t count = ([data length] - headerSize) / sizeof(uint64_t);
+  _signatures.reserve(count);
+  for (size_t i = 0; i < count && _signatures.size() < kFBRetainCycleSignatureStoreMaxCount; ++i) {
+    uint64_t signature;
+    memcpy(&signature, bytes + headerSize + i * sizeof(uint64_t), sizeof(signature));
+    _signatures.insert(CFSwapInt64LittleToHost(signature));
+  }
+}
+
+- (void)_save
+{
+  if (!_fileURL) {
+    return;
+  }
+  NSMutableData *data = [NSMutableData dataWithCapacity:2 * sizeof(uint32_t) + _signatures.size() * sizeof(uint64_t)];
+  uint32_t header[2] = {
+    CFSwapInt32HostToLittle(kFBRetainCycleSignatureStoreMagic),
+    CFSwapInt32HostToLittle(kFBRetainCycleSignatureStoreVersion),
+  };
+  [data appendBytes:header length:sizeof(header)];
+  for (uint64_t signature: _signatures) {
+    uint64_t littleEndian = CFSwapInt64HostToLittle(signature);
+    [data appendBytes:&littleEndian length:sizeof(littleEndian)];
+  }
+  [data writeToURL:_fileURL atomically:YES];
+}
+
+@end
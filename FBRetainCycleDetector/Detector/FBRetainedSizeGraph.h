@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBRetainedSizeGraph_h
+#define FBRetainedSizeGraph_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FBDominatorTree.h"
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Records the object graph as the detector traverses it, and attributes retained memory to retain cycles found in
+   it. Objects are identified by address, address 0 is ignored.
+   */
+  class RetainedSizeGraph {
+  public:
+    /**
+     Object traversal started from (candidate).
+     */
+    void addRoot(size_t address) {
+      if (address) {
+        _roots.push_back(_indexOfNode(address));
+      }
+    }
+
+    void addNode(size_t address, uint64_t size) {
+      if (address) {
+        _sizes[_indexOfNode(address)] = size;
+      }
+    }
+
+    void addEdge(size_t fromAddress, size_t toAddress) {
+      if (fromAddress && toAddress) {
+        _edges.emplace_back(_indexOfNode(fromAddress), _indexOfNode(toAddress));
+      }
+    }
+
+    /**
+     Memory retained by each cycle is the memory that would be freed if nothing outside of the cycle referenced it,
+     that is every object reachable from candidates only through the cycle. We get it for all cycles with a single
+     dominator tree: every incoming edge from outside of a cycle is replaced by one edge from a virtual root to a
+     virtual node representing the cycle, and that node points to all cycle members.
+
+     Cycles sharing objects can't be told apart, so they are merged and each of them reports the memory retained by
+     all of them together.
+
+     @return retained size for every cycle, in the order they were passed in
+     */
+    std::vector<uint64_t> retainedSizesOfCycles(const std::vector<std::vector<size_t>> &cycles) const {
+      const uint32_t objectCount = (uint32_t)_sizes.size();
+
+      // Merge cycles sharing objects
+      std::vector<uint32_t> cycleGroups(cycles.size());
+      std::iota(cycleGroups.begin(), cycleGroups.end(), 0);
+      auto findGroup = [&cycleGroups](uint32_t cycle) {
+        while (cycleGroups[cycle] != cycle) {
+          cycleGroups[cycle] = cycleGroups[cycleGroups[cycle]];
+          cycle = cycleGroups[cycle];
+        }
+        return cycle;
+      };
+      std::vector<uint32_t> objectCycles(objectCount, (uint32_t)DominatorTree::kNoNode);
+      for (uint32_t cycle = 0; cycle < cycles.size(); ++cycle) {
+        for (size_t address: cycles[cycle]) {
+          auto node = _indices.find(address);
+          if (node == _indices.end()) {
+            continue;
+          }
+          uint32_t &objectCycle = objectCycles[node->second];
+          if (objectCycle == DominatorTree::kNoNode) {
+            objectCycle = cycle;
+          } else {
+            cycleGroups[findGroup(cycle)] = findGroup(objectCycle);
+          }
+        }
+      }
+      for (uint32_t &objectCycle: objectCycles) {
+        if (objectCycle != DominatorTree::kNoNode) {
+          objectCycle = findGroup(objectCycle);
+        }
+      }
+
+      // Node 0 is the virtual root, objects follow, then one node for each group of cycles
+      const uint32_t firstObjectNode = 1;
+      const uint32_t firstCycleNode = firstObjectNode + objectCount;
+      const uint32_t nodeCount = firstCycleNode + (uint32_t)cycles.size();
+      auto cycleOfNode = [&](uint32_t node) {
+        return (node >= firstObjectNode && node < firstCycleNode) ?
+          objectCycles[node - firstObjectNode] : DominatorTree::kNoNode;
+      };
+
+      std::vector<std::pair<uint32_t, uint32_t>> edges;
+      edges.reserve(_edges.size() + _roots.size() + objectCount);
+      for (uint32_t root: _roots) {
+        edges.emplace_back(0, firstObjectNode + root);
+      }
+      for (const auto &edge: _edges) {
+        edges.emplace_back(firstObjectNode + edge.first, firstObjectNode + edge.second);
+      }
+      for (uint32_t object = 0; object < objectCount; ++object) {
+        if (objectCycles[object] != DominatorTree::kNoNode) {
+          edges.emplace_back(firstCycleNode + objectCycles[object], firstObjectNode + object);
+        }
+      }
+      for (uint32_t cycle = 0; cycle < cycles.size(); ++cycle) {
+        if (findGroup(cycle) == cycle) {
+          edges.emplace_back(0, firstCycleNode + cycle);
+        }
+      }
+
+      std::vector<uint32_t> edgeOffsets(nodeCount + 1, 0);
+      for (const auto &edge: edges) {
+        uint32_t targetCycle = cycleOfNode(edge.second);
+        if (edge.first < firstCycleNode &&
+            targetCycle != DominatorTree::kNoNode &&
+            cycleOfNode(edge.first) != targetCycle) {
+          // Incoming edge from outside of the cycle
+          continue;
+        }
+        edgeOffsets[edge.first + 1]++;
+      }
+      for (uint32_t node = 0; node < nodeCount; ++node) {
+        edgeOffsets[node + 1] += edgeOffsets[node];
+      }
+      std::vector<uint32_t> edgeTargets(edgeOffsets[nodeCount]);
+      std::vector<uint32_t> fill(edgeOffsets.begin(), edgeOffsets.end() - 1);
+      for (const auto &edge: edges) {
+        uint32_t targetCycle = cycleOfNode(edge.second);
+        if (edge.first < firstCycleNode &&
+            targetCycle != DominatorTree::kNoNode &&
+            cycleOfNode(edge.first) != targetCycle) {
+          continue;
+        }
+        edgeTargets[fill[edge.first]++] = edge.second;
+      }
+
+      std::vector<uint64_t> shallowSizes(nodeCount, 0);
+      std::copy(_sizes.begin(), _sizes.end(), shallowSizes.begin() + firstObjectNode);
+
+      DominatorTree dominatorTree(edgeOffsets, edgeTargets, 0);
+      std::vector<uint64_t> retainedSizes = dominatorTree.retainedSizes(shallowSizes);
+
+      std::vector<uint64_t> cycleSizes(cycles.size(), 0);
+      for (uint32_t cycle = 0; cycle < cycles.size(); ++cycle) {
+        cycleSizes[cycle] = retainedSizes[firstCycleNode + findGroup(cycle)];
+      }
+      return cycleSizes;
+    }
+
+  private:
+    uint32_t _indexOfNode(size_t address) {
+      auto inserted = _indices.emplace(address, (uint32_t)_sizes.size());
+      if (inserted.second) {
+        _sizes.push_back(0);
+      }
+      return inserted.first->second;
+    }
+
+    std::unordered_map<size_t, uint32_t> _indices;
+    std::vector<uint64_t> _sizes;
+    std::vector<std::pair<uint32_t, uint32_t>> _edges;
+    std::vector<uint32_t> _roots;
+  };
+} }
+
+#endif /* FBRetainedSizeGraph_h */
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBScanCostModel_h
+#define FBScanCostModel_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Decides how much scanning we can afford without spending more CPU time than the budget in any minute.
+
+   Cost of a single candidate is learned for every maximum cycle length, as an exponentially weighted moving average
+   of past scans. Scans are paced with a token bucket refilled at budget / 60 per second, so the budget is spread
+   evenly instead of being spent at the start of every minute. Sample rate is then set so that the expected number of
+   sampled candidates fits into the budget; when that's not possible even at the lowest sample rate, cycle length is
+   lowered, and when everything fits at the highest one, it's raised again.
+
+   Time is passed in explicitly (in seconds), so the model is deterministic and easy to test.
+   */
+  class ScanCostModel {
+  public:
+    struct Plan {
+      size_t candidateCount;
+      size_t maxCycleLength;
+    };
+
+    ScanCostModel(double cpuSecondsPerMinute,
+                  size_t minCycleLength,
+                  size_t maxCycleLength,
+                  double minSampleRate,
+                  double maxSampleRate)
+    : _budget(std::max(cpuSecondsPerMinute, 0.0)),
+      _minCycleLength(std::max<size_t>(minCycleLength, 1)),
+      _maxCycleLength(std::max(maxCycleLength, std::max<size_t>(minCycleLength, 1))),
+      _minSampleRate(minSampleRate),
+      _maxSampleRate(std::max(minSampleRate, maxSampleRate)),
+      _sampleRate(_maxSampleRate),
+      _cycleLength(_maxCycleLength),
+      _costPerCandidate(_maxCycleLength + 1, 0),
+      _allowance(_budget * kBurst) {}
+
+    /**
+     @return how many of the pending candidates to scan now, and with what maximum cycle length
+     */
+    Plan plan(double now, size_t pendingCandidates) {
+      if (_lastPlan >= 0 && now > _lastPlan) {
+        _allowance = std::min(_budget * kBurst, _allowance + (now - _lastPlan) * _budget / 60);
+      }
+      _lastPlan = now;
+
+      double available = std::min(_budget - spentInLastMinute(now), _allowance);
+      if (pendingCandidates == 0 || available <= 0) {
+        return {0, _cycleLength};
+      }
+
+      for (size_t length = _cycleLength; length >= _minCycleLength; --length) {
+        double cost = estimatedCostPerCandidate(length);
+        if (cost <= 0) {
+          // Nothing known yet, probe with a single candidate
+          return {1, length};
+        }
+        size_t affordable = (size_t)std::floor(available / cost);
+        if (affordable > 0) {
+          return {std::min(affordable, pendingCandidates), length};
+        }
+        if (length == _minCycleLength) {
+          break;
+        }
+      }
+      return {0, _minCycleLength};
+    }
+
+    /**
+     Records the outcome of a scan planned with plan(), and adapts sample rate and cycle length for the next ones.
+
+     @param sampledCandidates how many candidates were sampled since the previous scan
+     */
+    void record(double now,
+                const Plan &plan,
+                double cpuSeconds,
+                size_t sampledCandidates) {
+      if (plan.candidateCount > 0) {
+        _spent.emplace_back(now, cpuSeconds);
+        _allowance -= cpuSeconds;
+        double cost = cpuSeconds / plan.candidateCount;
+        double &average = _costPerCandidate[std::min(plan.maxCycleLength, _maxCycleLength)];
+        average = (average > 0) ? average + kSmoothing * (cost - average) : cost;
+      }
+
+      if (_lastRecord >= 0 && now > _lastRecord && _sampleRate > 0) {
+        double offersPerSecond = sampledCandidates / _sampleRate / (now - _lastRecord);
+        _offersPerSecond = (_offersPerSecond > 0) ?
+          _offersPerSecond + kSmoothing * (offersPerSecond - _offersPerSecond) : offersPerSecond;
+      }
+      _lastRecord = now;
+
+      _adapt();
+    }
+
+    double spentInLastMinute(double now) {
+      while (!_spent.empty() && _spent.front().first <= now - 60) {
+        _spent.pop_front();
+      }
+      double spent = 0;
+      for (const auto &entry: _spent) {
+        spent += entry.second;
+      }
+      return spent;
+    }
+
+    /**
+     Predicted CPU seconds needed to scan one candidate. Lengths we didn't scan with yet are extrapolated from the
+     nearest one we did, assuming the cost doubles with every extra step. Returns 0 if nothing is known.
+     */
+    double estimatedCostPerCandidate(size_t length) const {
+      length = std::min(length, _maxCycleLength);
+      if (_costPerCandidate[length] > 0) {
+        return _costPerCandidate[length];
+      }
+      for (size_t distance = 1; distance <= _maxCycleLength; ++distance) {
+        if (length >= distance && _costPerCandidate[length - distance] > 0) {
+          return _costPerCandidate[length - distance] * std::pow(2.0, (double)distance);
+        }
+        if (length + distance <= _maxCycleLength && _costPerCandidate[length + distance] > 0) {
+          return _costPerCandidate[length + distance] / std::pow(2.0, (double)distance);
+        }
+      }
+      return 0;
+    }
+
+    double sampleRate() const {
+      return _sampleRate;
+    }
+
+    size_t cycleLength() const {
+      return _cycleLength;
+    }
+
+  private:
+    static constexpr double kSmoothing = 0.3;
+    // Fraction of the budget we aim to use, leaves room for noise in the estimates
+    static constexpr double kHeadroom = 0.8;
+    // Fraction of the budget a single scan can use
+    static constexpr double kBurst = 0.25;
+
+    void _adapt() {
+      double cost = estimatedCostPerCandidate(_cycleLength);
+      if (cost <= 0 || _offersPerSecond <= 0) {
+        return;
+      }
+      double affordablePerSecond = kHeadroom * _budget / 60;
+      double sampleRate = affordablePerSecond / cost / _offersPerSecond;
+      if (sampleRate < _minSampleRate && _cycleLength > _minCycleLength) {
+        _cycleLength--;
+      } else if (sampleRate >= _maxSampleRate &&
+                 _cycleLength < _maxCycleLength &&
+                 estimatedCostPerCandidate(_cycleLength + 1) * _offersPerSecond * _maxSampleRate <= affordablePerSecond) {
+        _cycleLength++;
+      }
+      _sampleRate = std::max(_minSampleRate, std::min(_maxSampleRate, sampleRate));
+    }
+
+    double _budget;
+    size_t _minCycleLength;
+    size_t _maxCycleLength;
+    double _minSampleRate;
+    double _maxSampleRate;
+    double _sampleRate;
+    size_t _cycleLength;
+    std::vector<double> _costPerCandidate;
+    std::deque<std::pair<double, double>> _spent;
+    double _allowance;
+    double _offersPerSecond = 0;
+    double _lastPlan = -1;
+    double _lastRecord = -1;
+  };
+} }
+
+#endif /* FBScanCostModel_h */
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBTimingWheel_h
+#define FBTimingWheel_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Unbounded inbox that any number of threads can push values to, drained by one consumer at a time. Linking values in
+   and draining them is lock-free, allocating nodes is up to the allocator.
+
+   It's a Treiber stack: push allocates a node and links it in with a compare-and-swap, drain takes the whole stack with
+   a single exchange and hands values over oldest first. Since nodes are never popped one by one, there is no ABA
+   problem to worry about.
+   */
+  template <typename T>
+  class RegistrationInbox {
+  public:
+    RegistrationInbox() = default;
+    RegistrationInbox(const RegistrationInbox &) = delete;
+    RegistrationInbox &operator=(const RegistrationInbox &) = delete;
+
+    ~RegistrationInbox() {
+      drain([](T &&) {});
+    }
+
+    void push(T value) {
+      Node *node = new Node{std::move(value), _head.load(std::memory_order_relaxed)};
+      while (!_head.compare_exchange_weak(node->next, node, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      }
+    }
+
+    /**
+     Calls callback with every value pushed since the previous drain, oldest first.
+
+     @return number of values drained.
+     */
+    template <typename Callback>
+    size_t drain(Callback &&callback) {
+      Node *node = _head.exchange(nullptr, std::memory_order_acquire);
+      Node *oldest = nullptr;
+      while (node) {
+        Node *next = node->next;
+        node->next = oldest;
+        oldest = node;
+        node = next;
+      }
+      size_t count = 0;
+      while (oldest) {
+        Node *next = oldest->next;
+        callback(std::move(oldest->value));
+        delete oldest;
+        oldest = next;
+        count++;
+      }
+      return count;
+    }
+
+    /**
+     Sequentially consistent, so that a consumer going idle and then checking for values doesn't miss a producer that
+     pushed a value and then checked whether the consumer is idle.
+     */
+    bool empty() const {
+      return _head.load() == nullptr;
+    }
+
+  private:
+    struct Node {
+      T value;
+      Node *next;
+    };
+
+    std::atomic<Node *> _head{nullptr};
+  };
+
+  /**
+   Hierarchical timing wheel, holding values until their deadline, in ticks, has passed.
+
+   Every level has 64 slots, a slot of level L covering 64^L ticks. A value is kept at the lowest level whose slots
+   are wide enough to hold its deadline together with the current tick, and is moved down a level every time the
+   wheel below wraps around. Scheduling is constant time, and advancing the wheel touches only values that are due,
+   or are moved one level closer to being due, no matter how many are waiting. Stretches of ticks in which nothing
+   can happen are skipped, so a wheel left alone for hours catches up quickly.
+
+   Not thread safe, the wheel belongs to a single consumer.
+   */
+  template <typename T>
+  class TimingWheel {
+  public:
+    explicit TimingWheel(uint64_t currentTick = 0)
+    : _currentTick(currentTick) {}
+
+    /**
+     @param deadline Tick after which the value is due. Values already due fire on the next advance.
+     */
+    void schedule(T value, uint64_t deadline) {
+      _place(std::move(value), deadline > _currentTick ? deadline : _currentTick + 1);
+      _count++;
+    }
+
+    /**
+     Moves the wheel to given tick, calling callback with every value due by then, earliest deadlines first.
+     */
+    template <typename Callback>
+    void advance(uint64_t tick, Callback &&callback) {
+      while (_currentTick < tick) {
+        if (_count == 0) {
+          // Nothing to cascade or fire on the way
+          _currentTick = tick;
+          break;
+        }
+        // Nothing happens until the lowest level holding values moves some of them down
+        size_t lowestLevel = 0;
+        while (_levelCounts[lowestLevel] == 0) {
+          lowestLevel++;
+        }
+        if (lowestLevel > 0) {
+          const uint64_t quietUntil = _currentTick | ((1ULL << (kSlotBits * lowestLevel)) - 1);
+          if (quietUntil >= tick) {
+            _currentTick = tick;
+            break;
+          }
+          _currentTick = quietUntil;
+        }
+        _currentTick++;
+        for (size_t level = kLevelCount - 1; level > 0; --level) {
+          if ((_currentTick & ((1ULL << (kSlotBits * level)) - 1)) == 0) {
+            _cascade(level);
+          }
+        }
+        std::vector<Entry> due;
+        due.swap(_slots[0][_currentTick & kSlotMask]);
+        _count -= due.size();
+        _levelCounts[0] -= due.size();
+        for (Entry &entry: due) {
+          callback(std::move(entry.value));
+        }
+      }
+    }
+
+    size_t count() const {
+      return _count;
+    }
+
+    uint64_t currentTick() const {
+      return _currentTick;
+    }
+
+  private:
+    static const size_t kSlotBits = 6;
+    static const size_t kSlotCount = 1 << kSlotBits;
+    static const uint64_t kSlotMask = kSlotCount - 1;
+    static const size_t kLevelCount = 4;
+
+    struct Entry {
+      T value;
+      uint64_t deadline;
+    };
+
+    void _place(T value, uint64_t deadline) {
+      size_t level = 0;
+      while (level < kLevelCount - 1 &&
+             (deadline >> (kSlotBits * (level + 1))) != (_currentTick >> (kSlotBits * (level + 1)))) {
+        level++;
+      }
+      // Deadlines too far away for the top level go around it more than once, and are placed again every time
+      _slots[level][(deadline >> (kSlotBits * level)) & kSlotMask].push_back({std::move(value), deadline});
+      _levelCounts[level]++;
+    }
+
+    void _cascade(size_t level) {
+      std::vector<Entry> entries;
+      entries.swap(_slots[level][(_currentTick >> (kSlotBits * level)) & kSlotMask]);
+      _levelCounts[level] -= entries.size();
+      for (Entry &entry: entries) {
+        _place(std::move(entry.value), entry.deadline);
+      }
+    }
+
+    std::vector<Entry> _slots[kLevelCount][kSlotCount];
+    uint64_t _currentTick;
+    size_t _levelCounts[kLevelCount] = {};
+    size_t _count = 0;
+  };
+} }
+
+#endif /* FBTimingWheel_h */
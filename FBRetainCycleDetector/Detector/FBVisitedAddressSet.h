@@ -0,0 +1,275 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBVisitedAddressSet_h
+#define FBVisitedAddressSet_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Set of object addresses visited during a scan, with a hard limit on the memory it can use.
+
+   Heap objects are 16 byte aligned, so an address is stored as a single bit of address >> 4. Bits are split in pages
+   of 32768, each covering 512kB of address space. Like in roaring bitmaps, a page starts as a sorted array of 16 bit
+   offsets and turns into a 4kB bitmap once that would be smaller, so both sparse and dense regions of the heap
+   take at most 2 bytes per object. Unaligned addresses, which never come from malloc, are kept aside in a hash set.
+
+   Once the limit is reached, addresses that would need more memory are not inserted, and insert says so, so the
+   scan can stop going deeper instead of growing without bound.
+   */
+  class VisitedAddressSet {
+  public:
+    enum class InsertResult {
+      Inserted,
+      AlreadyPresent,
+      OverMemoryLimit,
+    };
+
+    explicit VisitedAddressSet(size_t memoryLimit = std::numeric_limits<size_t>::max())
+    : _memoryLimit(memoryLimit) {}
+
+    InsertResult insert(size_t address) {
+      if (address & kAlignmentMask) {
+        if (_unalignedAddresses.count(address)) {
+          return InsertResult::AlreadyPresent;
+        }
+        if (!_reserve(kUnalignedEntrySize)) {
+          return InsertResult::OverMemoryLimit;
+        }
+        _unalignedAddresses.insert(address);
+        _count++;
+        return InsertResult::Inserted;
+      }
+
+      uint64_t key = (uint64_t)address >> kAlignmentShift;
+      uint64_t pageNumber = key >> kPageShift;
+      uint16_t offset = (uint16_t)(key & kPageMask);
+
+      Page *page = _findPage(pageNumber);
+      if (!page) {
+        if (!_reserve(sizeof(Page) + _slotTableGrowth())) {
+          return InsertResult::OverMemoryLimit;
+        }
+        page = _addPage(pageNumber);
+      }
+
+      InsertResult result = page->bitmap ? _insertIntoBitmap(*page, offset) : _insertIntoArray(*page, offset);
+      if (result == InsertResult::Inserted) {
+        _count++;
+      }
+      return result;
+    }
+
+    bool contains(size_t address) const {
+      if (address & kAlignmentMask) {
+        return _unalignedAddresses.count(address) > 0;
+      }
+      uint64_t key = (uint64_t)address >> kAlignmentShift;
+      const Page *page = _findPage(key >> kPageShift);
+      if (!page) {
+        return false;
+      }
+      uint16_t offset = (uint16_t)(key & kPageMask);
+      if (page->bitmap) {
+        return (page->bitmap[offset >> 6] >> (offset & 63)) & 1;
+      }
+      return std::binary_search(page->offsets.get(), page->offsets.get() + page->offsetCount, offset);
+    }
+
+    void clear() {
+      _pages.clear();
+      _slots.clear();
+      _unalignedAddresses.clear();
+      _lastPage = kNoPage;
+      _count = 0;
+      _memoryUsage = 0;
+    }
+
+    size_t count() const {
+      return _count;
+    }
+
+    /**
+     Memory taken by pages and lookup tables, which is what the limit is compared against. Allocator overhead is
+     not included.
+     */
+    size_t memoryUsage() const {
+      return _memoryUsage;
+    }
+
+    size_t memoryLimit() const {
+      return _memoryLimit;
+    }
+
+  private:
+    static const unsigned kAlignmentShift = 4;
+    static const size_t kAlignmentMask = (1 << kAlignmentShift) - 1;
+    static const unsigned kPageShift = 15;
+    static const uint64_t kPageMask = (1 << kPageShift) - 1;
+    static const size_t kBitmapWords = (1 << kPageShift) / 64;
+    static const size_t kBitmapSize = kBitmapWords * sizeof(uint64_t);
+    // Past this many offsets an array takes as much memory as a bitmap
+    static const uint32_t kMaximumArrayCount = kBitmapSize / sizeof(uint16_t);
+    static const uint32_t kMinimumArrayCapacity = 4;
+    static const size_t kUnalignedEntrySize = 4 * sizeof(void *);
+    static const uint32_t kNoPage = std::numeric_limits<uint32_t>::max();
+
+    struct Page {
+      uint64_t number;
+      std::unique_ptr<uint16_t[]> offsets;
+      uint32_t offsetCount;
+      uint32_t offsetCapacity;
+      std::unique_ptr<uint64_t[]> bitmap;
+    };
+
+    struct Slot {
+      uint64_t pageNumber;
+      uint32_t pageIndex;
+    };
+
+    bool _reserve(size_t bytes) {
+      if (bytes > _memoryLimit - std::min(_memoryUsage, _memoryLimit)) {
+        return false;
+      }
+      _memoryUsage += bytes;
+      return true;
+    }
+
+    static size_t _hash(uint64_t pageNumber) {
+      return (size_t)((pageNumber * 0x9E3779B97F4A7C15ULL) >> 32);
+    }
+
+    Page *_findPage(uint64_t pageNumber) {
+      return const_cast<Page *>(static_cast<const VisitedAddressSet *>(this)->_findPage(pageNumber));
+    }
+
+    const Page *_findPage(uint64_t pageNumber) const {
+      // Objects reached one after another are often allocated close to each other
+      if (_lastPage != kNoPage && _pages[_lastPage].number == pageNumber) {
+        return &_pages[_lastPage];
+      }
+      if (_slots.empty()) {
+        return nullptr;
+      }
+      size_t mask = _slots.size() - 1;
+      for (size_t i = _hash(pageNumber) & mask;; i = (i + 1) & mask) {
+        const Slot &slot = _slots[i];
+        if (slot.pageIndex == kNoPage) {
+          return nullptr;
+        }
+        if (slot.pageNumber == pageNumber) {
+          _lastPage = slot.pageIndex;
+          return &_pages[slot.pageIndex];
+        }
+      }
+    }
+
+    // Slot table is kept at most half full, and doubles when it would get fuller
+    size_t _slotTableGrowth() const {
+      if ((_pages.size() + 1) * 2 <= _slots.size()) {
+        return 0;
+      }
+      return (std::max<size_t>(_slots.size() * 2, 32) - _slots.size()) * sizeof(Slot);
+    }
+
+    Page *_addPage(uint64_t pageNumber) {
+      if ((_pages.size() + 1) * 2 > _slots.size()) {
+        std::vector<Slot> slots(std::max<size_t>(_slots.size() * 2, 32), Slot{0, kNoPage});
+        size_t mask = slots.size() - 1;
+        for (const Page &page: _pages) {
+          size_t i = _hash(page.number) & mask;
+          while (slots[i].pageIndex != kNoPage) {
+            i = (i + 1) & mask;
+          }
+          slots[i] = Slot{page.number, (uint32_t)(&page - _pages.data())};
+        }
+        _slots.swap(slots);
+      }
+
+      size_t mask = _slots.size() - 1;
+      size_t i = _hash(pageNumber) & mask;
+      while (_slots[i].pageIndex != kNoPage) {
+        i = (i + 1) & mask;
+      }
+      _slots[i] = Slot{pageNumber, (uint32_t)_pages.size()};
+      _lastPage = (uint32_t)_pages.size();
+      _pages.push_back(Page{pageNumber, nullptr, 0, 0, nullptr});
+      return &_pages.back();
+    }
+
+    InsertResult _insertIntoBitmap(Page &page, uint16_t offset) {
+      uint64_t bit = 1ULL << (offset & 63);
+      uint64_t &word = page.bitmap[offset >> 6];
+      if (word & bit) {
+        return InsertResult::AlreadyPresent;
+      }
+      word |= bit;
+      return InsertResult::Inserted;
+    }
+
+    InsertResult _insertIntoArray(Page &page, uint16_t offset) {
+      uint16_t *begin = page.offsets.get();
+      uint16_t *end = begin + page.offsetCount;
+      uint16_t *position = std::lower_bound(begin, end, offset);
+      if (position != end && *position == offset) {
+        return InsertResult::AlreadyPresent;
+      }
+
+      if (page.offsetCount == kMaximumArrayCount) {
+        if (!_reserve(kBitmapSize - page.offsetCapacity * sizeof(uint16_t))) {
+          return InsertResult::OverMemoryLimit;
+        }
+        page.bitmap.reset(new uint64_t[kBitmapWords]());
+        for (uint16_t *it = begin; it != end; ++it) {
+          page.bitmap[*it >> 6] |= 1ULL << (*it & 63);
+        }
+        page.offsets.reset();
+        page.offsetCount = 0;
+        page.offsetCapacity = 0;
+        return _insertIntoBitmap(page, offset);
+      }
+
+      if (page.offsetCount == page.offsetCapacity) {
+        uint32_t capacity = std::min(std::max(page.offsetCapacity * 2, (uint32_t)kMinimumArrayCapacity),
+                                     (uint32_t)kMaximumArrayCount);
+        if (!_reserve((capacity - page.offsetCapacity) * sizeof(uint16_t))) {
+          return InsertResult::OverMemoryLimit;
+        }
+        std::unique_ptr<uint16_t[]> offsets(new uint16_t[capacity]);
+        size_t index = position - begin;
+        std::copy(begin, position, offsets.get());
+        std::copy(position, end, offsets.get() + index + 1);
+        offsets[index] = offset;
+        page.offsets.swap(offsets);
+        page.offsetCapacity = capacity;
+      } else {
+        std::copy_backward(position, end, end + 1);
+        *position = offset;
+      }
+      page.offsetCount++;
+      return InsertResult::Inserted;
+    }
+
+    std::vector<Page> _pages;
+    std::vector<Slot> _slots;
+    std::unordered_set<size_t> _unalignedAddresses;
+    mutable uint32_t _lastPage = kNoPage;
+    size_t _count = 0;
+    size_t _memoryUsage = 0;
+    size_t _memoryLimit;
+  };
+} }
+
+#endif /* FBVisitedAddressSet_h */
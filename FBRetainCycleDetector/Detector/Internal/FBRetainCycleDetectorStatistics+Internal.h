@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FBRetainCycleDetectorStatistics.h"
+
+typedef NS_ENUM(NSUInteger, FBRetainCycleDetectorCounter) {
+  FBRetainCycleDetectorCounterCandidatesScanned,
+  FBRetainCycleDetectorCounterNodesVisited,
+  FBRetainCycleDetectorCounterEdgesExamined,
+  FBRetainCycleDetectorCounterEdgesRejectedByFilters,
+  FBRetainCycleDetectorCounterLayoutCacheHits,
+  FBRetainCycleDetectorCounterLayoutCacheMisses,
+  FBRetainCycleDetectorCounterAssociationLookups,
+  FBRetainCycleDetectorCounterCollectionEnumerationRetries,
+  FBRetainCycleDetectorCounterSwiftABIResolutions,
+  FBRetainCycleDetectorCounterCyclesFound,
+  FBRetainCycleDetectorCounterAcyclicMemoHits,
+  FBRetainCycleDetectorCounterKnownCyclesSkipped,
+  FBRetainCycleDetectorCounterNodesOverMemoryLimit,
+  FBRetainCycleDetectorCounterRepeatedCyclesCounted,
+  FBRetainCycleDetectorCounterCount,
+};
+
+typedef NS_ENUM(NSUInteger, FBRetainCycleDetectorPhase) {
+  FBRetainCycleDetectorPhaseExpand,
+  FBRetainCycleDetectorPhaseFilter,
+  FBRetainCycleDetectorPhaseCanonicalize,
+  FBRetainCycleDetectorPhaseVerify,
+  FBRetainCycleDetectorPhaseSnapshotPause,
+  FBRetainCycleDetectorPhaseAnalysisBackpressure,
+  FBRetainCycleDetectorPhaseCount,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ Hooks used by the traversal code. They record into the statistics of the scan currently running on the calling
+ thread, and do nothing if there is none. They are always compiled, so recording can be tested, but traversal code
+ only calls them through the macros below, which compile to nothing unless statistics are enabled.
+ */
+void FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounter counter);
+void FBRetainCycleDetectorStatisticsAdd(FBRetainCycleDetectorCounter counter, uint64_t count);
+uint64_t FBRetainCycleDetectorStatisticsPhaseBegin(void);
+void FBRetainCycleDetectorStatisticsPhaseEnd(FBRetainCycleDetectorPhase phase, uint64_t beginTimestamp, BOOL traced);
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+
+#define FB_RCD_STATS_INCREMENT(counter) \
+  FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounter##counter)
+#define FB_RCD_STATS_ADD(counter, count) \
+  FBRetainCycleDetectorStatisticsAdd(FBRetainCycleDetectorCounter##counter, count)
+#define FB_RCD_STATS_PHASE_BEGIN(timestamp) \
+  uint64_t timestamp = FBRetainCycleDetectorStatisticsPhaseBegin()
+#define FB_RCD_STATS_PHASE_END(phase, timestamp) \
+  FBRetainCycleDetectorStatisticsPhaseEnd(FBRetainCycleDetectorPhase##phase, timestamp, NO)
+#define FB_RCD_STATS_TRACED_PHASE_END(phase, timestamp) \
+  FBRetainCycleDetectorStatisticsPhaseEnd(FBRetainCycleDetectorPhase##phase, timestamp, YES)
+
+#else
+
+#define FB_RCD_STATS_INCREMENT(counter) do {} while (0)
+#define FB_RCD_STATS_ADD(counter, count) do {} while (0)
+#define FB_RCD_STATS_PHASE_BEGIN(timestamp) do {} while (0)
+#define FB_RCD_STATS_PHASE_END(phase, timestamp) do {} while (0)
+#define FB_RCD_STATS_TRACED_PHASE_END(phase, timestamp) do {} while (0)
+
+#endif // _INTERNAL_RCD_STATISTICS_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+@interface FBRetainCycleDetectorStatistics ()
+
+/**
+ Makes these statistics the destination of all hooks called on the current thread, until -endScan is called.
+ */
+- (void)beginScan;
+- (void)endScan;
+
+/**
+ Brackets traversal of a single candidate, so it shows up as its own event in the trace.
+ */
+- (void)beginCandidate:(nonnull NSString *)candidateDescription;
+- (void)endCandidate;
+
+/**
+ Adds counters, timings and trace events of work another thread did for the same scan, recorded between its own
+ -beginScan and -endScan. Its events show up on a separate track of the trace.
+ */
+- (void)addStatisticsOfOtherThread:(nonnull FBRetainCycleDetectorStatistics *)statistics;
+
+@end
@@ -8,6 +8,9 @@
 
 #import <Foundation/Foundation.h>
 
+#import "FBGraphEdgeKind.h"
+#import "FBNamePathTable.h"
+
 @class FBObjectGraphConfiguration;
 @class FBObjectiveCGraphElement;
 
@@ -17,8 +20,23 @@ extern "C" {
 
 /**
  Wrapper functions, for given object they will categorize it and create proper Graph Element subclass instance
- for it.
+ for it. Returns nil if the edge is skipped by configuration's skippedEdgeKinds or rejected by its filters.
+ */
+FBObjectiveCGraphElement *_Nullable FBWrapObjectGraphElementWithEdgeKind(FBObjectiveCGraphElement *_Nullable sourceElement,
+                                                                         id _Nullable object,
+                                                                         FBObjectGraphConfiguration *_Nullable configuration,
+                                                                         FBNamePathID namePathID,
+                                                                         FBGraphEdgeKind edgeKind);
+/**
+ Wrapping function specialized for a configuration, it only checks for options that configuration has turned on.
+ Element subclasses fetch it once before wrapping all objects they retain.
  */
+typedef FBObjectiveCGraphElement *_Nullable (*FBObjectGraphElementWrapper)(FBObjectiveCGraphElement *_Nullable sourceElement,
+                                                                           id _Nullable object,
+                                                                           FBObjectGraphConfiguration *_Nullable configuration,
+                                                                           FBNamePathID namePathID,
+                                                                           FBGraphEdgeKind edgeKind);
+FBObjectGraphElementWrapper _Nonnull FBGetObjectGraphElementWrapper(FBObjectGraphConfiguration *_Nullable configuration);
 FBObjectiveCGraphElement *_Nullable FBWrapObjectGraphElementWithContext(FBObjectiveCGraphElement *_Nullable sourceElement,
                                                                         id _Nullable object,
                                                                         FBObjectGraphConfiguration *_Nullable configuration,
@@ -27,6 +45,14 @@ FBObjectiveCGraphElement *_Nullable FBWrapObjectGraphElement(FBObjectiveCGraphEl
                                                              id _Nullable object,
                                                              FBObjectGraphConfiguration *_Nullable configuration);
 
+/**
+ Cheap hash of the class and all objects given object retains through ivars and associations, computed without
+ wrapping them into graph elements. Returns 0 for objects whose references can't be read that way (collections,
+ blocks, timers, Swift objects) or if configuration uses a transformer block.
+ */
+uint64_t FBGetObjectRetainedObjectsFingerprint(id _Nullable object,
+                                               FBObjectGraphConfiguration *_Nullable configuration);
+
 #ifdef __cplusplus
 }
 #endif
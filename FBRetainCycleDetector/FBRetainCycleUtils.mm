@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBRetainCycleUtils.h"
+
+#import <objc/runtime.h>
+
+#import "FBAssociationManager.h"
+#import "FBClassStrongLayout.h"
+#import "FBClassTraits.h"
+#import "FBObjectiveCBlock.h"
+#import "FBObjectiveCGraphElement+Internal.h"
+#import "FBObjectiveCNSCFTimer.h"
+#import "FBObjectiveCObject.h"
+#import "FBObjectGraphConfiguration+Internal.h"
+#import "FBObjectReference.h"
+#import "FBRetainCycleDetectorStatistics+Internal.h"
+
+static BOOL _ShouldBreakGraphEdge(FBObjectGraphConfiguration *configuration,
+                                  FBObjectiveCGraphElement *fromObject,
+                                  NSString *byIvar,
+                                  Class toObjectOfClass) {
+  for (FBGraphEdgeFilterBlock filterBlock in configuration.filterBlocks) {
+    if (filterBlock(fromObject, byIvar, toObjectOfClass) == FBGraphEdgeInvalid) {
+      return YES;
+    }
+  }
+
+  return NO;
+}
+
+/**
+ Options of a configuration that change what happens for every edge. Kernels are instantiated for every combination
+ of them, so options that are turned off cost nothing when expanding edges.
+ */
+template <bool SkipsEdgeKinds, bool HasFilters, bool InspectsTimers, bool HasTransformer>
+struct FBGraphExpansionPolicy {
+  static const bool skipsEdgeKinds = SkipsEdgeKinds;
+  static const bool hasFilters = HasFilters;
+  static const bool inspectsTimers = InspectsTimers;
+  static const bool hasTransformer = HasTransformer;
+};
+
+template <typename Policy>
+static FBObjectiveCGraphElement *FBWrapObjectGraphElementWithPolicy(FBObjectiveCGraphElement *sourceElement,
+                                                                    id object,
+                                                                    FBObjectGraphConfiguration *configuration,
+                                                                    FBNamePathID namePathID,
+                                                                    FBGraphEdgeKind edgeKind) {
+  if (Policy::skipsEdgeKinds && (configuration.skippedEdgeKinds & edgeKind)) {
+    return nil;
+  }
+  FB_RCD_STATS_INCREMENT(EdgesExamined);
+  Class objectClass = object_getClass(object);
+  if (Policy::hasFilters) {
+    FB_RCD_STATS_PHASE_BEGIN(filterBegin);
+    BOOL shouldBreakGraphEdge = _ShouldBreakGraphEdge(configuration,
+                                                      sourceElement,
+                                                      FBGetInternedNamePathFirstName(namePathID),
+                                                      objectClass);
+    FB_RCD_STATS_PHASE_END(Filter, filterBegin);
+    if (shouldBreakGraphEdge) {
+      FB_RCD_STATS_INCREMENT(EdgesRejectedByFilters);
+      return nil;
+    }
+  }
+  FBClassTraits traits = FBGetClassTraits(objectClass);
+  FBObjectiveCGraphElement *newElement;
+  if (traits & FBClassTraitsBlock) {
+    newElement = [[FBObjectiveCBlock alloc] initWithObject:object
+                                             configuration:configuration
+                                                namePathID:namePathID];
+  } else {
+    if (Policy::inspectsTimers && (traits & FBClassTraitsTimer)) {
+      newElement = [[FBObjectiveCNSCFTimer alloc] initWithObject:object
+                                                   configuration:configuration
+                                                      namePathID:namePathID];
+    } else {
+      newElement = [[FBObjectiveCObject alloc] initWithObject:object
+                                                configuration:configuration
+                                                   namePathID:namePathID];
+    }
+  }
+  newElement.edgeKind = edgeKind;
+  if (Policy::hasTransformer) {
+    FBObjectiveCGraphElement *transformedElement = configuration.transformerBlock(newElement);
+    transformedElement.edgeKind = edgeKind;
+    return transformedElement;
+  }
+  return newElement;
+}
+
+template <bool SkipsEdgeKinds, bool HasFilters, bool InspectsTimers>
+static FBObjectGraphElementWrapper FBSelectObjectGraphElementWrapper(bool hasTransformer) {
+  return (hasTransformer
+          ? &FBWrapObjectGraphElementWithPolicy<FBGraphExpansionPolicy<SkipsEdgeKinds, HasFilters, InspectsTimers, true>>
+          : &FBWrapObjectGraphElementWithPolicy<FBGraphExpansionPolicy<SkipsEdgeKinds, HasFilters, InspectsTimers, false>>);
+}
+
+template <bool SkipsEdgeKinds, bool HasFilters>
+static FBObjectGraphElementWrapper FBSelectObjectGraphElementWrapper(bool inspectsTimers, bool hasTransformer) {
+  return (inspectsTimers
+          ? FBSelectObjectGraphElementWrapper<SkipsEdgeKinds, HasFilters, true>(hasTransformer)
+          : FBSelectObjectGraphElementWrapper<SkipsEdgeKinds, HasFilters, false>(hasTransformer));
+}
+
+template <bool SkipsEdgeKinds>
+static FBObjectGraphElementWrapper FBSelectObjectGraphElementWrapper(bool hasFilters, bool inspectsTimers, bool hasTransformer) {
+  return (hasFilters
+          ? FBSelectObjectGraphElementWrapper<SkipsEdgeKinds, true>(inspectsTimers, hasTransformer)
+          : FBSelectObjectGraphElementWrapper<SkipsEdgeKinds, false>(inspectsTimers, hasTransformer));
+}
+
+FBObjectGraphElementWrapper FBGetObjectGraphElementWrapper(FBObjectGraphConfiguration *configuration) {
+  if (configuration.graphElementWrapper) {
+    return configuration.graphElementWrapper;
+  }
+  bool skipsEdgeKinds = configuration.skippedEdgeKinds != FBGraphEdgeKindNone;
+  bool hasFilters = [configuration.filterBlocks count] > 0;
+  bool inspectsTimers = configuration.shouldInspectTimers;
+  bool hasTransformer = configuration.transformerBlock != nil;
+  return (skipsEdgeKinds
+          ? FBSelectObjectGraphElementWrapper<true>(hasFilters, inspectsTimers, hasTransformer)
+          : FBSelectObjectGraphElementWrapper<false>(hasFilters, inspectsTimers, hasTransformer));
+}
+
+FBObjectiveCGraphElement *FBWrapObjectGraphElementWithEdgeKind(FBObjectiveCGraphElement *sourceElement,
+                                                               id object,
+                                                               FBObjectGraphConfiguration *configuration,
+                                                               FBNamePathID namePathID,
+                                                               FBGraphEdgeKind edgeKind) {
+  return FBGetObjectGraphElementWrapper(configuration)(sourceElement, object, configuration, namePathID, edgeKind);
+}
+
+FBObjectiveCGraphElement *FBWrapObjectGraphElementWithContext(FBObjectiveCGraphElement *sourceElement,
+                                                              id object,
+                                                              FBObjectGraphConfiguration *configuration,
+                                                              NSArray<NSString *> *namePath) {
+  return FBWrapObjectGraphElementWithEdgeKind(sourceElement,
+                                              object,
+                                              configuration,
+                                              FBInternNamePath(namePath),
+                                              FBGraphEdgeKindNone);
+}
+
+FBObjectiveCGraphElement *FBWrapObjectGraphElement(FBObjectiveCGraphElement *sourceElement,
+                                                   id object,
+                                                   FBObjectGraphConfiguration *configuration) {
+  return FBWrapObjectGraphElementWithContext(sourceElement, object, configuration, nil);
+}
+
+static const uint64_t kFBFingerprintOffsetBasis = 14695981039346656037ULL;
+static const uint64_t kFBFingerprintPrime = 1099511628211ULL;
+
+static inline uint64_t FBFingerprintCombine(uint64_t fingerprint, uintptr_t value) {
+  return (fingerprint ^ (uint64_t)value) * kFBFingerprintPrime;
+}
+
+uint64_t FBGetObjectRetainedObjectsFingerprint(id object, FBObjectGraphConfiguration *configuration) {
+  if (!object || !configuration || configuration.transformerBlock) {
+    // Transformed elements can retain anything, we can't predict that from ivars
+    return 0;
+  }
+
+  Class aCls = object_getClass(object);
+  FBClassTraits traits = FBGetClassTraits(aCls);
+  if (!aCls || (traits & (FBClassTraitsMetaClass | FBClassTraitsBlock))) {
+    return 0;
+  }
+  if (configuration.shouldInspectTimers && (traits & FBClassTraitsTimer)) {
+    // Timer context is not part of the ivar layout
+    return 0;
+  }
+  if (configuration.shouldIncludeSwiftObjects && (traits & FBClassTraitsSwift)) {
+    // Swift references are read through Mirror or ABI metadata, that's not cheap
+    return 0;
+  }
+  FBGraphEdgeKind skippedEdgeKinds = configuration.skippedEdgeKinds;
+  if (!(skippedEdgeKinds & FBGraphEdgeKindCollectionEntry) && (traits & FBClassTraitsEnumerable)) {
+    // Contents of collections are not part of the ivar layout
+    return 0;
+  }
+
+  uint64_t fingerprint = FBFingerprintCombine(kFBFingerprintOffsetBasis, (uintptr_t)aCls);
+
+  if (!(skippedEdgeKinds & FBGraphEdgeKindAssociatedObject)) {
+    for (id associatedObject in [FBAssociationManager associationsForObject:object]) {
+      fingerprint = FBFingerprintCombine(fingerprint, (uintptr_t)(__bridge void *)associatedObject);
+    }
+  }
+
+  NSArray<id<FBObjectReference>> *strongIvars = FBGetObjectStrongReferences(object,
+                                                                            YES,
+                                                                            configuration.shouldIncludeSwiftObjects,
+                                                                            configuration.shouldUseSwiftABITraversal,
+                                                                            configuration.shouldScanSwiftObjectMemory);
+  for (id<FBObjectReference> ref in strongIvars) {
+    if (skippedEdgeKinds & [ref edgeKind]) {
+      continue;
+    }
+    fingerprint = FBFingerprintCombine(fingerprint, (uintptr_t)(__bridge void *)[ref objectReferenceFromObject:object]);
+  }
+
+  return fingerprint ?: 1;
+}
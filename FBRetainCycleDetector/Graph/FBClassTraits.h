@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ Everything the detector needs to know about a class to decide how to wrap and expand its instances.
+ */
+typedef NS_OPTIONS(uint32_t, FBClassTraits) {
+  // Set for every class traits were computed for, so that they are never 0
+  FBClassTraitsComputed = 1 << 0,
+  FBClassTraitsMetaClass = 1 << 1,
+  FBClassTraitsBlock = 1 << 2,
+  FBClassTraitsTimer = 1 << 3,
+  FBClassTraitsSwift = 1 << 4,
+  // Toll-free bridged CoreFoundation class, __NSCF*
+  FBClassTraitsTollFreeBridged = 1 << 5,
+  // Conforms to NSFastEnumeration
+  FBClassTraitsEnumerable = 1 << 6,
+  // Instances respond to objectForKey:
+  FBClassTraitsKeyValued = 1 << 7,
+  // Collections defined in Foundation, whose contents can be copied out in bulk
+  FBClassTraitsFoundationArray = 1 << 8,
+  FBClassTraitsFoundationDictionary = 1 << 9,
+  FBClassTraitsFoundationSet = 1 << 10,
+  FBClassTraitsFoundationHashTable = 1 << 11,
+  FBClassTraitsFoundationMapTable = 1 << 12,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ Traits are computed the first time a class is asked about and cached, later calls take a single lookup. Safe to
+ call from any thread.
+
+ @return 0 for Nil.
+ */
+FBClassTraits FBGetClassTraits(Class _Nullable aCls);
+
+#ifdef __cplusplus
+}
+#endif
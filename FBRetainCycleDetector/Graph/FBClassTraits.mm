@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBClassTraits.h"
+
+#import <objc/runtime.h>
+
+#import "FBBlockStrongLayout.h"
+#import "FBClassSwiftHelpers.h"
+#import "FBClassTraitsTable.h"
+
+// Classes a process deals with during scans, with plenty of room to keep probes short
+static const size_t kFBClassTraitsTableCapacity = 16384;
+
+static BOOL FBClassIsSubclassOf(Class cls, Class parentCls) {
+  Class c = cls;
+  for (int depth = 0; c != Nil && depth < 128; depth++) {
+    if ((uintptr_t)c & (sizeof(void *) - 1)) {
+      return NO;
+    }
+    if (c == parentCls) {
+      return YES;
+    }
+    c = class_getSuperclass(c);
+  }
+  return NO;
+}
+
+/**
+ Same as +conformsToProtocol:, without sending messages to classes that may not be initialized yet.
+ */
+static BOOL FBClassConformsToProtocol(Class cls, Protocol *protocol) {
+  for (Class c = cls; c != Nil; c = class_getSuperclass(c)) {
+    if (class_conformsToProtocol(c, protocol)) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+static BOOL FBClassIsDefinedInFoundation(Class aCls) {
+  static const char *foundationImage;
+  static const char *coreFoundationImage;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    foundationImage = class_getImageName([NSMapTable class]);
+    coreFoundationImage = class_getImageName([NSArray class]);
+  });
+
+  const char *image = class_getImageName(aCls);
+  if (!image) {
+    return NO;
+  }
+  return ((foundationImage && strcmp(image, foundationImage) == 0) ||
+          (coreFoundationImage && strcmp(image, coreFoundationImage) == 0));
+}
+
+static FBClassTraits FBComputeClassTraits(Class aCls) {
+  FBClassTraits traits = FBClassTraitsComputed;
+  if (FBIsSwiftObjectOrClass(aCls)) {
+    traits |= FBClassTraitsSwift;
+  }
+  if (strncmp(class_getName(aCls), "__NSCF", 6) == 0) {
+    traits |= FBClassTraitsTollFreeBridged;
+  }
+  if (class_isMetaClass(aCls)) {
+    // Meta classes answer to the protocol checks below as if they were instances, they are not
+    return traits | FBClassTraitsMetaClass;
+  }
+  if (FBClassIsBlock(aCls)) {
+    traits |= FBClassTraitsBlock;
+  }
+  if (FBClassIsSubclassOf(aCls, [NSTimer class])) {
+    traits |= FBClassTraitsTimer;
+  }
+  if (FBClassConformsToProtocol(aCls, @protocol(NSFastEnumeration))) {
+    traits |= FBClassTraitsEnumerable;
+  }
+  if (class_respondsToSelector(aCls, @selector(objectForKey:))) {
+    traits |= FBClassTraitsKeyValued;
+  }
+  if (FBClassIsDefinedInFoundation(aCls)) {
+    if (FBClassIsSubclassOf(aCls, [NSArray class])) {
+      traits |= FBClassTraitsFoundationArray;
+    } else if (FBClassIsSubclassOf(aCls, [NSDictionary class])) {
+      traits |= FBClassTraitsFoundationDictionary;
+    } else if (FBClassIsSubclassOf(aCls, [NSSet class])) {
+      traits |= FBClassTraitsFoundationSet;
+    } else if (FBClassIsSubclassOf(aCls, [NSHashTable class])) {
+      traits |= FBClassTraitsFoundationHashTable;
+    } else if (FBClassIsSubclassOf(aCls, [NSMapTable class])) {
+      traits |= FBClassTraitsFoundationMapTable;
+    }
+  }
+  return traits;
+}
+
+FBClassTraits FBGetClassTraits(Class aCls) {
+  if (!aCls) {
+    return 0;
+  }
+  static auto *table = new FB::RetainCycleDetector::ClassTraitsTable(kFBClassTraitsTableCapacity);
+  uintptr_t key = (uintptr_t)(__bridge void *)aCls;
+  FBClassTraits traits = table->find(key);
+  if (!traits) {
+    traits = FBComputeClassTraits(aCls);
+    table->insert(key, traits);
+  }
+  return traits;
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBClassTraitsTable_h
+#define FBClassTraitsTable_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Fixed size hash table from class addresses to their traits, that any number of threads can read and fill at the
+   same time without locking. Entries are never removed, classes are never unloaded in practice.
+
+   Traits of a class never change, so racing threads that compute them at the same time store the same value, and
+   a reader that finds an entry still being filled can just compute them again. Once the table is full, or a key
+   can't be placed within a few probes, values are simply not stored.
+   */
+  class ClassTraitsTable {
+  public:
+    /**
+     @param capacity Rounded up to a power of two.
+     */
+    explicit ClassTraitsTable(size_t capacity) {
+      _capacity = 16;
+      while (_capacity < capacity) {
+        _capacity *= 2;
+      }
+      _slots.reset(new Slot[_capacity]);
+    }
+
+    /**
+     @param key Anything but 0.
+     @return 0 if no traits are stored for the key.
+     */
+    uint32_t find(uintptr_t key) const {
+      const size_t mask = _capacity - 1;
+      size_t index = _hash(key) & mask;
+      for (size_t probe = 0; probe < kMaximumProbeCount; ++probe, index = (index + 1) & mask) {
+        uintptr_t slotKey = _slots[index].key.load(std::memory_order_acquire);
+        if (slotKey == key) {
+          return _slots[index].value.load(std::memory_order_acquire);
+        }
+        if (slotKey == 0) {
+          return 0;
+        }
+      }
+      return 0;
+    }
+
+    /**
+     @param key Anything but 0.
+     @param value Anything but 0.
+     @return false if there was no room for it.
+     */
+    bool insert(uintptr_t key, uint32_t value) {
+      const size_t mask = _capacity - 1;
+      size_t index = _hash(key) & mask;
+      for (size_t probe = 0; probe < kMaximumProbeCount; ++probe, index = (index + 1) & mask) {
+        uintptr_t slotKey = _slots[index].key.load(std::memory_order_acquire);
+        if (slotKey == 0) {
+          if (_slots[index].key.compare_exchange_strong(slotKey, key, std::memory_order_acq_rel)) {
+            _count.fetch_add(1, std::memory_order_relaxed);
+            slotKey = key;
+          }
+          // Otherwise slotKey now holds the key another thread just claimed the slot for
+        }
+        if (slotKey == key) {
+          _slots[index].value.store(value, std::memory_order_release);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    size_t count() const {
+      return _count.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const {
+      return _capacity;
+    }
+
+  private:
+    static const size_t kMaximumProbeCount = 16;
+
+    struct Slot {
+      std::atomic<uintptr_t> key{0};
+      std::atomic<uint32_t> value{0};
+    };
+
+    static size_t _hash(uintptr_t key) {
+      // Classes are aligned, low bits carry no information
+      return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 24);
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _capacity;
+    std::atomic<size_t> _count{0};
+  };
+} }
+
+#endif /* FBClassTraitsTable_h */
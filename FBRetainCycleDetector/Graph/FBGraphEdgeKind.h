@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ How an object holds a reference to another one. Every graph element remembers the kind of the edge it was reached
+ through, and configuration can skip whole kinds of edges during traversal.
+ @see FBObjectGraphConfiguration skippedEdgeKinds
+ */
+typedef NS_OPTIONS(NSUInteger, FBGraphEdgeKind) {
+  /** Elements that were not reached through an edge, like candidates. */
+  FBGraphEdgeKindNone = 0,
+  FBGraphEdgeKindIvar = 1 << 0,
+  /** Object inside of a struct held in an ivar. */
+  FBGraphEdgeKindStructField = 1 << 1,
+  /** Object associated with objc_setAssociatedObject. */
+  FBGraphEdgeKindAssociatedObject = 1 << 2,
+  /** Object, key or value held by a collection. */
+  FBGraphEdgeKindCollectionEntry = 1 << 3,
+  /** Object captured by an Objective-C block. */
+  FBGraphEdgeKindBlockCapture = 1 << 4,
+  /** Stored property of a pure Swift object. */
+  FBGraphEdgeKindSwiftField = 1 << 5,
+  /** Object captured by a closure held by a pure Swift object. */
+  FBGraphEdgeKindSwiftClosureCapture = 1 << 6,
+  /** Target or user info retained by a timer. */
+  FBGraphEdgeKindTimerTarget = 1 << 7,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @return short name of a single edge kind (like "ivar" or "collection entry"), for reports.
+ */
+NSString *_Nonnull FBGetGraphEdgeKindName(FBGraphEdgeKind edgeKind);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ Name paths are interned once, when a layout slot is created, into a table shared by the whole process. Edges carry
+ their 32-bit ID, and strings are only looked at when a filter asks for the ivar name, or a cycle is reported.
+ Interned name paths are never freed, there is one per distinct slot of all classes scanned.
+ */
+typedef uint32_t FBNamePathID;
+
+/**
+ ID of an edge without a name path, like a collection entry.
+ */
+static const FBNamePathID FBNamePathIDNone = 0;
+
+/**
+ Thread safe, takes a lock, so it should be called once per slot rather than once per edge.
+
+ @return FBNamePathIDNone for nil or empty name paths, or when the table is full.
+ */
+FBNamePathID FBInternNamePath(NSArray<NSString *> *_Nullable namePath);
+
+/**
+ Lock free. Given ID must have been returned by FBInternNamePath, on this thread or one that handed it over.
+ */
+NSArray<NSString *> *_Nullable FBGetInternedNamePath(FBNamePathID namePathID);
+
+/**
+ First name of the path, which filters get as byIvar. Lock free.
+ */
+NSString *_Nullable FBGetInternedNamePathFirstName(FBNamePathID namePathID);
+
+#ifdef __cplusplus
+}
+#endif
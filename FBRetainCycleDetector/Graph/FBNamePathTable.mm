@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBNamePathTable.h"
+
+#import <atomic>
+#import <mutex>
+
+static const size_t kFBNamePathTableSegmentBits = 10;
+static const size_t kFBNamePathTableSegmentSize = 1 << kFBNamePathTableSegmentBits;
+static const size_t kFBNamePathTableMaximumSegmentCount = 4096;
+
+struct FBInternedNamePath {
+  // Retained for as long as the process runs
+  __unsafe_unretained NSArray<NSString *> *namePath;
+  __unsafe_unretained NSString *firstName;
+};
+
+/**
+ Segments never move once allocated, so readers can index them without taking the lock.
+ */
+static std::atomic<FBInternedNamePath *> sFBNamePathTableSegments[kFBNamePathTableMaximumSegmentCount];
+
+static const FBInternedNamePath *FBGetInternedNamePathEntry(FBNamePathID namePathID) {
+  if (namePathID == FBNamePathIDNone) {
+    return nullptr;
+  }
+  const size_t segment = namePathID >> kFBNamePathTableSegmentBits;
+  if (segment >= kFBNamePathTableMaximumSegmentCount) {
+    return nullptr;
+  }
+  FBInternedNamePath *entries = sFBNamePathTableSegments[segment].load(std::memory_order_acquire);
+  if (!entries) {
+    return nullptr;
+  }
+  return &entries[namePathID & (kFBNamePathTableSegmentSize - 1)];
+}
+
+FBNamePathID FBInternNamePath(NSArray<NSString *> *namePath) {
+  if ([namePath count] == 0) {
+    return FBNamePathIDNone;
+  }
+
+  static std::mutex *mutex = new std::mutex();
+  static NSMutableDictionary<NSArray<NSString *> *, NSNumber *> *namePathIDs = [NSMutableDictionary new];
+  // IDs start at 1, so that 0 can stand for no name path
+  static FBNamePathID nextNamePathID = 1;
+
+  std::lock_guard<std::mutex> l(*mutex);
+  NSNumber *existingNamePathID = namePathIDs[namePath];
+  if (existingNamePathID) {
+    return [existingNamePathID unsignedIntValue];
+  }
+
+  const FBNamePathID namePathID = nextNamePathID;
+  const size_t segment = namePathID >> kFBNamePathTableSegmentBits;
+  if (segment >= kFBNamePathTableMaximumSegmentCount) {
+    return FBNamePathIDNone;
+  }
+  FBInternedNamePath *entries = sFBNamePathTableSegments[segment].load(std::memory_order_relaxed);
+  if (!entries) {
+    entries = new FBInternedNamePath[kFBNamePathTableSegmentSize]();
+    sFBNamePathTableSegments[segment].store(entries, std::memory_order_release);
+  }
+
+  NSArray<NSString *> *internedNamePath = [namePath copy];
+  FBInternedNamePath &entry = entries[namePathID & (kFBNamePathTableSegmentSize - 1)];
+  entry.namePath = (__bridge NSArray<NSString *> *)CFBridgingRetain(internedNamePath);
+  entry.firstName = [internedNamePath firstObject];
+  namePathIDs[internedNamePath] = @(namePathID);
+  nextNamePathID++;
+  return namePathID;
+}
+
+NSArray<NSString *> *FBGetInternedNamePath(FBNamePathID namePathID) {
+  const FBInternedNamePath *entry = FBGetInternedNamePathEntry(namePathID);
+  return entry ? entry->namePath : nil;
+}
+
+NSString *FBGetInternedNamePathFirstName(FBNamePathID namePathID) {
+  const FBInternedNamePath *entry = FBGetInternedNamePathEntry(namePathID);
+  return entry ? entry->firstName : nil;
+}
@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 
+#import <FBRetainCycleDetector/FBGraphEdgeKind.h>
 #import <FBRetainCycleDetector/FBObjectiveCGraphElement.h>
 
 typedef NS_ENUM(NSUInteger, FBGraphEdgeType) {
@@ -86,9 +87,19 @@ typedef FBObjectiveCGraphElement *_Nullable(^FBObjectiveCGraphElementTransformer
 @property (nonatomic, readonly) BOOL shouldScanSwiftObjectMemory;
 
 /**
- Will cache layout
+ Kinds of edges object graph walker will not follow. Unlike filter blocks, skipped edges are dropped before the
+ referenced objects are even read, so for example skipping FBGraphEdgeKindCollectionEntry doesn't enumerate
+ collections at all and skipping FBGraphEdgeKindAssociatedObject doesn't look up associations.
+ Useful for quick passes that only care about ivars.
  */
-@property (nonatomic, readonly, nullable) NSMutableDictionary<NSString*, NSArray<id<FBObjectReference>> *> *layoutCache;
+@property (nonatomic, readonly) FBGraphEdgeKind skippedEdgeKinds;
+
+/**
+ No longer read or written. Layouts are cached in a store shared by all scans in the process, clearing this
+ dictionary doesn't invalidate them; use +[FBClassLayoutPrewarmer resetLayouts] instead.
+ */
+@property (nonatomic, readonly, nullable) NSMutableDictionary<NSString*, NSArray<id<FBObjectReference>> *> *layoutCache
+__deprecated_msg("Layouts are shared by all scans, use +[FBClassLayoutPrewarmer resetLayouts] to invalidate them");
 @property (nonatomic, readonly) BOOL shouldCacheLayouts;
 
 - (nonnull instancetype)initWithFilterBlocks:(nonnull NSArray<FBGraphEdgeFilterBlock> *)filterBlocks
@@ -97,7 +108,16 @@ typedef FBObjectiveCGraphElement *_Nullable(^FBObjectiveCGraphElementTransformer
                          shouldIncludeBlockAddress:(BOOL)shouldIncludeBlockAddress
                          shouldIncludeSwiftObjects:(BOOL)shouldIncludeSwiftObjects
                          shouldUseSwiftABITraversal:(BOOL)shouldUseSwiftABITraversal
-                         shouldScanSwiftObjectMemory:(BOOL)shouldScanSwiftObjectMemory NS_DESIGNATED_INITIALIZER;
+                         shouldScanSwiftObjectMemory:(BOOL)shouldScanSwiftObjectMemory
+                         skippedEdgeKinds:(FBGraphEdgeKind)skippedEdgeKinds NS_DESIGNATED_INITIALIZER;
+
+- (nonnull instancetype)initWithFilterBlocks:(nonnull NSArray<FBGraphEdgeFilterBlock> *)filterBlocks
+                         shouldInspectTimers:(BOOL)shouldInspectTimers
+                         transformerBlock:(nullable FBObjectiveCGraphElementTransformerBlock)transformerBlock
+                         shouldIncludeBlockAddress:(BOOL)shouldIncludeBlockAddress
+                         shouldIncludeSwiftObjects:(BOOL)shouldIncludeSwiftObjects
+                         shouldUseSwiftABITraversal:(BOOL)shouldUseSwiftABITraversal
+                         shouldScanSwiftObjectMemory:(BOOL)shouldScanSwiftObjectMemory;
 
 - (nonnull instancetype)initWithFilterBlocks:(nonnull NSArray<FBGraphEdgeFilterBlock> *)filterBlocks
                          shouldInspectTimers:(BOOL)shouldInspectTimers
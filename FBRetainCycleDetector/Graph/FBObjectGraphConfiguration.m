@@ -6,7 +6,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
-#import "FBObjectGraphConfiguration.h"
+#import "FBObjectGraphConfiguration+Internal.h"
 
 @implementation FBObjectGraphConfiguration
 
@@ -17,6 +17,7 @@
            shouldIncludeSwiftObjects:(BOOL)shouldIncludeSwiftObjects
           shouldUseSwiftABITraversal:(BOOL)shouldUseSwiftABITraversal
        shouldScanSwiftObjectMemory:(BOOL)shouldScanSwiftObjectMemory
+                  skippedEdgeKinds:(FBGraphEdgeKind)skippedEdgeKinds
 {
   if (self = [super init]) {
     _filterBlocks = [filterBlocks copy];
@@ -25,13 +26,33 @@
     _shouldIncludeSwiftObjects = shouldIncludeSwiftObjects;
     _shouldUseSwiftABITraversal = shouldUseSwiftABITraversal;
     _shouldScanSwiftObjectMemory = shouldScanSwiftObjectMemory;
+    _skippedEdgeKinds = skippedEdgeKinds;
     _transformerBlock = [transformerBlock copy];
     _layoutCache = [NSMutableDictionary new];
+    _graphElementWrapper = FBGetObjectGraphElementWrapper(self);
   }
 
   return self;
 }
 
+- (instancetype)initWithFilterBlocks:(NSArray<FBGraphEdgeFilterBlock> *)filterBlocks
+                 shouldInspectTimers:(BOOL)shouldInspectTimers
+                    transformerBlock:(nullable FBObjectiveCGraphElementTransformerBlock)transformerBlock
+           shouldIncludeBlockAddress:(BOOL)shouldIncludeBlockAddress
+           shouldIncludeSwiftObjects:(BOOL)shouldIncludeSwiftObjects
+          shouldUseSwiftABITraversal:(BOOL)shouldUseSwiftABITraversal
+       shouldScanSwiftObjectMemory:(BOOL)shouldScanSwiftObjectMemory
+{
+  return [self initWithFilterBlocks:filterBlocks
+                shouldInspectTimers:shouldInspectTimers
+                   transformerBlock:transformerBlock
+          shouldIncludeBlockAddress:shouldIncludeBlockAddress
+          shouldIncludeSwiftObjects:shouldIncludeSwiftObjects
+         shouldUseSwiftABITraversal:shouldUseSwiftABITraversal
+      shouldScanSwiftObjectMemory:shouldScanSwiftObjectMemory
+                 skippedEdgeKinds:FBGraphEdgeKindNone];
+}
+
 - (instancetype)initWithFilterBlocks:(NSArray<FBGraphEdgeFilterBlock> *)filterBlocks
                  shouldInspectTimers:(BOOL)shouldInspectTimers
                     transformerBlock:(nullable FBObjectiveCGraphElementTransformerBlock)transformerBlock
@@ -29,6 +29,9 @@ struct __attribute__((packed)) BlockLiteral {
 - (NSSet *)allRetainedObjects
 {
   NSMutableArray *results = [[[super allRetainedObjects] allObjects] mutableCopy];
+  if (self.configuration.skippedEdgeKinds & FBGraphEdgeKindBlockCapture) {
+    return [NSSet setWithArray:results];
+  }
 
   // Grab a strong reference to the object, otherwise it can crash while doing
   // nasty stuff on deallocation
@@ -38,7 +41,11 @@ struct __attribute__((packed)) BlockLiteral {
   NSArray *allRetainedReferences = FBGetBlockStrongReferences(blockObjectReference);
 
   for (id object in allRetainedReferences) {
-    FBObjectiveCGraphElement *element = FBWrapObjectGraphElement(self, object, self.configuration);
+    FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithEdgeKind(self,
+                                                                             object,
+                                                                             self.configuration,
+                                                                             FBNamePathIDNone,
+                                                                             FBGraphEdgeKindBlockCapture);
     if (element) {
       [results addObject:element];
     }
@@ -8,6 +8,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import <FBRetainCycleDetector/FBGraphEdgeKind.h>
+
 @class FBObjectGraphConfiguration;
 
 /**
@@ -48,6 +50,12 @@
  (for example ivar names, struct references). For more check FBObjectReference protocol.
  */
 @property (nonatomic, copy, readonly, nullable) NSArray<NSString *> *namePath;
+
+/**
+ How the parent object holds this object (ivar, collection, block capture...). Together with namePath it describes
+ the edge that leads to this element. FBGraphEdgeKindNone for candidates.
+ */
+@property (nonatomic, readonly) FBGraphEdgeKind edgeKind;
 @property (nonatomic, weak, nullable) id object;
 @property (nonatomic, readonly, nonnull) FBObjectGraphConfiguration *configuration;
 
@@ -64,6 +72,14 @@
  */
 - (nullable NSSet *)allRetainedObjects;
 
+/**
+ Same objects as allRetainedObjects, wrapped one by one as the enumerator advances, so that objects with many
+ references, like big collections, don't have all of them wrapped at once. Thread unsafe.
+
+ Default implementation enumerates allRetainedObjects. It can return the same object more than once.
+ */
+- (nonnull NSEnumerator<FBObjectiveCGraphElement *> *)retainedObjectsEnumerator;
+
 /**
  @return address of the object represented by this element
  */
@@ -16,10 +16,11 @@
 
 #import "FBAssociationManager.h"
 #import "FBClassStrongLayout.h"
+#import "FBClassTraits.h"
 #import "FBObjectGraphConfiguration.h"
 #import "FBRetainCycleUtils.h"
 #import "FBRetainCycleDetector.h"
-#import "FBClassSwiftHelpers.h"
+#import "FBRetainCycleDetectorStatistics+Internal.h"
 
 extern "C" char *swift_demangle(
     const char *mangledName,
@@ -56,6 +57,15 @@ extern "C" char *swift_demangle(
 - (instancetype)initWithObject:(id)object
                  configuration:(nonnull FBObjectGraphConfiguration *)configuration
                       namePath:(NSArray<NSString *> *)namePath
+{
+  return [self initWithObject:object
+                configuration:configuration
+                   namePathID:FBInternNamePath(namePath)];
+}
+
+- (instancetype)initWithObject:(id)object
+                 configuration:(FBObjectGraphConfiguration *)configuration
+                    namePathID:(FBNamePathID)namePathID
 {
   if (self = [super init]) {
 #if _INTERNAL_RCD_ENABLED
@@ -82,7 +92,7 @@ extern "C" char *swift_demangle(
       }
     }
 #endif
-    _namePath = namePath;
+    _namePathID = namePathID;
     _configuration = configuration;
   }
 
@@ -99,12 +109,17 @@ extern "C" char *swift_demangle(
       _unsafeSwiftObject = objectPtr;
     }
 #endif
-    _namePath = namePath;
+    _namePathID = FBInternNamePath(namePath);
     _configuration = configuration;
   }
   return self;
 }
 
+- (NSArray<NSString *> *)namePath
+{
+  return FBGetInternedNamePath(_namePathID);
+}
+
 - (void *)objectPtr
 {
   if (_unsafeSwiftObject) {
@@ -119,14 +134,20 @@ extern "C" char *swift_demangle(
   if (!ptr) {
     return nil;
   }
-  NSArray *retainedObjectsNotWrapped = [FBAssociationManager associationsForObject:(__bridge id)ptr];
   NSMutableSet *retainedObjects = [NSMutableSet new];
+  if (_configuration.skippedEdgeKinds & FBGraphEdgeKindAssociatedObject) {
+    return retainedObjects;
+  }
+  FB_RCD_STATS_INCREMENT(AssociationLookups);
+  NSArray *retainedObjectsNotWrapped = [FBAssociationManager associationsForObject:(__bridge id)ptr];
 
+  static const FBNamePathID associatedObjectNamePathID = FBInternNamePath(@[@"__associated_object"]);
   for (id obj in retainedObjectsNotWrapped) {
-    FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithContext(self,
-                                                                            obj,
-                                                                            _configuration,
-                                                                            @[@"__associated_object"]);
+    FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithEdgeKind(self,
+                                                                             obj,
+                                                                             _configuration,
+                                                                             associatedObjectNamePathID,
+                                                                             FBGraphEdgeKindAssociatedObject);
     if (element) {
       [retainedObjects addObject:element];
     }
@@ -135,6 +156,11 @@ extern "C" char *swift_demangle(
   return retainedObjects;
 }
 
+- (NSEnumerator<FBObjectiveCGraphElement *> *)retainedObjectsEnumerator
+{
+  return [[self allRetainedObjects] objectEnumerator] ?: [[NSSet set] objectEnumerator];
+}
+
 - (BOOL)isEqual:(id)object
 {
   if ([object isKindOfClass:[FBObjectiveCGraphElement class]]) {
@@ -151,8 +177,9 @@ extern "C" char *swift_demangle(
 
 - (NSString *)description
 {
-  if (_namePath) {
-    NSString *namePathStringified = [_namePath componentsJoinedByString:@" -> "];
+  NSArray<NSString *> *namePath = [self namePath];
+  if (namePath) {
+    NSString *namePathStringified = [namePath componentsJoinedByString:@" -> "];
     return [NSString stringWithFormat:@"-> %@ -> %@ ", namePathStringified, [self classNameOrNull]];
   }
   return [NSString stringWithFormat:@"-> %@ ", [self classNameOrNull]];
@@ -217,8 +244,32 @@ extern "C" char *swift_demangle(
 
 - (bool)isSwift
 {
-    Class cls = self.objectClass;
-    return cls != nil && FBIsSwiftObjectOrClass(cls);
+    return (FBGetClassTraits(self.objectClass) & FBClassTraitsSwift) != 0;
 }
 
 @end
+
+NSString *FBGetGraphEdgeKindName(FBGraphEdgeKind edgeKind)
+{
+  switch (edgeKind) {
+    case FBGraphEdgeKindNone:
+      return @"none";
+    case FBGraphEdgeKindIvar:
+      return @"ivar";
+    case FBGraphEdgeKindStructField:
+      return @"struct field";
+    case FBGraphEdgeKindAssociatedObject:
+      return @"associated object";
+    case FBGraphEdgeKindCollectionEntry:
+      return @"collection entry";
+    case FBGraphEdgeKindBlockCapture:
+      return @"block capture";
+    case FBGraphEdgeKindSwiftField:
+      return @"swift field";
+    case FBGraphEdgeKindSwiftClosureCapture:
+      return @"swift closure capture";
+    case FBGraphEdgeKindTimerTarget:
+      return @"timer target";
+  }
+  return @"unknown";
+}
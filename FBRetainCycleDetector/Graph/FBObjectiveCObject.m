@@ -12,12 +12,567 @@
 #import <malloc/malloc.h>
 
 #import "FBClassStrongLayout.h"
-#import "FBObjectGraphConfiguration.h"
+#import "FBClassTraits.h"
+#import "FBObjectGraphConfiguration+Internal.h"
 #import "FBObjectReference.h"
+#import "FBRetainCycleDetectorStatistics+Internal.h"
 #import "FBRetainCycleUtils.h"
 
+typedef NS_ENUM(NSUInteger, FBCollectionKind) {
+  FBCollectionKindUnknown,
+  FBCollectionKindArray,
+  FBCollectionKindDictionary,
+  FBCollectionKindSet,
+  FBCollectionKindHashTable,
+  FBCollectionKindMapTable,
+};
+
+/**
+ Collections we know how to copy out in bulk. Everything else, including subclasses outside of Foundation that
+ could do anything in their accessors, goes through fast enumeration.
+ */
+static FBCollectionKind FBGetCollectionKind(FBClassTraits traits) {
+  if (traits & FBClassTraitsFoundationArray) {
+    return FBCollectionKindArray;
+  }
+  if (traits & FBClassTraitsFoundationDictionary) {
+    return FBCollectionKindDictionary;
+  }
+  if (traits & FBClassTraitsFoundationSet) {
+    return FBCollectionKindSet;
+  }
+  if (traits & FBClassTraitsFoundationHashTable) {
+    return FBCollectionKindHashTable;
+  }
+  if (traits & FBClassTraitsFoundationMapTable) {
+    return FBCollectionKindMapTable;
+  }
+  return FBCollectionKindUnknown;
+}
+
+/**
+ Buffer used to copy collection contents, reused between calls on the same thread so big collections don't
+ allocate every time. Buffers above kFBCollectionBufferMaximumRetainedCapacity entries are freed after use.
+ */
+static const NSUInteger kFBCollectionBufferMaximumRetainedCapacity = 1 << 16;
+static __thread void **_FBCollectionBuffer = NULL;
+static __thread NSUInteger _FBCollectionBufferCapacity = 0;
+static __thread BOOL _FBCollectionBufferInUse = NO;
+
+static void **FBCollectionBufferAcquire(NSUInteger count) {
+  if (_FBCollectionBufferInUse) {
+    // Wrapping elements can call back into us through transformer block
+    return NULL;
+  }
+  if (count > _FBCollectionBufferCapacity) {
+    void **buffer = (void **)realloc(_FBCollectionBuffer, count * sizeof(void *));
+    if (!buffer) {
+      return NULL;
+    }
+    _FBCollectionBuffer = buffer;
+    _FBCollectionBufferCapacity = count;
+  }
+  _FBCollectionBufferInUse = YES;
+  return _FBCollectionBuffer;
+}
+
+static void FBCollectionBufferRelinquish(void) {
+  if (_FBCollectionBufferCapacity > kFBCollectionBufferMaximumRetainedCapacity) {
+    free(_FBCollectionBuffer);
+    _FBCollectionBuffer = NULL;
+    _FBCollectionBufferCapacity = 0;
+  }
+  _FBCollectionBufferInUse = NO;
+}
+
+/**
+ Entries of a collection copied to the collection buffer. Key and value with the same index come from the same entry,
+ keys or values are NULL if the collection doesn't retain them.
+ */
+typedef struct {
+  __unsafe_unretained id *keys;
+  __unsafe_unretained id *values;
+  NSUInteger count;
+} FBCollectionEntries;
+
+/**
+ NSSet, NSHashTable and NSMapTable can't copy their contents out without allocating an array, or without writing past
+ a buffer sized before the collection grew, so they are enumerated in one tight loop instead. Values are looked up
+ while their key is current, so pairs stay together even when weak keys or values are being zeroed.
+ */
+static NSUInteger FBCopyTableEntries(id table,
+                                     BOOL copiesValues,
+                                     __unsafe_unretained id *keys,
+                                     __unsafe_unretained id *values,
+                                     NSUInteger capacity) {
+  NSUInteger copiedCount = 0;
+  for (id key in table) {
+    if (copiedCount == capacity) {
+      break;
+    }
+    if (copiesValues) {
+      id value = [table objectForKey:key];
+      if (!value) {
+        continue;
+      }
+      values[copiedCount] = value;
+    }
+    keys[copiedCount++] = key;
+  }
+  return copiedCount;
+}
+
+/**
+ Copies entries of a Foundation collection in one pass, so they all come from the same state of the collection.
+ Only the part of the buffer the collection actually wrote is handed out. On success, the collection buffer has to
+ be relinquished once entries are no longer needed.
+
+ @return NO if collection kind is not known, or copying failed and caller should enumerate instead
+ */
+static BOOL FBCopyCollectionEntries(id collection,
+                                    FBCollectionKind kind,
+                                    BOOL retainsKeys,
+                                    BOOL retainsValues,
+                                    FBCollectionEntries *entries) {
+  if (kind == FBCollectionKindUnknown) {
+    return NO;
+  }
+
+  NSUInteger count = [collection count];
+  // Keys go to the first half of the buffer, values of key-valued collections to the second one
+  void **buffer = FBCollectionBufferAcquire(MAX(count * 2, 1));
+  if (!buffer) {
+    return NO;
+  }
+
+  __unsafe_unretained id *keys = (__unsafe_unretained id *)buffer;
+  __unsafe_unretained id *values = keys + count;
+  BOOL isKeyValued = (kind == FBCollectionKindDictionary || kind == FBCollectionKindMapTable);
+  NSUInteger copiedCount = 0;
+
+  @try {
+    switch (kind) {
+      case FBCollectionKindArray: {
+        [(NSArray *)collection getObjects:keys range:NSMakeRange(0, count)];
+        copiedCount = count;
+        break;
+      }
+      case FBCollectionKindDictionary: {
+        // Dictionary could have shrunk since we asked for its count, only non-nil keys were written
+        memset(buffer, 0, count * 2 * sizeof(void *));
+        [(NSDictionary *)collection getObjects:values andKeys:keys count:count];
+        while (copiedCount < count && keys[copiedCount]) {
+          copiedCount++;
+        }
+        break;
+      }
+      case FBCollectionKindSet:
+      case FBCollectionKindHashTable:
+      case FBCollectionKindMapTable: {
+        if (!retainsKeys && !(isKeyValued && retainsValues)) {
+          break;
+        }
+        copiedCount = FBCopyTableEntries(collection, isKeyValued && retainsValues, keys, values, count);
+        break;
+      }
+      case FBCollectionKindUnknown:
+        break;
+    }
+  }
+  @catch (NSException *exception) {
+    FBCollectionBufferRelinquish();
+    return NO;
+  }
+
+  entries->keys = retainsKeys ? keys : NULL;
+  entries->values = (isKeyValued && retainsValues) ? values : NULL;
+  entries->count = copiedCount;
+  return YES;
+}
+
+@interface FBObjectiveCObject ()
+- (BOOL)_objectRetainsEnumerableKeys;
+- (BOOL)_objectRetainsEnumerableValues;
+@end
+
+typedef NS_ENUM(NSUInteger, FBRetainedObjectsStage) {
+  FBRetainedObjectsStageAssociations,
+  FBRetainedObjectsStageReferences,
+  FBRetainedObjectsStageCollection,
+  FBRetainedObjectsStageDone,
+};
+
+/**
+ Number of collection entries fast enumeration is asked for at once. An enum, so it can size the buffer ivar.
+ */
+enum { kFBRetainedObjectsEnumeratorBatchSize = 16 };
+static const NSInteger kFBRetainedObjectsEnumeratorMaximumRetries = 10;
+
+/**
+ Retained entries of a Foundation collection, copied when the enumerator gets to it. Chunks are freed as entries are
+ handed out, so there is no big allocation to grow, and memory shrinks as the enumeration progresses.
+ */
+enum { kFBCollectionSnapshotChunkCapacity = 256 };
+typedef struct FBCollectionSnapshotChunk {
+  struct FBCollectionSnapshotChunk *next;
+  NSUInteger count;
+  const void *entries[kFBCollectionSnapshotChunkCapacity];
+} FBCollectionSnapshotChunk;
+
+/**
+ Wraps objects retained by an FBObjectiveCObject one at a time: associations first, then references from the class
+ layout, then collection entries. Foundation collections are copied in one pass when their stage begins, and entries
+ are wrapped from the copy, so mutations while the detector descends into earlier entries don't matter. Other
+ collections are read with resumable fast enumeration, keeping only a position between calls.
+ */
+@interface FBObjectiveCObjectRetainedObjectsEnumerator : NSEnumerator<FBObjectiveCGraphElement *>
+
+- (instancetype)initWithElement:(FBObjectiveCObject *)element
+              associatedObjects:(NSSet *)associatedObjects;
+
+@end
+
+@implementation FBObjectiveCObjectRetainedObjectsEnumerator
+{
+  FBObjectiveCObject *_element;
+  FBObjectGraphConfiguration *_configuration;
+  FBObjectGraphElementWrapper _wrap;
+  FBGraphEdgeKind _skippedEdgeKinds;
+  FBRetainedObjectsStage _stage;
+
+  NSEnumerator *_associatedObjects;
+
+  NSArray<id<FBObjectReference>> *_references;
+  NSUInteger _referenceIndex;
+
+  BOOL _retainsKeys;
+  BOOL _retainsValues;
+  BOOL _isKeyValued;
+  NSFastEnumerationState _state;
+  __unsafe_unretained id _buffer[kFBRetainedObjectsEnumeratorBatchSize];
+  NSUInteger _batchCount;
+  NSUInteger _batchIndex;
+  unsigned long _mutations;
+  NSInteger _retries;
+  FBObjectiveCGraphElement *_pendingValue;
+
+  BOOL _usesSnapshot;
+  FBCollectionSnapshotChunk *_snapshot;
+  FBCollectionSnapshotChunk *_snapshotTail;
+  NSUInteger _snapshotIndex;
+}
+
+- (instancetype)initWithElement:(FBObjectiveCObject *)element
+              associatedObjects:(NSSet *)associatedObjects
+{
+  if (self = [super init]) {
+    _element = element;
+    _configuration = element.configuration;
+    _wrap = FBGetObjectGraphElementWrapper(_configuration);
+    _skippedEdgeKinds = _configuration.skippedEdgeKinds;
+    _associatedObjects = [associatedObjects objectEnumerator];
+    _stage = FBRetainedObjectsStageAssociations;
+  }
+
+  return self;
+}
+
+- (FBObjectiveCGraphElement *)nextObject
+{
+  // Object is only pinned for the duration of a single step, entries are wrapped weakly anyway
+  __strong id object = _element.object;
+  if (!object) {
+    _stage = FBRetainedObjectsStageDone;
+  }
+
+  while (_stage != FBRetainedObjectsStageDone) {
+    switch (_stage) {
+      case FBRetainedObjectsStageAssociations: {
+        FBObjectiveCGraphElement *element = [_associatedObjects nextObject];
+        if (element) {
+          return element;
+        }
+        _associatedObjects = nil;
+        _references = FBGetObjectStrongReferences(object,
+                                                  YES,
+                                                  _configuration.shouldIncludeSwiftObjects,
+                                                  _configuration.shouldUseSwiftABITraversal,
+                                                  _configuration.shouldScanSwiftObjectMemory);
+        _stage = FBRetainedObjectsStageReferences;
+        break;
+      }
+      case FBRetainedObjectsStageReferences: {
+        FBObjectiveCGraphElement *element = [self _nextReferenceOfObject:object];
+        if (element) {
+          return element;
+        }
+        _references = nil;
+        _stage = [self _beginEnumeratingCollection:object] ? FBRetainedObjectsStageCollection : FBRetainedObjectsStageDone;
+        break;
+      }
+      case FBRetainedObjectsStageCollection: {
+        FBObjectiveCGraphElement *element = (_usesSnapshot
+                                             ? [self _nextEntryOfSnapshot]
+                                             : [self _nextEntryOfCollection:object]);
+        if (element) {
+          return element;
+        }
+        _stage = FBRetainedObjectsStageDone;
+        break;
+      }
+      case FBRetainedObjectsStageDone:
+        break;
+    }
+  }
+
+  _pendingValue = nil;
+  [self _discardSnapshot];
+  return nil;
+}
+
+- (void)dealloc
+{
+  [self _discardSnapshot];
+}
+
+- (FBObjectiveCGraphElement *)_nextReferenceOfObject:(id)object
+{
+  NSUInteger count = [_references count];
+  while (_referenceIndex < count) {
+    id<FBObjectReference> ref = _references[_referenceIndex++];
+    FBGraphEdgeKind edgeKind = [ref edgeKind];
+    if (_skippedEdgeKinds & edgeKind) {
+      continue;
+    }
+    id referencedObject = [ref objectReferenceFromObject:object];
+    if (!referencedObject) {
+      continue;
+    }
+    FBObjectiveCGraphElement *element = _wrap(_element, referencedObject, _configuration, [ref namePathID], edgeKind);
+    if (element) {
+      return element;
+    }
+  }
+
+  return nil;
+}
+
+- (BOOL)_beginEnumeratingCollection:(id)collection
+{
+  FBClassTraits traits = FBGetClassTraits(object_getClass(collection));
+  if ((traits & FBClassTraitsTollFreeBridged) ||
+      (_skippedEdgeKinds & FBGraphEdgeKindCollectionEntry) ||
+      !(traits & FBClassTraitsEnumerable)) {
+    return NO;
+  }
+
+  _retainsKeys = [_element _objectRetainsEnumerableKeys];
+  _retainsValues = [_element _objectRetainsEnumerableValues];
+  _isKeyValued = (traits & FBClassTraitsKeyValued) != 0;
+  if (!_retainsKeys && !(_isKeyValued && _retainsValues)) {
+    return NO;
+  }
+
+  FBCollectionEntries entries;
+  if (FBCopyCollectionEntries(collection, FBGetCollectionKind(traits), _retainsKeys, _retainsValues, &entries)) {
+    // Entries are only valid until the collection changes, retain them before the buffer is given back
+    BOOL didCopy = YES;
+    for (NSUInteger i = 0; i < entries.count && didCopy; ++i) {
+      if (entries.keys) {
+        didCopy = [self _addEntryToSnapshot:(__bridge const void *)entries.keys[i]];
+      }
+      if (entries.values && didCopy) {
+        didCopy = [self _addEntryToSnapshot:(__bridge const void *)entries.values[i]];
+      }
+    }
+    FBCollectionBufferRelinquish();
+    if (didCopy) {
+      _usesSnapshot = YES;
+      return YES;
+    }
+    [self _discardSnapshot];
+  }
+
+  [self _restartEnumeration];
+  return YES;
+}
+
+- (BOOL)_addEntryToSnapshot:(const void *)entry
+{
+  if (!_snapshotTail || _snapshotTail->count == kFBCollectionSnapshotChunkCapacity) {
+    FBCollectionSnapshotChunk *chunk = (FBCollectionSnapshotChunk *)malloc(sizeof(FBCollectionSnapshotChunk));
+    if (!chunk) {
+      return NO;
+    }
+    chunk->next = NULL;
+    chunk->count = 0;
+    if (_snapshotTail) {
+      _snapshotTail->next = chunk;
+    } else {
+      _snapshot = chunk;
+    }
+    _snapshotTail = chunk;
+  }
+  _snapshotTail->entries[_snapshotTail->count++] = CFRetain(entry);
+  return YES;
+}
+
+- (FBObjectiveCGraphElement *)_nextEntryOfSnapshot
+{
+  while (_snapshot) {
+    if (_snapshotIndex == _snapshot->count) {
+      FBCollectionSnapshotChunk *next = _snapshot->next;
+      free(_snapshot);
+      _snapshot = next;
+      _snapshotIndex = 0;
+      continue;
+    }
+    const void *entry = _snapshot->entries[_snapshotIndex++];
+    FBObjectiveCGraphElement *element = _wrap(_element,
+                                              (__bridge id)entry,
+                                              _configuration,
+                                              FBNamePathIDNone,
+                                              FBGraphEdgeKindCollectionEntry);
+    // Wrapper holds the entry weakly, like entries wrapped straight from the collection
+    CFRelease(entry);
+    if (element) {
+      return element;
+    }
+  }
+
+  _snapshotTail = NULL;
+  return nil;
+}
+
+- (void)_discardSnapshot
+{
+  while (_snapshot) {
+    for (NSUInteger i = _snapshotIndex; i < _snapshot->count; ++i) {
+      CFRelease(_snapshot->entries[i]);
+    }
+    FBCollectionSnapshotChunk *next = _snapshot->next;
+    free(_snapshot);
+    _snapshot = next;
+    _snapshotIndex = 0;
+  }
+  _snapshotTail = NULL;
+}
+
+- (void)_restartEnumeration
+{
+  memset(&_state, 0, sizeof(_state));
+  _batchCount = 0;
+  _batchIndex = 0;
+}
+
+/**
+ Same rules for mutations as with for-in loop: items handed out by the collection are only valid as long as
+ mutations counter didn't change. When it does, we start over, and give up after a few tries. Only collections
+ we can't copy in one pass get here.
+ */
+- (BOOL)_retryAfterMutation
+{
+  FB_RCD_STATS_INCREMENT(CollectionEnumerationRetries);
+  if (++_retries >= kFBRetainedObjectsEnumeratorMaximumRetries) {
+    return NO;
+  }
+  [self _restartEnumeration];
+  return YES;
+}
+
+- (FBObjectiveCGraphElement *)_nextEntryOfCollection:(id)collection
+{
+  if (_pendingValue) {
+    FBObjectiveCGraphElement *value = _pendingValue;
+    _pendingValue = nil;
+    return value;
+  }
+
+  for (;;) {
+    if (_state.mutationsPtr && *_state.mutationsPtr != _mutations) {
+      if (![self _retryAfterMutation]) {
+        return nil;
+      }
+      continue;
+    }
+
+    if (_batchIndex == _batchCount) {
+      BOOL isFirstBatch = (_state.state == 0);
+      @try {
+        _batchCount = [collection countByEnumeratingWithState:&_state
+                                                      objects:_buffer
+                                                        count:kFBRetainedObjectsEnumeratorBatchSize];
+      }
+      @catch (NSException *exception) {
+        if (![self _retryAfterMutation]) {
+          return nil;
+        }
+        continue;
+      }
+      _batchIndex = 0;
+      if (_batchCount == 0) {
+        return nil;
+      }
+      if (isFirstBatch && _state.mutationsPtr) {
+        _mutations = *_state.mutationsPtr;
+      }
+    }
+
+    __unsafe_unretained id key = _state.itemsPtr[_batchIndex++];
+    FBObjectiveCGraphElement *keyElement = nil;
+    if (_retainsKeys) {
+      keyElement = _wrap(_element, key, _configuration, FBNamePathIDNone, FBGraphEdgeKindCollectionEntry);
+    }
+    FBObjectiveCGraphElement *valueElement = nil;
+    if (_isKeyValued && _retainsValues) {
+      id value = nil;
+      @try {
+        value = [collection objectForKey:key];
+      }
+      @catch (NSException *exception) {
+        if (![self _retryAfterMutation]) {
+          return nil;
+        }
+        continue;
+      }
+      if (_state.mutationsPtr && *_state.mutationsPtr != _mutations) {
+        // Accessor mutated the collection, neither key nor value can be trusted
+        continue;
+      }
+      valueElement = _wrap(_element, value, _configuration, FBNamePathIDNone, FBGraphEdgeKindCollectionEntry);
+    }
+
+    if (keyElement) {
+      _pendingValue = valueElement;
+      return keyElement;
+    }
+    if (valueElement) {
+      return valueElement;
+    }
+  }
+}
+
+@end
+
 @implementation FBObjectiveCObject
 
+- (NSEnumerator<FBObjectiveCGraphElement *> *)retainedObjectsEnumerator
+{
+  __strong id object = self.object;
+  if (!object ||
+      (FBGetClassTraits(object_getClass(object)) & FBClassTraitsMetaClass) ||
+      [self methodForSelector:@selector(allRetainedObjects)] !=
+      [FBObjectiveCObject instanceMethodForSelector:@selector(allRetainedObjects)]) {
+    // Pure Swift objects have to stay pinned while their layout is read, and specializations add their own
+    // references on top, so these get the whole set at once
+    return [super retainedObjectsEnumerator];
+  }
+
+  return [[FBObjectiveCObjectRetainedObjectsEnumerator alloc] initWithElement:self
+                                                            associatedObjects:[super allRetainedObjects]];
+}
+
+
 - (NSSet *)allRetainedObjects
 {
   // Pin the object alive for the entire method. For ObjC objects, reading
@@ -56,27 +611,31 @@
     if (didRetainSwiftObject) { CFRelease(ptr); }
     return nil;
   }
+  FBClassTraits traits = FBGetClassTraits(aCls);
 
-  NSArray *strongIvars = FBGetObjectStrongReferences(obj, self.configuration.layoutCache, self.configuration.shouldIncludeSwiftObjects, self.configuration.shouldUseSwiftABITraversal, self.configuration.shouldScanSwiftObjectMemory);
+  FBObjectGraphConfiguration *configuration = self.configuration;
+  NSArray *strongIvars = FBGetObjectStrongReferences(obj, YES, configuration.shouldIncludeSwiftObjects, configuration.shouldUseSwiftABITraversal, configuration.shouldScanSwiftObjectMemory);
 
   NSMutableArray *retainedObjects = [[[super allRetainedObjects] allObjects] mutableCopy];
+  FBGraphEdgeKind skippedEdgeKinds = configuration.skippedEdgeKinds;
+  FBObjectGraphElementWrapper wrap = FBGetObjectGraphElementWrapper(configuration);
 
   for (id<FBObjectReference> ref in strongIvars) {
+    FBGraphEdgeKind edgeKind = [ref edgeKind];
+    if (skippedEdgeKinds & edgeKind) {
+      continue;
+    }
     id referencedObject = [ref objectReferenceFromObject:obj];
 
     if (referencedObject) {
-      NSArray<NSString *> *namePath = [ref namePath];
-      FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithContext(self,
-                                                                              referencedObject,
-                                                                              self.configuration,
-                                                                              namePath);
+      FBObjectiveCGraphElement *element = wrap(self, referencedObject, configuration, [ref namePathID], edgeKind);
       if (element) {
         [retainedObjects addObject:element];
       }
     }
   }
 
-  if ([NSStringFromClass(aCls) hasPrefix:@"__NSCF"]) {
+  if (traits & FBClassTraitsTollFreeBridged) {
     /**
      If we are dealing with toll-free bridged collections, we are not guaranteed that the collection
      will hold only Objective-C objects. We are not able to check in runtime what callbacks it uses to
@@ -86,20 +645,28 @@
     return [NSSet setWithArray:retainedObjects];
   }
 
-  if (class_isMetaClass(aCls)) {
+  if (traits & FBClassTraitsMetaClass) {
     // If it's a meta-class it can conform to following protocols,
     // but it would crash when trying enumerating
     if (didRetainSwiftObject) { CFRelease(ptr); }
     return nil;
   }
 
-  if ([aCls conformsToProtocol:@protocol(NSFastEnumeration)]) {
+  if (!(skippedEdgeKinds & FBGraphEdgeKindCollectionEntry) &&
+      (traits & FBClassTraitsEnumerable)) {
     BOOL retainsKeys = [self _objectRetainsEnumerableKeys];
     BOOL retainsValues = [self _objectRetainsEnumerableValues];
 
-    BOOL isKeyValued = NO;
-    if ([aCls instancesRespondToSelector:@selector(objectForKey:)]) {
-      isKeyValued = YES;
+    BOOL isKeyValued = (traits & FBClassTraitsKeyValued) != 0;
+
+    if ([self _addRetainedObjectsOfCollection:obj
+                                         kind:FBGetCollectionKind(traits)
+                                  retainsKeys:retainsKeys
+                                retainsValues:retainsValues
+                                      wrapper:wrap
+                                      toArray:retainedObjects]) {
+      if (didRetainSwiftObject) { CFRelease(ptr); }
+      return [NSSet setWithArray:retainedObjects];
     }
 
     /**
@@ -114,15 +681,21 @@
       @try {
         for (id subobject in obj) {
           if (retainsKeys) {
-            FBObjectiveCGraphElement *element = FBWrapObjectGraphElement(self, subobject, self.configuration);
+            FBObjectiveCGraphElement *element = wrap(self,
+                                                     subobject,
+                                                     configuration,
+                                                     FBNamePathIDNone,
+                                                     FBGraphEdgeKindCollectionEntry);
             if (element) {
               [temporaryRetainedObjects addObject:element];
             }
           }
           if (isKeyValued && retainsValues) {
-            FBObjectiveCGraphElement *element = FBWrapObjectGraphElement(self,
-                                                                         [obj objectForKey:subobject],
-                                                                         self.configuration);
+            FBObjectiveCGraphElement *element = wrap(self,
+                                                     [obj objectForKey:subobject],
+                                                     configuration,
+                                                     FBNamePathIDNone,
+                                                     FBGraphEdgeKindCollectionEntry);
             if (element) {
               [temporaryRetainedObjects addObject:element];
             }
@@ -131,6 +704,7 @@
       }
       @catch (NSException *exception) {
         // mutation happened, we want to try enumerating again
+        FB_RCD_STATS_INCREMENT(CollectionEnumerationRetries);
         continue;
       }
 
@@ -144,6 +718,44 @@
   return [NSSet setWithArray:retainedObjects];
 }
 
+/**
+ Fast path for Foundation collections. Contents are copied into a buffer with one call, so we don't pay a message
+ send per element, nor restart the enumeration when collection gets mutated.
+
+ @return NO if collection kind is not known, or copying failed and caller should enumerate instead
+ */
+- (BOOL)_addRetainedObjectsOfCollection:(id)collection
+                                   kind:(FBCollectionKind)kind
+                            retainsKeys:(BOOL)retainsKeys
+                          retainsValues:(BOOL)retainsValues
+                                wrapper:(FBObjectGraphElementWrapper)wrap
+                                toArray:(NSMutableArray *)retainedObjects
+{
+  FBCollectionEntries entries;
+  if (!FBCopyCollectionEntries(collection, kind, retainsKeys, retainsValues, &entries)) {
+    return NO;
+  }
+
+  FBObjectGraphConfiguration *configuration = self.configuration;
+  for (NSUInteger i = 0; i < entries.count; ++i) {
+    if (entries.keys) {
+      FBObjectiveCGraphElement *element = wrap(self, entries.keys[i], configuration, FBNamePathIDNone, FBGraphEdgeKindCollectionEntry);
+      if (element) {
+        [retainedObjects addObject:element];
+      }
+    }
+    if (entries.values) {
+      FBObjectiveCGraphElement *element = wrap(self, entries.values[i], configuration, FBNamePathIDNone, FBGraphEdgeKindCollectionEntry);
+      if (element) {
+        [retainedObjects addObject:element];
+      }
+    }
+  }
+
+  FBCollectionBufferRelinquish();
+  return YES;
+}
+
 - (BOOL)_objectRetainsEnumerableValues
 {
   if ([self.object respondsToSelector:@selector(valuePointerFunctions)]) {
@@ -0,0 +1,22 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FBObjectGraphConfiguration.h"
+#import "FBRetainCycleUtils.h"
+
+@interface FBObjectGraphConfiguration ()
+
+/**
+ Picked once, when configuration is created, since all options it depends on are readonly.
+ @see FBGetObjectGraphElementWrapper
+ */
+@property (nonatomic, readonly, nullable) FBObjectGraphElementWrapper graphElementWrapper;
+
+@end
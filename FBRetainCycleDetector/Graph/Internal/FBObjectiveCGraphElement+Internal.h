@@ -8,10 +8,25 @@
 
 #import <Foundation/Foundation.h>
 
+#import "FBNamePathTable.h"
 #import "FBObjectiveCGraphElement.h"
 
 @interface FBObjectiveCGraphElement ()
 
+@property (nonatomic, readwrite) FBGraphEdgeKind edgeKind;
+
+/**
+ Interned namePath, compared and hashed instead of the strings.
+ */
+@property (nonatomic, readonly) FBNamePathID namePathID;
+
 - (instancetype)initWithObject:(id)object;
 
+/**
+ Used when wrapping edges, namePath is only materialized if someone asks for it.
+ */
+- (instancetype)initWithObject:(id)object
+                 configuration:(FBObjectGraphConfiguration *)configuration
+                    namePathID:(FBNamePathID)namePathID;
+
 @end
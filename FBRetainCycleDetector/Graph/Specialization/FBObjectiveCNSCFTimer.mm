@@ -34,6 +34,12 @@ typedef struct {
   }
 
   NSMutableSet *retained = [[super allRetainedObjects] mutableCopy];
+  if (self.configuration.skippedEdgeKinds & FBGraphEdgeKindTimerTarget) {
+    return retained;
+  }
+
+  static const FBNamePathID targetNamePathID = FBInternNamePath(@[@"target"]);
+  static const FBNamePathID userInfoNamePathID = FBInternNamePath(@[@"userInfo"]);
 
   CFRunLoopTimerContext context;
   CFRunLoopTimerGetContext((CFRunLoopTimerRef)timer, &context);
@@ -42,13 +48,13 @@ typedef struct {
   if (context.info && context.retain) {
     _FBNSCFTimerInfoStruct infoStruct = *(_FBNSCFTimerInfoStruct *)(context.info);
     if (infoStruct.target) {
-      FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithContext(self, infoStruct.target, self.configuration, @[@"target"]);
+      FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithEdgeKind(self, infoStruct.target, self.configuration, targetNamePathID, FBGraphEdgeKindTimerTarget);
       if (element) {
         [retained addObject:element];
       }
     }
     if (infoStruct.userInfo) {
-      FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithContext(self, infoStruct.userInfo, self.configuration, @[@"userInfo"]);
+      FBObjectiveCGraphElement *element = FBWrapObjectGraphElementWithEdgeKind(self, infoStruct.userInfo, self.configuration, userInfoNamePathID, FBGraphEdgeKindTimerTarget);
       if (element) {
         [retained addObject:element];
       }
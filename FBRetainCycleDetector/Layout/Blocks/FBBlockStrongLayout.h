@@ -19,6 +19,23 @@ extern "C" {
 NSArray *_Nullable FBGetBlockStrongReferences(void *_Nonnull block);
 
 BOOL FBObjectIsBlock(void *_Nullable object);
+
+/**
+ Walks the class hierarchy, FBObjectIsBlock uses cached class traits instead.
+ */
+BOOL FBClassIsBlock(Class _Nullable aCls);
+
+/**
+ Offsets, from the start of the block, of objects captured strongly by blocks with given flags and descriptor. Only
+ depends on the block literal, so it can be used without a block at hand. Objects captured through __block
+ variables are not included.
+
+ @return Number of offsets written, at most maximumCount.
+ */
+NSUInteger FBGetBlockStrongCaptureOffsets(int flags,
+                                          const void *_Nonnull descriptor,
+                                          uint32_t *_Nonnull offsets,
+                                          NSUInteger maximumCount);
   
 #ifdef __cplusplus
 }
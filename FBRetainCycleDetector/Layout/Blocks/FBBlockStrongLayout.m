@@ -17,6 +17,7 @@
 
 #import "FBBlockInterface.h"
 #import "FBBlockStrongRelationDetector.h"
+#import "FBClassTraits.h"
 
 /**
  Validate that a raw pointer is safe to bridge to `id` and retain.
@@ -70,25 +71,29 @@ static BOOL _FBIsRetainableObjCPointer(const void *ptr) {
    [signature]                                              -- if BLOCK_HAS_SIGNATURE
    [layout]                                                 -- if BLOCK_HAS_EXTENDED_LAYOUT
  */
-static const char *_GetBlockDescriptorLayout(struct BlockLiteral *blockLiteral) {
-  uint8_t *desc = (uint8_t *)blockLiteral->descriptor;
+static const char *_GetBlockDescriptorLayoutWithFlags(int flags, const void *descriptor) {
+  uint8_t *desc = (uint8_t *)descriptor;
 
   // Skip past reserved and size (always present).
   desc += sizeof(unsigned long int); // reserved
   desc += sizeof(unsigned long int); // size
 
-  if (blockLiteral->flags & BLOCK_HAS_COPY_DISPOSE) {
+  if (flags & BLOCK_HAS_COPY_DISPOSE) {
     desc += sizeof(void *); // copy_helper
     desc += sizeof(void *); // dispose_helper
   }
 
-  if (blockLiteral->flags & BLOCK_HAS_SIGNATURE) {
+  if (flags & BLOCK_HAS_SIGNATURE) {
     desc += sizeof(void *); // signature
   }
 
   return *(const char **)desc;
 }
 
+static const char *_GetBlockDescriptorLayout(struct BlockLiteral *blockLiteral) {
+  return _GetBlockDescriptorLayoutWithFlags(blockLiteral->flags, blockLiteral->descriptor);
+}
+
 static NSArray *_GetStrongReferencesCompactLayout(struct BlockLiteral *blockLiteral, const char *layout) {
   NSMutableArray *strongReferences = [NSMutableArray array];
 
@@ -188,6 +193,40 @@ NSArray *FBGetBlockStrongReferences(void *block) {
   }
 }
 
+NSUInteger FBGetBlockStrongCaptureOffsets(int flags,
+                                          const void *descriptor,
+                                          uint32_t *offsets,
+                                          NSUInteger maximumCount) {
+  if (!(flags & BLOCK_HAS_EXTENDED_LAYOUT) || !(flags & BLOCK_HAS_COPY_DISPOSE)) {
+    return 0;
+  }
+
+  NSUInteger count = 0;
+  const uint32_t storageOffset = sizeof(struct BlockLiteral);
+  const char *layout = _GetBlockDescriptorLayoutWithFlags(flags, descriptor);
+  if ((uintptr_t)layout < 0x1000) {
+    // Compact layout starts with strong references
+    int strongReferenceCount = ((uintptr_t)layout & 0xF00) >> 8;
+    for (int i = 0; i < strongReferenceCount && count < maximumCount; i++) {
+      offsets[count++] = storageOffset + i * sizeof(void *);
+    }
+    return count;
+  }
+
+  uint32_t wordOffset = 0;
+  for (int i = 0; layout[i] != 0x00; i++) {
+    int p = (layout[i] & 0xF0) >> 4;
+    int n = (layout[i] & 0x0F) + 1;
+    if (p == BLOCK_LAYOUT_STRONG) {
+      for (int j = 0; j < n && count < maximumCount; j++) {
+        offsets[count++] = storageOffset + (wordOffset + j) * sizeof(void *);
+      }
+    }
+    wordOffset += n;
+  }
+  return count;
+}
+
 static Class _BlockClass(void) {
   static dispatch_once_t onceToken;
   static Class blockClass;
@@ -202,9 +241,11 @@ static Class _BlockClass(void) {
   return blockClass;
 }
 
-BOOL FBObjectIsBlock(void *object) {
+BOOL FBClassIsBlock(Class aCls) {
   Class blockClass = _BlockClass();
+  return [aCls isSubclassOfClass:blockClass];
+}
 
-  Class candidate = object_getClass((__bridge id)object);
-  return [candidate isSubclassOfClass:blockClass];
+BOOL FBObjectIsBlock(void *object) {
+  return (FBGetClassTraits(object_getClass((__bridge id)object)) & FBClassTraitsBlock) != 0;
 }
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ @param computedCount Number of classes whose layout was not cached before.
+ */
+typedef void (^FBClassLayoutPrewarmerCompletionHandler)(NSUInteger computedCount);
+
+/**
+ FBClassLayoutPrewarmer
+
+ The first time a scan reaches an object of some class, it has to read the ivars of the class and parse their layout
+ and struct encodings, which is slow. Prewarmer does that ahead of time, on background queues and in parallel, and
+ installs layouts in the cache shared by all scans. Run it shortly after launch, so later scans find caches warm.
+
+ Only Objective-C layouts are prewarmed. Pure Swift objects traversed with shouldIncludeSwiftObjects are still
+ resolved during scans. Classes are realized by the runtime when their layout is read, which takes some memory for
+ classes that would otherwise never be used.
+
+ The class is thread safe.
+ */
+@interface FBClassLayoutPrewarmer : NSObject
+
+/**
+ Computes layouts of given classes and their superclasses.
+
+ @param completionHandler Called on a background queue once all layouts are installed.
+ */
++ (void)prewarmLayoutsOfClasses:(nonnull NSArray<Class> *)classes
+              completionHandler:(nullable FBClassLayoutPrewarmerCompletionHandler)completionHandler;
+
+/**
+ Computes layouts of all classes defined in the image at given path, as returned by objc_copyClassNamesForImage.
+ */
++ (void)prewarmLayoutsOfClassesInImage:(nonnull NSString *)imagePath
+                     completionHandler:(nullable FBClassLayoutPrewarmerCompletionHandler)completionHandler;
+
+/**
+ Computes layouts of all classes defined in the main executable of the app.
+ */
++ (void)prewarmLayoutsOfClassesInMainExecutableWithCompletionHandler:(nullable FBClassLayoutPrewarmerCompletionHandler)completionHandler;
+
+/**
+ Drops layouts computed or prewarmed so far from the cache shared by all scans, for example after classes were
+ changed at runtime in a way that affects their ivars. Precompiled layouts stay loaded.
+ */
++ (void)resetLayouts;
+
+/**
+ Loads layouts written at build time by tools/rcd_layout_extractor from the app binary, replacing layouts loaded
+ before. Layouts are looked up by class name when a class is met for the first time, and only trusted if the class
+ still has the instance size, ivar layout and ivar offsets it had in the binary; otherwise its layout is computed as
+ usual. Layouts that were already computed or prewarmed are kept.
+
+ @return NO if data is not a table of layouts for this architecture.
+ */
++ (BOOL)loadPrecompiledLayoutsFromData:(nonnull NSData *)data;
+
+/**
+ Loads ownership of Swift fields and closure captures written at build time by tools/rcd_swift_field_extractor from
+ an app binary or framework, used by scans with shouldUseSwiftABITraversal. Mangled type names of classes in the table
+ don't have to be resolved during scans, and fields keep being found when reflection metadata is stripped from the
+ shipped binary. Tables of several images can be loaded.
+
+ @return NO if data is not a table, or it was extracted from a binary that is not loaded.
+ */
++ (BOOL)loadPrecompiledSwiftFieldsFromData:(nonnull NSData *)data;
+
+@end
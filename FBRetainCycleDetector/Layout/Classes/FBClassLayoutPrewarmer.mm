@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBClassLayoutPrewarmer.h"
+
+#import <atomic>
+#import <objc/runtime.h>
+#import <vector>
+
+#import "FBClassStrongLayout.h"
+#import "FBPrecompiledSwiftFields.h"
+
+// Small enough for work to spread evenly over cores, big enough not to pay dispatch overhead for every class
+static const size_t kFBClassLayoutPrewarmerChunkSize = 64;
+
+static void FBPrewarmClassLayouts(std::vector<__unsafe_unretained Class> classes,
+                                  FBClassLayoutPrewarmerCompletionHandler completionHandler) {
+  std::atomic<NSUInteger> computedCount(0);
+  std::atomic<NSUInteger> *computedCountPointer = &computedCount;
+  const size_t chunkCount = (classes.size() + kFBClassLayoutPrewarmerChunkSize - 1) / kFBClassLayoutPrewarmerChunkSize;
+  const __unsafe_unretained Class *classesData = classes.data();
+  const size_t classCount = classes.size();
+
+  dispatch_apply(chunkCount, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(size_t chunk) {
+    @autoreleasepool {
+      size_t end = MIN((chunk + 1) * kFBClassLayoutPrewarmerChunkSize, classCount);
+      for (size_t i = chunk * kFBClassLayoutPrewarmerChunkSize; i < end; ++i) {
+        if (FBPrewarmClassStrongLayout(classesData[i])) {
+          (*computedCountPointer)++;
+        }
+      }
+    }
+  });
+
+  if (completionHandler) {
+    completionHandler(computedCount.load());
+  }
+}
+
+@implementation FBClassLayoutPrewarmer
+
++ (void)prewarmLayoutsOfClasses:(NSArray<Class> *)classes
+              completionHandler:(FBClassLayoutPrewarmerCompletionHandler)completionHandler
+{
+  NSArray<Class> *classesCopy = [classes copy];
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+    std::vector<__unsafe_unretained Class> classesToPrewarm;
+    classesToPrewarm.reserve([classesCopy count]);
+    for (Class aCls in classesCopy) {
+      classesToPrewarm.push_back(aCls);
+    }
+    FBPrewarmClassLayouts(std::move(classesToPrewarm), completionHandler);
+  });
+}
+
++ (void)prewarmLayoutsOfClassesInImage:(NSString *)imagePath
+                     completionHandler:(FBClassLayoutPrewarmerCompletionHandler)completionHandler
+{
+  NSString *imagePathCopy = [imagePath copy];
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+    std::vector<__unsafe_unretained Class> classesToPrewarm;
+    unsigned int count = 0;
+    const char **classNames = objc_copyClassNamesForImage([imagePathCopy fileSystemRepresentation], &count);
+    classesToPrewarm.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+      Class aCls = objc_lookUpClass(classNames[i]);
+      if (aCls) {
+        classesToPrewarm.push_back(aCls);
+      }
+    }
+    free(classNames);
+    FBPrewarmClassLayouts(std::move(classesToPrewarm), completionHandler);
+  });
+}
+
++ (void)prewarmLayoutsOfClassesInMainExecutableWithCompletionHandler:(FBClassLayoutPrewarmerCompletionHandler)completionHandler
+{
+  NSString *executablePath = [[NSBundle mainBundle] executablePath];
+  if (!executablePath) {
+    if (completionHandler) {
+      dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        completionHandler(0);
+      });
+    }
+    return;
+  }
+  [self prewarmLayoutsOfClassesInImage:executablePath completionHandler:completionHandler];
+}
+
++ (void)resetLayouts
+{
+  FBResetClassStrongLayouts();
+}
+
++ (BOOL)loadPrecompiledLayoutsFromData:(NSData *)data
+{
+  return FBLoadPrecompiledClassLayouts(data);
+}
+
++ (BOOL)loadPrecompiledSwiftFieldsFromData:(NSData *)data
+{
+  return FBLoadPrecompiledSwiftFields(data);
+}
+
+@end
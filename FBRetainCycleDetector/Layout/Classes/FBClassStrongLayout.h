@@ -18,13 +18,44 @@ extern "C" {
 /**
  @return An array of id<FBObjectReference> objects that will have only those references
  that are retained by the object. It also goes through parent classes.
+ @param shouldUseSharedLayouts If YES, layouts that only depend on the class are taken from, and added to, the store
+ shared by all scans in the process. FBResetClassStrongLayouts empties it.
  */
 NSArray<id<FBObjectReference>> *_Nonnull FBGetObjectStrongReferences(id _Nullable obj,
-                                                                     NSMutableDictionary<NSString*, NSArray<id<FBObjectReference>> *> *_Nullable layoutCache,
+                                                                     BOOL shouldUseSharedLayouts,
                                                                      BOOL shouldIncludeSwiftObjects,
                                                                      BOOL shouldUseSwiftABITraversal,
                                                                      BOOL shouldScanSwiftObjectMemory);
 
+/**
+ Computes strong layouts of given class and its superclasses, as seen by Objective-C, and installs them in the layout
+ store shared by all scans. Thread safe.
+
+ @return YES if any layout had to be computed, NO if all of them were cached already.
+ */
+BOOL FBPrewarmClassStrongLayout(Class _Nonnull aCls);
+
+/**
+ Drops all layouts from the store shared by all scans, so they are computed again when next needed. Precompiled
+ layouts stay loaded. Thread safe.
+ */
+void FBResetClassStrongLayouts(void);
+
+/**
+ Strong references of instances of given class, including ones declared by superclasses, without an instance at
+ hand. Layouts come from the cache shared by all scans. Swift classes are always described through Mirror, since ABI
+ traversal and memory scanning need an instance.
+ */
+NSArray<id<FBObjectReference>> *_Nonnull FBGetClassStrongReferences(Class _Nonnull aCls, BOOL shouldIncludeSwiftObjects);
+
+/**
+ Installs strong layouts extracted from the app binary at build time, replacing ones installed before. Layouts that
+ were already computed are kept. Thread safe.
+
+ @return NO if data is not a valid table for this architecture, in which case nothing is installed.
+ */
+BOOL FBLoadPrecompiledClassLayouts(NSData *_Nonnull data);
+
 #ifdef __cplusplus
 }
 #endif
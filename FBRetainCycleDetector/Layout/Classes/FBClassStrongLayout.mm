@@ -8,10 +8,13 @@
 
 #import "FBClassStrongLayout.h"
 
+#import <atomic>
 #import <mach/mach.h>
 #import <math.h>
 #import <memory>
+#import <mutex>
 #import <objc/runtime.h>
+#import <unordered_map>
 #import <vector>
 
 #import <UIKit/UIKit.h>
@@ -25,6 +28,8 @@
 #import "Type.h"
 #import "FBClassSwiftHelpers.h"
 #import "FBObjectReferenceWithLayout.h"
+#import "FBPrecompiledLayoutTable.h"
+#import "FBRetainCycleDetectorStatistics+Internal.h"
 #import "FBSwiftReference.h"
 #import "FBSwiftABIReference.h"
 #import "FBSwiftABICaptureReference.h"
@@ -195,34 +200,46 @@ static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForObjectiveCClass(C
   return filteredIvars;
 }
 
-static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForSwiftClass(id obj, Class aCls) {
+/**
+ Strong references of a Swift class, as told by Mirror. Properties that hold a single object pointer are read by
+ their offset, anything else (strings, collections, existentials, ...) is looked up through Mirror by name.
+ */
+static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForSwiftClass(Class aCls) {
     // This contains all the Swift properties, including of it superclasses (recursive until any Objective-c class)
-    NSArray<PropertyIntrospection *> *const properties = [SwiftIntrospector getPropertiesRecursiveWithObject:obj];
+    NSArray<PropertyIntrospection *> *const properties = [SwiftIntrospector getPropertiesRecursiveOfClass:aCls];
 
-    // Since we only want properties for this class, lets create a map and check against `class_copyIvarList`, which isn't recursive
-    NSMutableDictionary<NSString *, PropertyIntrospection *> *const propertyMap = [NSMutableDictionary new];
+    // Since we only want properties for this class, lets index them by offset and check against `class_copyIvarList`,
+    // which isn't recursive
+    std::unordered_map<ptrdiff_t, PropertyIntrospection *> propertiesByOffset;
     for (PropertyIntrospection *property in properties) {
-        [propertyMap setObject:property forKey:[NSString stringWithFormat:@"%@%i", property.name, (int)property.offset]];
+        propertiesByOffset[property.offset] = property;
     }
 
     NSMutableArray<id<FBObjectReference>> *const result = [NSMutableArray new];
 
     // class_copyIvarList still works for Swift objects, including pure Swift objects
-    // Maybe a safer way would be to use the Mirror API
     unsigned int count;
     Ivar *ivars = class_copyIvarList(aCls, &count);
 
     for (unsigned int i = 0; i < count; ++i) {
         Ivar ivar = ivars[i];
         const char *utf8Name = ivar_getName(ivar);
-        NSString *const ivarName = (utf8Name == NULL) ? nil : [NSString stringWithUTF8String:utf8Name];
+        if (!utf8Name) {
+            continue;
+        }
         const ptrdiff_t offset = ivar_getOffset(ivar);
-        NSString *const propertyKey = [NSString stringWithFormat:@"%@%i", ivarName, (int)offset];
-
-        PropertyIntrospection *property = [propertyMap objectForKey:propertyKey];
-        if (property && property.isStrong) {
-            FBSwiftReference *wrapper = [[FBSwiftReference alloc] initWithName:ivarName];
-            [result addObject:wrapper];
+        auto property = propertiesByOffset.find(offset);
+        if (property == propertiesByOffset.end() || !property->second.isStrong) {
+            continue;
+        }
+        NSString *const ivarName = [NSString stringWithUTF8String:utf8Name];
+        if (![property->second.name isEqualToString:ivarName]) {
+            continue;
+        }
+        if (property->second.isClassReference) {
+            [result addObject:[[FBSwiftABIReference alloc] initWithName:ivarName offset:offset]];
+        } else {
+            [result addObject:[[FBSwiftReference alloc] initWithName:ivarName]];
         }
     }
     free(ivars);
@@ -230,6 +247,145 @@ static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForSwiftClass(id obj
     return [result copy];
 }
 
+/**
+ Layouts extracted from the app binary at build time. Replaced as a whole when another table is loaded, so lookups
+ only need to hold on to the table they started with.
+ */
+static std::shared_ptr<const FB::RetainCycleDetector::PrecompiledLayoutReader> &FBPrecompiledClassLayouts() {
+  static auto *layouts = new std::shared_ptr<const FB::RetainCycleDetector::PrecompiledLayoutReader>();
+  return *layouts;
+}
+
+BOOL FBLoadPrecompiledClassLayouts(NSData *data) {
+  auto layouts = std::make_shared<FB::RetainCycleDetector::PrecompiledLayoutReader>();
+  if (!layouts->read((const uint8_t *)data.bytes, data.length, sizeof(void *))) {
+    return NO;
+  }
+  std::atomic_store(&FBPrecompiledClassLayouts(),
+                    std::shared_ptr<const FB::RetainCycleDetector::PrecompiledLayoutReader>(std::move(layouts)));
+  return YES;
+}
+
+/**
+ Strong references of a class from the precompiled table. The table is only trusted if the class still looks the way
+ it did in the binary: same instance size, same ivar layout starting at the same ivar, and ivars at their offsets.
+
+ @return nil if there is no usable precompiled layout, in which case the layout has to be computed
+ */
+static NSArray<id<FBObjectReference>> *FBGetPrecompiledStrongReferencesForObjectiveCClass(Class aCls) {
+  auto layouts = std::atomic_load(&FBPrecompiledClassLayouts());
+  if (!layouts) {
+    return nil;
+  }
+  const FB::RetainCycleDetector::PrecompiledClassLayout *layout = layouts->findClass(class_getName(aCls));
+  if (!layout ||
+      layout->instanceSize != class_getInstanceSize(aCls) ||
+      layout->ivarLayoutHash != FB::RetainCycleDetector::ivarLayoutHash(class_getIvarLayout(aCls))) {
+    return nil;
+  }
+
+  unsigned int count;
+  Ivar *ivars = class_copyIvarList(aCls, &count);
+  const ptrdiff_t firstIvarOffset = count > 0 ? ivar_getOffset(ivars[0]) : 0;
+  free(ivars);
+  if (firstIvarOffset != (ptrdiff_t)layout->firstIvarOffset) {
+    return nil;
+  }
+
+  NSMutableArray<id<FBObjectReference>> *references = [NSMutableArray arrayWithCapacity:layout->slots.size()];
+  for (const auto &slot: layout->slots) {
+    if (slot.kind == FB::RetainCycleDetector::PrecompiledSlotKind::Ivar) {
+      Ivar ivar = class_getInstanceVariable(aCls, slot.namePath[0].c_str());
+      if (!ivar || ivar_getOffset(ivar) != (ptrdiff_t)slot.offset) {
+        return nil;
+      }
+      [references addObject:[[FBIvarReference alloc] initWithIvar:ivar]];
+    } else {
+      NSMutableArray<NSString *> *namePath = [NSMutableArray arrayWithCapacity:slot.namePath.size()];
+      for (const auto &name: slot.namePath) {
+        NSString *nameString = [NSString stringWithUTF8String:name.c_str()];
+        if (nameString) {
+          [namePath addObject:nameString];
+        }
+      }
+      [references addObject:[[FBObjectInStructReference alloc] initWithIndex:slot.offset / sizeof(void *)
+                                                                    namePath:namePath]];
+    }
+  }
+  return [references copy];
+}
+
+/**
+ Layouts of Objective-C classes, and Mirror layouts of Swift classes, only depend on the class, so they are computed
+ once and shared by all scans and threads. Entries remember the name of their class, in case a disposed class pair is
+ replaced by another class at the same address.
+ */
+struct FBSharedClassLayout {
+  const char *className;
+  NSArray<id<FBObjectReference>> *layout;
+};
+
+static std::mutex &FBSharedClassLayoutsMutex() {
+  static std::mutex *mutex = new std::mutex;
+  return *mutex;
+}
+
+// Classes are aligned, so the low bit of the key tells the Mirror layout of a Swift class from its Objective-C layout
+static std::unordered_map<uintptr_t, FBSharedClassLayout> &FBSharedClassLayouts() {
+  static auto *layouts = new std::unordered_map<uintptr_t, FBSharedClassLayout>();
+  return *layouts;
+}
+
+static NSArray<id<FBObjectReference>> *FBGetSharedStrongReferencesForClass(Class aCls, BOOL usesSwiftMirror, BOOL *cached) {
+  const char *className = class_getName(aCls);
+  const uintptr_t key = (uintptr_t)aCls | (usesSwiftMirror ? 1 : 0);
+  {
+    std::lock_guard<std::mutex> l(FBSharedClassLayoutsMutex());
+    auto layout = FBSharedClassLayouts().find(key);
+    if (layout != FBSharedClassLayouts().end() && layout->second.className == className) {
+      *cached = YES;
+      return layout->second.layout;
+    }
+  }
+
+  // Computed outside of the lock, two threads racing for the same class compute the same layout
+  NSArray<id<FBObjectReference>> *layout = nil;
+  if (usesSwiftMirror) {
+    layout = FBGetStrongReferencesForSwiftClass(aCls);
+  } else {
+    layout = FBGetPrecompiledStrongReferencesForObjectiveCClass(aCls) ?: FBGetStrongReferencesForObjectiveCClass(aCls);
+  }
+  std::lock_guard<std::mutex> l(FBSharedClassLayoutsMutex());
+  FBSharedClassLayouts()[key] = {className, layout};
+  *cached = NO;
+  return layout;
+}
+
+BOOL FBPrewarmClassStrongLayout(Class aCls) {
+  BOOL computed = NO;
+  for (Class currentClass = aCls; currentClass; currentClass = class_getSuperclass(currentClass)) {
+    BOOL cached;
+    FBGetSharedStrongReferencesForClass(currentClass, NO, &cached);
+    computed = computed || !cached;
+  }
+  return computed;
+}
+
+void FBResetClassStrongLayouts(void) {
+  std::lock_guard<std::mutex> l(FBSharedClassLayoutsMutex());
+  FBSharedClassLayouts().clear();
+}
+
+NSArray<id<FBObjectReference>> *FBGetClassStrongReferences(Class aCls, BOOL shouldIncludeSwiftObjects) {
+  NSMutableArray<id<FBObjectReference>> *array = [NSMutableArray new];
+  for (Class currentClass = aCls; currentClass; currentClass = class_getSuperclass(currentClass)) {
+    BOOL cached;
+    BOOL isSwiftClass = shouldIncludeSwiftObjects && FBIsSwiftObjectOrClass(currentClass);
+    [array addObjectsFromArray:FBGetSharedStrongReferencesForClass(currentClass, isSwiftClass, &cached)];
+  }
+  return array;
+}
+
 static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForClass(id obj, Class aCls, BOOL shouldIncludeSwiftObjects, BOOL shouldUseSwiftABITraversal, BOOL shouldScanSwiftObjectMemory) {
     if (aCls == nil) {
         return @[];
@@ -237,6 +393,7 @@ static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForClass(id obj, Cla
     if (shouldIncludeSwiftObjects && FBIsSwiftObjectOrClass(aCls)) {
         if (shouldUseSwiftABITraversal) {
             FBSwiftABIFieldInfo fields[FB_SWIFT_ABI_MAX_FIELDS];
+            FB_RCD_STATS_INCREMENT(SwiftABIResolutions);
             int count = FBGetSwiftABIFields((__bridge const void *)aCls, fields, FB_SWIFT_ABI_MAX_FIELDS);
             NSMutableArray<id<FBObjectReference>> *result = [NSMutableArray new];
             for (int i = 0; i < count; i++) {
@@ -256,6 +413,7 @@ static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForClass(id obj, Cla
                         if (contextKind == SWIFT_KIND_HEAP_LOCAL_VARIABLE) {
                             // Capture box (HeapLocalVariable, kind 0x400) — scan for strong captures
                             uintptr_t captureOffsets[FB_SWIFT_ABI_MAX_CAPTURES];
+                            FB_RCD_STATS_INCREMENT(SwiftABIResolutions);
                             int captureCount = FBGetSwiftABICapturedStrongRefs(contextPtr, captureOffsets, FB_SWIFT_ABI_MAX_CAPTURES);
                             for (int j = 0; j < captureCount; j++) {
                                 NSString *captureName = [NSString stringWithFormat:@"%@->capture[%d]", name, j];
@@ -270,7 +428,8 @@ static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForClass(id obj, Cla
                             // when there is a single strong capture.
                             NSString *captureName = [NSString stringWithFormat:@"%@->capture", name];
                             [result addObject:[[FBSwiftABIReference alloc] initWithName:captureName
-                                                                                offset:fields[i].offset + sizeof(void *)]];
+                                                                                offset:fields[i].offset + sizeof(void *)
+                                                                              edgeKind:FBGraphEdgeKindSwiftClosureCapture]];
                         }
                     }
                 }
@@ -356,13 +515,13 @@ static NSArray<id<FBObjectReference>> *FBGetStrongReferencesForClass(id obj, Cla
             }
             return [result copy];
         }
-        return FBGetStrongReferencesForSwiftClass(obj, aCls);
+        return FBGetStrongReferencesForSwiftClass(aCls);
     }
     return FBGetStrongReferencesForObjectiveCClass(aCls);
 }
 
 NSArray<id<FBObjectReference>> *FBGetObjectStrongReferences(id obj,
-                                                            NSMutableDictionary<NSString*, NSArray<id<FBObjectReference>> *> *layoutCache,
+                                                            BOOL shouldUseSharedLayouts,
                                                             BOOL shouldIncludeSwiftObjects,
                                                             BOOL shouldUseSwiftABITraversal,
                                                             BOOL shouldScanSwiftObjectMemory) {
@@ -374,20 +533,18 @@ NSArray<id<FBObjectReference>> *FBGetObjectStrongReferences(id obj,
   while (previousClass != currentClass && currentClass) {
     NSArray<id<FBObjectReference>> *ivars;
 
-    const char * className = class_getName(currentClass);
-    NSString *claseName = [[NSString alloc] initWithCString:className encoding:NSUTF8StringEncoding];
-
-    // Skip cache for ABI-traversed Swift classes — closure captures are instance-specific
-    BOOL skipCache = (shouldUseSwiftABITraversal || shouldScanSwiftObjectMemory) && shouldIncludeSwiftObjects && FBIsSwiftObjectOrClass(currentClass);
-    if (!skipCache) {
-      ivars = layoutCache[claseName];
-    }
-
-    if (!ivars) {
-      ivars = FBGetStrongReferencesForClass(obj, currentClass, shouldIncludeSwiftObjects, shouldUseSwiftABITraversal, shouldScanSwiftObjectMemory);
-      if (!skipCache && layoutCache && currentClass) {
-        layoutCache[claseName] = ivars;
+    const BOOL isSwiftClass = shouldIncludeSwiftObjects && FBIsSwiftObjectOrClass(currentClass);
+    // Layouts found with ABI traversal or memory scanning depend on the instance, closure captures for example
+    if (shouldUseSharedLayouts && !(isSwiftClass && (shouldUseSwiftABITraversal || shouldScanSwiftObjectMemory))) {
+      BOOL cached;
+      ivars = FBGetSharedStrongReferencesForClass(currentClass, isSwiftClass, &cached);
+      if (cached) {
+        FB_RCD_STATS_INCREMENT(LayoutCacheHits);
+      } else {
+        FB_RCD_STATS_INCREMENT(LayoutCacheMisses);
       }
+    } else {
+      ivars = FBGetStrongReferencesForClass(obj, currentClass, shouldIncludeSwiftObjects, shouldUseSwiftABITraversal, shouldScanSwiftObjectMemory);
     }
     [array addObjectsFromArray:ivars];
 
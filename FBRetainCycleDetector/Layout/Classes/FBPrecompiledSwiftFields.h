@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FBSwiftABIHelpers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  const char *_Nullable name;
+  uint32_t fieldIndex;
+  FBSwiftABIFieldKind kind;
+} FBPrecompiledSwiftField;
+
+/**
+ Installs ownership of Swift fields and closure captures, classified at build time by tools/rcd_swift_field_extractor,
+ for the loaded image the table was extracted from. Tables of several images can be loaded, they are kept for the
+ lifetime of the process. Thread safe.
+
+ @return NO if data is not a valid table, or no loaded image has the UUID the table was extracted from.
+ */
+BOOL FBLoadPrecompiledSwiftFields(NSData *_Nonnull data);
+
+/**
+ Strong and closure fields of a Swift class, by index in its field offset vector.
+
+ @param numberOfFields Number of fields the descriptor declares, the table is not trusted if it disagrees
+ @param hasUnresolvedFields Set to YES if some fields could hold references, but the table couldn't tell
+ @return -1 if there are no precompiled fields for the descriptor, otherwise the number of fields written
+ */
+int FBGetPrecompiledSwiftFields(const void *_Nonnull typeDescriptor,
+                                uint32_t numberOfFields,
+                                BOOL *_Nonnull hasUnresolvedFields,
+                                FBPrecompiledSwiftField *_Nonnull outFields,
+                                int maxFields);
+
+/**
+ Indices of strong captures of closure contexts with given heap metadata.
+
+ @return -1 if there are no precompiled captures for the metadata, otherwise the number of indices written
+ */
+int FBGetPrecompiledSwiftStrongCaptures(const void *_Nonnull captureMetadata,
+                                        uint32_t *_Nonnull outIndices,
+                                        int maxCaptures);
+
+#ifdef __cplusplus
+}
+#endif
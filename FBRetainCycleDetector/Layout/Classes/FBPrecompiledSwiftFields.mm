@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBPrecompiledSwiftFields.h"
+
+#import <mach-o/dyld.h>
+#import <mach-o/loader.h>
+#import <memory>
+#import <mutex>
+#import <unordered_map>
+#import <vector>
+
+#import "FBPrecompiledSwiftFieldTable.h"
+
+/**
+ Entries point into tables, which are never freed, so names handed out stay valid. Keys are addresses in the loaded
+ image, offsets from the table are slid when it's loaded.
+ */
+struct FBPrecompiledSwiftFieldEntries {
+  std::vector<std::unique_ptr<FB::RetainCycleDetector::PrecompiledSwiftFieldReader>> tables;
+  std::unordered_map<uintptr_t, const FB::RetainCycleDetector::PrecompiledSwiftType *> types;
+  std::unordered_map<uintptr_t, std::vector<uint32_t>> strongCaptures;
+};
+
+static std::mutex &FBPrecompiledSwiftFieldEntriesMutex() {
+  static std::mutex *mutex = new std::mutex;
+  return *mutex;
+}
+
+static FBPrecompiledSwiftFieldEntries &FBPrecompiledSwiftFieldEntriesStorage() {
+  static auto *entries = new FBPrecompiledSwiftFieldEntries();
+  return *entries;
+}
+
+static const struct mach_header_64 *FBFindLoadedImageWithUUID(const uint8_t *uuid) {
+  for (uint32_t i = 0; i < _dyld_image_count(); ++i) {
+    const struct mach_header_64 *header = (const struct mach_header_64 *)_dyld_get_image_header(i);
+    if (!header || header->magic != MH_MAGIC_64) {
+      continue;
+    }
+    const uint8_t *command = (const uint8_t *)(header + 1);
+    for (uint32_t j = 0; j < header->ncmds; ++j) {
+      const struct load_command *loadCommand = (const struct load_command *)command;
+      if (loadCommand->cmd == LC_UUID) {
+        if (memcmp(((const struct uuid_command *)loadCommand)->uuid, uuid, 16) == 0) {
+          return header;
+        }
+        break;
+      }
+      command += loadCommand->cmdsize;
+    }
+  }
+  return NULL;
+}
+
+BOOL FBLoadPrecompiledSwiftFields(NSData *data) {
+  std::unique_ptr<FB::RetainCycleDetector::PrecompiledSwiftFieldReader> table(
+    new FB::RetainCycleDetector::PrecompiledSwiftFieldReader());
+  if (!table->read((const uint8_t *)data.bytes, data.length)) {
+    return NO;
+  }
+  const struct mach_header_64 *image = FBFindLoadedImageWithUUID(table->uuid());
+  if (!image) {
+    return NO;
+  }
+
+  const uintptr_t base = (uintptr_t)image;
+  std::lock_guard<std::mutex> l(FBPrecompiledSwiftFieldEntriesMutex());
+  FBPrecompiledSwiftFieldEntries &entries = FBPrecompiledSwiftFieldEntriesStorage();
+  for (const auto &type: table->types()) {
+    entries.types[base + type.descriptorOffset] = &type;
+  }
+  for (const auto &captures: table->captures()) {
+    std::vector<uint32_t> strongCaptures;
+    for (uint32_t i = 0; i < captures.captures.size(); ++i) {
+      if (captures.captures[i] == FB::RetainCycleDetector::SwiftFieldOwnership::Strong) {
+        strongCaptures.push_back(i);
+      }
+    }
+    entries.strongCaptures[base + captures.metadataOffset] = std::move(strongCaptures);
+  }
+  entries.tables.push_back(std::move(table));
+  return YES;
+}
+
+int FBGetPrecompiledSwiftFields(const void *typeDescriptor,
+                                uint32_t numberOfFields,
+                                BOOL *hasUnresolvedFields,
+                                FBPrecompiledSwiftField *outFields,
+                                int maxFields) {
+  const FB::RetainCycleDetector::PrecompiledSwiftType *type = nullptr;
+  {
+    std::lock_guard<std::mutex> l(FBPrecompiledSwiftFieldEntriesMutex());
+    const auto &types = FBPrecompiledSwiftFieldEntriesStorage().types;
+    auto entry = types.find((uintptr_t)typeDescriptor);
+    if (entry == types.end()) {
+      return -1;
+    }
+    type = entry->second;
+  }
+  if (type->numberOfFields != numberOfFields) {
+    return -1;
+  }
+
+  *hasUnresolvedFields = (type->flags & FB::RetainCycleDetector::kPrecompiledSwiftTypeHasUnresolvedFields) != 0;
+  int count = 0;
+  for (const auto &field: type->fields) {
+    if (count >= maxFields) {
+      break;
+    }
+    if (field.ownership == FB::RetainCycleDetector::SwiftFieldOwnership::Strong) {
+      outFields[count++] = {field.name.c_str(), field.index, FBSwiftABIFieldKindStrongRef};
+    } else if (field.ownership == FB::RetainCycleDetector::SwiftFieldOwnership::Closure) {
+      outFields[count++] = {field.name.c_str(), field.index, FBSwiftABIFieldKindClosure};
+    }
+  }
+  return count;
+}
+
+int FBGetPrecompiledSwiftStrongCaptures(const void *captureMetadata,
+                                        uint32_t *outIndices,
+                                        int maxCaptures) {
+  std::lock_guard<std::mutex> l(FBPrecompiledSwiftFieldEntriesMutex());
+  const auto &strongCaptures = FBPrecompiledSwiftFieldEntriesStorage().strongCaptures;
+  auto entry = strongCaptures.find((uintptr_t)captureMetadata);
+  if (entry == strongCaptures.end()) {
+    return -1;
+  }
+  int count = 0;
+  for (uint32_t index: entry->second) {
+    if (count >= maxCaptures) {
+      break;
+    }
+    outIndices[count++] = index;
+  }
+  return count;
+}
@@ -36,7 +36,8 @@ typedef struct {
 /**
  Returns the number of interesting fields (strong refs + closures) declared
  by the given Swift class. Does NOT walk superclasses.
- Returns 0 for ObjC classes or if reflection metadata is stripped.
+ Returns 0 for ObjC classes or if reflection metadata is stripped, unless
+ fields of the class were precompiled (see FBLoadPrecompiledSwiftFields).
  */
 int FBGetSwiftABIFields(const void *classMetadata,
                         FBSwiftABIFieldInfo *outFields,
@@ -47,7 +48,8 @@ int FBGetSwiftABIFields(const void *classMetadata,
  Uses the CaptureDescriptor (from HeapLocalVariableMetadata) to resolve
  each capture's mangled type name to type metadata, then classifies
  ownership deterministically. Weak (Xw) and unowned (Xo) captures are
- excluded. Returns 0 if no CaptureDescriptor is available.
+ excluded. Returns 0 if no CaptureDescriptor is available and captures
+ were not precompiled.
  outOffsets receives the byte offsets within the box for each strong capture.
  */
 int FBGetSwiftABICapturedStrongRefs(const void *captureBoxPtr,
@@ -7,6 +7,7 @@
  */
 
 #import "FBSwiftABIHelpers.h"
+#import "FBPrecompiledSwiftFields.h"
 #import <Foundation/Foundation.h>
 #include <string.h>
 #include <malloc/malloc.h>
@@ -344,6 +345,33 @@ static int fbGetStructStrongRefFields(const void *structMetadata,
   return count;
 }
 
+/**
+ Fields classified at build time, see FBLoadPrecompiledSwiftFields. Offsets still come
+ from the metadata, since they depend on superclasses. Fields the table couldn't
+ classify, like structs, are left to the runtime, unless reflection metadata is
+ stripped and the runtime can't classify anything either.
+
+ Returns -1 if fields have to be resolved at runtime.
+ */
+static int fbGetPrecompiledFields(const FBSwiftClassDescriptor *classDesc,
+                                  const uintptr_t *metaWords,
+                                  FBSwiftABIFieldInfo *outFields,
+                                  int maxFields) {
+  FBPrecompiledSwiftField fields[FB_SWIFT_ABI_MAX_FIELDS];
+  BOOL hasUnresolvedFields = NO;
+  int count = FBGetPrecompiledSwiftFields(classDesc, classDesc->NumFields, &hasUnresolvedFields,
+                                          fields, MIN(maxFields, FB_SWIFT_ABI_MAX_FIELDS));
+  if (count < 0) return -1;
+  if (hasUnresolvedFields && classDesc->FieldDescriptor != 0) return -1;
+
+  for (int i = 0; i < count; i++) {
+    outFields[i].name = fields[i].name;
+    outFields[i].offset = metaWords[classDesc->FieldOffsetVectorOffset + fields[i].fieldIndex];
+    outFields[i].kind = fields[i].kind;
+  }
+  return count;
+}
+
 int FBGetSwiftABIFields(const void *classMetadata,
                         FBSwiftABIFieldInfo *outFields,
                         int maxFields) {
@@ -355,6 +383,11 @@ int FBGetSwiftABIFields(const void *classMetadata,
   const FBSwiftClassDescriptor *classDesc = (const FBSwiftClassDescriptor *)descriptor;
 
   if (classDesc->NumFields == 0 || classDesc->FieldOffsetVectorOffset == 0) return 0;
+
+  const uintptr_t *metaWords = (const uintptr_t *)classMetadata;
+  int precompiledCount = fbGetPrecompiledFields(classDesc, metaWords, outFields, maxFields);
+  if (precompiledCount >= 0) return precompiledCount;
+
   if (classDesc->FieldDescriptor == 0) return 0;
 
   const FBSwiftFieldDescriptor *fieldDesc =
@@ -362,7 +395,6 @@ int FBGetSwiftABIFields(const void *classMetadata,
           &classDesc->FieldDescriptor, classDesc->FieldDescriptor);
   if (!fieldDesc) return 0;
 
-  const uintptr_t *metaWords = (const uintptr_t *)classMetadata;
   const FBSwiftFieldRecord *records =
       (const FBSwiftFieldRecord *)((const char *)fieldDesc + sizeof(FBSwiftFieldDescriptor));
 
@@ -404,6 +436,15 @@ int FBGetSwiftABIFields(const void *classMetadata,
   return count;
 }
 
+// Safety: validate the value at this offset of a capture box is a valid heap pointer
+static int fbIsHeapPointerAt(const void *captureBoxPtr, size_t offset) {
+  const void *val = *(const void **)((const char *)captureBoxPtr + offset);
+  if (!val) return 0;
+  if ((uintptr_t)val & 0x7) return 0;
+  if (malloc_size(val) == 0) return 0;
+  return 1;
+}
+
 int FBGetSwiftABICapturedStrongRefs(const void *captureBoxPtr,
                                     uintptr_t *outOffsets,
                                     int maxCaptures) {
@@ -424,6 +465,24 @@ int FBGetSwiftABICapturedStrongRefs(const void *captureBoxPtr,
     offsetToFirstCapture = 16;
   }
 
+  // Captures classified at build time don't need the CaptureDescriptor, which
+  // may be stripped along with the rest of reflection metadata
+  uint32_t strongCaptures[FB_SWIFT_ABI_MAX_CAPTURES];
+  int precompiledCount = FBGetPrecompiledSwiftStrongCaptures(metadata, strongCaptures,
+                                                             MIN(maxCaptures, FB_SWIFT_ABI_MAX_CAPTURES));
+  if (precompiledCount >= 0) {
+    int count = 0;
+    for (int i = 0; i < precompiledCount; i++) {
+      size_t captureOffset = (size_t)offsetToFirstCapture + strongCaptures[i] * sizeof(void *);
+      if (captureOffset + sizeof(void *) > boxSize) break;
+      if (!fbIsHeapPointerAt(captureBoxPtr, captureOffset)) continue;
+
+      outOffsets[count] = captureOffset;
+      count++;
+    }
+    return count;
+  }
+
   // HeapLocalVariableMetadata layout (arm64):
   //   +0:  kind (8 bytes, value = 0x400)
   //   +8:  OffsetToFirstCapture (uint32_t)
@@ -458,11 +517,7 @@ int FBGetSwiftABICapturedStrongRefs(const void *captureBoxPtr,
                                                  NULL);
         if (ownership < 0 || ownership != FBSwiftABIFieldKindStrongRef) continue;
 
-        // Safety: validate the value at this offset is a valid heap pointer
-        const void *val = *(const void **)((const char *)captureBoxPtr + captureOffset);
-        if (!val) continue;
-        if ((uintptr_t)val & 0x7) continue;
-        if (malloc_size(val) == 0) continue;
+        if (!fbIsHeapPointerAt(captureBoxPtr, captureOffset)) continue;
 
         outOffsets[count] = captureOffset;
         count++;
@@ -0,0 +1,392 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBMachOImage_h
+#define FBMachOImage_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  static const uint32_t kMachOCPUTypeX86_64 = 0x01000007;
+  static const uint32_t kMachOCPUTypeARM64 = 0x0100000c;
+
+  /**
+   Read-only view of a 64-bit Mach-O file, thin or one slice of a fat one, addressed the way the image is laid out
+   in memory before it is slid. Pointers stored in the image can be read either as raw rebases or as chained fixups,
+   binds to other images can't be resolved and read as failures.
+
+   Used by tools/rcd_layout_extractor and tools/rcd_swift_field_extractor to read metadata of an app binary. These
+   tools are built for the build host with a plain C++ compiler, so this header only relies on the standard library.
+   */
+  class MachOImage {
+  public:
+    struct Section {
+      std::string segmentName;
+      std::string sectionName;
+      uint64_t address;
+      uint64_t size;
+    };
+
+    /**
+     @param data Contents of the file, have to outlive the image
+     @param cpuType Architecture of the slice to read from fat files, thin files have to match it too
+     @return false if data is not a 64-bit Mach-O file with given architecture, error is set then
+     */
+    bool parse(const uint8_t *data, size_t size, uint32_t cpuType, std::string &error) {
+      _segments.clear();
+      _sections.clear();
+      _usesChainedFixups = false;
+      _hasUUID = false;
+
+      uint32_t magic;
+      if (!_readUInt32(data, size, 0, magic)) {
+        error = "File is too small";
+        return false;
+      }
+      // Fat headers are big endian
+      if (magic == 0xbebafeca || magic == 0xbfbafeca) {
+        const bool is64 = (magic == 0xbfbafeca);
+        uint32_t archCount = 0;
+        _readUInt32(data, size, 4, archCount);
+        archCount = _swap(archCount);
+        const size_t archSize = is64 ? 32 : 20;
+        for (uint32_t i = 0; i < archCount; ++i) {
+          const size_t archOffset = 8 + i * archSize;
+          uint32_t archCPUType = 0, offset32 = 0, size32 = 0;
+          uint64_t offset = 0, sliceSize = 0;
+          if (!_readUInt32(data, size, archOffset, archCPUType) || archSize > size - archOffset) {
+            break;
+          }
+          if (_swap(archCPUType) != cpuType) {
+            continue;
+          }
+          if (is64) {
+            _readUInt64(data, size, archOffset + 8, offset);
+            _readUInt64(data, size, archOffset + 16, sliceSize);
+            offset = _swap64(offset);
+            sliceSize = _swap64(sliceSize);
+          } else {
+            _readUInt32(data, size, archOffset + 8, offset32);
+            _readUInt32(data, size, archOffset + 12, size32);
+            offset = _swap(offset32);
+            sliceSize = _swap(size32);
+          }
+          if (offset > size || sliceSize > size - offset) {
+            error = "Fat slice lies outside of the file";
+            return false;
+          }
+          return _parseThin(data + offset, (size_t)sliceSize, cpuType, error);
+        }
+        error = "Fat file has no slice with requested architecture";
+        return false;
+      }
+      return _parseThin(data, size, cpuType, error);
+    }
+
+    /**
+     Address of the Mach-O header when the image is not slid, addresses are turned into offsets within the loaded
+     image by subtracting it.
+     */
+    uint64_t baseAddress() const {
+      return _baseAddress;
+    }
+
+    /**
+     @return false if the image has no LC_UUID
+     */
+    bool getUUID(uint8_t uuid[16]) const {
+      if (_hasUUID) {
+        memcpy(uuid, _uuid, sizeof(_uuid));
+      }
+      return _hasUUID;
+    }
+
+    const std::vector<Section> &sections() const {
+      return _sections;
+    }
+
+    /**
+     @return nullptr if there is no such section, segment name is not compared if it's nullptr
+     */
+    const Section *findSection(const char *segmentName, const char *sectionName) const {
+      for (const auto &section: _sections) {
+        if ((!segmentName || section.segmentName == segmentName) && section.sectionName == sectionName) {
+          return &section;
+        }
+      }
+      return nullptr;
+    }
+
+    /**
+     @return Bytes at given address, or nullptr if they are not all backed by the file
+     */
+    const uint8_t *bytesAt(uint64_t address, uint64_t size) const {
+      for (const auto &segment: _segments) {
+        if (address >= segment.address && address - segment.address < segment.fileSize &&
+            size <= segment.fileSize - (address - segment.address)) {
+          return _data + segment.fileOffset + (address - segment.address);
+        }
+      }
+      return nullptr;
+    }
+
+    bool readUInt32(uint64_t address, uint32_t &value) const {
+      const uint8_t *bytes = bytesAt(address, sizeof(value));
+      if (!bytes) {
+        return false;
+      }
+      memcpy(&value, bytes, sizeof(value));
+      return true;
+    }
+
+    bool readInt32(uint64_t address, int32_t &value) const {
+      uint32_t unsignedValue;
+      if (!readUInt32(address, unsignedValue)) {
+        return false;
+      }
+      memcpy(&value, &unsignedValue, sizeof(value));
+      return true;
+    }
+
+    /**
+     Reads a pointer stored at given address and decodes it to an unslid address.
+
+     @return false if the address is not mapped, or the pointer is null or bound to another image
+     */
+    bool readPointer(uint64_t address, uint64_t &target) const {
+      const Segment *segment = nullptr;
+      for (const auto &candidate: _segments) {
+        if (address >= candidate.address && address - candidate.address < candidate.fileSize &&
+            candidate.fileSize - (address - candidate.address) >= 8) {
+          segment = &candidate;
+          break;
+        }
+      }
+      if (!segment) {
+        return false;
+      }
+      uint64_t raw;
+      memcpy(&raw, _data + segment->fileOffset + (address - segment->address), sizeof(raw));
+      if (!raw) {
+        return false;
+      }
+      if (!_usesChainedFixups || segment->pointerFormat == 0) {
+        target = raw;
+        return true;
+      }
+
+      switch (segment->pointerFormat) {
+        // DYLD_CHAINED_PTR_64, DYLD_CHAINED_PTR_64_OFFSET
+        case 2:
+        case 6:
+          if (raw >> 63) {
+            return false;
+          }
+          target = raw & 0xfffffffffULL;
+          if (segment->pointerFormat == 6) {
+            target += _baseAddress;
+          }
+          return true;
+        // DYLD_CHAINED_PTR_ARM64E, DYLD_CHAINED_PTR_ARM64E_USERLAND, DYLD_CHAINED_PTR_ARM64E_USERLAND24
+        case 1:
+        case 9:
+        case 12: {
+          const bool isAuthenticated = (raw >> 63) & 1;
+          const bool isBind = (raw >> 62) & 1;
+          if (isBind) {
+            return false;
+          }
+          if (isAuthenticated) {
+            target = _baseAddress + (raw & 0xffffffffULL);
+          } else {
+            target = raw & 0x7ffffffffffULL;
+            if (segment->pointerFormat != 1) {
+              target += _baseAddress;
+            }
+          }
+          return true;
+        }
+        default:
+          return false;
+      }
+    }
+
+    /**
+     @return NUL terminated string at given address, or nullptr if it doesn't end within its segment
+     */
+    const char *stringAt(uint64_t address) const {
+      for (const auto &segment: _segments) {
+        if (address >= segment.address && address - segment.address < segment.fileSize) {
+          const char *string = (const char *)_data + segment.fileOffset + (address - segment.address);
+          const size_t maximumLength = (size_t)(segment.fileSize - (address - segment.address));
+          return memchr(string, 0, maximumLength) ? string : nullptr;
+        }
+      }
+      return nullptr;
+    }
+
+  private:
+    struct Segment {
+      uint64_t address;
+      uint64_t fileOffset;
+      uint64_t fileSize;
+      uint16_t pointerFormat;
+    };
+
+    bool _parseThin(const uint8_t *data, size_t size, uint32_t cpuType, std::string &error) {
+      // Size of mach_header_64
+      static const size_t kHeaderSize = 32;
+      uint32_t magic = 0, fileCPUType = 0, commandCount = 0;
+      if (size < kHeaderSize || !_readUInt32(data, size, 0, magic) || magic != 0xfeedfacf) {
+        error = "Not a 64-bit Mach-O file";
+        return false;
+      }
+      _readUInt32(data, size, 4, fileCPUType);
+      if (fileCPUType != cpuType) {
+        error = "File has a different architecture";
+        return false;
+      }
+      _readUInt32(data, size, 16, commandCount);
+      _data = data;
+      _size = size;
+
+      uint32_t fixupsOffset = 0, fixupsSize = 0;
+      size_t offset = kHeaderSize;
+      for (uint32_t i = 0; i < commandCount; ++i) {
+        uint32_t command, commandSize;
+        if (!_readUInt32(data, size, offset, command) || !_readUInt32(data, size, offset + 4, commandSize) ||
+            commandSize < 8 || commandSize > size - offset) {
+          error = "Load commands are truncated";
+          return false;
+        }
+        // LC_SEGMENT_64
+        if (command == 0x19) {
+          if (!_parseSegment(offset, commandSize, error)) {
+            return false;
+          }
+        }
+        // LC_UUID
+        if (command == 0x1b && commandSize >= 24) {
+          memcpy(_uuid, data + offset + 8, sizeof(_uuid));
+          _hasUUID = true;
+        }
+        // LC_DYLD_CHAINED_FIXUPS
+        if (command == 0x80000034 && commandSize >= 16) {
+          _readUInt32(data, size, offset + 8, fixupsOffset);
+          _readUInt32(data, size, offset + 12, fixupsSize);
+          _usesChainedFixups = true;
+        }
+        offset += commandSize;
+      }
+      if (_usesChainedFixups && !_parseChainedFixups(fixupsOffset, fixupsSize)) {
+        error = "Chained fixups are malformed";
+        return false;
+      }
+      return true;
+    }
+
+    bool _parseSegment(size_t offset, uint32_t commandSize, std::string &error) {
+      if (commandSize < 72) {
+        error = "Segment command is truncated";
+        return false;
+      }
+      Segment segment = {0, 0, 0, 0};
+      char name[17] = {0};
+      memcpy(name, _data + offset + 8, 16);
+      uint32_t sectionCount = 0;
+      _readUInt64(_data, _size, offset + 24, segment.address);
+      _readUInt64(_data, _size, offset + 40, segment.fileOffset);
+      _readUInt64(_data, _size, offset + 48, segment.fileSize);
+      _readUInt32(_data, _size, offset + 64, sectionCount);
+      if (segment.fileOffset > _size || segment.fileSize > _size - segment.fileOffset ||
+          (uint64_t)sectionCount * 80 > commandSize - 72) {
+        error = "Segment lies outside of the file";
+        return false;
+      }
+      if (segment.fileOffset == 0 && segment.fileSize > 0) {
+        _baseAddress = segment.address;
+      }
+      _segments.push_back(segment);
+
+      for (uint32_t i = 0; i < sectionCount; ++i) {
+        const size_t sectionOffset = offset + 72 + i * 80;
+        char sectionName[17] = {0};
+        memcpy(sectionName, _data + sectionOffset, 16);
+        Section section = {name, sectionName, 0, 0};
+        _readUInt64(_data, _size, sectionOffset + 32, section.address);
+        _readUInt64(_data, _size, sectionOffset + 40, section.size);
+        _sections.push_back(section);
+      }
+      return true;
+    }
+
+    // Only pointer formats of segments are needed, pointers are decoded in place without walking the chains
+    bool _parseChainedFixups(uint32_t offset, uint32_t size) {
+      uint32_t startsOffset, segmentCount;
+      if (offset > _size || size > _size - offset ||
+          !_readUInt32(_data + offset, size, 4, startsOffset) ||
+          !_readUInt32(_data + offset, size, startsOffset, segmentCount)) {
+        return false;
+      }
+      for (uint32_t i = 0; i < segmentCount && i < _segments.size(); ++i) {
+        uint32_t segmentStartsOffset;
+        if (!_readUInt32(_data + offset, size, (size_t)startsOffset + 4 + i * 4, segmentStartsOffset)) {
+          return false;
+        }
+        if (segmentStartsOffset == 0) {
+          continue;
+        }
+        const size_t formatOffset = (size_t)startsOffset + segmentStartsOffset + 6;
+        if (formatOffset + 2 > size) {
+          return false;
+        }
+        memcpy(&_segments[i].pointerFormat, _data + offset + formatOffset, sizeof(uint16_t));
+      }
+      return true;
+    }
+
+    static bool _readUInt32(const uint8_t *data, size_t size, size_t offset, uint32_t &value) {
+      if (offset > size || size - offset < sizeof(value)) {
+        return false;
+      }
+      memcpy(&value, data + offset, sizeof(value));
+      return true;
+    }
+
+    static bool _readUInt64(const uint8_t *data, size_t size, size_t offset, uint64_t &value) {
+      if (offset > size || size - offset < sizeof(value)) {
+        return false;
+      }
+      memcpy(&value, data + offset, sizeof(value));
+      return true;
+    }
+
+    static uint32_t _swap(uint32_t value) {
+      return ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00) | (value >> 24);
+    }
+
+    static uint64_t _swap64(uint64_t value) {
+      return ((uint64_t)_swap((uint32_t)value) << 32) | _swap((uint32_t)(value >> 32));
+    }
+
+    const uint8_t *_data = nullptr;
+    size_t _size = 0;
+    uint64_t _baseAddress = 0;
+    bool _usesChainedFixups = false;
+    bool _hasUUID = false;
+    uint8_t _uuid[16] = {0};
+    std::vector<Segment> _segments;
+    std::vector<Section> _sections;
+  };
+} }
+
+#endif /* FBMachOImage_h */
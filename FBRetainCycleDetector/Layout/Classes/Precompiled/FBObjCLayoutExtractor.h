@@ -0,0 +1,375 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBObjCLayoutExtractor_h
+#define FBObjCLayoutExtractor_h
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "FBMachOImage.h"
+#include "FBPrecompiledLayoutTable.h"
+
+namespace FB { namespace RetainCycleDetector {
+  namespace ObjCLayoutExtraction {
+    // Offsets in class_t and class_ro_t of 64-bit images
+    static const uint64_t kClassDataOffset = 32;
+    static const uint64_t kClassDataMask = 0x00007ffffffffff8ULL;
+    static const uint64_t kClassROFlagsMeta = 1;
+    static const uint64_t kClassROInstanceSizeOffset = 8;
+    static const uint64_t kClassROIvarLayoutOffset = 16;
+    static const uint64_t kClassRONameOffset = 24;
+    static const uint64_t kClassROIvarsOffset = 48;
+    static const uint32_t kPointerSize = 8;
+
+    /**
+     Type of a struct field parsed from an encoding, with the natural size and alignment the compiler gave it.
+     */
+    struct EncodedType {
+      char kind; // '{' for structs, '@' for objects and blocks, 0 for everything else
+      std::string name;
+      std::string typeName;
+      uint64_t size = 0;
+      uint64_t alignment = 1;
+      std::vector<EncodedType> fields;
+    };
+
+    inline bool parseEncodedType(const std::string &encoding, size_t &i, EncodedType &type);
+
+    inline bool _parseScalar(char c, EncodedType &type) {
+      switch (c) {
+        case 'c': case 'C': case 'B':
+          type.size = 1;
+          break;
+        case 's': case 'S':
+          type.size = 2;
+          break;
+        case 'i': case 'I': case 'l': case 'L': case 'f':
+          type.size = 4;
+          break;
+        case 'q': case 'Q': case 'd': case '*': case ':': case '#':
+          type.size = 8;
+          break;
+        default:
+          return false;
+      }
+      type.alignment = type.size;
+      return true;
+    }
+
+    inline bool _skipDelimited(const std::string &encoding, size_t &i, char open, char close) {
+      int depth = 0;
+      for (; i < encoding.size(); ++i) {
+        if (encoding[i] == open) {
+          depth++;
+        } else if (encoding[i] == close && --depth == 0) {
+          ++i;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     Parses one type from an Objective-C type encoding, like the runtime parser does for struct ivars. Parsing stops
+     at unions, bitfields and types of unknown size, but fields parsed before them are kept.
+
+     @return false if parsing stopped before the end of the type
+     */
+    inline bool parseEncodedType(const std::string &encoding, size_t &i, EncodedType &type) {
+      type.kind = 0;
+      // Qualifiers don't change the layout
+      while (i < encoding.size() && strchr("rnNoORVA", encoding[i])) {
+        ++i;
+      }
+      if (i >= encoding.size()) {
+        return false;
+      }
+
+      const char c = encoding[i++];
+      if (_parseScalar(c, type)) {
+        return true;
+      }
+      switch (c) {
+        case '@':
+          type.kind = '@';
+          type.size = type.alignment = kPointerSize;
+          if (i < encoding.size() && encoding[i] == '?') {
+            ++i;
+            if (i < encoding.size() && encoding[i] == '<') {
+              _skipDelimited(encoding, i, '<', '>');
+            }
+          } else if (i < encoding.size() && encoding[i] == '"') {
+            // A quoted class name, unless the quote opens the name of the next field
+            size_t closingQuote = encoding.find('"', i + 1);
+            if (closingQuote != std::string::npos &&
+                (closingQuote + 1 == encoding.size() || encoding[closingQuote + 1] == '"' ||
+                 encoding[closingQuote + 1] == '}')) {
+              i = closingQuote + 1;
+            }
+          }
+          return true;
+        case '^': {
+          type.size = type.alignment = kPointerSize;
+          if (i < encoding.size() && encoding[i] == '?') {
+            ++i;
+            return true;
+          }
+          if (i < encoding.size() && (encoding[i] == '{' || encoding[i] == '(')) {
+            return _skipDelimited(encoding, i, encoding[i], encoding[i] == '{' ? '}' : ')');
+          }
+          // Only the pointee has to be skipped, the size of a pointer doesn't depend on it
+          EncodedType pointee;
+          parseEncodedType(encoding, i, pointee);
+          return true;
+        }
+        case '[': {
+          uint64_t count = 0;
+          for (; i < encoding.size() && isdigit((unsigned char)encoding[i]); ++i) {
+            count = count * 10 + (encoding[i] - '0');
+          }
+          EncodedType element;
+          if (!parseEncodedType(encoding, i, element) || i >= encoding.size() || encoding[i] != ']') {
+            return false;
+          }
+          ++i;
+          // Objects in arrays are not references the runtime knows about either
+          type.size = count * element.size;
+          type.alignment = element.alignment;
+          return true;
+        }
+        case '{': {
+          type.kind = '{';
+          size_t nameEnd = encoding.find_first_of("=}", i);
+          if (nameEnd == std::string::npos || encoding[nameEnd] == '}') {
+            // Opaque struct, its size is unknown
+            return false;
+          }
+          type.typeName = encoding.substr(i, nameEnd - i);
+          i = nameEnd + 1;
+          while (i < encoding.size() && encoding[i] != '}') {
+            EncodedType field;
+            if (encoding[i] == '"') {
+              size_t nameClose = encoding.find('"', i + 1);
+              if (nameClose == std::string::npos) {
+                return false;
+              }
+              field.name = encoding.substr(i + 1, nameClose - i - 1);
+              i = nameClose + 1;
+            }
+            bool parsed = parseEncodedType(encoding, i, field);
+            if (field.size > 0 || field.kind == '{') {
+              type.size = (type.size + field.alignment - 1) / field.alignment * field.alignment + field.size;
+              type.alignment = std::max(type.alignment, field.alignment);
+              type.fields.push_back(std::move(field));
+            }
+            if (!parsed) {
+              return false;
+            }
+          }
+          if (i >= encoding.size()) {
+            return false;
+          }
+          ++i;
+          type.size = (type.size + type.alignment - 1) / type.alignment * type.alignment;
+          return true;
+        }
+        default:
+          // Unions, bitfields, long doubles and anything else we don't know the size of
+          return false;
+      }
+    }
+
+    /**
+     Collects objects in a struct, named the way FBObjectInStructReference names them at runtime: name of the ivar,
+     then names of struct types (unless anonymous) and fields leading to the object.
+     */
+    inline void collectObjectsInStruct(const EncodedType &type,
+                                       uint64_t offset,
+                                       std::vector<std::string> namePath,
+                                       std::vector<PrecompiledSlot> &slots) {
+      if (!type.name.empty()) {
+        namePath.push_back(type.name);
+      }
+      if (!type.typeName.empty() && type.typeName != "?") {
+        namePath.push_back(type.typeName);
+      }
+      for (const auto &field: type.fields) {
+        offset = (offset + field.alignment - 1) / field.alignment * field.alignment;
+        if (field.kind == '@') {
+          std::vector<std::string> fieldPath = namePath;
+          fieldPath.push_back(field.name);
+          slots.push_back({PrecompiledSlotKind::ObjectInStruct, (uint32_t)offset, std::move(fieldPath)});
+        } else if (field.kind == '{') {
+          collectObjectsInStruct(field, offset, namePath, slots);
+        }
+        offset += field.size;
+      }
+    }
+
+    /**
+     Decodes indices of strong words from an ivar layout description: each byte skips as many words as its upper
+     nibble says, then marks as many words as its lower nibble says as strong.
+     */
+    inline std::unordered_set<uint64_t> strongIndicesFromIvarLayout(const uint8_t *layout, uint64_t minimumIndex) {
+      std::unordered_set<uint64_t> indices;
+      uint64_t index = minimumIndex;
+      for (; layout && *layout; ++layout) {
+        index += (*layout & 0xf0) >> 4;
+        for (uint64_t i = 0; i < (*layout & 0xf); ++i) {
+          indices.insert(index++);
+        }
+      }
+      return indices;
+    }
+
+    struct Ivar {
+      std::string name;
+      std::string typeEncoding;
+      uint32_t offset;
+    };
+
+    inline bool _readIvars(const MachOImage &image, uint64_t ivarListAddress, std::vector<Ivar> &ivars) {
+      uint32_t entrySize, count;
+      if (!image.readUInt32(ivarListAddress, entrySize) || !image.readUInt32(ivarListAddress + 4, count)) {
+        return false;
+      }
+      entrySize &= ~3U;
+      if (entrySize < 32) {
+        return false;
+      }
+      for (uint32_t i = 0; i < count; ++i) {
+        const uint64_t entry = ivarListAddress + 8 + (uint64_t)i * entrySize;
+        uint64_t offsetAddress, nameAddress, typeAddress;
+        Ivar ivar = {"", "", 0};
+        if (!image.readPointer(entry, offsetAddress) || !image.readUInt32(offsetAddress, ivar.offset) ||
+            !image.readPointer(entry + 8, nameAddress)) {
+          return false;
+        }
+        const char *name = image.stringAt(nameAddress);
+        if (!name) {
+          return false;
+        }
+        ivar.name = name;
+        // Ivars without a type, like those of some Swift classes, are skipped at runtime too
+        if (image.readPointer(entry + 16, typeAddress)) {
+          const char *type = image.stringAt(typeAddress);
+          ivar.typeEncoding = type ? type : "";
+        }
+        ivars.push_back(std::move(ivar));
+      }
+      return true;
+    }
+
+    /**
+     Reads the strong layout of one class from its class_ro_t.
+
+     @return false if class data is malformed or points outside of the image
+     */
+    inline bool extractClassLayout(const MachOImage &image, uint64_t classAddress, PrecompiledClassLayout &layout) {
+      uint64_t dataAddress, nameAddress;
+      uint32_t flags, instanceSize;
+      if (!image.readPointer(classAddress + kClassDataOffset, dataAddress)) {
+        return false;
+      }
+      const uint64_t roAddress = dataAddress & kClassDataMask;
+      if (!image.readUInt32(roAddress, flags) || (flags & kClassROFlagsMeta) ||
+          !image.readUInt32(roAddress + kClassROInstanceSizeOffset, instanceSize) ||
+          !image.readPointer(roAddress + kClassRONameOffset, nameAddress)) {
+        return false;
+      }
+      const char *name = image.stringAt(nameAddress);
+      if (!name) {
+        return false;
+      }
+
+      std::vector<Ivar> ivars;
+      uint64_t ivarListAddress;
+      if (image.readPointer(roAddress + kClassROIvarsOffset, ivarListAddress) &&
+          !_readIvars(image, ivarListAddress, ivars)) {
+        return false;
+      }
+      const uint8_t *ivarLayout = nullptr;
+      uint64_t ivarLayoutAddress;
+      if (image.readPointer(roAddress + kClassROIvarLayoutOffset, ivarLayoutAddress)) {
+        ivarLayout = (const uint8_t *)image.stringAt(ivarLayoutAddress);
+        if (!ivarLayout) {
+          return false;
+        }
+      }
+
+      layout.className = name;
+      layout.firstIvarOffset = ivars.empty() ? 0 : ivars.front().offset;
+      layout.instanceSize = (instanceSize + kPointerSize - 1) & ~(kPointerSize - 1);
+      layout.ivarLayoutHash = ivarLayoutHash(ivarLayout);
+      layout.slots.clear();
+      if (!ivarLayout) {
+        return true;
+      }
+
+      // Same as FBGetMinimumIvarIndex, the description starts at the first ivar of the class
+      const uint64_t minimumIndex = ivars.empty() ? 1 : ivars.front().offset / kPointerSize;
+      const std::unordered_set<uint64_t> strongIndices = strongIndicesFromIvarLayout(ivarLayout, minimumIndex);
+      std::vector<PrecompiledSlot> slots;
+      for (const auto &ivar: ivars) {
+        if (ivar.typeEncoding.empty()) {
+          continue;
+        }
+        if (ivar.typeEncoding[0] == '@') {
+          slots.push_back({PrecompiledSlotKind::Ivar, ivar.offset, {ivar.name}});
+        } else if (ivar.typeEncoding[0] == '{') {
+          size_t i = 0;
+          EncodedType type;
+          parseEncodedType(ivar.typeEncoding, i, type);
+          type.name = ivar.name;
+          collectObjectsInStruct(type, ivar.offset, {}, slots);
+        }
+      }
+      for (auto &slot: slots) {
+        if (slot.offset % kPointerSize == 0 && strongIndices.count(slot.offset / kPointerSize) &&
+            slot.offset + kPointerSize <= layout.instanceSize) {
+          layout.slots.push_back(std::move(slot));
+        }
+      }
+      return true;
+    }
+  }
+
+  /**
+   Reads strong layouts of all Objective-C classes an image defines in __objc_classlist. Only 64-bit images are
+   supported. Classes whose data can't be read, for example because it's bound to another image, are skipped.
+
+   @return Number of classes that were skipped
+   */
+  inline size_t extractObjCClassLayouts(const MachOImage &image, std::vector<PrecompiledClassLayout> &layouts) {
+    size_t skippedCount = 0;
+    const MachOImage::Section *classList = image.findSection(nullptr, "__objc_classlist");
+    if (!classList) {
+      return 0;
+    }
+    for (uint64_t entry = 0; entry + ObjCLayoutExtraction::kPointerSize <= classList->size;
+         entry += ObjCLayoutExtraction::kPointerSize) {
+      uint64_t classAddress;
+      PrecompiledClassLayout layout = {"", 0, 0, 0, {}};
+      if (image.readPointer(classList->address + entry, classAddress) &&
+          ObjCLayoutExtraction::extractClassLayout(image, classAddress, layout)) {
+        layouts.push_back(std::move(layout));
+      } else {
+        skippedCount++;
+      }
+    }
+    return skippedCount;
+  }
+} }
+
+#endif /* FBObjCLayoutExtractor_h */
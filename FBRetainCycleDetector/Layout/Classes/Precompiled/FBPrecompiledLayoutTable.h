@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBPrecompiledLayoutTable_h
+#define FBPrecompiledLayoutTable_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Strong layouts of Objective-C classes, extracted from an app binary at build time, so that the detector doesn't have
+   to read ivar lists, ivar layouts and struct encodings on the device. Every distinct string (class names, ivar names,
+   names of struct fields) is written once to a string table.
+
+   Layout, all integers are unsigned LEB128 varints unless noted otherwise:
+
+     magic         4 bytes, "RCDL"
+     version
+     pointer size
+     string count
+     strings       length, UTF-8 bytes
+     class count
+     classes       name index, first ivar offset, instance size, ivar layout hash (8 bytes, little endian),
+                   slot count, slots
+     slot          kind, offset in bytes, name path length, name path indices
+
+   A class is only trusted at runtime if its instance size, offset of its first ivar and ivar layout are the same as
+   they were in the binary, which they are not when the runtime had to slide its ivars.
+
+   Tables are written by tools/rcd_layout_extractor on the build host and read by the app, so this header only relies
+   on the standard library, and nothing in the format depends on the byte order or word size of either.
+   */
+  static const uint8_t kPrecompiledLayoutMagic[4] = {'R', 'C', 'D', 'L'};
+  static const uint64_t kPrecompiledLayoutVersion = 1;
+
+  enum class PrecompiledSlotKind : uint8_t {
+    // Object or block ivar, name path is the name of the ivar
+    Ivar = 0,
+    // Object in a struct ivar, name path leads to it through names of the ivar, struct types and fields
+    ObjectInStruct = 1,
+  };
+
+  struct PrecompiledSlot {
+    PrecompiledSlotKind kind;
+    uint32_t offset;
+    std::vector<std::string> namePath;
+  };
+
+  struct PrecompiledClassLayout {
+    std::string className;
+    // Offset of the first ivar declared by the class, its layout description starts at that word
+    uint32_t firstIvarOffset;
+    // Word aligned, like class_getInstanceSize returns it
+    uint32_t instanceSize;
+    uint64_t ivarLayoutHash;
+    // Only strong ones, ordered like ivars of the class
+    std::vector<PrecompiledSlot> slots;
+  };
+
+  /**
+   FNV-1a hash of an ivar layout description, as returned by class_getIvarLayout. Classes without one hash to 0.
+   */
+  inline uint64_t ivarLayoutHash(const uint8_t *layout) {
+    if (!layout) {
+      return 0;
+    }
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *layout; ++layout) {
+      hash = (hash ^ *layout) * 1099511628211ULL;
+    }
+    // Never 0, so an empty description is not mistaken for a missing one
+    return hash ? hash : 1;
+  }
+
+  class PrecompiledLayoutWriter {
+  public:
+    explicit PrecompiledLayoutWriter(uint32_t pointerSize) : _pointerSize(pointerSize) {}
+
+    void addClass(const PrecompiledClassLayout &layout) {
+      _writeVarint(_classes, _internString(layout.className));
+      _writeVarint(_classes, layout.firstIvarOffset);
+      _writeVarint(_classes, layout.instanceSize);
+      for (int byte = 0; byte < 8; ++byte) {
+        _classes.push_back((uint8_t)(layout.ivarLayoutHash >> (byte * 8)));
+      }
+      _writeVarint(_classes, layout.slots.size());
+      for (const auto &slot: layout.slots) {
+        _writeVarint(_classes, (uint64_t)slot.kind);
+        _writeVarint(_classes, slot.offset);
+        _writeVarint(_classes, slot.namePath.size());
+        for (const auto &name: slot.namePath) {
+          _writeVarint(_classes, _internString(name));
+        }
+      }
+      _classCount++;
+    }
+
+    std::vector<uint8_t> finish() const {
+      std::vector<uint8_t> data(kPrecompiledLayoutMagic, kPrecompiledLayoutMagic + sizeof(kPrecompiledLayoutMagic));
+      data.reserve(_strings.size() + _classes.size() + 16);
+      _writeVarint(data, kPrecompiledLayoutVersion);
+      _writeVarint(data, _pointerSize);
+      _writeVarint(data, _stringIndices.size());
+      data.insert(data.end(), _strings.begin(), _strings.end());
+      _writeVarint(data, _classCount);
+      data.insert(data.end(), _classes.begin(), _classes.end());
+      return data;
+    }
+
+  private:
+    uint32_t _internString(const std::string &string) {
+      auto inserted = _stringIndices.emplace(string, (uint32_t)_stringIndices.size());
+      if (inserted.second) {
+        _writeVarint(_strings, string.size());
+        _strings.insert(_strings.end(), string.begin(), string.end());
+      }
+      return inserted.first->second;
+    }
+
+    static void _writeVarint(std::vector<uint8_t> &data, uint64_t value) {
+      while (value >= 0x80) {
+        data.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+      }
+      data.push_back((uint8_t)value);
+    }
+
+    uint32_t _pointerSize;
+    std::unordered_map<std::string, uint32_t> _stringIndices;
+    std::vector<uint8_t> _strings;
+    std::vector<uint8_t> _classes;
+    uint64_t _classCount = 0;
+  };
+
+  class PrecompiledLayoutReader {
+  public:
+    /**
+     @return false if data is not a valid table for given pointer size, in which case nothing is read
+     */
+    bool read(const uint8_t *data, size_t size, uint32_t pointerSize) {
+      _classes.clear();
+      _classIndices.clear();
+      _position = data;
+      _end = data + size;
+      if (!_read(data, size, pointerSize)) {
+        _classes.clear();
+        _classIndices.clear();
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     @return nullptr if the class is not in the table
+     */
+    const PrecompiledClassLayout *findClass(const char *className) const {
+      auto index = _classIndices.find(className);
+      return index != _classIndices.end() ? &_classes[index->second] : nullptr;
+    }
+
+    const std::vector<PrecompiledClassLayout> &classes() const {
+      return _classes;
+    }
+
+  private:
+    bool _read(const uint8_t *data, size_t size, uint32_t pointerSize) {
+      if (size < sizeof(kPrecompiledLayoutMagic) ||
+          !std::equal(kPrecompiledLayoutMagic, kPrecompiledLayoutMagic + sizeof(kPrecompiledLayoutMagic), data)) {
+        return false;
+      }
+      _position += sizeof(kPrecompiledLayoutMagic);
+
+      uint64_t version, tablePointerSize, stringCount;
+      if (!_readVarint(version) || version != kPrecompiledLayoutVersion ||
+          !_readVarint(tablePointerSize) || tablePointerSize != pointerSize ||
+          !_readCount(stringCount)) {
+        return false;
+      }
+      std::vector<std::string> strings;
+      strings.reserve(stringCount);
+      for (uint64_t i = 0; i < stringCount; ++i) {
+        uint64_t length;
+        if (!_readVarint(length) || length > (uint64_t)(_end - _position)) {
+          return false;
+        }
+        strings.emplace_back((const char *)_position, (size_t)length);
+        _position += length;
+      }
+
+      uint64_t classCount;
+      if (!_readCount(classCount)) {
+        return false;
+      }
+      _classes.reserve(classCount);
+      for (uint64_t i = 0; i < classCount; ++i) {
+        PrecompiledClassLayout layout = {"", 0, 0, 0, {}};
+        uint64_t nameIndex, slotCount;
+        if (!_readIndex(nameIndex, strings) ||
+            !_readUInt32(layout.firstIvarOffset) ||
+            !_readUInt32(layout.instanceSize) ||
+            _end - _position < 8) {
+          return false;
+        }
+        layout.className = strings[nameIndex];
+        for (int byte = 0; byte < 8; ++byte) {
+          layout.ivarLayoutHash |= (uint64_t)*_position++ << (byte * 8);
+        }
+        if (!_readCount(slotCount)) {
+          return false;
+        }
+        layout.slots.resize(slotCount);
+        for (auto &slot: layout.slots) {
+          uint64_t kind, nameCount;
+          if (!_readVarint(kind) || kind > (uint64_t)PrecompiledSlotKind::ObjectInStruct ||
+              !_readUInt32(slot.offset) || slot.offset % pointerSize != 0 ||
+              !_readCount(nameCount)) {
+            return false;
+          }
+          slot.kind = (PrecompiledSlotKind)kind;
+          slot.namePath.reserve(nameCount);
+          for (uint64_t name = 0; name < nameCount; ++name) {
+            uint64_t index;
+            if (!_readIndex(index, strings)) {
+              return false;
+            }
+            slot.namePath.push_back(strings[index]);
+          }
+          // Slots have to lie within instances
+          if (slot.offset < layout.firstIvarOffset || slot.offset + pointerSize > layout.instanceSize ||
+              (slot.kind == PrecompiledSlotKind::Ivar && nameCount != 1)) {
+            return false;
+          }
+        }
+        // First class with a given name wins, like in the runtime
+        _classIndices.emplace(layout.className, _classes.size());
+        _classes.push_back(std::move(layout));
+      }
+      return _position == _end;
+    }
+
+    bool _readVarint(uint64_t &value) {
+      value = 0;
+      for (int shift = 0; shift < 64 && _position < _end; shift += 7) {
+        uint8_t byte = *_position++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool _readUInt32(uint32_t &value) {
+      uint64_t wideValue;
+      if (!_readVarint(wideValue) || wideValue > UINT32_MAX) {
+        return false;
+      }
+      value = (uint32_t)wideValue;
+      return true;
+    }
+
+    // Every counted item takes at least one byte, which rules out absurd counts before anything is allocated
+    bool _readCount(uint64_t &count) {
+      return _readVarint(count) && count <= (uint64_t)(_end - _position);
+    }
+
+    bool _readIndex(uint64_t &index, const std::vector<std::string> &strings) {
+      return _readVarint(index) && index < strings.size();
+    }
+
+    std::vector<PrecompiledClassLayout> _classes;
+    std::unordered_map<std::string, size_t> _classIndices;
+    const uint8_t *_position = nullptr;
+    const uint8_t *_end = nullptr;
+  };
+} }
+
+#endif /* FBPrecompiledLayoutTable_h */
@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBPrecompiledSwiftFieldTable_h
+#define FBPrecompiledSwiftFieldTable_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FB { namespace RetainCycleDetector {
+  /**
+   Ownership of stored Swift fields and closure captures, classified from reflection metadata of an app binary at
+   build time, so the detector doesn't need to resolve mangled type names on the device, or have reflection metadata
+   in the shipped binary at all.
+
+   Types are keyed by the offset of their type context descriptor within the image, capture boxes by the offset of
+   their heap metadata, both measured from the Mach-O header. Offsets are only meaningful for the image the table was
+   extracted from, so the table carries its UUID.
+
+   Layout, all integers are unsigned LEB128 varints unless noted otherwise:
+
+     magic         4 bytes, "RCDS"
+     version
+     image UUID    16 bytes
+     string count
+     strings       length, UTF-8 bytes
+     type count
+     types         descriptor offset, number of fields, flags, field count, fields
+     field         index in the field offset vector, ownership, name index
+     capture count
+     captures      metadata offset, capture count, ownership of every capture
+
+   Tables are written by tools/rcd_swift_field_extractor on the build host and read by the app, so this header only
+   relies on the standard library, and nothing in the format depends on the byte order or word size of either.
+   */
+  static const uint8_t kPrecompiledSwiftFieldsMagic[4] = {'R', 'C', 'D', 'S'};
+  static const uint64_t kPrecompiledSwiftFieldsVersion = 1;
+
+  enum class SwiftFieldOwnership : uint8_t {
+    Strong = 0,
+    Weak = 1,
+    Unowned = 2,
+    Closure = 3,
+    // Holds no references, like scalars, strings, enums and metatypes
+    Value = 4,
+    // Could hold references, like structs or generic parameters, but only the runtime can tell
+    Unresolved = 5,
+  };
+
+  enum : uint64_t {
+    // Some fields are Unresolved, the runtime knows better if it still has reflection metadata
+    kPrecompiledSwiftTypeHasUnresolvedFields = 1 << 0,
+  };
+
+  struct PrecompiledSwiftField {
+    uint32_t index;
+    SwiftFieldOwnership ownership;
+    std::string name;
+  };
+
+  struct PrecompiledSwiftType {
+    uint64_t descriptorOffset;
+    // Number of fields the descriptor declares, so a descriptor that doesn't match the table is not trusted
+    uint32_t numberOfFields;
+    uint64_t flags;
+    // Only those that hold references, or might
+    std::vector<PrecompiledSwiftField> fields;
+  };
+
+  struct PrecompiledSwiftCaptures {
+    uint64_t metadataOffset;
+    std::vector<SwiftFieldOwnership> captures;
+  };
+
+  class PrecompiledSwiftFieldWriter {
+  public:
+    explicit PrecompiledSwiftFieldWriter(const uint8_t uuid[16]) {
+      memcpy(_uuid, uuid, sizeof(_uuid));
+    }
+
+    void addType(const PrecompiledSwiftType &type) {
+      _writeVarint(_types, type.descriptorOffset);
+      _writeVarint(_types, type.numberOfFields);
+      _writeVarint(_types, type.flags);
+      _writeVarint(_types, type.fields.size());
+      for (const auto &field: type.fields) {
+        _writeVarint(_types, field.index);
+        _writeVarint(_types, (uint64_t)field.ownership);
+        _writeVarint(_types, _internString(field.name));
+      }
+      _typeCount++;
+    }
+
+    void addCaptures(const PrecompiledSwiftCaptures &captures) {
+      _writeVarint(_captures, captures.metadataOffset);
+      _writeVarint(_captures, captures.captures.size());
+      for (const auto ownership: captures.captures) {
+        _writeVarint(_captures, (uint64_t)ownership);
+      }
+      _captureCount++;
+    }
+
+    std::vector<uint8_t> finish() const {
+      std::vector<uint8_t> data(kPrecompiledSwiftFieldsMagic,
+                                kPrecompiledSwiftFieldsMagic + sizeof(kPrecompiledSwiftFieldsMagic));
+      data.reserve(_strings.size() + _types.size() + _captures.size() + 32);
+      _writeVarint(data, kPrecompiledSwiftFieldsVersion);
+      data.insert(data.end(), _uuid, _uuid + sizeof(_uuid));
+      _writeVarint(data, _stringIndices.size());
+      data.insert(data.end(), _strings.begin(), _strings.end());
+      _writeVarint(data, _typeCount);
+      data.insert(data.end(), _types.begin(), _types.end());
+      _writeVarint(data, _captureCount);
+      data.insert(data.end(), _captures.begin(), _captures.end());
+      return data;
+    }
+
+  private:
+    uint32_t _internString(const std::string &string) {
+      auto inserted = _stringIndices.emplace(string, (uint32_t)_stringIndices.size());
+      if (inserted.second) {
+        _writeVarint(_strings, string.size());
+        _strings.insert(_strings.end(), string.begin(), string.end());
+      }
+      return inserted.first->second;
+    }
+
+    static void _writeVarint(std::vector<uint8_t> &data, uint64_t value) {
+      while (value >= 0x80) {
+        data.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+      }
+      data.push_back((uint8_t)value);
+    }
+
+    uint8_t _uuid[16];
+    std::unordered_map<std::string, uint32_t> _stringIndices;
+    std::vector<uint8_t> _strings;
+    std::vector<uint8_t> _types;
+    std::vector<uint8_t> _captures;
+    uint64_t _typeCount = 0;
+    uint64_t _captureCount = 0;
+  };
+
+  class PrecompiledSwiftFieldReader {
+  public:
+    /**
+     @return false if data is not a valid table, in which case nothing is read
+     */
+    bool read(const uint8_t *data, size_t size) {
+      _types.clear();
+      _captures.clear();
+      _position = data;
+      _end = data + size;
+      if (!_read()) {
+        _types.clear();
+        _captures.clear();
+        return false;
+      }
+      return true;
+    }
+
+    const uint8_t *uuid() const {
+      return _uuid;
+    }
+
+    const std::vector<PrecompiledSwiftType> &types() const {
+      return _types;
+    }
+
+    const std::vector<PrecompiledSwiftCaptures> &captures() const {
+      return _captures;
+    }
+
+  private:
+    bool _read() {
+      if (_end - _position < (ptrdiff_t)sizeof(kPrecompiledSwiftFieldsMagic) ||
+          !std::equal(kPrecompiledSwiftFieldsMagic, kPrecompiledSwiftFieldsMagic + sizeof(kPrecompiledSwiftFieldsMagic),
+                      _position)) {
+        return false;
+      }
+      _position += sizeof(kPrecompiledSwiftFieldsMagic);
+
+      uint64_t version, stringCount;
+      if (!_readVarint(version) || version != kPrecompiledSwiftFieldsVersion || _end - _position < 16) {
+        return false;
+      }
+      memcpy(_uuid, _position, sizeof(_uuid));
+      _position += sizeof(_uuid);
+      if (!_readCount(stringCount)) {
+        return false;
+      }
+      std::vector<std::string> strings;
+      strings.reserve(stringCount);
+      for (uint64_t i = 0; i < stringCount; ++i) {
+        uint64_t length;
+        if (!_readVarint(length) || length > (uint64_t)(_end - _position)) {
+          return false;
+        }
+        strings.emplace_back((const char *)_position, (size_t)length);
+        _position += length;
+      }
+
+      uint64_t typeCount;
+      if (!_readCount(typeCount)) {
+        return false;
+      }
+      _types.resize(typeCount);
+      for (auto &type: _types) {
+        uint64_t fieldCount;
+        if (!_readVarint(type.descriptorOffset) || !_readUInt32(type.numberOfFields) ||
+            !_readVarint(type.flags) || !_readCount(fieldCount)) {
+          return false;
+        }
+        type.fields.resize(fieldCount);
+        for (auto &field: type.fields) {
+          uint64_t nameIndex;
+          if (!_readUInt32(field.index) || field.index >= type.numberOfFields ||
+              !_readOwnership(field.ownership) ||
+              !_readVarint(nameIndex) || nameIndex >= strings.size()) {
+            return false;
+          }
+          field.name = strings[nameIndex];
+        }
+      }
+
+      uint64_t captureCount;
+      if (!_readCount(captureCount)) {
+        return false;
+      }
+      _captures.resize(captureCount);
+      for (auto &captures: _captures) {
+        uint64_t count;
+        if (!_readVarint(captures.metadataOffset) || !_readCount(count)) {
+          return false;
+        }
+        captures.captures.resize(count);
+        for (auto &ownership: captures.captures) {
+          if (!_readOwnership(ownership)) {
+            return false;
+          }
+        }
+      }
+      return _position == _end;
+    }
+
+    bool _readOwnership(SwiftFieldOwnership &ownership) {
+      uint64_t value;
+      if (!_readVarint(value) || value > (uint64_t)SwiftFieldOwnership::Unresolved) {
+        return false;
+      }
+      ownership = (SwiftFieldOwnership)value;
+      return true;
+    }
+
+    bool _readVarint(uint64_t &value) {
+      value = 0;
+      for (int shift = 0; shift < 64 && _position < _end; shift += 7) {
+        uint8_t byte = *_position++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool _readUInt32(uint32_t &value) {
+      uint64_t wideValue;
+      if (!_readVarint(wideValue) || wideValue > UINT32_MAX) {
+        return false;
+      }
+      value = (uint32_t)wideValue;
+      return true;
+    }
+
+    // Every counted item takes at least one byte, which rules out absurd counts before anything is allocated
+    bool _readCount(uint64_t &count) {
+      return _readVarint(count) && count <= (uint64_t)(_end - _position);
+    }
+
+    uint8_t _uuid[16] = {0};
+    std::vector<PrecompiledSwiftType> _types;
+    std::vector<PrecompiledSwiftCaptures> _captures;
+    const uint8_t *_position = nullptr;
+    const uint8_t *_end = nullptr;
+  };
+} }
+
+#endif /* FBPrecompiledSwiftFieldTable_h */
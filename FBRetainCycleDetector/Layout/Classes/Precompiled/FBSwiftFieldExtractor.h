@@ -0,0 +1,346 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef FBSwiftFieldExtractor_h
+#define FBSwiftFieldExtractor_h
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FBMachOImage.h"
+#include "FBPrecompiledSwiftFieldTable.h"
+
+namespace FB { namespace RetainCycleDetector {
+  namespace SwiftFieldExtraction {
+    // From swift/ABI/Metadata.h and swift/RemoteInspection/Records.h
+    static const uint32_t kContextDescriptorKindMask = 0x1f;
+    static const uint32_t kContextDescriptorKindClass = 16;
+    static const uint32_t kContextDescriptorKindStruct = 17;
+    static const uint32_t kContextDescriptorKindEnum = 18;
+    static const uint64_t kClassDescriptorNumFieldsOffset = 36;
+    static const uint16_t kFieldDescriptorKindClass = 1;
+    static const uint64_t kFieldDescriptorSize = 16;
+    static const uint64_t kFieldRecordSize = 12;
+    static const uint64_t kCaptureDescriptorSize = 12;
+    static const uint64_t kCaptureTypeRecordSize = 4;
+    static const uint64_t kMetadataSourceRecordSize = 8;
+    static const uint64_t kHeapLocalVariableKind = 0x400;
+    static const uint64_t kHeapLocalVariableCaptureDescriptionOffset = 16;
+    // Anything longer is not a type name we are going to classify
+    static const size_t kMaximumMangledNameLength = 4096;
+
+    /**
+     Reads a mangled type name. Symbolic references to type descriptors are replaced by \x01 followed by the mangling
+     suffix of the kind of type they refer to (C, V or O), so a reference to a class reads like a class name would.
+     References that can't be followed, for example to types in other images, are left as a bare \x01.
+
+     @param firstReference Set to the descriptor of the first symbolic reference, 0 if there is none
+     @return false if the name doesn't end within the image
+     */
+    inline bool readMangledTypeName(const MachOImage &image, uint64_t address, std::string &name, uint64_t &firstReference) {
+      name.clear();
+      firstReference = 0;
+      bool isFirstReference = true;
+      while (name.size() < kMaximumMangledNameLength) {
+        const uint8_t *byte = image.bytesAt(address, 1);
+        if (!byte) {
+          return false;
+        }
+        if (*byte == 0) {
+          return true;
+        }
+        if (*byte > 0x1f) {
+          name.push_back((char)*byte);
+          address++;
+          continue;
+        }
+
+        // 0x01-0x17 are followed by a 32-bit relative offset, 0x18-0x1f by an absolute pointer
+        uint64_t descriptor = 0;
+        if (*byte <= 0x17) {
+          int32_t relativeOffset;
+          if (!image.readInt32(address + 1, relativeOffset)) {
+            return false;
+          }
+          const uint64_t target = address + 1 + (int64_t)relativeOffset;
+          if (*byte == 0x01) {
+            descriptor = target;
+          } else if (*byte == 0x02) {
+            // Left 0 if the pointer is bound to another image
+            image.readPointer(target, descriptor);
+          }
+          address += 5;
+        } else {
+          address += 9;
+        }
+
+        uint32_t flags = 0;
+        name.push_back('\x01');
+        if (descriptor && image.readUInt32(descriptor, flags)) {
+          switch (flags & kContextDescriptorKindMask) {
+            case kContextDescriptorKindClass:
+              name.push_back('C');
+              break;
+            case kContextDescriptorKindStruct:
+              name.push_back('V');
+              break;
+            case kContextDescriptorKindEnum:
+              name.push_back('O');
+              break;
+          }
+        }
+        if (isFirstReference) {
+          firstReference = descriptor;
+          isFirstReference = false;
+        }
+      }
+      return false;
+    }
+
+    inline bool _hasSuffix(const std::string &string, const char *suffix) {
+      const size_t length = strlen(suffix);
+      return string.size() >= length && string.compare(string.size() - length, length, suffix) == 0;
+    }
+
+    inline bool _hasPrefix(const std::string &string, const char *prefix) {
+      return string.compare(0, strlen(prefix), prefix) == 0;
+    }
+
+    /**
+     Classifies ownership of a field from the mangled name of its type, the way FBGetSwiftABIFields classifies the
+     metadata the name resolves to: classes, existentials and pointer sized collections are strong, functions are
+     closures, Optional is classified by what it wraps. Unlike the runtime, unowned(unsafe) is not mistaken for strong.
+     */
+    inline SwiftFieldOwnership classifyMangledTypeName(std::string name) {
+      if (_hasSuffix(name, "Xw")) {
+        return SwiftFieldOwnership::Weak;
+      }
+      if (_hasSuffix(name, "Xo") || _hasSuffix(name, "Xu")) {
+        return SwiftFieldOwnership::Unowned;
+      }
+      while (_hasSuffix(name, "Sg")) {
+        name.resize(name.size() - 2);
+      }
+      if (name.empty()) {
+        return SwiftFieldOwnership::Unresolved;
+      }
+
+      // @convention(block) closures are Objective-C objects, @convention(c) ones hold nothing
+      if (_hasSuffix(name, "XB")) {
+        return SwiftFieldOwnership::Strong;
+      }
+      if (_hasSuffix(name, "XC")) {
+        return SwiftFieldOwnership::Value;
+      }
+      if (_hasSuffix(name, "c") || _hasSuffix(name, "XE")) {
+        return SwiftFieldOwnership::Closure;
+      }
+      if (_hasSuffix(name, "Xp") || _hasSuffix(name, "m")) {
+        return SwiftFieldOwnership::Value;
+      }
+      if (_hasSuffix(name, "Xl") || _hasSuffix(name, "p")) {
+        return SwiftFieldOwnership::Strong;
+      }
+      if (_hasSuffix(name, "G")) {
+        // Bound generic types are what their unbound type is, which comes first
+        if (_hasPrefix(name, "Say") || _hasPrefix(name, "SDy") || _hasPrefix(name, "Shy") ||
+            _hasPrefix(name, "\x01" "Cy")) {
+          return SwiftFieldOwnership::Strong;
+        }
+        if (_hasPrefix(name, "\x01" "Oy")) {
+          return SwiftFieldOwnership::Value;
+        }
+        return SwiftFieldOwnership::Unresolved;
+      }
+      if (_hasSuffix(name, "C")) {
+        return SwiftFieldOwnership::Strong;
+      }
+      if (_hasSuffix(name, "O") || _hasSuffix(name, "t")) {
+        return SwiftFieldOwnership::Value;
+      }
+      // Standard library structs (Int, String, ...) don't hold anything the detector would follow
+      if ((name.size() == 2 && name[0] == 'S') || (_hasPrefix(name, "s") && _hasSuffix(name, "V"))) {
+        return SwiftFieldOwnership::Value;
+      }
+      return SwiftFieldOwnership::Unresolved;
+    }
+
+    inline bool _readRelativeString(const MachOImage &image, uint64_t address, std::string &string) {
+      int32_t relativeOffset;
+      if (!image.readInt32(address, relativeOffset) || relativeOffset == 0) {
+        return false;
+      }
+      const char *value = image.stringAt(address + (int64_t)relativeOffset);
+      if (!value) {
+        return false;
+      }
+      string = value;
+      return true;
+    }
+
+    inline bool _classifyRelativeTypeName(const MachOImage &image, uint64_t address, SwiftFieldOwnership &ownership) {
+      int32_t relativeOffset;
+      std::string name;
+      uint64_t firstReference;
+      if (!image.readInt32(address, relativeOffset) || relativeOffset == 0 ||
+          !readMangledTypeName(image, address + (int64_t)relativeOffset, name, firstReference)) {
+        return false;
+      }
+      ownership = classifyMangledTypeName(name);
+      return true;
+    }
+
+    /**
+     Reads fields of a class from its field descriptor in __swift5_fieldmd. Field names point to __swift5_reflstr.
+
+     @return false if the descriptor is not of a class defined in the image
+     */
+    inline bool extractClassFields(const MachOImage &image, uint64_t fieldDescriptor, PrecompiledSwiftType &type) {
+      uint16_t kind, recordSize;
+      uint32_t numberOfRecords;
+      int32_t relativeOffset;
+      const uint8_t *header = image.bytesAt(fieldDescriptor, kFieldDescriptorSize);
+      if (!header) {
+        return false;
+      }
+      memcpy(&kind, header + 8, sizeof(kind));
+      memcpy(&recordSize, header + 10, sizeof(recordSize));
+      memcpy(&numberOfRecords, header + 12, sizeof(numberOfRecords));
+      memcpy(&relativeOffset, header, sizeof(relativeOffset));
+      if (kind != kFieldDescriptorKindClass || relativeOffset == 0 || recordSize < kFieldRecordSize) {
+        return false;
+      }
+
+      // The descriptor names its class by a symbolic reference to the class's context descriptor
+      std::string name;
+      uint64_t descriptor;
+      if (!readMangledTypeName(image, fieldDescriptor + (int64_t)relativeOffset, name, descriptor) ||
+          name != "\x01" "C" ||
+          !image.readUInt32(descriptor + kClassDescriptorNumFieldsOffset, type.numberOfFields) ||
+          type.numberOfFields != numberOfRecords) {
+        return false;
+      }
+      type.descriptorOffset = descriptor - image.baseAddress();
+      type.flags = 0;
+      type.fields.clear();
+
+      for (uint32_t i = 0; i < numberOfRecords; ++i) {
+        const uint64_t record = fieldDescriptor + kFieldDescriptorSize + (uint64_t)i * recordSize;
+        PrecompiledSwiftField field = {i, SwiftFieldOwnership::Unresolved, ""};
+        if (!_classifyRelativeTypeName(image, record + 4, field.ownership)) {
+          field.ownership = SwiftFieldOwnership::Unresolved;
+        }
+        if (field.ownership == SwiftFieldOwnership::Value) {
+          continue;
+        }
+        if (field.ownership == SwiftFieldOwnership::Unresolved) {
+          type.flags |= kPrecompiledSwiftTypeHasUnresolvedFields;
+        }
+        _readRelativeString(image, record + 8, field.name);
+        type.fields.push_back(std::move(field));
+      }
+      return true;
+    }
+
+    /**
+     Capture descriptors in __swift5_capture, by address, with ownership of every capture.
+     */
+    inline std::unordered_map<uint64_t, std::vector<SwiftFieldOwnership>> readCaptureDescriptors(const MachOImage &image) {
+      std::unordered_map<uint64_t, std::vector<SwiftFieldOwnership>> descriptors;
+      const MachOImage::Section *section = image.findSection(nullptr, "__swift5_capture");
+      if (!section) {
+        return descriptors;
+      }
+      const uint64_t end = section->address + section->size;
+      for (uint64_t address = section->address; address + kCaptureDescriptorSize <= end;) {
+        uint32_t numberOfCaptures, numberOfMetadataSources;
+        if (!image.readUInt32(address, numberOfCaptures) || !image.readUInt32(address + 4, numberOfMetadataSources) ||
+            numberOfCaptures > section->size || numberOfMetadataSources > section->size) {
+          break;
+        }
+        std::vector<SwiftFieldOwnership> captures(numberOfCaptures, SwiftFieldOwnership::Unresolved);
+        for (uint32_t i = 0; i < numberOfCaptures; ++i) {
+          _classifyRelativeTypeName(image, address + kCaptureDescriptorSize + i * kCaptureTypeRecordSize, captures[i]);
+        }
+        descriptors.emplace(address, std::move(captures));
+        address += kCaptureDescriptorSize + numberOfCaptures * kCaptureTypeRecordSize +
+                   numberOfMetadataSources * kMetadataSourceRecordSize;
+      }
+      return descriptors;
+    }
+  }
+
+  /**
+   Reads ownership of fields of all Swift classes defined in an image, and of captures of all closure contexts whose
+   heap metadata points to a capture descriptor. Only 64-bit images are supported.
+   */
+  inline void extractSwiftFields(const MachOImage &image,
+                                 std::vector<PrecompiledSwiftType> &types,
+                                 std::vector<PrecompiledSwiftCaptures> &captures) {
+    using namespace SwiftFieldExtraction;
+
+    const MachOImage::Section *fieldSection = image.findSection(nullptr, "__swift5_fieldmd");
+    if (fieldSection) {
+      const uint64_t end = fieldSection->address + fieldSection->size;
+      for (uint64_t address = fieldSection->address; address + kFieldDescriptorSize <= end;) {
+        uint16_t recordSize;
+        uint32_t numberOfRecords;
+        const uint8_t *header = image.bytesAt(address, kFieldDescriptorSize);
+        if (!header) {
+          break;
+        }
+        memcpy(&recordSize, header + 10, sizeof(recordSize));
+        memcpy(&numberOfRecords, header + 12, sizeof(numberOfRecords));
+        PrecompiledSwiftType type = {0, 0, 0, {}};
+        if (extractClassFields(image, address, type)) {
+          types.push_back(std::move(type));
+        }
+        const uint64_t size = kFieldDescriptorSize + (uint64_t)numberOfRecords * recordSize;
+        if (size > end - address) {
+          break;
+        }
+        address += size;
+      }
+    }
+
+    // Heap metadata of closure contexts is not listed anywhere, but it's recognizable: kind, offset to the first
+    // capture, and a pointer to a capture descriptor
+    const auto captureDescriptors = readCaptureDescriptors(image);
+    if (captureDescriptors.empty()) {
+      return;
+    }
+    for (const auto &section: image.sections()) {
+      if (section.segmentName == "__TEXT" || section.segmentName == "__LINKEDIT") {
+        continue;
+      }
+      for (uint64_t address = (section.address + 7) & ~7ULL;
+           address + kHeapLocalVariableCaptureDescriptionOffset + 8 <= section.address + section.size;
+           address += 8) {
+        const uint8_t *kind = image.bytesAt(address, 8);
+        uint64_t kindValue, captureDescriptor;
+        if (!kind) {
+          break;
+        }
+        memcpy(&kindValue, kind, sizeof(kindValue));
+        if (kindValue != kHeapLocalVariableKind ||
+            !image.readPointer(address + kHeapLocalVariableCaptureDescriptionOffset, captureDescriptor)) {
+          continue;
+        }
+        auto descriptor = captureDescriptors.find(captureDescriptor);
+        if (descriptor != captureDescriptors.end()) {
+          captures.push_back({address - image.baseAddress(), descriptor->second});
+        }
+      }
+    }
+  }
+} }
+
+#endif /* FBSwiftFieldExtractor_h */
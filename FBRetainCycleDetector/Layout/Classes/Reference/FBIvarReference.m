@@ -9,6 +9,9 @@
 #import "FBIvarReference.h"
 
 @implementation FBIvarReference
+{
+  FBNamePathID _namePathID;
+}
 
 - (instancetype)initWithIvar:(Ivar)ivar
 {
@@ -22,6 +25,7 @@
     _offset = ivar_getOffset(ivar);
     _index = _offset / sizeof(void *);
     _ivar = ivar;
+    _namePathID = _name ? FBInternNamePath(@[_name]) : FBNamePathIDNone;
   }
 
   return self;
@@ -72,11 +76,17 @@
 
 - (NSArray<NSString *> *)namePath
 {
-/* @cwt-override FIXME[T168581563]: -Wnullable-to-nonnull-conversion */
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wnullable-to-nonnull-conversion"
-  return @[@(ivar_getName(_ivar))];
-#pragma clang diagnostic pop
+  return FBGetInternedNamePath(_namePathID);
+}
+
+- (FBNamePathID)namePathID
+{
+  return _namePathID;
+}
+
+- (FBGraphEdgeKind)edgeKind
+{
+  return FBGraphEdgeKindIvar;
 }
 
 @end
@@ -13,7 +13,7 @@
 @implementation FBObjectInStructReference
 {
   NSUInteger _index;
-  NSArray<NSString *> *_namePath;
+  FBNamePathID _namePathID;
 }
 
 - (instancetype)initWithIndex:(NSUInteger)index
@@ -21,7 +21,7 @@
 {
   if (self = [super init]) {
     _index = index;
-    _namePath = namePath;
+    _namePathID = FBInternNamePath(namePath);
   }
 
   return self;
@@ -46,7 +46,17 @@
 
 - (NSArray<NSString *> *)namePath
 {
-  return _namePath;
+  return FBGetInternedNamePath(_namePathID);
+}
+
+- (FBNamePathID)namePathID
+{
+  return _namePathID;
+}
+
+- (FBGraphEdgeKind)edgeKind
+{
+  return FBGraphEdgeKindStructField;
 }
 
 @end
@@ -8,6 +8,9 @@
 
 #import <Foundation/Foundation.h>
 
+#import "FBGraphEdgeKind.h"
+#import "FBNamePathTable.h"
+
 /**
  Defines an outgoing reference.
  */
@@ -31,7 +34,19 @@
 
  If that struct will be used in class, then name path would look like this:
  @[@"_myIvar", @"SomeStruct", @"myObject"]
+
+ Name paths are interned once per reference, so all edges going through the same reference share them.
  */
 - (nullable NSArray<NSString *> *)namePath;
 
+/**
+ ID of the interned name path, that's what edges going through the reference carry.
+ */
+- (FBNamePathID)namePathID;
+
+/**
+ How the object holds the reference, for example FBGraphEdgeKindStructField for the example above.
+ */
+- (FBGraphEdgeKind)edgeKind;
+
 @end
@@ -11,7 +11,7 @@
 #import <malloc/malloc.h>
 
 @implementation FBSwiftABICaptureReference {
-  NSString *_name;
+  FBNamePathID _namePathID;
   uintptr_t _closureFieldOffset;
   uintptr_t _captureBoxOffset;
 }
@@ -20,7 +20,7 @@
                   closureFieldOffset:(uintptr_t)closureFieldOffset
                     captureBoxOffset:(uintptr_t)captureBoxOffset {
   if (self = [super init]) {
-    _name = [name copy];
+    _namePathID = FBInternNamePath(@[[name copy]]);
     _closureFieldOffset = closureFieldOffset;
     _captureBoxOffset = captureBoxOffset;
   }
@@ -51,7 +51,15 @@
 }
 
 - (nullable NSArray<NSString *> *)namePath {
-  return @[_name];
+  return FBGetInternedNamePath(_namePathID);
+}
+
+- (FBNamePathID)namePathID {
+  return _namePathID;
+}
+
+- (FBGraphEdgeKind)edgeKind {
+  return FBGraphEdgeKindSwiftClosureCapture;
 }
 
 @end
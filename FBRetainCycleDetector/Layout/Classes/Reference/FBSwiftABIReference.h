@@ -17,6 +17,19 @@
  */
 @interface FBSwiftABIReference : NSObject <FBObjectReference>
 
+/**
+ Offset of the field from the start of the object.
+ */
+@property (nonatomic, readonly) uintptr_t offset;
+
 - (nonnull instancetype)initWithName:(nonnull NSString *)name offset:(uintptr_t)offset;
 
+/**
+ @param edgeKind Closures with a single capture store the captured object right in the field, these references are
+ reported as FBGraphEdgeKindSwiftClosureCapture.
+ */
+- (nonnull instancetype)initWithName:(nonnull NSString *)name
+                              offset:(uintptr_t)offset
+                            edgeKind:(FBGraphEdgeKind)edgeKind;
+
 @end
@@ -11,14 +11,21 @@
 #import <malloc/malloc.h>
 
 @implementation FBSwiftABIReference {
-  NSString *_name;
-  uintptr_t _offset;
+  FBNamePathID _namePathID;
+  FBGraphEdgeKind _edgeKind;
 }
 
 - (nonnull instancetype)initWithName:(nonnull NSString *)name offset:(uintptr_t)offset {
+  return [self initWithName:name offset:offset edgeKind:FBGraphEdgeKindSwiftField];
+}
+
+- (nonnull instancetype)initWithName:(nonnull NSString *)name
+                              offset:(uintptr_t)offset
+                            edgeKind:(FBGraphEdgeKind)edgeKind {
   if (self = [super init]) {
-    _name = [name copy];
+    _namePathID = FBInternNamePath(@[[name copy]]);
     _offset = offset;
+    _edgeKind = edgeKind;
   }
   return self;
 }
@@ -40,7 +47,15 @@
 }
 
 - (nullable NSArray<NSString *> *)namePath {
-  return @[_name];
+  return FBGetInternedNamePath(_namePathID);
+}
+
+- (FBNamePathID)namePathID {
+  return _namePathID;
+}
+
+- (FBGraphEdgeKind)edgeKind {
+  return _edgeKind;
 }
 
 @end
@@ -11,10 +11,14 @@
 #import <FBRetainCycleDetector/FBRetainCycleDetector-Swift.h>
 
 @implementation FBSwiftReference
+{
+  FBNamePathID _namePathID;
+}
 
 - (nonnull instancetype)initWithName:(NSString *)name {
   if (self = [super init]) {
       _name = name;
+      _namePathID = FBInternNamePath(@[name]);
   }
   return self;
 }
@@ -26,7 +30,15 @@
 }
 
 - (NSArray<NSString *> *)namePath {
-    return @[_name];
+    return FBGetInternedNamePath(_namePathID);
+}
+
+- (FBNamePathID)namePathID {
+    return _namePathID;
+}
+
+- (FBGraphEdgeKind)edgeKind {
+    return FBGraphEdgeKindSwiftField;
 }
 
 @end
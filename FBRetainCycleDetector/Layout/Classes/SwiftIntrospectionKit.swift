@@ -48,11 +48,36 @@
 
     @objc public let isStrong: Bool
 
+    /// Whether the property is stored as a single pointer to an object: a class instance, `AnyObject`,
+    /// or an optional of one of these (nil is stored as a null pointer). Such properties can be read
+    /// directly at `offset` instead of going through Mirror.
+    @objc public var isClassReference: Bool {
+        var type: Any.Type = valueType.rawValue
+        if let optionalType = type as? _OptionalIntrospection.Type {
+            type = optionalType.wrappedType
+        }
+        return type is AnyClass || ObjectIdentifier(type) == ObjectIdentifier(AnyObject.self)
+    }
+
     // MARK: Identifiable
 
     let id: ID
 }
 
+private protocol _OptionalIntrospection {
+
+    static var wrappedType: Any.Type { get }
+}
+
+extension Optional: _OptionalIntrospection {
+
+    // MARK: _OptionalIntrospection
+
+    static var wrappedType: Any.Type {
+        return Wrapped.self
+    }
+}
+
 extension PropertyIntrospection {
 
     // MARK: PropertyIntrospection - Raw
@@ -25,6 +25,13 @@ import Foundation
         return properties
     }
 
+    /// Same as `getPropertiesRecursive(object:)`, for instances of the given class, without having an instance at hand.
+    /// Properties only depend on the class, so callers can resolve them once and cache the result.
+    @objc(getPropertiesRecursiveOfClass:)
+    public class func getPropertiesRecursive(ofClass cls: AnyClass) -> [PropertyIntrospection] {
+        return Array(TypeIntrospection(rawValue: cls).properties)
+    }
+
     /// Get the value of the property.
     /// Filters out pure value types that cannot form retain cycles and
     /// may crash when bridged to ObjC id (EXC_BREAKPOINT in swift_dynamicCast).
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBAllocationRingBuffer.h>
+
+#import <thread>
+#import <vector>
+
+using namespace FB::RetainCycleDetector;
+
+static uintptr_t _RCDTagForAddress(uintptr_t address)
+{
+  return (address * 2654435761u) ^ 0x5555;
+}
+
+@interface FBAllocationRingBufferTests : XCTestCase
+@end
+
+@implementation FBAllocationRingBufferTests
+
+- (void)testThatDrainReturnsPushedEntriesInOrder
+{
+  AllocationRingBuffer buffer(8);
+  for (uintptr_t address = 1; address <= 5; ++address) {
+    XCTAssertTrue(buffer.push(address, _RCDTagForAddress(address)));
+  }
+
+  std::vector<AllocationRingBuffer::Entry> entries;
+  uint64_t lost = buffer.drain([&](const AllocationRingBuffer::Entry &entry) {
+    entries.push_back(entry);
+  });
+
+  XCTAssertEqual(lost, 0);
+  XCTAssertEqual(entries.size(), 5);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    XCTAssertEqual(entries[i].address, i + 1);
+    XCTAssertEqual(entries[i].tag, _RCDTagForAddress(i + 1));
+    XCTAssertEqual(entries[i].generation, i);
+  }
+
+  // Nothing new
+  buffer.drain([&](const AllocationRingBuffer::Entry &) {
+    XCTFail(@"Entry drained twice");
+  });
+}
+
+- (void)testThatOldestEntriesAreOverwrittenWhenBufferIsFull
+{
+  AllocationRingBuffer buffer(6);
+  XCTAssertEqual(buffer.capacity(), 8);
+  for (uintptr_t address = 1; address <= 20; ++address) {
+    buffer.push(address, _RCDTagForAddress(address));
+  }
+
+  std::vector<uintptr_t> addresses;
+  uint64_t lost = buffer.drain([&](const AllocationRingBuffer::Entry &entry) {
+    addresses.push_back(entry.address);
+  });
+
+  XCTAssertEqual(lost, 12);
+  XCTAssertEqual(addresses.size(), 8);
+  XCTAssertEqual(addresses.front(), 13);
+  XCTAssertEqual(addresses.back(), 20);
+}
+
+- (void)testThatConcurrentProducersNeverProduceTornEntries
+{
+  const int producerCount = 8;
+  const uintptr_t entriesPerProducer = 200000;
+  AllocationRingBuffer buffer(1024);
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < producerCount; ++producer) {
+    producers.emplace_back([&buffer, producer, entriesPerProducer] {
+      for (uintptr_t i = 1; i <= entriesPerProducer; ++i) {
+        uintptr_t address = ((uintptr_t)producer << 40) | i;
+        buffer.push(address, _RCDTagForAddress(address));
+      }
+    });
+  }
+
+  uint64_t drained = 0;
+  uint64_t lost = 0;
+  uint64_t tornEntries = 0;
+  uint64_t reorderedEntries = 0;
+  std::vector<uintptr_t> lastIndices(producerCount, 0);
+  auto drain = [&] {
+    lost += buffer.drain([&](const AllocationRingBuffer::Entry &entry) {
+      drained++;
+      if (entry.tag != _RCDTagForAddress(entry.address)) {
+        tornEntries++;
+        return;
+      }
+      // Entries of a single producer must come out in the order they were pushed
+      uintptr_t producer = entry.address >> 40;
+      uintptr_t index = entry.address & ((1ULL << 40) - 1);
+      if (index <= lastIndices[producer]) {
+        reorderedEntries++;
+      }
+      lastIndices[producer] = index;
+    });
+  };
+
+  while (buffer.pushedCount() < producerCount * entriesPerProducer) {
+    drain();
+  }
+  for (auto &producer: producers) {
+    producer.join();
+  }
+  drain();
+
+  XCTAssertEqual(drained + lost, producerCount * entriesPerProducer);
+  XCTAssertGreaterThan(drained, 0);
+  XCTAssertEqual(tornEntries, 0);
+  XCTAssertEqual(reorderedEntries, 0);
+}
+
+@end
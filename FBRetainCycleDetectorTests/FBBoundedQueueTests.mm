@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBBoundedQueue.h>
+
+#import <atomic>
+#import <chrono>
+#import <memory>
+#import <thread>
+#import <vector>
+
+using namespace FB::RetainCycleDetector;
+
+@interface FBBoundedQueueTests : XCTestCase
+@end
+
+@implementation FBBoundedQueueTests
+
+- (void)testThatValuesArePoppedInOrderUntilQueueIsClosedAndDrained
+{
+  BoundedQueue<std::unique_ptr<int>> queue(4);
+  std::vector<int> popped;
+  std::thread consumer([&queue, &popped] {
+    std::unique_ptr<int> value;
+    while (queue.pop(value)) {
+      popped.push_back(*value);
+    }
+  });
+
+  for (int i = 0; i < 1000; ++i) {
+    XCTAssertTrue(queue.push(std::unique_ptr<int>(new int(i))));
+  }
+  queue.close();
+  consumer.join();
+
+  XCTAssertEqual(popped.size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    XCTAssertEqual(popped[i], i);
+  }
+  XCTAssertFalse(queue.push(std::unique_ptr<int>(new int(0))));
+}
+
+- (void)testThatProducerWaitsWhenQueueIsFull
+{
+  BoundedQueue<int> queue(2);
+  bool waited = true;
+  XCTAssertTrue(queue.push(1, &waited));
+  XCTAssertFalse(waited);
+  XCTAssertTrue(queue.push(2, &waited));
+  XCTAssertFalse(waited);
+
+  std::atomic<bool> pushed(false);
+  std::thread producer([&queue, &pushed, &waited] {
+    queue.push(3, &waited);
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  XCTAssertFalse(pushed);
+  XCTAssertEqual(queue.size(), 2);
+
+  int value = 0;
+  XCTAssertTrue(queue.pop(value));
+  XCTAssertEqual(value, 1);
+  producer.join();
+  XCTAssertTrue(pushed);
+  XCTAssertTrue(waited);
+  XCTAssertEqual(queue.size(), 2);
+}
+
+- (void)testThatClosingQueueWakesUpWaitingProducer
+{
+  BoundedQueue<int> queue(1);
+  queue.push(1);
+  std::atomic<bool> result(true);
+  std::thread producer([&queue, &result] {
+    result = queue.push(2);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.close();
+  producer.join();
+  XCTAssertFalse(result);
+
+  int value = 0;
+  XCTAssertTrue(queue.pop(value));
+  XCTAssertEqual(value, 1);
+  XCTAssertFalse(queue.pop(value));
+}
+
+@end
@@ -11,6 +11,7 @@
 #import <UIKit/UIKit.h>
 #import <XCTest/XCTest.h>
 
+#import <FBRetainCycleDetector/FBClassLayoutPrewarmer.h>
 #import <FBRetainCycleDetector/FBClassStrongLayout.h>
 #import <FBRetainCycleDetector/FBRetainCycleDetector.h>
 
@@ -164,100 +165,131 @@ typedef struct {
 
 - (void)testLayoutForEmptyClassWillBeEmpty
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestEmptyClass new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestEmptyClass new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 0);
 }
 
 - (void)testLayoutForClassWithWeakPropertyWillBeEmpty
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithWeakProperty new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithWeakProperty new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 0);
 }
 
 - (void)testLayoutForClassWithStrongPropertyWillHaveOneReference
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithStrongProperty new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithStrongProperty new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 1);
 }
 
 - (void)testLayoutForClassWithMixedStrongAndWeakWillFetchOnlyStrong
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithMixedWeakAndStrongProperties new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithMixedWeakAndStrongProperties new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 4);
 }
 
 - (void)testLayoutForClassSubclassingEmptyClassWillFetchPropertiesProperly
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithSimpleInheritance new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithSimpleInheritance new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 1);
 }
 
 - (void)testLayoutForClassSubclassingClassWithStrongPropertiesWillFetchParentsClassProperties
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassSubclassingClassWithStrongProperties new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassSubclassingClassWithStrongProperties new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 4);
 }
 
 - (void)testLayoutForClassWithStructAsIvarWillNotCrash
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithSimpleStruct new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithSimpleStruct new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 0);
 }
 
 - (void)testLayoutForClassWithStructContainingObjectsWillFetchThoseObjects
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithStructContainingObjects new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithStructContainingObjects new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 2);
 }
 
 - (void)testLayoutForClassWithStructContainingWeakObjectWillBeEmpty
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithStructContainingWeakObject new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithStructContainingWeakObject new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 0);
 }
 
 - (void)testLayoutForClassWithComplicatedStructWillWorkProperly
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithComplicatedStruct new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithComplicatedStruct new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 5);
 }
 
 - (void)testLayoutForClassWithBitfieldsWillNotCrash
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithBitfieldStructAndStrongProperties new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithBitfieldStructAndStrongProperties new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 2);
 }
 
 - (void)testLayoutForClassWithEnumValueWillNotCrash
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithEnumValue new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithEnumValue new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 0);
 }
 
 - (void)testLayoutForClassWithSharedPointerWillNotCrash
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithSharedPointer new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithSharedPointer new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 0);
 }
 
 - (void)testLayoutForClassWithCppStructAndStrongPropertyWillNotCrashAndFetchStrongProperty
 {
-  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithCppStructAndStrongProperty new], nil, false, false, false);
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassWithCppStructAndStrongProperty new], NO, false, false, false);
 
   XCTAssertEqual([ivars count], 1);
 }
 
+- (void)testThatPrewarmedLayoutIsComputedOnceAndMatchesLayoutComputedDuringScan
+{
+  XCTestExpectation *firstPrewarm = [self expectationWithDescription:@"First prewarm"];
+  [FBClassLayoutPrewarmer prewarmLayoutsOfClasses:@[[_RCDTestClassSubclassingClassWithStrongProperties class]]
+                                completionHandler:^(NSUInteger computedCount) {
+                                  XCTAssertGreaterThan(computedCount, 0);
+                                  [firstPrewarm fulfill];
+                                }];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTestExpectation *secondPrewarm = [self expectationWithDescription:@"Second prewarm"];
+  [FBClassLayoutPrewarmer prewarmLayoutsOfClasses:@[[_RCDTestClassSubclassingClassWithStrongProperties class]]
+                                completionHandler:^(NSUInteger computedCount) {
+                                  XCTAssertEqual(computedCount, 0);
+                                  [secondPrewarm fulfill];
+                                }];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  NSArray *ivars = FBGetObjectStrongReferences([_RCDTestClassSubclassingClassWithStrongProperties new], YES, false, false, false);
+  XCTAssertEqual([ivars count], 4);
+
+  [FBClassLayoutPrewarmer resetLayouts];
+  XCTestExpectation *prewarmAfterReset = [self expectationWithDescription:@"Prewarm after reset"];
+  [FBClassLayoutPrewarmer prewarmLayoutsOfClasses:@[[_RCDTestClassSubclassingClassWithStrongProperties class]]
+                                completionHandler:^(NSUInteger computedCount) {
+                                  XCTAssertGreaterThan(computedCount, 0);
+                                  [prewarmAfterReset fulfill];
+                                }];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
 @end
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <objc/runtime.h>
+
+#import <thread>
+#import <vector>
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBClassTraits.h>
+#import <FBRetainCycleDetector/FBClassTraitsTable.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetector.h>
+
+using namespace FB::RetainCycleDetector;
+
+@interface FBClassTraitsTests : XCTestCase
+@end
+
+@implementation FBClassTraitsTests
+
+- (void)testThatTableReturnsInsertedTraits
+{
+  ClassTraitsTable table(64);
+  XCTAssertEqual(table.find(0x1000), 0);
+  XCTAssertTrue(table.insert(0x1000, 3));
+  XCTAssertTrue(table.insert(0x2000, 5));
+  XCTAssertEqual(table.find(0x1000), 3);
+  XCTAssertEqual(table.find(0x2000), 5);
+  XCTAssertEqual(table.find(0x3000), 0);
+
+  // Racing threads store the same value again
+  XCTAssertTrue(table.insert(0x1000, 3));
+  XCTAssertEqual(table.count(), 2);
+}
+
+- (void)testThatFullTableDropsNewKeys
+{
+  ClassTraitsTable table(16);
+  size_t inserted = 0;
+  for (uintptr_t key = 1; key <= 64; ++key) {
+    inserted += table.insert(key * 16, (uint32_t)key);
+  }
+  XCTAssertEqual(inserted, table.capacity());
+  for (uintptr_t key = 1; key <= 64; ++key) {
+    uint32_t value = table.find(key * 16);
+    XCTAssertTrue(value == 0 || value == key);
+  }
+}
+
+- (void)testThatConcurrentInsertsAreAllFound
+{
+  ClassTraitsTable table(4096);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&table] {
+      for (uintptr_t key = 1; key <= 1000; ++key) {
+        if (table.find(key * 16) == 0) {
+          table.insert(key * 16, (uint32_t)key);
+        }
+      }
+    });
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+
+  XCTAssertEqual(table.count(), 1000);
+  for (uintptr_t key = 1; key <= 1000; ++key) {
+    XCTAssertEqual(table.find(key * 16), key);
+  }
+}
+
+#if _INTERNAL_RCD_ENABLED
+
+- (void)testThatTraitsDescribeCommonClasses
+{
+  XCTAssertEqual(FBGetClassTraits(Nil), 0);
+
+  FBClassTraits objectTraits = FBGetClassTraits([NSObject class]);
+  XCTAssertEqual(objectTraits, FBClassTraitsComputed);
+
+  FBClassTraits arrayTraits = FBGetClassTraits([@[[NSObject new]] class]);
+  XCTAssertTrue(arrayTraits & FBClassTraitsEnumerable);
+  XCTAssertTrue(arrayTraits & FBClassTraitsFoundationArray);
+  XCTAssertFalse(arrayTraits & FBClassTraitsKeyValued);
+
+  FBClassTraits dictionaryTraits = FBGetClassTraits([[NSMutableDictionary new] class]);
+  XCTAssertTrue(dictionaryTraits & FBClassTraitsEnumerable);
+  XCTAssertTrue(dictionaryTraits & FBClassTraitsKeyValued);
+  XCTAssertTrue(dictionaryTraits & FBClassTraitsFoundationDictionary);
+
+  NSObject *object = [NSObject new];
+  void (^block)(void) = [^{
+    [object description];
+  } copy];
+  XCTAssertTrue(FBGetClassTraits(object_getClass(block)) & FBClassTraitsBlock);
+
+  XCTAssertTrue(FBGetClassTraits([NSTimer class]) & FBClassTraitsTimer);
+  XCTAssertEqual(FBGetClassTraits(object_getClass([NSArray class])), FBClassTraitsComputed | FBClassTraitsMetaClass);
+
+  // Cached traits are the same
+  XCTAssertEqual(FBGetClassTraits([@[[NSObject new]] class]), arrayTraits);
+}
+
+- (void)testPerformanceOfClassifyingObjects
+{
+  NSArray *classes = @[[NSObject class], [NSArray class], [NSDictionary class], [NSTimer class], [NSString class]];
+  [self measureBlock:^{
+    NSUInteger blocks = 0;
+    for (NSUInteger i = 0; i < 1000000; ++i) {
+      blocks += (FBGetClassTraits(classes[i % [classes count]]) & FBClassTraitsBlock) != 0;
+    }
+    XCTAssertEqual(blocks, 0);
+  }];
+}
+
+#endif //_INTERNAL_RCD_ENABLED
+
+@end
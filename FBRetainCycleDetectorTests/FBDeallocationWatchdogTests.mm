@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBDeallocationWatchdog.h>
+#import <FBRetainCycleDetector/FBObjectGraphConfiguration.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetector.h>
+#import <FBRetainCycleDetector/FBStandardGraphEdgeFilters.h>
+#import <FBRetainCycleDetector/FBTimingWheel.h>
+
+#import <thread>
+#import <vector>
+
+using namespace FB::RetainCycleDetector;
+
+@interface _RCDWatchdogTestClass : NSObject
+@property (nonatomic, strong) id object;
+@end
+@implementation _RCDWatchdogTestClass
+@end
+
+@interface FBDeallocationWatchdogTests : XCTestCase
+@end
+
+@implementation FBDeallocationWatchdogTests
+
+- (void)testThatWheelFiresValuesAtTheirDeadlines
+{
+  TimingWheel<int> wheel(100);
+  wheel.schedule(1, 101);
+  wheel.schedule(2, 100 + 64);
+  wheel.schedule(3, 100 + 64 * 64 + 5);
+  // Already due
+  wheel.schedule(4, 50);
+  XCTAssertEqual(wheel.count(), 4);
+
+  std::vector<int> fired;
+  auto record = [&fired](int value) {
+    fired.push_back(value);
+  };
+  wheel.advance(101, record);
+  XCTAssertTrue((fired == std::vector<int>{1, 4}));
+
+  wheel.advance(100 + 63, record);
+  XCTAssertEqual(fired.size(), 2);
+  wheel.advance(100 + 64, record);
+  XCTAssertTrue((fired == std::vector<int>{1, 4, 2}));
+
+  wheel.advance(100 + 64 * 64 + 4, record);
+  XCTAssertEqual(fired.size(), 3);
+  wheel.advance(100 + 64 * 64 + 5, record);
+  XCTAssertTrue((fired == std::vector<int>{1, 4, 2, 3}));
+  XCTAssertEqual(wheel.count(), 0);
+}
+
+- (void)testThatWheelFiresFarDeadlinesInOrder
+{
+  TimingWheel<uint64_t> wheel;
+  const uint64_t deadlines[] = {1ULL << 30, 17, 1ULL << 25, 4096, 4095, 262144 + 3};
+  for (uint64_t deadline: deadlines) {
+    wheel.schedule(deadline, deadline);
+  }
+
+  std::vector<uint64_t> fired;
+  for (uint64_t tick = 0; tick <= (1ULL << 30); tick += 1 + (tick % 7919)) {
+    wheel.advance(tick, [&fired, tick](uint64_t deadline) {
+      XCTAssertLessThanOrEqual(deadline, tick);
+      fired.push_back(deadline);
+    });
+  }
+  wheel.advance(1ULL << 30, [&fired](uint64_t deadline) {
+    fired.push_back(deadline);
+  });
+  XCTAssertTrue((fired == std::vector<uint64_t>{17, 4095, 4096, 262144 + 3, 1ULL << 25, 1ULL << 30}));
+}
+
+- (void)testThatInboxDrainsEveryValuePushedConcurrently
+{
+  RegistrationInbox<int> inbox;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&inbox] {
+      for (int i = 0; i < 10000; ++i) {
+        inbox.push(i);
+      }
+    });
+  }
+  size_t drained = 0;
+  long long sum = 0;
+  while (drained < 40000) {
+    drained += inbox.drain([&sum](int value) {
+      sum += value;
+    });
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+
+  XCTAssertTrue(inbox.empty());
+  XCTAssertEqual(sum, 4LL * 10000 * 9999 / 2);
+}
+
+#if _INTERNAL_RCD_ENABLED
+
+- (void)testThatWatchdogScansOnlySurvivors
+{
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Survivors reported"];
+  FBObjectGraphConfiguration *configuration =
+    [[FBObjectGraphConfiguration alloc] initWithFilterBlocks:FBGetStandardGraphEdgeFilters()
+                                         shouldInspectTimers:YES];
+  _RCDWatchdogTestClass *leakingObject = [_RCDWatchdogTestClass new];
+  leakingObject.object = leakingObject;
+
+  FBDeallocationWatchdog *watchdog =
+    [[FBDeallocationWatchdog alloc] initWithConfiguration:configuration
+                                              gracePeriod:0.1
+                                           resultsHandler:^(NSArray *survivors, NSSet *retainCycles) {
+                                             XCTAssertEqual(survivors.count, 1);
+                                             XCTAssertEqual(survivors.firstObject, leakingObject);
+                                             XCTAssertEqual(retainCycles.count, 1);
+                                             [expectation fulfill];
+                                           }];
+
+  @autoreleasepool {
+    [watchdog watchObject:[_RCDWatchdogTestClass new]];
+  }
+  [watchdog watchObject:leakingObject];
+
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  leakingObject.object = nil;
+}
+
+#endif //_INTERNAL_RCD_ENABLED
+
+@end
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBDominatorTree.h>
+#import <FBRetainCycleDetector/FBRetainedSizeGraph.h>
+
+#import <random>
+#import <utility>
+#import <vector>
+
+using namespace FB::RetainCycleDetector;
+
+static DominatorTree _RCDBuildDominatorTree(uint32_t nodeCount,
+                                            const std::vector<std::pair<uint32_t, uint32_t>> &edges) {
+  std::vector<uint32_t> edgeOffsets(nodeCount + 1, 0);
+  for (const auto &edge: edges) {
+    edgeOffsets[edge.first + 1]++;
+  }
+  for (uint32_t node = 0; node < nodeCount; ++node) {
+    edgeOffsets[node + 1] += edgeOffsets[node];
+  }
+  std::vector<uint32_t> edgeTargets(edges.size());
+  std::vector<uint32_t> fill(edgeOffsets.begin(), edgeOffsets.end() - 1);
+  for (const auto &edge: edges) {
+    edgeTargets[fill[edge.first]++] = edge.second;
+  }
+  return DominatorTree(edgeOffsets, edgeTargets, 0);
+}
+
+@interface FBDominatorTreeTests : XCTestCase
+@end
+
+@implementation FBDominatorTreeTests
+
+- (void)testThatDiamondIsDominatedByItsTop
+{
+  // 0 -> 1 -> 2 -> 4
+  //      1 -> 3 -> 4
+  DominatorTree tree = _RCDBuildDominatorTree(5, {{0, 1}, {1, 2}, {1, 3}, {2, 4}, {3, 4}});
+
+  XCTAssertEqual(tree.immediateDominator(0), DominatorTree::kNoNode);
+  XCTAssertEqual(tree.immediateDominator(1), 0);
+  XCTAssertEqual(tree.immediateDominator(2), 1);
+  XCTAssertEqual(tree.immediateDominator(3), 1);
+  XCTAssertEqual(tree.immediateDominator(4), 1);
+}
+
+- (void)testThatLoopDoesNotChangeDominators
+{
+  // 0 -> 1 -> 2 -> 3 -> 1, and 0 -> 3
+  DominatorTree tree = _RCDBuildDominatorTree(4, {{0, 1}, {1, 2}, {2, 3}, {3, 1}, {0, 3}});
+
+  XCTAssertEqual(tree.immediateDominator(1), 0);
+  XCTAssertEqual(tree.immediateDominator(2), 1);
+  XCTAssertEqual(tree.immediateDominator(3), 0);
+}
+
+- (void)testThatRetainedSizesAreSummedOverDominatedNodes
+{
+  DominatorTree tree = _RCDBuildDominatorTree(5, {{0, 1}, {1, 2}, {1, 3}, {2, 4}, {3, 4}});
+  std::vector<uint64_t> retainedSizes = tree.retainedSizes({1, 2, 4, 8, 16});
+
+  XCTAssertEqual(retainedSizes[0], 31);
+  XCTAssertEqual(retainedSizes[1], 30);
+  XCTAssertEqual(retainedSizes[2], 4);
+  XCTAssertEqual(retainedSizes[4], 16);
+}
+
+- (void)testThatUnreachableNodesRetainNothing
+{
+  DominatorTree tree = _RCDBuildDominatorTree(3, {{0, 1}, {2, 1}});
+  std::vector<uint64_t> retainedSizes = tree.retainedSizes({1, 2, 4});
+
+  XCTAssertEqual(tree.immediateDominator(2), DominatorTree::kNoNode);
+  XCTAssertEqual(retainedSizes[0], 3);
+  XCTAssertEqual(retainedSizes[2], 0);
+}
+
+- (void)testThatCycleRetainsOnlyObjectsNotReachableFromOutside
+{
+  RetainedSizeGraph graph;
+  // Candidate 0x10 <-> 0x20 form a cycle, 0x20 retains 0x30 and 0x40, 0x40 is also retained by candidate 0x50
+  graph.addRoot(0x10);
+  graph.addRoot(0x50);
+  graph.addNode(0x10, 16);
+  graph.addNode(0x20, 32);
+  graph.addNode(0x30, 64);
+  graph.addNode(0x40, 128);
+  graph.addNode(0x50, 16);
+  graph.addEdge(0x10, 0x20);
+  graph.addEdge(0x20, 0x10);
+  graph.addEdge(0x20, 0x30);
+  graph.addEdge(0x20, 0x40);
+  graph.addEdge(0x50, 0x40);
+
+  std::vector<uint64_t> retainedSizes = graph.retainedSizesOfCycles({{0x10, 0x20}});
+
+  XCTAssertEqual(retainedSizes[0], 16 + 32 + 64);
+}
+
+- (void)testThatCyclesSharingObjectsReportMemoryTogether
+{
+  RetainedSizeGraph graph;
+  graph.addRoot(0x10);
+  graph.addNode(0x10, 16);
+  graph.addNode(0x20, 32);
+  graph.addNode(0x30, 64);
+  graph.addEdge(0x10, 0x20);
+  graph.addEdge(0x20, 0x10);
+  graph.addEdge(0x20, 0x30);
+  graph.addEdge(0x30, 0x20);
+
+  std::vector<uint64_t> retainedSizes = graph.retainedSizesOfCycles({{0x10, 0x20}, {0x20, 0x30}});
+
+  XCTAssertEqual(retainedSizes[0], 16 + 32 + 64);
+  XCTAssertEqual(retainedSizes[1], 16 + 32 + 64);
+}
+
+- (void)testPerformanceOfDominatorTreeOnMillionNodeGraph
+{
+  const uint32_t nodeCount = 1000000;
+  std::mt19937 random(42);
+  std::vector<std::pair<uint32_t, uint32_t>> edges;
+  edges.reserve(nodeCount * 4);
+  for (uint32_t node = 1; node < nodeCount; ++node) {
+    edges.emplace_back(random() % node, node);
+    for (int i = 0; i < 3; ++i) {
+      edges.emplace_back(node, random() % nodeCount);
+    }
+  }
+  std::vector<uint64_t> shallowSizes(nodeCount, 16);
+
+  [self measureBlock:^{
+    DominatorTree tree = _RCDBuildDominatorTree(nodeCount, edges);
+    XCTAssertEqual(tree.retainedSizes(shallowSizes)[0], 16ull * nodeCount);
+  }];
+}
+
+@end
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <dlfcn.h>
+
+#import <FBRetainCycleDetector/rcd_fishhook_macho.h>
+
+@interface FBFishhookMachOTests : XCTestCase
+@end
+
+@implementation FBFishhookMachOTests
+
+- (void)testThatSymbolIndexFindsInsertedNames
+{
+  struct rcd_symbol_index index;
+  XCTAssertEqual(rcd_symbol_index_init(&index, 3), 0);
+
+  int first = 1, second = 2, duplicate = 3;
+  XCTAssertEqual(rcd_symbol_index_insert(&index, "objc_setAssociatedObject", &first), 1);
+  XCTAssertEqual(rcd_symbol_index_insert(&index, "objc_removeAssociatedObjects", &second), 1);
+  XCTAssertEqual(rcd_symbol_index_insert(&index, "objc_setAssociatedObject", &duplicate), 0);
+
+  XCTAssertEqual(rcd_symbol_index_lookup(&index, "objc_setAssociatedObject",
+                                         rcd_macho_symbol_hash("objc_setAssociatedObject")), &first);
+  XCTAssertEqual(rcd_symbol_index_lookup(&index, "objc_removeAssociatedObjects",
+                                         rcd_macho_symbol_hash("objc_removeAssociatedObjects")), &second);
+  XCTAssertTrue(rcd_symbol_index_lookup(&index, "objc_getAssociatedObject",
+                                        rcd_macho_symbol_hash("objc_getAssociatedObject")) == NULL);
+
+  rcd_symbol_index_destroy(&index);
+}
+
+- (void)testThatImageReadFromDiskParsesLikeLoadedImage
+{
+  Dl_info info;
+  XCTAssertNotEqual(dladdr((const void *)&rcd_macho_parse_image, &info), 0);
+
+  NSData *imageData = [NSData dataWithContentsOfFile:@(info.dli_fname)];
+  XCTAssertNotNil(imageData);
+
+  struct rcd_macho_image_info loadedImageInfo;
+  struct rcd_macho_image_info fileImageInfo;
+  int loadedResult = rcd_macho_parse_image(info.dli_fbase, 0, &loadedImageInfo);
+  int fileResult = rcd_macho_parse_image([imageData bytes], [imageData length], &fileImageInfo);
+
+  XCTAssertEqual(loadedResult, fileResult);
+  if (loadedResult == 0) {
+    XCTAssertEqual(loadedImageInfo.nsyms, fileImageInfo.nsyms);
+    XCTAssertEqual(loadedImageInfo.nindirectsyms, fileImageInfo.nindirectsyms);
+    XCTAssertEqual(loadedImageInfo.pointer_sections_count, fileImageInfo.pointer_sections_count);
+
+    // Every pointer in symbol pointer sections resolves to a name, or is a local symbol
+    const uint8_t *bytes = (const uint8_t *)[imageData bytes];
+    for (size_t i = 0; i < fileImageInfo.pointer_sections_count; i++) {
+      const struct rcd_macho_pointer_section *section = &fileImageInfo.pointer_sections[i];
+      for (uint64_t j = 0; j < section->size / fileImageInfo.pointer_size; j++) {
+        const char *name = rcd_macho_indirect_symbol_name(&fileImageInfo,
+                                                          bytes + fileImageInfo.symoff,
+                                                          (const char *)bytes + fileImageInfo.stroff,
+                                                          (const uint32_t *)(bytes + fileImageInfo.indirectsymoff),
+                                                          section->indirect_symbol_index + (uint32_t)j);
+        if (name) {
+          XCTAssertLessThan(name, (const char *)bytes + fileImageInfo.stroff + fileImageInfo.strsize);
+        }
+      }
+    }
+    rcd_macho_image_info_destroy(&loadedImageInfo);
+    rcd_macho_image_info_destroy(&fileImageInfo);
+  }
+}
+
+- (void)testThatImageWithManyPointerSectionsKeepsAllOfThem
+{
+  // 64-bit header, __DATA with 20 symbol pointer sections, __LINKEDIT, LC_SYMTAB and LC_DYSYMTAB
+  const uint32_t sectionCount = 20;
+  NSMutableData *image = [NSMutableData dataWithLength:4096];
+  uint8_t *bytes = (uint8_t *)[image mutableBytes];
+  const uint32_t header[8] = {0xfeedfacf, 0, 0, 0, 4, 0, 0, 0};
+  memcpy(bytes, header, sizeof(header));
+  uint8_t *command = bytes + sizeof(header);
+
+  const uint32_t dataSegmentSize = 72 + 80 * sectionCount;
+  const uint32_t dataSegment[2] = {0x19, dataSegmentSize};
+  memcpy(command, dataSegment, sizeof(dataSegment));
+  strcpy((char *)command + 8, "__DATA");
+  memcpy(command + 64, &sectionCount, sizeof(sectionCount));
+  for (uint32_t i = 0; i < sectionCount; i++) {
+    uint8_t *section = command + 72 + 80 * i;
+    strcpy((char *)section + 16, "__DATA");
+    const uint64_t size = 8;
+    const uint32_t flags = (i % 2) ? 0x6 : 0x7;
+    memcpy(section + 40, &size, sizeof(size));
+    memcpy(section + 64, &flags, sizeof(flags));
+    memcpy(section + 68, &i, sizeof(i));
+  }
+  command += dataSegmentSize;
+
+  const uint32_t linkeditSegment[2] = {0x19, 72};
+  memcpy(command, linkeditSegment, sizeof(linkeditSegment));
+  strcpy((char *)command + 8, "__LINKEDIT");
+  command += 72;
+
+  const uint32_t symtab[6] = {0x2, 24, 0, 0, 0, 0};
+  memcpy(command, symtab, sizeof(symtab));
+  command += sizeof(symtab);
+
+  uint32_t dysymtab[20] = {0xb, 80};
+  dysymtab[15] = sectionCount;
+  memcpy(command, dysymtab, sizeof(dysymtab));
+
+  struct rcd_macho_image_info imageInfo;
+  XCTAssertEqual(rcd_macho_parse_image(bytes, [image length], &imageInfo), 0);
+  XCTAssertEqual(imageInfo.pointer_sections_count, sectionCount);
+  XCTAssertEqual(imageInfo.pointer_sections[sectionCount - 1].indirect_symbol_index, sectionCount - 1);
+  rcd_macho_image_info_destroy(&imageInfo);
+}
+
+- (void)testThatTruncatedImageIsRejected
+{
+  Dl_info info;
+  XCTAssertNotEqual(dladdr((const void *)&rcd_macho_parse_image, &info), 0);
+
+  struct rcd_macho_image_info imageInfo;
+  XCTAssertEqual(rcd_macho_parse_image(info.dli_fbase, 16, &imageInfo), -1);
+
+  const uint8_t garbage[64] = {0};
+  XCTAssertEqual(rcd_macho_parse_image(garbage, sizeof(garbage), &imageInfo), -1);
+}
+
+@end
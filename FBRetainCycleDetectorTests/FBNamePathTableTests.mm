@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBNamePathTable.h>
+
+#import <vector>
+
+@interface FBNamePathTableTests : XCTestCase
+@end
+
+@implementation FBNamePathTableTests
+
+- (void)testThatEqualNamePathsAreInternedOnce
+{
+  FBNamePathID namePathID = FBInternNamePath(@[@"_someStruct", @"SomeStruct", @"object"]);
+  XCTAssertNotEqual(namePathID, FBNamePathIDNone);
+
+  NSMutableArray<NSString *> *equalNamePath = [@[@"_someStruct", @"SomeStruct"] mutableCopy];
+  [equalNamePath addObject:@"object"];
+  XCTAssertEqual(FBInternNamePath(equalNamePath), namePathID);
+  XCTAssertNotEqual(FBInternNamePath(@[@"_someStruct"]), namePathID);
+
+  NSArray<NSString *> *expectedNamePath = @[@"_someStruct", @"SomeStruct", @"object"];
+  XCTAssertEqualObjects(FBGetInternedNamePath(namePathID), expectedNamePath);
+  XCTAssertEqualObjects(FBGetInternedNamePathFirstName(namePathID), @"_someStruct");
+}
+
+- (void)testThatMissingNamePathsAreNotInterned
+{
+  XCTAssertEqual(FBInternNamePath(nil), FBNamePathIDNone);
+  XCTAssertEqual(FBInternNamePath(@[]), FBNamePathIDNone);
+  XCTAssertNil(FBGetInternedNamePath(FBNamePathIDNone));
+  XCTAssertNil(FBGetInternedNamePathFirstName(FBNamePathIDNone));
+}
+
+- (void)testThatConcurrentlyInternedNamePathsGetSameIDs
+{
+  const size_t count = 2000;
+  std::vector<FBNamePathID> firstIDs(count);
+  std::vector<FBNamePathID> secondIDs(count);
+  FBNamePathID *first = firstIDs.data();
+  FBNamePathID *second = secondIDs.data();
+  dispatch_apply(2 * count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+    NSArray<NSString *> *namePath = @[[NSString stringWithFormat:@"_concurrentIvar%zu", i / 2]];
+    FBNamePathID namePathID = FBInternNamePath(namePath);
+    // Reads of IDs interned by other threads don't take the lock
+    XCTAssertEqualObjects(FBGetInternedNamePath(namePathID), namePath);
+    (i % 2 ? second : first)[i / 2] = namePathID;
+  });
+
+  XCTAssertTrue(firstIDs == secondIDs);
+}
+
+@end
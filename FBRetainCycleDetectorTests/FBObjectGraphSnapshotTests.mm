@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBObjectGraphSnapshot.h>
+
+#import <vector>
+
+using namespace FB::RetainCycleDetector;
+
+/**
+ Fake objects are arrays of words: the first one holds the type key, the others hold references.
+ */
+static const uintptr_t _RCDNodeTypeKey = 1;
+static const uintptr_t _RCDLeafTypeKey = 2;
+
+static SnapshotLayoutTable _RCDLayouts()
+{
+  SnapshotLayoutTable layouts;
+  layouts[_RCDNodeTypeKey].slotOffsets = {sizeof(size_t), 2 * sizeof(size_t)};
+  layouts[_RCDLeafTypeKey].slotOffsets = {};
+  return layouts;
+}
+
+static uintptr_t _RCDTypeKeyOf(size_t address)
+{
+  return *(const size_t *)address;
+}
+
+static uint64_t _RCDNeverNow()
+{
+  return 0;
+}
+
+static bool _RCDAllowAll(const ObjectGraphSnapshot::Edge &)
+{
+  return true;
+}
+
+@interface FBObjectGraphSnapshotTests : XCTestCase
+@end
+
+@implementation FBObjectGraphSnapshotTests
+
+- (void)testThatCyclesAreFoundInCapturedGraph
+{
+  size_t a[3] = {_RCDNodeTypeKey}, b[3] = {_RCDNodeTypeKey}, c[3] = {_RCDNodeTypeKey}, leaf[1] = {_RCDLeafTypeKey};
+  a[1] = (size_t)b;
+  b[1] = (size_t)c;
+  b[2] = (size_t)leaf;
+  c[2] = (size_t)a;
+
+  ObjectGraphSnapshot snapshot(16, 64);
+  auto status = snapshot.capture({(size_t)a}, _RCDLayouts(), 10, _RCDTypeKeyOf, _RCDNeverNow, 1);
+  XCTAssertTrue(status == ObjectGraphSnapshot::Status::Complete);
+  XCTAssertEqual(snapshot.nodes().size(), 4);
+  XCTAssertEqual(snapshot.rootCount(), 1);
+  XCTAssertTrue(snapshot.unresolvedTypeKeys().empty());
+
+  auto cycles = snapshot.findCycles(10, _RCDAllowAll);
+  XCTAssertEqual(cycles.size(), 1);
+  XCTAssertEqual(cycles[0].size(), 3);
+  const auto &edges = snapshot.edges();
+  for (size_t i = 0; i < cycles[0].size(); ++i) {
+    const auto &edge = edges[cycles[0][i]];
+    XCTAssertEqual(edge.to, edges[cycles[0][(i + 1) % cycles[0].size()]].from);
+    XCTAssertEqual(edge.value, snapshot.nodes()[edge.to].address);
+  }
+  // Slot of c that closes the cycle
+  XCTAssertEqual(edges[cycles[0][2]].slot, 1);
+
+  auto filteredCycles = snapshot.findCycles(10, [&snapshot](const ObjectGraphSnapshot::Edge &edge) {
+    return snapshot.nodes()[edge.from].address != (size_t)c;
+  });
+  XCTAssertTrue(filteredCycles.empty());
+}
+
+- (void)testThatObjectsPastMaximumDepthAreNotCaptured
+{
+  size_t a[3] = {_RCDNodeTypeKey}, b[3] = {_RCDNodeTypeKey}, c[3] = {_RCDNodeTypeKey};
+  a[1] = (size_t)b;
+  b[1] = (size_t)c;
+  c[1] = (size_t)a;
+  b[2] = (size_t)b;
+
+  ObjectGraphSnapshot snapshot(16, 64);
+  snapshot.capture({(size_t)a}, _RCDLayouts(), 2, _RCDTypeKeyOf, _RCDNeverNow, 1);
+  XCTAssertEqual(snapshot.nodes().size(), 2);
+  XCTAssertEqual(snapshot.indexOfAddress((size_t)c), ObjectGraphSnapshot::kNoIndex);
+
+  auto cycles = snapshot.findCycles(2, _RCDAllowAll);
+  XCTAssertEqual(cycles.size(), 1);
+  XCTAssertEqual(cycles[0].size(), 1);
+}
+
+- (void)testThatObjectsOfUnknownTypesAreReported
+{
+  size_t a[3] = {_RCDNodeTypeKey}, unknown[3] = {42};
+  a[1] = (size_t)unknown;
+  unknown[1] = (size_t)a;
+
+  ObjectGraphSnapshot snapshot(16, 64);
+  snapshot.capture({(size_t)a}, _RCDLayouts(), 10, _RCDTypeKeyOf, _RCDNeverNow, 1);
+  XCTAssertEqual(snapshot.nodes().size(), 2);
+  XCTAssertTrue(snapshot.unresolvedTypeKeys() == std::vector<uintptr_t>{42});
+  XCTAssertTrue(snapshot.findCycles(10, _RCDAllowAll).empty());
+
+  SnapshotLayoutTable layouts = _RCDLayouts();
+  layouts[42] = layouts[_RCDNodeTypeKey];
+  snapshot.capture({(size_t)a}, layouts, 10, _RCDTypeKeyOf, _RCDNeverNow, 1);
+  XCTAssertTrue(snapshot.unresolvedTypeKeys().empty());
+  XCTAssertEqual(snapshot.findCycles(10, _RCDAllowAll).size(), 1);
+}
+
+- (void)testThatCaptureStopsWhenBuffersAreFull
+{
+  std::vector<std::vector<size_t>> chain(100, std::vector<size_t>(3, _RCDNodeTypeKey));
+  for (size_t i = 0; i + 1 < chain.size(); ++i) {
+    chain[i][1] = (size_t)chain[i + 1].data();
+  }
+
+  ObjectGraphSnapshot smallSnapshot(10, 100);
+  XCTAssertTrue(smallSnapshot.capture({(size_t)chain[0].data()}, _RCDLayouts(), 1000, _RCDTypeKeyOf, _RCDNeverNow, 1)
+                == ObjectGraphSnapshot::Status::NodeLimitReached);
+  XCTAssertEqual(smallSnapshot.nodes().size(), 10);
+
+  ObjectGraphSnapshot fewEdgesSnapshot(1000, 10);
+  XCTAssertTrue(fewEdgesSnapshot.capture({(size_t)chain[0].data()}, _RCDLayouts(), 1000, _RCDTypeKeyOf, _RCDNeverNow, 1)
+                == ObjectGraphSnapshot::Status::EdgeLimitReached);
+}
+
+- (void)testThatCaptureStopsAtDeadline
+{
+  size_t a[3] = {_RCDNodeTypeKey};
+  a[1] = (size_t)a;
+
+  ObjectGraphSnapshot snapshot(16, 64);
+  auto status = snapshot.capture({(size_t)a}, _RCDLayouts(), 10, _RCDTypeKeyOf, []{ return (uint64_t)2; }, 1);
+  XCTAssertTrue(status == ObjectGraphSnapshot::Status::DeadlineReached);
+}
+
+- (void)testThatNothingIsFoundBeforeFirstCapture
+{
+  ObjectGraphSnapshot snapshot(16, 64);
+  XCTAssertEqual(snapshot.indexOfAddress(0x1000), ObjectGraphSnapshot::kNoIndex);
+}
+
+@end
@@ -266,6 +266,118 @@
   XCTAssertTrue([retainedObjects containsObject:[[FBObjectiveCObject alloc] initWithObject:valueObject]]);
 }
 
+- (void)testObjectsRetainedByLargeMutableCollectionsWillBeFetched
+{
+  NSMutableArray *array = [NSMutableArray new];
+  NSMutableDictionary *dictionary = [NSMutableDictionary new];
+  for (NSUInteger i = 0; i < 10000; ++i) {
+    NSObject *object = [NSObject new];
+    [array addObject:object];
+    dictionary[@(i)] = object;
+  }
+
+  NSSet *retainedByArray = [[[FBObjectiveCObject alloc] initWithObject:array] allRetainedObjects];
+  NSSet *retainedByDictionary = [[[FBObjectiveCObject alloc] initWithObject:dictionary] allRetainedObjects];
+
+  XCTAssertEqual([retainedByArray count], 10000);
+  XCTAssertTrue([retainedByArray containsObject:[[FBObjectiveCObject alloc] initWithObject:[array lastObject]]]);
+  XCTAssertTrue([retainedByDictionary containsObject:[[FBObjectiveCObject alloc] initWithObject:@(9999)]]);
+  XCTAssertTrue([retainedByDictionary containsObject:[[FBObjectiveCObject alloc] initWithObject:[array firstObject]]]);
+}
+
+- (void)testCollectionsCopiedAfterLargerOnesWillFetchOnlyTheirOwnObjects
+{
+  NSMutableDictionary *largeDictionary = [NSMutableDictionary new];
+  for (NSUInteger i = 0; i < 1000; ++i) {
+    largeDictionary[@(i)] = [NSObject new];
+  }
+  XCTAssertEqual([[[[FBObjectiveCObject alloc] initWithObject:largeDictionary] allRetainedObjects] count], 2000);
+
+  NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithObject:[NSObject new] forKey:@"key"];
+  NSMutableSet *set = [NSMutableSet setWithObjects:[NSObject new], [NSObject new], nil];
+  NSMapTable *mapTable = [NSMapTable strongToStrongObjectsMapTable];
+  _RCDObjectWrapperTestClass *keyObject = [_RCDObjectWrapperTestClass new];
+  _RCDObjectWrapperTestClass *valueObject = [_RCDObjectWrapperTestClass new];
+  [mapTable setObject:valueObject forKey:keyObject];
+
+  XCTAssertEqual([[[[FBObjectiveCObject alloc] initWithObject:dictionary] allRetainedObjects] count], 2);
+  XCTAssertEqual([[[[FBObjectiveCObject alloc] initWithObject:set] allRetainedObjects] count], 2);
+  NSSet *retainedByMapTable = [[[FBObjectiveCObject alloc] initWithObject:mapTable] allRetainedObjects];
+  XCTAssertEqual([retainedByMapTable count], 2);
+  XCTAssertTrue([retainedByMapTable containsObject:[[FBObjectiveCObject alloc] initWithObject:valueObject]]);
+}
+
+- (void)testRetainedObjectsEnumeratorWillFetchSameObjectsAsAllRetainedObjects
+{
+  _RCDObjectWrapperTestClass *object = [_RCDObjectWrapperTestClass new];
+  object.someObject = [NSObject new];
+  NSMutableArray *array = [NSMutableArray arrayWithObject:object];
+  NSMutableDictionary *dictionary = [NSMutableDictionary new];
+  for (NSUInteger i = 0; i < 10000; ++i) {
+    NSObject *entry = [NSObject new];
+    [array addObject:entry];
+    dictionary[@(i)] = entry;
+  }
+
+  for (id collection in @[object, array, dictionary]) {
+    FBObjectiveCObject *abstractedObject = [[FBObjectiveCObject alloc] initWithObject:collection];
+    NSMutableSet *enumeratedObjects = [NSMutableSet new];
+    for (FBObjectiveCGraphElement *element in [abstractedObject retainedObjectsEnumerator]) {
+      [enumeratedObjects addObject:element];
+    }
+    XCTAssertEqualObjects(enumeratedObjects, [abstractedObject allRetainedObjects]);
+  }
+}
+
+- (void)testRetainedObjectsEnumeratorWillNotFetchDuplicateOrStaleObjectsOfDictionaryMutatedBetweenCalls
+{
+  NSMutableDictionary *dictionary = [NSMutableDictionary new];
+  NSMutableSet *expectedObjects = [NSMutableSet new];
+  // Keeps removed entries alive, so wrappers of them stay comparable
+  NSMutableArray *originalEntries = [NSMutableArray new];
+  for (NSUInteger i = 0; i < 100; ++i) {
+    NSString *key = [NSString stringWithFormat:@"key-%lu", (unsigned long)i];
+    NSObject *value = [NSObject new];
+    dictionary[key] = value;
+    [originalEntries addObject:key];
+    [originalEntries addObject:value];
+    [expectedObjects addObject:[[FBObjectiveCObject alloc] initWithObject:key]];
+    [expectedObjects addObject:[[FBObjectiveCObject alloc] initWithObject:value]];
+  }
+
+  FBObjectiveCObject *abstractedObject = [[FBObjectiveCObject alloc] initWithObject:dictionary];
+  NSEnumerator<FBObjectiveCGraphElement *> *enumerator = [abstractedObject retainedObjectsEnumerator];
+  NSMutableArray *enumeratedObjects = [NSMutableArray new];
+  NSUInteger step = 0;
+  FBObjectiveCGraphElement *element;
+  while ((element = [enumerator nextObject])) {
+    [enumeratedObjects addObject:element];
+    [dictionary removeObjectForKey:originalEntries[(step % 100) * 2]];
+    dictionary[[NSString stringWithFormat:@"added-%lu", (unsigned long)step]] = [NSObject new];
+    step++;
+  }
+
+  XCTAssertEqual([enumeratedObjects count], 200);
+  XCTAssertEqualObjects([NSSet setWithArray:enumeratedObjects], expectedObjects);
+}
+
+- (void)testRetainedObjectsEnumeratorStopsWhenObjectDeallocates
+{
+  FBObjectiveCObject *abstractedObject;
+  NSEnumerator<FBObjectiveCGraphElement *> *enumerator;
+  @autoreleasepool {
+    NSMutableArray *array = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 100; ++i) {
+      [array addObject:[NSObject new]];
+    }
+    abstractedObject = [[FBObjectiveCObject alloc] initWithObject:array];
+    enumerator = [abstractedObject retainedObjectsEnumerator];
+    XCTAssertNotNil([enumerator nextObject]);
+  }
+
+  XCTAssertNil([enumerator nextObject]);
+}
+
 - (void)testTollFreeBridgedDictionaryWillNotCrash
 {
   CFDictionaryValueCallBacks cb = kCFTypeDictionaryValueCallBacks;
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <objc/runtime.h>
+#import <vector>
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBClassLayoutPrewarmer.h>
+#import <FBRetainCycleDetector/FBClassStrongLayout.h>
+#import <FBRetainCycleDetector/FBMachOImage.h>
+#import <FBRetainCycleDetector/FBObjCLayoutExtractor.h>
+#import <FBRetainCycleDetector/FBObjectReferenceWithLayout.h>
+#import <FBRetainCycleDetector/FBPrecompiledLayoutTable.h>
+
+using namespace FB::RetainCycleDetector;
+
+typedef struct {
+  NSObject *object;
+  int number;
+  NSObject *anotherObject;
+} _RCDPrecompiledTestStruct;
+
+@interface _RCDPrecompiledTestClass : NSObject
+@property (nonatomic, strong) NSObject *object;
+@property (nonatomic, weak) NSObject *weakObject;
+@property (nonatomic, assign) _RCDPrecompiledTestStruct structure;
+@end
+@implementation _RCDPrecompiledTestClass
+@end
+
+// Layouts are cached once computed, so every test that loads a table needs classes no other test has met
+@interface _RCDPrecompiledLoadedTestClass : NSObject
+@property (nonatomic, assign) _RCDPrecompiledTestStruct structure;
+@end
+@implementation _RCDPrecompiledLoadedTestClass
+@end
+
+@interface _RCDPrecompiledMismatchedTestClass : NSObject
+@property (nonatomic, assign) _RCDPrecompiledTestStruct structure;
+@end
+@implementation _RCDPrecompiledMismatchedTestClass
+@end
+
+static PrecompiledClassLayout _RCDRuntimeLayoutWithoutSlots(Class aCls) {
+  unsigned int count;
+  Ivar *ivars = class_copyIvarList(aCls, &count);
+  uint32_t firstIvarOffset = count > 0 ? (uint32_t)ivar_getOffset(ivars[0]) : 0;
+  free(ivars);
+  return {class_getName(aCls), firstIvarOffset, (uint32_t)class_getInstanceSize(aCls),
+          ivarLayoutHash(class_getIvarLayout(aCls)), {}};
+}
+
+@interface FBPrecompiledLayoutTableTests : XCTestCase
+@end
+
+@implementation FBPrecompiledLayoutTableTests
+
+- (void)testThatPrecompiledLayoutTableRoundTrips
+{
+  PrecompiledLayoutWriter writer(8);
+  writer.addClass({"SomeClass", 8, 40, 0x1234, {
+    {PrecompiledSlotKind::Ivar, 8, {"_object"}},
+    {PrecompiledSlotKind::ObjectInStruct, 24, {"_structure", "SomeStruct", "object"}},
+  }});
+  writer.addClass({"OtherClass", 16, 24, 0, {}});
+  std::vector<uint8_t> data = writer.finish();
+
+  PrecompiledLayoutReader reader;
+  XCTAssertTrue(reader.read(data.data(), data.size(), 8));
+  XCTAssertEqual(reader.classes().size(), 2);
+
+  const PrecompiledClassLayout *layout = reader.findClass("SomeClass");
+  XCTAssertTrue(layout != nullptr);
+  XCTAssertEqual(layout->firstIvarOffset, 8);
+  XCTAssertEqual(layout->instanceSize, 40);
+  XCTAssertEqual(layout->ivarLayoutHash, 0x1234);
+  XCTAssertEqual(layout->slots.size(), 2);
+  XCTAssertEqual(layout->slots[1].offset, 24);
+  XCTAssertTrue(layout->slots[1].namePath == std::vector<std::string>({"_structure", "SomeStruct", "object"}));
+  XCTAssertTrue(reader.findClass("MissingClass") == nullptr);
+}
+
+- (void)testThatCorruptPrecompiledLayoutTableIsRejected
+{
+  PrecompiledLayoutWriter writer(8);
+  writer.addClass({"SomeClass", 8, 24, 0x1234, {{PrecompiledSlotKind::Ivar, 8, {"_object"}}}});
+  std::vector<uint8_t> data = writer.finish();
+
+  PrecompiledLayoutReader reader;
+  XCTAssertFalse(reader.read(data.data(), data.size() - 1, 8));
+  XCTAssertFalse(reader.read(data.data(), data.size(), 4));
+  XCTAssertTrue(reader.classes().empty());
+
+  PrecompiledLayoutWriter slotOutsideOfInstanceWriter(8);
+  slotOutsideOfInstanceWriter.addClass({"SomeClass", 8, 16, 0x1234, {{PrecompiledSlotKind::Ivar, 16, {"_object"}}}});
+  std::vector<uint8_t> slotOutsideOfInstance = slotOutsideOfInstanceWriter.finish();
+  XCTAssertFalse(reader.read(slotOutsideOfInstance.data(), slotOutsideOfInstance.size(), 8));
+}
+
+- (void)testThatEncodedStructsAreLaidOutLikeTheCompilerLaysThemOut
+{
+  std::string encoding = @encode(_RCDPrecompiledTestStruct);
+  size_t i = 0;
+  ObjCLayoutExtraction::EncodedType type;
+  XCTAssertTrue(ObjCLayoutExtraction::parseEncodedType(encoding, i, type));
+  XCTAssertEqual(type.size, sizeof(_RCDPrecompiledTestStruct));
+
+  std::vector<PrecompiledSlot> slots;
+  ObjCLayoutExtraction::collectObjectsInStruct(type, 0, {}, slots);
+  XCTAssertEqual(slots.size(), 2);
+  XCTAssertEqual(slots[1].offset, offsetof(_RCDPrecompiledTestStruct, anotherObject));
+}
+
+- (void)testThatLayoutsExtractedFromTestBinaryMatchLayoutsComputedAtRuntime
+{
+  NSData *binary = [NSData dataWithContentsOfFile:[[NSBundle bundleForClass:[self class]] executablePath]];
+  XCTAssertNotNil(binary);
+#if __arm64__
+  const uint32_t cpuType = kMachOCPUTypeARM64;
+#else
+  const uint32_t cpuType = kMachOCPUTypeX86_64;
+#endif
+  MachOImage image;
+  std::string error;
+  XCTAssertTrue(image.parse((const uint8_t *)binary.bytes, binary.length, cpuType, error));
+
+  std::vector<PrecompiledClassLayout> layouts;
+  extractObjCClassLayouts(image, layouts);
+  const PrecompiledClassLayout *layout = nullptr;
+  for (const auto &candidate: layouts) {
+    if (candidate.className == "_RCDPrecompiledTestClass") {
+      layout = &candidate;
+    }
+  }
+  XCTAssertTrue(layout != nullptr);
+
+  PrecompiledClassLayout runtimeLayout = _RCDRuntimeLayoutWithoutSlots([_RCDPrecompiledTestClass class]);
+  XCTAssertEqual(layout->instanceSize, runtimeLayout.instanceSize);
+  XCTAssertEqual(layout->firstIvarOffset, runtimeLayout.firstIvarOffset);
+  XCTAssertEqual(layout->ivarLayoutHash, runtimeLayout.ivarLayoutHash);
+
+  NSArray<id<FBObjectReferenceWithLayout>> *references =
+  (NSArray<id<FBObjectReferenceWithLayout>> *)FBGetObjectStrongReferences([_RCDPrecompiledTestClass new], NO, NO, NO, NO);
+  XCTAssertEqual(layout->slots.size(), [references count]);
+  for (size_t i = 0; i < layout->slots.size() && i < [references count]; ++i) {
+    XCTAssertEqual(layout->slots[i].offset, [references[i] indexInIvarLayout] * sizeof(void *));
+  }
+}
+
+- (void)testThatLoadedPrecompiledLayoutIsUsedWhenClassMatches
+{
+  Class aCls = [_RCDPrecompiledLoadedTestClass class];
+  PrecompiledClassLayout layout = _RCDRuntimeLayoutWithoutSlots(aCls);
+  const uint32_t offset = layout.firstIvarOffset + (uint32_t)offsetof(_RCDPrecompiledTestStruct, anotherObject);
+  layout.slots.push_back({PrecompiledSlotKind::ObjectInStruct, offset, {"_structure", "Precompiled", "anotherObject"}});
+  PrecompiledLayoutWriter writer(sizeof(void *));
+  writer.addClass(layout);
+  std::vector<uint8_t> data = writer.finish();
+
+  XCTAssertTrue([FBClassLayoutPrewarmer loadPrecompiledLayoutsFromData:[NSData dataWithBytes:data.data() length:data.size()]]);
+
+  NSArray<id<FBObjectReference>> *references = FBGetClassStrongReferences(aCls, NO);
+  XCTAssertEqual([references count], 1);
+  NSArray<NSString *> *expectedNamePath = @[@"_structure", @"Precompiled", @"anotherObject"];
+  XCTAssertEqualObjects([[references firstObject] namePath], expectedNamePath);
+}
+
+- (void)testThatLoadedPrecompiledLayoutIsIgnoredWhenClassDoesNotMatch
+{
+  Class aCls = [_RCDPrecompiledMismatchedTestClass class];
+  PrecompiledClassLayout layout = _RCDRuntimeLayoutWithoutSlots(aCls);
+  layout.instanceSize += sizeof(void *);
+  PrecompiledLayoutWriter writer(sizeof(void *));
+  writer.addClass(layout);
+  std::vector<uint8_t> data = writer.finish();
+
+  XCTAssertTrue([FBClassLayoutPrewarmer loadPrecompiledLayoutsFromData:[NSData dataWithBytes:data.data() length:data.size()]]);
+  XCTAssertFalse([FBClassLayoutPrewarmer loadPrecompiledLayoutsFromData:[NSData data]]);
+
+  // Computed from the runtime, so both objects of the struct are there
+  XCTAssertEqual([FBGetClassStrongReferences(aCls, NO) count], 2);
+}
+
+@end
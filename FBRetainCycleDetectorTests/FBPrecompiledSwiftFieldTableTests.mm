@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <string>
+#import <vector>
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBClassLayoutPrewarmer.h>
+#import <FBRetainCycleDetector/FBMachOImage.h>
+#import <FBRetainCycleDetector/FBPrecompiledSwiftFieldTable.h>
+#import <FBRetainCycleDetector/FBSwiftFieldExtractor.h>
+
+using namespace FB::RetainCycleDetector;
+
+@interface FBPrecompiledSwiftFieldTableTests : XCTestCase
+@end
+
+@implementation FBPrecompiledSwiftFieldTableTests
+
+- (void)testThatPrecompiledSwiftFieldTableRoundTrips
+{
+  const uint8_t uuid[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  PrecompiledSwiftFieldWriter writer(uuid);
+  writer.addType({0x1000, 3, kPrecompiledSwiftTypeHasUnresolvedFields, {
+    {0, SwiftFieldOwnership::Strong, "strongRef"},
+    {2, SwiftFieldOwnership::Unresolved, "point"},
+  }});
+  writer.addCaptures({0x2000, {SwiftFieldOwnership::Strong, SwiftFieldOwnership::Weak}});
+  std::vector<uint8_t> data = writer.finish();
+
+  PrecompiledSwiftFieldReader reader;
+  XCTAssertTrue(reader.read(data.data(), data.size()));
+  XCTAssertEqual(memcmp(reader.uuid(), uuid, sizeof(uuid)), 0);
+  XCTAssertEqual(reader.types().size(), 1);
+  XCTAssertEqual(reader.types()[0].descriptorOffset, 0x1000);
+  XCTAssertEqual(reader.types()[0].fields.size(), 2);
+  XCTAssertTrue(reader.types()[0].fields[1].name == "point");
+  XCTAssertEqual(reader.captures().size(), 1);
+  XCTAssertTrue(reader.captures()[0].captures[1] == SwiftFieldOwnership::Weak);
+
+  XCTAssertFalse(reader.read(data.data(), data.size() - 1));
+  XCTAssertTrue(reader.types().empty());
+}
+
+- (void)testThatOwnershipIsClassifiedFromMangledTypeNames
+{
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("So8NSObjectCSg") == SwiftFieldOwnership::Strong);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("yXlSg") == SwiftFieldOwnership::Strong);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("SaySo8NSObjectCG") == SwiftFieldOwnership::Strong);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("So8NSObjectCSgXw") == SwiftFieldOwnership::Weak);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("So8NSObjectCXo") == SwiftFieldOwnership::Unowned);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("So8NSObjectCXu") == SwiftFieldOwnership::Unowned);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("yycSg") == SwiftFieldOwnership::Closure);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("SSSg") == SwiftFieldOwnership::Value);
+  XCTAssertTrue(SwiftFieldExtraction::classifyMangledTypeName("4main5PointV") == SwiftFieldOwnership::Unresolved);
+}
+
+- (void)testThatFieldsExtractedFromTestBinaryAreClassifiedAndLoaded
+{
+  NSData *binary = [NSData dataWithContentsOfFile:[[NSBundle bundleForClass:[self class]] executablePath]];
+  XCTAssertNotNil(binary);
+#if __arm64__
+  const uint32_t cpuType = kMachOCPUTypeARM64;
+#else
+  const uint32_t cpuType = kMachOCPUTypeX86_64;
+#endif
+  MachOImage image;
+  std::string error;
+  uint8_t uuid[16];
+  XCTAssertTrue(image.parse((const uint8_t *)binary.bytes, binary.length, cpuType, error));
+  XCTAssertTrue(image.getUUID(uuid));
+
+  std::vector<PrecompiledSwiftType> types;
+  std::vector<PrecompiledSwiftCaptures> captures;
+  extractSwiftFields(image, types, captures);
+
+  // PureSwiftWithMixedRefs from FBRetainCycleSwiftDetectorTests.swift
+  const PrecompiledSwiftType *mixedRefs = nullptr;
+  for (const auto &type: types) {
+    if (type.fields.size() == 3 && type.fields[0].name == "strongRef" && type.fields[2].name == "unownedRef") {
+      mixedRefs = &type;
+    }
+  }
+  XCTAssertTrue(mixedRefs != nullptr);
+  if (mixedRefs) {
+    XCTAssertTrue(mixedRefs->fields[0].ownership == SwiftFieldOwnership::Strong);
+    XCTAssertTrue(mixedRefs->fields[1].ownership == SwiftFieldOwnership::Weak);
+    XCTAssertTrue(mixedRefs->fields[2].ownership == SwiftFieldOwnership::Unowned);
+  }
+
+  PrecompiledSwiftFieldWriter writer(uuid);
+  for (const auto &type: types) {
+    writer.addType(type);
+  }
+  std::vector<uint8_t> table = writer.finish();
+  XCTAssertTrue([FBClassLayoutPrewarmer loadPrecompiledSwiftFieldsFromData:[NSData dataWithBytes:table.data() length:table.size()]]);
+
+  // Not extracted from any loaded image
+  const uint8_t unknownUUID[16] = {0};
+  PrecompiledSwiftFieldWriter unknownImageWriter(unknownUUID);
+  std::vector<uint8_t> unknownImageTable = unknownImageWriter.finish();
+  XCTAssertFalse([FBClassLayoutPrewarmer loadPrecompiledSwiftFieldsFromData:[NSData dataWithBytes:unknownImageTable.data()
+                                                                                            length:unknownImageTable.size()]]);
+}
+
+@end
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBObjectGraphConfiguration.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetectionScheduler.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetector.h>
+#import <FBRetainCycleDetector/FBScanCostModel.h>
+#import <FBRetainCycleDetector/FBStandardGraphEdgeFilters.h>
+
+#import <cmath>
+
+using namespace FB::RetainCycleDetector;
+
+@interface _RCDSchedulerTestClass : NSObject
+@property (nonatomic, strong) id object;
+@end
+@implementation _RCDSchedulerTestClass
+@end
+
+@interface FBRetainCycleDetectionSchedulerTests : XCTestCase
+@end
+
+@implementation FBRetainCycleDetectionSchedulerTests
+
+- (void)testThatCostModelProbesWithSingleCandidateFirst
+{
+  ScanCostModel model(1, 2, 10, 0.01, 1);
+  ScanCostModel::Plan plan = model.plan(0, 100);
+  XCTAssertEqual(plan.candidateCount, 1);
+  XCTAssertEqual(plan.maxCycleLength, 10);
+}
+
+- (void)testThatCostModelScansNothingWithoutBudget
+{
+  ScanCostModel model(0, 2, 10, 0.01, 1);
+  XCTAssertEqual(model.plan(0, 100).candidateCount, 0);
+}
+
+- (void)testThatCostModelKeepsSpendingUnderBudget
+{
+  const double budget = 0.1;
+  ScanCostModel model(budget, 2, 10, 0.001, 1);
+  double maxSpent = 0;
+  double time = 0;
+  size_t backlog = 0;
+  for (int scan = 0; scan < 240; ++scan) {
+    time += 5;
+    // 40 offers per second, every candidate costs 1ms * 1.5 ^ length
+    size_t sampled = (size_t)std::lround(200 * model.sampleRate());
+    ScanCostModel::Plan plan = model.plan(time, backlog + sampled);
+    double cost = plan.candidateCount * 0.001 * std::pow(1.5, (double)plan.maxCycleLength);
+    model.record(time, plan, cost, sampled);
+    backlog = std::min<size_t>(512, backlog + sampled - plan.candidateCount);
+    maxSpent = std::max(maxSpent, model.spentInLastMinute(time));
+  }
+
+  XCTAssertLessThanOrEqual(maxSpent, budget * 1.01);
+  XCTAssertLessThan(model.sampleRate(), 0.01);
+  XCTAssertLessThan(model.cycleLength(), 10);
+}
+
+- (void)testThatCostModelUsesFullSampleRateAndCycleLengthWhenScansAreCheap
+{
+  ScanCostModel model(10, 2, 10, 0.001, 1);
+  double time = 0;
+  for (int scan = 0; scan < 60; ++scan) {
+    time += 5;
+    size_t sampled = (size_t)std::lround(4 * model.sampleRate());
+    ScanCostModel::Plan plan = model.plan(time, sampled);
+    model.record(time, plan, plan.candidateCount * 0.001 * std::pow(1.5, (double)plan.maxCycleLength), sampled);
+  }
+
+  XCTAssertEqual(model.sampleRate(), 1);
+  XCTAssertEqual(model.cycleLength(), 10);
+}
+
+#if _INTERNAL_RCD_ENABLED
+
+- (void)testThatSchedulerReportsCycleOfSampledCandidate
+{
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Retain cycle reported"];
+  FBObjectGraphConfiguration *configuration =
+    [[FBObjectGraphConfiguration alloc] initWithFilterBlocks:FBGetStandardGraphEdgeFilters()
+                                         shouldInspectTimers:YES];
+  FBRetainCycleDetectionScheduler *scheduler =
+    [[FBRetainCycleDetectionScheduler alloc] initWithConfiguration:configuration
+                                            cpuTimeBudgetPerMinute:1
+                                                    resultsHandler:^(NSSet *retainCycles) {
+                                                      XCTAssertEqual(retainCycles.count, 1);
+                                                      [expectation fulfill];
+                                                    }];
+
+  _RCDSchedulerTestClass *object = [_RCDSchedulerTestClass new];
+  object.object = object;
+
+  // Nothing was measured yet, so everything is sampled
+  XCTAssertEqual(scheduler.sampleRate, 1);
+  XCTAssertTrue([scheduler offerCandidate:object]);
+  [scheduler scanNow];
+
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  object.object = nil;
+}
+
+#endif //_INTERNAL_RCD_ENABLED
+
+@end
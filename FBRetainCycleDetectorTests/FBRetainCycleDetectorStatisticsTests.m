@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBRetainCycleDetector.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetectorStatistics.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetectorStatistics+Internal.h>
+
+@interface _RCDStatisticsTestClass : NSObject
+@property (nonatomic, strong) id object;
+@end
+@implementation _RCDStatisticsTestClass
+@end
+
+@interface FBRetainCycleDetectorStatisticsTests : XCTestCase
+@end
+
+@implementation FBRetainCycleDetectorStatisticsTests
+
+- (void)testThatHooksRecordIntoScanRunningOnCurrentThread
+{
+  FBRetainCycleDetectorStatistics *statistics = [FBRetainCycleDetectorStatistics new];
+  FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterNodesVisited);
+
+  [statistics beginScan];
+  [statistics beginCandidate:@"candidate"];
+  FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterNodesVisited);
+  FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterNodesVisited);
+  FBRetainCycleDetectorStatisticsAdd(FBRetainCycleDetectorCounterEdgesExamined, 3);
+  uint64_t canonicalizeBegin = FBRetainCycleDetectorStatisticsPhaseBegin();
+  XCTAssertGreaterThan(canonicalizeBegin, 0);
+  FBRetainCycleDetectorStatisticsPhaseEnd(FBRetainCycleDetectorPhaseCanonicalize, canonicalizeBegin, YES);
+  [statistics endCandidate];
+  [statistics endScan];
+
+  // Nothing records once the scan has ended
+  FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterNodesVisited);
+  XCTAssertEqual(FBRetainCycleDetectorStatisticsPhaseBegin(), 0);
+
+  XCTAssertEqual(statistics.candidatesScanned, 1);
+  XCTAssertEqual(statistics.nodesVisited, 2);
+  XCTAssertEqual(statistics.edgesExamined, 3);
+  XCTAssertGreaterThan(statistics.totalDuration, 0);
+
+  NSDictionary *json = [NSJSONSerialization JSONObjectWithData:[statistics chromeTraceJSONData] options:0 error:nil];
+  NSArray *names = [json[@"traceEvents"] valueForKey:@"name"];
+  XCTAssertTrue([names containsObject:@"findRetainCycles"]);
+  XCTAssertTrue([names containsObject:@"candidate"]);
+  XCTAssertTrue([names containsObject:@"canonicalize"]);
+  XCTAssertTrue([names containsObject:@"counters"]);
+}
+
+- (void)testThatStatisticsOfOtherThreadAreAddedOnTheirOwnTrack
+{
+  FBRetainCycleDetectorStatistics *statistics = [FBRetainCycleDetectorStatistics new];
+  FBRetainCycleDetectorStatistics *analysisStatistics = [FBRetainCycleDetectorStatistics new];
+
+  [statistics beginScan];
+  FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterCyclesFound);
+  dispatch_sync(dispatch_queue_create("com.facebook.rcd.statistics-tests", DISPATCH_QUEUE_SERIAL), ^{
+    [analysisStatistics beginScan];
+    FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterCyclesFound);
+    FBRetainCycleDetectorStatisticsIncrement(FBRetainCycleDetectorCounterKnownCyclesSkipped);
+    uint64_t canonicalizeBegin = FBRetainCycleDetectorStatisticsPhaseBegin();
+    FBRetainCycleDetectorStatisticsPhaseEnd(FBRetainCycleDetectorPhaseCanonicalize, canonicalizeBegin, YES);
+    [analysisStatistics endScan];
+  });
+  [statistics addStatisticsOfOtherThread:analysisStatistics];
+  [statistics endScan];
+
+  XCTAssertEqual(statistics.cyclesFound, 2);
+  XCTAssertEqual(statistics.knownCyclesSkipped, 1);
+
+  NSDictionary *json = [NSJSONSerialization JSONObjectWithData:[statistics chromeTraceJSONData] options:0 error:nil];
+  NSArray *canonicalizeEvents =
+    [json[@"traceEvents"] filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == 'canonicalize'"]];
+  XCTAssertEqual([canonicalizeEvents count], 1);
+  XCTAssertEqualObjects(canonicalizeEvents[0][@"tid"], @2);
+}
+
+#if _INTERNAL_RCD_ENABLED
+
+#if _INTERNAL_RCD_STATISTICS_ENABLED
+
+- (void)testThatStatisticsCountNodesEdgesAndCycles
+{
+  _RCDStatisticsTestClass *object1 = [_RCDStatisticsTestClass new];
+  _RCDStatisticsTestClass *object2 = [_RCDStatisticsTestClass new];
+  object1.object = object2;
+  object2.object = object1;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:object1];
+  NSSet *retainCycles = [detector findRetainCycles];
+
+  FBRetainCycleDetectorStatistics *statistics = detector.statistics;
+  XCTAssertNotNil(statistics);
+  XCTAssertEqual([retainCycles count], 1);
+  XCTAssertEqual(statistics.candidatesScanned, 1);
+  XCTAssertEqual(statistics.nodesVisited, 2);
+  XCTAssertGreaterThanOrEqual(statistics.edgesExamined, 2);
+  XCTAssertGreaterThanOrEqual(statistics.cyclesFound, 1);
+  XCTAssertGreaterThan(statistics.layoutCacheMisses, 0);
+  XCTAssertGreaterThan(statistics.layoutCacheHits, 0);
+  XCTAssertGreaterThan(statistics.totalDuration, 0);
+}
+
+- (void)testThatStatisticsOfPipelinedScanIncludeAnalysis
+{
+  _RCDStatisticsTestClass *object = [_RCDStatisticsTestClass new];
+  object.object = object;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  detector.shouldPipelineAnalysis = YES;
+  [detector addCandidate:object];
+  XCTAssertEqual([[detector findRetainCycles] count], 1);
+
+  XCTAssertEqual(detector.statistics.cyclesFound, 1);
+  XCTAssertGreaterThan(detector.statistics.canonicalizeDuration, 0);
+
+  object.object = nil;
+}
+
+- (void)testThatStatisticsProduceChromeTrace
+{
+  _RCDStatisticsTestClass *object = [_RCDStatisticsTestClass new];
+  object.object = object;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:object];
+  [detector findRetainCycles];
+
+  NSData *trace = [detector.statistics chromeTraceJSONData];
+  NSDictionary *json = [NSJSONSerialization JSONObjectWithData:trace options:0 error:nil];
+  NSArray *events = json[@"traceEvents"];
+  XCTAssertGreaterThan([events count], 0);
+
+  NSArray *names = [events valueForKey:@"name"];
+  XCTAssertTrue([names containsObject:@"findRetainCycles"]);
+  XCTAssertTrue([names containsObject:@"canonicalize"]);
+  XCTAssertTrue([names containsObject:@"counters"]);
+}
+
+#else
+
+- (void)testThatStatisticsAreNilWhenCompiledOut
+{
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:[NSObject new]];
+  [detector findRetainCycles];
+
+  XCTAssertNil(detector.statistics);
+}
+
+#endif // _INTERNAL_RCD_STATISTICS_ENABLED
+
+#endif //_INTERNAL_RCD_ENABLED
+
+@end
@@ -6,6 +6,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#import <malloc/malloc.h>
+
 #import <UIKit/UIKit.h>
 #import <XCTest/XCTest.h>
 
@@ -926,6 +928,479 @@ typedef struct {
   XCTAssertEqual([retainCycles count], 1, @"Timer userInfo retaining owner should form cycle");
 }
 
+- (void)testThatDetectorWithAcyclicNodeMemoWillFindCycleClosedDeepInRememberedSubgraph
+{
+  _RCDTestClass *object1 = [_RCDTestClass new];
+  _RCDTestClass *object2 = [_RCDTestClass new];
+  _RCDTestClass *object3 = [_RCDTestClass new];
+  object1.object = object2;
+  object2.object = object3;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  detector.shouldMemoizeAcyclicNodes = YES;
+  [detector addCandidate:object1];
+  XCTAssertEqual([[detector findRetainCycles] count], 0);
+
+  object3.object = object1;
+
+  [detector addCandidate:object1];
+  NSSet *retainCycles = [detector findRetainCycles];
+  XCTAssertEqual([retainCycles count], 1);
+  XCTAssertEqual([[retainCycles anyObject] count], 3);
+}
+
+- (void)testThatDetectorWithAcyclicNodeMemoWillFindSameCyclesWhenNothingChanged
+{
+  _RCDTestClass *object1 = [_RCDTestClass new];
+  _RCDTestClass *object2 = [_RCDTestClass new];
+  _RCDTestClass *object3 = [_RCDTestClass new];
+  object1.object = object2;
+  object1.secondObject = object3;
+  object3.object = object1;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  detector.shouldMemoizeAcyclicNodes = YES;
+  [detector addCandidate:object1];
+  NSSet *firstRetainCycles = [detector findRetainCycles];
+
+  [detector addCandidate:object1];
+  NSSet *secondRetainCycles = [detector findRetainCycles];
+
+  XCTAssertEqual([firstRetainCycles count], 1);
+  XCTAssertEqualObjects(firstRetainCycles, secondRetainCycles);
+
+  object3.object = nil;
+}
+
+- (void)testThatRetainCycleReportsAreSortedByRetainedMemory
+{
+  _RCDTestClass *smallCycleObject = [_RCDTestClass new];
+  smallCycleObject.object = smallCycleObject;
+
+  _RCDTestClass *bigCycleObject1 = [_RCDTestClass new];
+  _RCDTestClass *bigCycleObject2 = [_RCDTestClass new];
+  bigCycleObject1.object = bigCycleObject2;
+  bigCycleObject2.object = bigCycleObject1;
+  NSMutableArray *retainedArray = [NSMutableArray new];
+  for (NSUInteger i = 0; i < 100; ++i) {
+    [retainedArray addObject:[NSObject new]];
+  }
+  bigCycleObject2.array = retainedArray;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:smallCycleObject];
+  [detector addCandidate:bigCycleObject1];
+  NSArray<FBRetainCycleReport *> *reports = [detector findRetainCycleReports];
+
+  XCTAssertEqual([reports count], 2);
+  XCTAssertEqual([reports[0].cycle count], 2);
+  XCTAssertEqual([reports[1].cycle count], 1);
+  XCTAssertGreaterThan(reports[0].retainedBytes, reports[1].retainedBytes);
+  XCTAssertGreaterThanOrEqual(reports[1].retainedBytes, malloc_size((__bridge void *)smallCycleObject));
+
+  smallCycleObject.object = nil;
+  bigCycleObject1.object = nil;
+}
+
+- (void)testThatRetainCycleSignatureDoesNotDependOnWhereCycleStarts
+{
+  _RCDTestClass *object1 = [_RCDTestClass new];
+  _RCDTestSubclass *object2 = [_RCDTestSubclass new];
+  object1.object = object2;
+  object2.secondObject = object1;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:object1];
+  NSArray *cycle = [[detector findRetainCycles] anyObject];
+  NSArray *rotatedCycle = @[cycle[1], cycle[0]];
+
+  XCTAssertEqual([cycle count], 2);
+  XCTAssertEqual(FBGetRetainCycleSignature(cycle), FBGetRetainCycleSignature(rotatedCycle));
+
+  object2.secondObject = nil;
+  object2.object = object1;
+  [detector addCandidate:object1];
+  NSArray *differentCycle = [[detector findRetainCycles] anyObject];
+  XCTAssertNotEqual(FBGetRetainCycleSignature(cycle), FBGetRetainCycleSignature(differentCycle));
+
+  object2.object = nil;
+}
+
+- (void)testThatDetectorWillNotReportKnownCyclesAgain
+{
+  NSURL *fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]]];
+  _RCDTestClass *object1 = [_RCDTestClass new];
+  _RCDTestClass *object2 = [_RCDTestClass new];
+  object1.object = object2;
+  object2.object = object1;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  detector.knownCycleSignatures = [[FBRetainCycleSignatureStore alloc] initWithFileURL:fileURL];
+  [detector addCandidate:object1];
+  XCTAssertEqual([[detector findRetainCycles] count], 1);
+  XCTAssertEqual(detector.knownCycleSignatures.count, 1);
+
+  // Signatures survive relaunch, other instances of the same leak are known too
+  _RCDTestClass *object3 = [_RCDTestClass new];
+  _RCDTestClass *object4 = [_RCDTestClass new];
+  object3.object = object4;
+  object4.object = object3;
+
+  FBRetainCycleDetector *relaunchedDetector = [FBRetainCycleDetector new];
+  relaunchedDetector.knownCycleSignatures = [[FBRetainCycleSignatureStore alloc] initWithFileURL:fileURL];
+  relaunchedDetector.shouldStopExpandingKnownCycles = YES;
+  [relaunchedDetector addCandidate:object3];
+  XCTAssertEqual([[relaunchedDetector findRetainCycles] count], 0);
+
+  [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+  object1.object = nil;
+  object3.object = nil;
+}
+
+- (void)testThatDetectorStopsFollowingObjectsOverVisitedAddressesMemoryLimit
+{
+  _RCDTestClass *object1 = [_RCDTestClass new];
+  _RCDTestClass *object2 = [_RCDTestClass new];
+  object1.object = object2;
+  object2.object = object1;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  detector.visitedAddressesMemoryLimit = 0;
+  [detector addCandidate:object1];
+  XCTAssertEqual([[detector findRetainCycles] count], 0);
+
+  detector.visitedAddressesMemoryLimit = 1024;
+  [detector addCandidate:object1];
+  XCTAssertEqual([[detector findRetainCycles] count], 1);
+
+  object1.object = nil;
+}
+
+- (void)testThatCycleElementsCarryKindOfEdgeLeadingToThem
+{
+  _RCDTestClass *owner = [_RCDTestClass new];
+  NSMutableArray *array = [NSMutableArray new];
+  [array addObject:owner];
+  owner.object = array;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:owner];
+  NSArray<FBObjectiveCGraphElement *> *retainCycle = [[detector findRetainCycles] anyObject];
+  XCTAssertEqual([retainCycle count], 2);
+
+  for (FBObjectiveCGraphElement *element in retainCycle) {
+    if ([element.object isKindOfClass:[NSArray class]]) {
+      XCTAssertEqual(element.edgeKind, FBGraphEdgeKindIvar);
+    } else {
+      XCTAssertEqual(element.edgeKind, FBGraphEdgeKindCollectionEntry);
+    }
+  }
+
+  owner.object = nil;
+}
+
+- (void)testThatSkippedEdgeKindsAreNotFollowed
+{
+  _RCDTestClass *owner = [_RCDTestClass new];
+  NSMutableArray *array = [NSMutableArray new];
+  [array addObject:owner];
+  owner.object = array;
+
+  FBObjectGraphConfiguration *configuration =
+  [[FBObjectGraphConfiguration alloc] initWithFilterBlocks:@[]
+                                       shouldInspectTimers:YES
+                                          transformerBlock:nil
+                                 shouldIncludeBlockAddress:NO
+                                 shouldIncludeSwiftObjects:NO
+                                shouldUseSwiftABITraversal:NO
+                               shouldScanSwiftObjectMemory:NO
+                                          skippedEdgeKinds:FBGraphEdgeKindCollectionEntry | FBGraphEdgeKindAssociatedObject];
+  FBRetainCycleDetector *detector = [[FBRetainCycleDetector alloc] initWithConfiguration:configuration];
+  [detector addCandidate:owner];
+  XCTAssertEqual([[detector findRetainCycles] count], 0);
+
+  _RCDTestClass *other = [_RCDTestClass new];
+  other.object = owner;
+  owner.object = other;
+  FBRetainCycleDetector *secondDetector = [[FBRetainCycleDetector alloc] initWithConfiguration:configuration];
+  [secondDetector addCandidate:owner];
+  XCTAssertEqual([[secondDetector findRetainCycles] count], 1);
+
+  owner.object = nil;
+}
+
+- (void)testThatPipelinedScanFindsSameCyclesAsRegularScan
+{
+  NSMutableArray<_RCDTestClass *> *objects = [NSMutableArray new];
+  for (NSUInteger i = 0; i < 40; ++i) {
+    [objects addObject:[_RCDTestClass new]];
+  }
+  // Chains of four objects, every other one closed into a cycle, some of them reachable from the previous chain
+  for (NSUInteger i = 0; i < [objects count]; ++i) {
+    if (i % 4 != 3) {
+      objects[i].object = objects[i + 1];
+    } else if (i % 8 == 3) {
+      objects[i].object = objects[i - 3];
+    }
+    if (i % 4 == 1 && i + 4 < [objects count]) {
+      objects[i].secondObject = objects[i + 4];
+    }
+  }
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  for (_RCDTestClass *object in objects) {
+    [detector addCandidate:object];
+  }
+  NSSet *retainCycles = [detector findRetainCycles];
+  XCTAssertEqual([retainCycles count], 5);
+
+  FBRetainCycleDetector *pipelinedDetector = [FBRetainCycleDetector new];
+  pipelinedDetector.shouldPipelineAnalysis = YES;
+  pipelinedDetector.maximumPendingAnalysisCount = 1;
+  __block FBRetainCycleDetectorProgress lastProgress = {};
+  __block NSUInteger progressCount = 0;
+  pipelinedDetector.progressHandler = ^(FBRetainCycleDetectorProgress progress) {
+    XCTAssertLessThanOrEqual(progress.candidatesAnalyzed, progress.candidatesGathered);
+    XCTAssertLessThanOrEqual(progress.pendingAnalysisCount, 1);
+    lastProgress = progress;
+    progressCount++;
+  };
+  for (_RCDTestClass *object in objects) {
+    [pipelinedDetector addCandidate:object];
+  }
+  XCTAssertEqualObjects([pipelinedDetector findRetainCycles], retainCycles);
+
+  XCTAssertEqual(progressCount, [objects count] + 1);
+  XCTAssertEqual(lastProgress.candidateCount, [objects count]);
+  XCTAssertEqual(lastProgress.candidatesGathered, [objects count]);
+  XCTAssertEqual(lastProgress.candidatesAnalyzed, [objects count]);
+  XCTAssertEqual(lastProgress.pendingAnalysisCount, 0);
+
+  for (_RCDTestClass *object in objects) {
+    object.object = nil;
+  }
+}
+
+- (void)testThatSearchForShortCyclesFirstFindsSameCyclesAsRegularScan
+{
+  NSMutableArray<_RCDTestClass *> *objects = [NSMutableArray new];
+  for (NSUInteger i = 0; i < 24; ++i) {
+    [objects addObject:[_RCDTestClass new]];
+  }
+  // Cycles of one to six objects, each one reachable from the previous one
+  NSUInteger first = 0;
+  for (NSUInteger length = 1; first + length <= [objects count]; first += length, ++length) {
+    for (NSUInteger i = first; i < first + length; ++i) {
+      objects[i].object = (i + 1 < first + length) ? objects[i + 1] : objects[first];
+    }
+    if (first + length < [objects count]) {
+      objects[first].secondObject = objects[first + length];
+    }
+  }
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:objects[0]];
+  NSSet *retainCycles = [detector findRetainCycles];
+  XCTAssertEqual([retainCycles count], 6);
+
+  FBRetainCycleDetector *guidedDetector = [FBRetainCycleDetector new];
+  guidedDetector.shouldSearchShortCyclesFirst = YES;
+  [guidedDetector addCandidate:objects[0]];
+  XCTAssertEqualObjects([guidedDetector findRetainCycles], retainCycles);
+  XCTAssertFalse(guidedDetector.lastScanExhaustedExpansionBudget);
+
+  // Edges of reported cycles are followed first next time, results stay the same
+  [guidedDetector addCandidate:objects[0]];
+  XCTAssertEqualObjects([guidedDetector findRetainCycles], retainCycles);
+
+  // Enough to remember every visited object, but not what all of them retain, so some are expanded again
+  FBRetainCycleDetector *constrainedDetector = [FBRetainCycleDetector new];
+  constrainedDetector.shouldSearchShortCyclesFirst = YES;
+  constrainedDetector.visitedAddressesMemoryLimit = 2048;
+  [constrainedDetector addCandidate:objects[0]];
+  XCTAssertEqualObjects([constrainedDetector findRetainCycles], retainCycles);
+
+  for (_RCDTestClass *object in objects) {
+    object.object = nil;
+  }
+}
+
+- (void)testThatSearchForShortCyclesFirstFindsBlockCycleWithinExpansionBudget
+{
+  _RCDTestClass *testObject = [_RCDTestClass new];
+  NSMutableArray *array = [NSMutableArray new];
+  for (NSUInteger i = 0; i < 50; ++i) {
+    [array addObject:[_RCDTestClass new]];
+  }
+  testObject.array = array;
+  __block NSObject *unretainedObject;
+  testObject.block = ^{
+    unretainedObject = testObject;
+  };
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  detector.shouldSearchShortCyclesFirst = YES;
+  // The object, its block and its array
+  detector.expansionBudget = 3;
+  [detector addCandidate:testObject];
+  NSSet *retainCycles = [detector findRetainCycles];
+  XCTAssertEqual([retainCycles count], 1);
+  XCTAssertTrue(detector.lastScanExhaustedExpansionBudget);
+
+  testObject.block = nil;
+}
+
+- (void)testThatRepeatedCyclesAreCountedAfterInstanceLimit
+{
+  _RCDTestClass *list = [_RCDTestClass new];
+  NSMutableArray<_RCDTestClass *> *cells = [NSMutableArray new];
+  __block NSObject *unretainedObject;
+  for (NSUInteger i = 0; i < 30; ++i) {
+    _RCDTestClass *cell = [_RCDTestClass new];
+    // Every cell leaks the same way, through a block capturing it
+    cell.block = ^{
+      unretainedObject = cell;
+    };
+    [cells addObject:cell];
+  }
+  list.array = cells;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:list];
+  XCTAssertEqual([[detector findRetainCycles] count], 30);
+  XCTAssertEqual([detector.lastScanCycleInstanceCounts count], 0);
+
+  detector.repeatedCycleInstanceLimit = 3;
+  [detector addCandidate:list];
+  NSSet<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = [detector findRetainCycles];
+  XCTAssertEqual([retainCycles count], 3);
+  XCTAssertEqualObjects([detector.lastScanCycleInstanceCounts allValues], @[@30]);
+  XCTAssertEqualObjects([detector.lastScanCycleInstanceCounts allKeys],
+                        @[@(FBGetRetainCycleSignature([retainCycles anyObject]))]);
+
+  [detector addCandidate:list];
+  NSArray<FBRetainCycleReport *> *reports = [detector findRetainCycleReports];
+  XCTAssertEqual([reports count], 3);
+  XCTAssertEqual(reports[0].instanceCount, 30);
+
+  for (_RCDTestClass *cell in cells) {
+    cell.block = nil;
+  }
+}
+
+- (void)testThatQueryFindsShortestCycleContainingObject
+{
+  _RCDTestClass *testObject1 = [_RCDTestClass new];
+  _RCDTestClass *testObject2 = [_RCDTestClass new];
+  _RCDTestClass *testObject3 = [_RCDTestClass new];
+  _RCDTestClass *testObject4 = [_RCDTestClass new];
+
+  // 1 -> 2 -> 3 -> 4 -> 1 and 1 -> 4 -> 1
+  testObject1.object = testObject2;
+  testObject2.object = testObject3;
+  testObject3.object = testObject4;
+  testObject4.object = testObject1;
+  testObject1.secondObject = testObject4;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  NSArray<FBObjectiveCGraphElement *> *retainCycle = [detector findShortestRetainCycleContainingObject:testObject1];
+  XCTAssertEqual([retainCycle count], 2);
+  XCTAssertEqual(retainCycle[0].object, testObject1);
+  XCTAssertEqual(retainCycle[1].object, testObject4);
+
+  retainCycle = [detector findShortestRetainCycleContainingObject:testObject2];
+  XCTAssertEqual([retainCycle count], 4);
+  XCTAssertEqual(retainCycle[0].object, testObject2);
+
+  XCTAssertNil([detector findShortestRetainCycleContainingObject:testObject2 maxCycleLength:3]);
+
+  testObject4.object = nil;
+}
+
+- (void)testThatQueryWillNotReportCycleObjectOnlyReferences
+{
+  _RCDTestClass *testObject1 = [_RCDTestClass new];
+  _RCDTestClass *testObject2 = [_RCDTestClass new];
+  _RCDTestClass *testObject3 = [_RCDTestClass new];
+
+  testObject1.object = testObject2;
+  testObject2.object = testObject3;
+  testObject3.object = testObject2;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  XCTAssertNil([detector findShortestRetainCycleContainingObject:testObject1]);
+  XCTAssertEqual([[detector findShortestRetainCycleContainingObject:testObject3] count], 2);
+
+  testObject3.object = nil;
+}
+
+- (void)testThatSnapshotSearchWillFindCycleBetweenThreeElements
+{
+  _RCDTestClass *testObject1 = [_RCDTestClass new];
+  _RCDTestClass *testObject2 = [_RCDTestClass new];
+  _RCDTestClass *testObject3 = [_RCDTestClass new];
+
+  testObject1.object = testObject2;
+  testObject2.secondObject = testObject3;
+  testObject3.object = testObject1;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:testObject1];
+  NSSet *retainCycles = [detector findRetainCyclesInSnapshot];
+
+  NSSet *expectedSet = [NSSet setWithObject:[detector _shiftToUnifiedCycle:
+                                              @[[[FBObjectiveCObject alloc] initWithObject:testObject1],
+                                                [[FBObjectiveCObject alloc] initWithObject:testObject2],
+                                                [[FBObjectiveCObject alloc] initWithObject:testObject3],
+                                                ]]];
+  XCTAssertEqualObjects(retainCycles, expectedSet);
+  XCTAssertTrue(detector.lastSnapshotWasComplete);
+  XCTAssertGreaterThanOrEqual(detector.lastSnapshotPauseDuration, 0);
+
+  // Same cycle as a regular search, with the same references
+  NSArray<FBObjectiveCGraphElement *> *retainCycle = [retainCycles anyObject];
+  [detector addCandidate:testObject1];
+  NSArray<FBObjectiveCGraphElement *> *traversedRetainCycle = [[detector findRetainCycles] anyObject];
+  for (NSUInteger i = 0; i < [retainCycle count]; ++i) {
+    XCTAssertEqualObjects(retainCycle[i].namePath, traversedRetainCycle[i].namePath);
+  }
+
+  testObject1.object = nil;
+}
+
+- (void)testThatSnapshotSearchWillFindCycleBetweenBlockAndObject
+{
+  _RCDTestClass *testObject = [_RCDTestClass new];
+  __block NSObject *unretainedObject;
+
+  _RCDTestBlockType block = ^{
+    unretainedObject = testObject;
+  };
+  block = [block copy];
+  testObject.block = block;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:testObject];
+  NSSet *retainCycles = [detector findRetainCyclesInSnapshot];
+
+  NSSet *expectedSet = [NSSet setWithObject:[detector _shiftToUnifiedCycle:
+                                             @[[[FBObjectiveCObject alloc] initWithObject:testObject],
+                                               [[FBObjectiveCBlock alloc] initWithObject:block]]]];
+  XCTAssertEqualObjects(retainCycles, expectedSet);
+
+  testObject.block = nil;
+}
+
+- (void)testThatSnapshotSearchWillNotFindCycleIfOneIsUsingWeakProperty
+{
+  _RCDTestClass *testObject = [_RCDTestClass new];
+  testObject.weakObject = testObject;
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:testObject];
+  XCTAssertEqual([[detector findRetainCyclesInSnapshot] count], 0);
+}
+
 // MARK: - TODO: Tests that need implementation work before they can pass
 //
 // Block-based NSTimer:
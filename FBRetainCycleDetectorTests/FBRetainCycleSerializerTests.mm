@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBCompactCycleEncoding.h>
+#import <FBRetainCycleDetector/FBRetainCycleDetector.h>
+#import <FBRetainCycleDetector/FBRetainCycleSerializer.h>
+
+using namespace FB::RetainCycleDetector;
+
+@interface _RCDSerializerTestClass : NSObject
+@property (nonatomic, strong) id object;
+@property (nonatomic, strong) id secondObject;
+@end
+@implementation _RCDSerializerTestClass
+@end
+
+@interface FBRetainCycleSerializerTests : XCTestCase
+@end
+
+@implementation FBRetainCycleSerializerTests
+
+- (void)testThatCompactEncodingRoundTrips
+{
+  CompactCycleWriter writer;
+  uint32_t className = writer.internString("MyClass", 7);
+  uint32_t ivarName = writer.internString("_delegate", 9);
+  XCTAssertEqual(writer.internString("MyClass", 7), className);
+
+  writer.addCycle({0x0123456789abcdefULL, {{className, {ivarName}}, {className, {}}}});
+  writer.addCycle({42, {{className, {ivarName, ivarName}}}});
+  std::vector<uint8_t> data = writer.finish();
+
+  CompactCycleReader reader;
+  XCTAssertTrue(reader.read(data.data(), data.size()));
+  XCTAssertEqual(reader.strings().size(), 2);
+  XCTAssertEqual(reader.cycles().size(), 2);
+  XCTAssertEqual(reader.cycles()[0].signature, 0x0123456789abcdefULL);
+  XCTAssertEqual(reader.cycles()[0].elements.size(), 2);
+  XCTAssertEqual(reader.strings()[reader.cycles()[0].elements[0].className], "MyClass");
+  XCTAssertEqual(reader.strings()[reader.cycles()[0].elements[0].namePath[0]], "_delegate");
+  XCTAssertEqual(reader.cycles()[1].elements[0].namePath.size(), 2);
+
+  // Truncated payloads are rejected
+  for (size_t size = 0; size < data.size(); ++size) {
+    XCTAssertFalse(reader.read(data.data(), size));
+  }
+}
+
+#if _INTERNAL_RCD_ENABLED
+
+- (void)testThatSerializedCyclesDecodeToElementDescriptions
+{
+  _RCDSerializerTestClass *object1 = [_RCDSerializerTestClass new];
+  _RCDSerializerTestClass *object2 = [_RCDSerializerTestClass new];
+  object1.object = object2;
+  object2.secondObject = @[object1];
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  [detector addCandidate:object1];
+  NSSet<NSArray<FBObjectiveCGraphElement *> *> *retainCycles = [detector findRetainCycles];
+  XCTAssertEqual([retainCycles count], 1);
+
+  NSData *data = [FBRetainCycleSerializer dataWithRetainCycles:retainCycles];
+  NSArray<NSArray<NSString *> *> *descriptions = [FBRetainCycleSerializer cycleDescriptionsWithData:data];
+
+  NSMutableArray *expectedDescriptions = [NSMutableArray new];
+  for (FBObjectiveCGraphElement *element in [retainCycles anyObject]) {
+    [expectedDescriptions addObject:[element description]];
+  }
+  XCTAssertEqualObjects(descriptions, @[expectedDescriptions]);
+
+  object2.secondObject = nil;
+}
+
+- (void)testThatRepeatedNamesAreWrittenOnce
+{
+  NSMutableArray *objects = [NSMutableArray new];
+  for (NSUInteger i = 0; i < 50; ++i) {
+    _RCDSerializerTestClass *object = [_RCDSerializerTestClass new];
+    object.object = object;
+    [objects addObject:object];
+  }
+
+  FBRetainCycleDetector *detector = [FBRetainCycleDetector new];
+  NSMutableArray *retainCycles = [NSMutableArray new];
+  for (_RCDSerializerTestClass *object in objects) {
+    [detector addCandidate:object];
+    [retainCycles addObjectsFromArray:[[detector findRetainCycles] allObjects]];
+  }
+  XCTAssertEqual([retainCycles count], 50);
+
+  NSData *data = [FBRetainCycleSerializer dataWithRetainCycles:retainCycles];
+  NSUInteger classNameLength = [NSStringFromClass([_RCDSerializerTestClass class]) length];
+  // Every cycle takes a signature and a handful of indices, names are only there once
+  XCTAssertLessThan([data length], 50 * 16 + 2 * classNameLength + 64);
+
+  for (_RCDSerializerTestClass *object in objects) {
+    object.object = nil;
+  }
+}
+
+#endif //_INTERNAL_RCD_ENABLED
+
+- (void)testThatInvalidDataIsRejected
+{
+  XCTAssertNil([FBRetainCycleSerializer cycleDescriptionsWithData:[NSData data]]);
+  XCTAssertNil([FBRetainCycleSerializer cycleDescriptionsWithData:[@"not a payload" dataUsingEncoding:NSUTF8StringEncoding]]);
+}
+
+@end
@@ -34,6 +34,21 @@ import XCTest
 }
 
 
+class RCDSwiftManyPropertiesTestClass {
+  let someObject: NSObject
+  var someOptionalObject: NSObject?
+  var someAnyObject: AnyObject?
+  var someSwiftObject: RCDSwiftObjectWrapperTestClass?
+  var someString: String?
+  var someInt = 0
+  weak var irrelevantObject: NSObject?
+
+  init(someObject: NSObject) {
+    self.someObject = someObject
+  }
+}
+
+
 class FBSwiftReferenceTest: XCTestCase {
   func testObjcObjectsRetainedBySomeObjectWillBeFetched() throws {
     let someObject: NSObject = NSObject()
@@ -101,4 +116,37 @@ class FBSwiftReferenceTest: XCTestCase {
       XCTAssertTrue(retainedObjects!.contains(FBObjectiveCObject(object: someObject, configuration: configuration)))
 
     }
+
+  func testSwiftPropertiesAreReadFromCachedLayout() throws {
+    let someObject = NSObject()
+    let someOptionalObject = NSObject()
+    let someAnyObject = NSObject()
+    let someSwiftObject = RCDSwiftObjectWrapperTestClass()
+    let irrelevant = NSObject()
+
+    let testSwiftObj = RCDSwiftManyPropertiesTestClass(someObject: someObject)
+    testSwiftObj.someOptionalObject = someOptionalObject
+    testSwiftObj.someAnyObject = someAnyObject
+    testSwiftObj.someSwiftObject = someSwiftObject
+    testSwiftObj.someString = "someString"
+    testSwiftObj.irrelevantObject = irrelevant
+
+    let configuration = FBObjectGraphConfiguration(
+      filterBlocks: [],
+      shouldInspectTimers: false,
+      transformerBlock: nil,
+      shouldIncludeBlockAddress: true,
+      shouldIncludeSwiftObjects: true)
+    // Second time around the layout comes from the cache, and has to give the same objects
+    for _ in 0..<2 {
+      let object = FBObjectiveCObject(object: testSwiftObj, configuration: configuration)
+      let retainedObjects: Set<AnyHashable>? = object.allRetainedObjects()
+
+      XCTAssertTrue(retainedObjects!.contains(FBObjectiveCObject(object: someObject, configuration: configuration)))
+      XCTAssertTrue(retainedObjects!.contains(FBObjectiveCObject(object: someOptionalObject, configuration: configuration)))
+      XCTAssertTrue(retainedObjects!.contains(FBObjectiveCObject(object: someAnyObject, configuration: configuration)))
+      XCTAssertTrue(retainedObjects!.contains(FBObjectiveCObject(object: someSwiftObject, configuration: configuration)))
+      XCTAssertFalse(retainedObjects!.contains(FBObjectiveCObject(object: irrelevant, configuration: configuration)))
+    }
+  }
 }
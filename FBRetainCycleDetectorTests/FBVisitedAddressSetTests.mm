@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBRetainCycleDetector/FBVisitedAddressSet.h>
+
+#import <random>
+#import <unordered_set>
+#import <vector>
+
+using namespace FB::RetainCycleDetector;
+
+/**
+ Addresses the way malloc hands them out: clustered in a few regions, 16 byte aligned.
+ */
+static std::vector<size_t> _RCDHeapLikeAddresses(size_t count, uint64_t seed)
+{
+  std::mt19937_64 random(seed);
+  std::vector<size_t> regions;
+  for (int i = 0; i < 64; ++i) {
+    regions.push_back(0x100000000ULL + (random() % (1ULL << 30)) * (1 << 20));
+  }
+  std::vector<size_t> addresses(count);
+  for (size_t &address: addresses) {
+    address = regions[random() % regions.size()] + (random() % (1 << 16)) * 16;
+  }
+  return addresses;
+}
+
+@interface FBVisitedAddressSetTests : XCTestCase
+@end
+
+@implementation FBVisitedAddressSetTests
+
+- (void)testThatSetContainsExactlyInsertedAddresses
+{
+  std::mt19937_64 random(7);
+  VisitedAddressSet set;
+  std::unordered_set<size_t> expected;
+
+  for (int i = 0; i < 200000; ++i) {
+    size_t address;
+    switch (random() % 3) {
+      case 0:
+        address = 0x100000000ULL + (random() % (1 << 20)) * 16;
+        break;
+      case 1:
+        address = (random() % (1ULL << 40)) & ~(size_t)15;
+        break;
+      default:
+        // Not aligned, for example faked addresses
+        address = random() % 4096;
+        break;
+    }
+    BOOL isNew = expected.insert(address).second;
+    XCTAssertEqual(set.insert(address) == VisitedAddressSet::InsertResult::Inserted, isNew);
+  }
+
+  XCTAssertEqual(set.count(), expected.size());
+  for (size_t address: expected) {
+    XCTAssertTrue(set.contains(address));
+  }
+  XCTAssertFalse(set.contains(0x100000000ULL + (1 << 20) * 16 + 16));
+
+  set.clear();
+  XCTAssertEqual(set.count(), 0);
+  XCTAssertEqual(set.memoryUsage(), 0);
+  XCTAssertFalse(set.contains(*expected.begin()));
+}
+
+- (void)testThatDenseRegionsTakeLessThanTwoBytesPerAddress
+{
+  VisitedAddressSet set;
+  for (size_t address = 0x200000000ULL; address < 0x200000000ULL + 16 * 1000000; address += 16) {
+    set.insert(address);
+  }
+  XCTAssertEqual(set.count(), 1000000);
+  XCTAssertLessThan(set.memoryUsage(), 2 * set.count());
+}
+
+- (void)testThatMemoryLimitIsNeverExceeded
+{
+  const size_t memoryLimit = 64 * 1024;
+  VisitedAddressSet set(memoryLimit);
+  std::mt19937_64 random(3);
+
+  size_t overLimitCount = 0;
+  for (int i = 0; i < 100000; ++i) {
+    size_t address = (random() % (1ULL << 36)) & ~(size_t)15;
+    if (set.insert(address) == VisitedAddressSet::InsertResult::OverMemoryLimit) {
+      overLimitCount++;
+      XCTAssertFalse(set.contains(address));
+    }
+    XCTAssertLessThanOrEqual(set.memoryUsage(), memoryLimit);
+  }
+  XCTAssertGreaterThan(overLimitCount, 0);
+  XCTAssertGreaterThan(set.count(), 0);
+}
+
+- (void)testPerformanceOfInsertingHeapLikeAddresses
+{
+  std::vector<size_t> addresses = _RCDHeapLikeAddresses(1000000, 42);
+  [self measureBlock:^{
+    VisitedAddressSet set;
+    for (size_t address: addresses) {
+      set.insert(address);
+    }
+  }];
+}
+
+- (void)testPerformanceOfLookingUpHeapLikeAddresses
+{
+  std::vector<size_t> addresses = _RCDHeapLikeAddresses(1000000, 42);
+  VisitedAddressSet set;
+  for (size_t address: addresses) {
+    set.insert(address);
+  }
+  [self measureBlock:^{
+    size_t found = 0;
+    for (size_t address: addresses) {
+      found += set.contains(address + 16);
+    }
+    XCTAssertLessThanOrEqual(found, addresses.size());
+  }];
+}
+
+@end
@@ -9,6 +9,7 @@
 #include "rcd_fishhook.h"
 
 #include <dlfcn.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,25 +20,8 @@
 #include <mach/vm_region.h>
 #include <mach-o/dyld.h>
 #include <mach-o/loader.h>
-#include <mach-o/nlist.h>
-
-#ifdef __LP64__
-typedef struct mach_header_64 mach_header_t;
-typedef struct segment_command_64 segment_command_t;
-typedef struct section_64 section_t;
-typedef struct nlist_64 nlist_t;
-#define LC_SEGMENT_ARCH_DEPENDENT LC_SEGMENT_64
-#else
-typedef struct mach_header mach_header_t;
-typedef struct segment_command segment_command_t;
-typedef struct section section_t;
-typedef struct nlist nlist_t;
-#define LC_SEGMENT_ARCH_DEPENDENT LC_SEGMENT
-#endif
 
-#ifndef SEG_DATA_CONST
-#define SEG_DATA_CONST  "__DATA_CONST"
-#endif
+#include "rcd_fishhook_macho.h"
 
 struct rcd_rebindings_entry {
   struct rcd_rebinding *rebindings;
@@ -47,6 +31,11 @@ struct rcd_rebindings_entry {
 
 static struct rcd_rebindings_entry *_rebindings_head;
 
+// All rebindings from the list above, indexed by name. Guarded by _rebindings_index_lock, which is never held while
+// calling into dyld, so it can't deadlock with dyld invoking our image callback.
+static struct rcd_symbol_index _rebindings_index;
+static pthread_rwlock_t _rebindings_index_lock = PTHREAD_RWLOCK_INITIALIZER;
+
 static int rcd_prepend_rebindings(struct rcd_rebindings_entry **rebindings_head,
                               struct rcd_rebinding rebindings[],
                               size_t nel) {
@@ -66,6 +55,27 @@ static int rcd_prepend_rebindings(struct rcd_rebindings_entry **rebindings_head,
   return 0;
 }
 
+/*
+ * Indexes rebindings by name (without the leading underscore every C symbol
+ * has). Newer batches come first in the list, so they take precedence.
+ */
+static int rcd_build_rebindings_index(struct rcd_symbol_index *index,
+                                      struct rcd_rebindings_entry *rebindings_head) {
+  size_t count = 0;
+  for (struct rcd_rebindings_entry *cur = rebindings_head; cur; cur = cur->next) {
+    count += cur->rebindings_nel;
+  }
+  if (rcd_symbol_index_init(index, count) < 0) {
+    return -1;
+  }
+  for (struct rcd_rebindings_entry *cur = rebindings_head; cur; cur = cur->next) {
+    for (size_t j = 0; j < cur->rebindings_nel; j++) {
+      rcd_symbol_index_insert(index, cur->rebindings[j].name, &cur->rebindings[j]);
+    }
+  }
+  return 0;
+}
+
 static vm_prot_t get_protection(void *sectionStart) {
   mach_port_t task = mach_task_self();
   vm_size_t size = 0;
@@ -87,45 +97,39 @@ static vm_prot_t get_protection(void *sectionStart) {
     return VM_PROT_READ;
   }
 }
-static void rcd_perform_rebinding_with_section(struct rcd_rebindings_entry *rebindings,
-                                           section_t *section,
+
+static void rcd_perform_rebinding_with_section(const struct rcd_symbol_index *rebindings,
+                                           const struct rcd_macho_image_info *image_info,
+                                           const struct rcd_macho_pointer_section *section,
                                            intptr_t slide,
-                                           nlist_t *symtab,
-                                           char *strtab,
-                                           uint32_t *indirect_symtab) {
-  const bool isDataConst = strcmp(section->segname, "__DATA_CONST") == 0;
-  uint32_t *indirect_symbol_indices = indirect_symtab + section->reserved1;
+                                           const void *symtab,
+                                           const char *strtab,
+                                           const uint32_t *indirect_symtab) {
+  const bool isDataConst = strncmp(section->segname, "__DATA_CONST", sizeof(section->segname)) == 0;
   void **indirect_symbol_bindings = (void **)((uintptr_t)slide + section->addr);
   vm_prot_t oldProtection = VM_PROT_READ;
   if (isDataConst) {
-    oldProtection = get_protection(rebindings);
+    oldProtection = get_protection(indirect_symbol_bindings);
     mprotect(indirect_symbol_bindings, section->size, PROT_READ | PROT_WRITE);
   }
   for (uint i = 0; i < section->size / sizeof(void *); i++) {
-    uint32_t symtab_index = indirect_symbol_indices[i];
-    if (symtab_index == INDIRECT_SYMBOL_ABS || symtab_index == INDIRECT_SYMBOL_LOCAL ||
-        symtab_index == (INDIRECT_SYMBOL_LOCAL   | INDIRECT_SYMBOL_ABS)) {
+    const char *symbol_name = rcd_macho_indirect_symbol_name(image_info, symtab, strtab, indirect_symtab,
+                                                             section->indirect_symbol_index + i);
+    if (!symbol_name || !symbol_name[0] || !symbol_name[1]) {
       continue;
     }
-    uint32_t strtab_offset = symtab[symtab_index].n_un.n_strx;
-    char *symbol_name = strtab + strtab_offset;
-    bool symbol_name_longer_than_1 = symbol_name[0] && symbol_name[1];
-    struct rcd_rebindings_entry *cur = rebindings;
-    while (cur) {
-      for (uint j = 0; j < cur->rebindings_nel; j++) {
-        if (symbol_name_longer_than_1 &&
-            strcmp(&symbol_name[1], cur->rebindings[j].name) == 0) {
-          if (cur->rebindings[j].replaced != NULL &&
-              indirect_symbol_bindings[i] != cur->rebindings[j].replacement) {
-            *(cur->rebindings[j].replaced) = indirect_symbol_bindings[i];
-          }
-          indirect_symbol_bindings[i] = cur->rebindings[j].replacement;
-          goto symbol_loop;
-        }
-      }
-      cur = cur->next;
+    struct rcd_rebinding *rebinding =
+      (struct rcd_rebinding *)rcd_symbol_index_lookup(rebindings, &symbol_name[1],
+                                                      rcd_macho_symbol_hash(&symbol_name[1]));
+    if (!rebinding) {
+      continue;
     }
-  symbol_loop:;
+    if (rebinding->replaced != NULL &&
+        indirect_symbol_bindings[i] != rebinding->replacement) {
+      // Images loaded on different threads are rebound concurrently, they all store the same original implementation
+      __atomic_store_n(rebinding->replaced, indirect_symbol_bindings[i], __ATOMIC_RELAXED);
+    }
+    indirect_symbol_bindings[i] = rebinding->replacement;
   }
   if (isDataConst) {
     int protection = 0;
@@ -142,71 +146,44 @@ static void rcd_perform_rebinding_with_section(struct rcd_rebindings_entry *rebi
   }
 }
 
-static void rebind_symbols_for_image(struct rcd_rebindings_entry *rebindings,
-                                     const struct mach_header *header,
-                                     intptr_t slide) {
-  Dl_info info;
-  if (dladdr(header, &info) == 0) {
+static void rebind_symbols_for_image_with_index(const struct rcd_symbol_index *rebindings,
+                                                const struct mach_header *header,
+                                                intptr_t slide) {
+  if (!rebindings->count) {
     return;
   }
 
-  segment_command_t *cur_seg_cmd;
-  segment_command_t *linkedit_segment = NULL;
-  struct symtab_command* symtab_cmd = NULL;
-  struct dysymtab_command* dysymtab_cmd = NULL;
-
-  uintptr_t cur = (uintptr_t)header + sizeof(mach_header_t);
-  for (uint i = 0; i < header->ncmds; i++, cur += cur_seg_cmd->cmdsize) {
-    cur_seg_cmd = (segment_command_t *)cur;
-    if (cur_seg_cmd->cmd == LC_SEGMENT_ARCH_DEPENDENT) {
-      if (strcmp(cur_seg_cmd->segname, SEG_LINKEDIT) == 0) {
-        linkedit_segment = cur_seg_cmd;
-      }
-    } else if (cur_seg_cmd->cmd == LC_SYMTAB) {
-      symtab_cmd = (struct symtab_command*)cur_seg_cmd;
-    } else if (cur_seg_cmd->cmd == LC_DYSYMTAB) {
-      dysymtab_cmd = (struct dysymtab_command*)cur_seg_cmd;
-    }
-  }
-
-  if (!symtab_cmd || !dysymtab_cmd || !linkedit_segment ||
-      !dysymtab_cmd->nindirectsyms) {
+  struct rcd_macho_image_info image_info;
+  if (rcd_macho_parse_image(header, 0, &image_info) != 0) {
     return;
   }
 
   // Find base symbol/string table addresses
-  uintptr_t linkedit_base = (uintptr_t)slide + linkedit_segment->vmaddr - linkedit_segment->fileoff;
-  nlist_t *symtab = (nlist_t *)(linkedit_base + symtab_cmd->symoff);
-  char *strtab = (char *)(linkedit_base + symtab_cmd->stroff);
+  uintptr_t linkedit_base = (uintptr_t)slide + image_info.linkedit_vmaddr - image_info.linkedit_fileoff;
+  const void *symtab = (const void *)(linkedit_base + image_info.symoff);
+  const char *strtab = (const char *)(linkedit_base + image_info.stroff);
 
   // Get indirect symbol table (array of uint32_t indices into symbol table)
-  uint32_t *indirect_symtab = (uint32_t *)(linkedit_base + dysymtab_cmd->indirectsymoff);
-
-  cur = (uintptr_t)header + sizeof(mach_header_t);
-  for (uint i = 0; i < header->ncmds; i++, cur += cur_seg_cmd->cmdsize) {
-    cur_seg_cmd = (segment_command_t *)cur;
-    if (cur_seg_cmd->cmd == LC_SEGMENT_ARCH_DEPENDENT) {
-      if (strcmp(cur_seg_cmd->segname, SEG_DATA) != 0 &&
-          strcmp(cur_seg_cmd->segname, SEG_DATA_CONST) != 0) {
-        continue;
-      }
-      for (uint j = 0; j < cur_seg_cmd->nsects; j++) {
-        section_t *sect =
-          (section_t *)(cur + sizeof(segment_command_t)) + j;
-        if ((sect->flags & SECTION_TYPE) == S_LAZY_SYMBOL_POINTERS) {
-          rcd_perform_rebinding_with_section(rebindings, sect, slide, symtab, strtab, indirect_symtab);
-        }
-        if ((sect->flags & SECTION_TYPE) == S_NON_LAZY_SYMBOL_POINTERS) {
-          rcd_perform_rebinding_with_section(rebindings, sect, slide, symtab, strtab, indirect_symtab);
-        }
-      }
-    }
+  const uint32_t *indirect_symtab = (const uint32_t *)(linkedit_base + image_info.indirectsymoff);
+
+  for (size_t i = 0; i < image_info.pointer_sections_count; i++) {
+    rcd_perform_rebinding_with_section(rebindings, &image_info, &image_info.pointer_sections[i],
+                                       slide, symtab, strtab, indirect_symtab);
   }
+  rcd_macho_image_info_destroy(&image_info);
 }
 
 static void _rebind_symbols_for_image(const struct mach_header *header,
                                       intptr_t slide) {
-    rebind_symbols_for_image(_rebindings_head, header, slide);
+  // dladdr takes dyld lock, so it has to be called before we take ours
+  Dl_info info;
+  if (dladdr(header, &info) == 0) {
+    return;
+  }
+
+  pthread_rwlock_rdlock(&_rebindings_index_lock);
+  rebind_symbols_for_image_with_index(&_rebindings_index, header, slide);
+  pthread_rwlock_unlock(&_rebindings_index_lock);
 }
 
 int rcd_rebind_symbols_image(void *header,
@@ -215,7 +192,14 @@ int rcd_rebind_symbols_image(void *header,
                          size_t rebindings_nel) {
     struct rcd_rebindings_entry *rebindings_head = NULL;
     int retval = rcd_prepend_rebindings(&rebindings_head, rebindings, rebindings_nel);
-    rebind_symbols_for_image(rebindings_head, (const struct mach_header *) header, slide);
+    struct rcd_symbol_index index;
+    if (retval == 0 && rcd_build_rebindings_index(&index, rebindings_head) == 0) {
+      Dl_info info;
+      if (dladdr(header, &info) != 0) {
+        rebind_symbols_for_image_with_index(&index, (const struct mach_header *) header, slide);
+      }
+      rcd_symbol_index_destroy(&index);
+    }
     if (rebindings_head) {
       free(rebindings_head->rebindings);
     }
@@ -228,6 +212,17 @@ int rcd_rebind_symbols(struct rcd_rebinding rebindings[], size_t rebindings_nel)
   if (retval < 0) {
     return retval;
   }
+
+  struct rcd_symbol_index index;
+  if (rcd_build_rebindings_index(&index, _rebindings_head) < 0) {
+    return -1;
+  }
+  pthread_rwlock_wrlock(&_rebindings_index_lock);
+  struct rcd_symbol_index old_index = _rebindings_index;
+  _rebindings_index = index;
+  pthread_rwlock_unlock(&_rebindings_index_lock);
+  rcd_symbol_index_destroy(&old_index);
+
   // If this was the first call, register callback for image additions (which is also invoked for
   // existing images, otherwise, just run on existing images
   if (!_rebindings_head->next) {
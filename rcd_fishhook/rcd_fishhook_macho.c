@@ -0,0 +1,386 @@
+/**
+* Copyright (c) 2016-present, Facebook, Inc.
+* All rights reserved.
+*
+* This source code is licensed under the BSD-style license found in the
+* LICENSE file in the root directory of this source tree.
+*/
+
+#include "rcd_fishhook_macho.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Subset of <mach-o/loader.h> and <mach-o/nlist.h>, so this file builds everywhere
+#define RCD_MH_MAGIC 0xfeedfaceu
+#define RCD_MH_MAGIC_64 0xfeedfacfu
+#define RCD_LC_SEGMENT 0x1u
+#define RCD_LC_SYMTAB 0x2u
+#define RCD_LC_DYSYMTAB 0xbu
+#define RCD_LC_SEGMENT_64 0x19u
+#define RCD_SECTION_TYPE 0x000000ffu
+#define RCD_S_NON_LAZY_SYMBOL_POINTERS 0x6u
+#define RCD_S_LAZY_SYMBOL_POINTERS 0x7u
+#define RCD_INDIRECT_SYMBOL_LOCAL 0x80000000u
+#define RCD_INDIRECT_SYMBOL_ABS 0x40000000u
+
+struct rcd_mach_header {
+  uint32_t magic;
+  int32_t cputype;
+  int32_t cpusubtype;
+  uint32_t filetype;
+  uint32_t ncmds;
+  uint32_t sizeofcmds;
+  uint32_t flags;
+};
+
+struct rcd_load_command {
+  uint32_t cmd;
+  uint32_t cmdsize;
+};
+
+struct rcd_segment_command {
+  uint32_t cmd;
+  uint32_t cmdsize;
+  char segname[16];
+  uint32_t vmaddr;
+  uint32_t vmsize;
+  uint32_t fileoff;
+  uint32_t filesize;
+  int32_t maxprot;
+  int32_t initprot;
+  uint32_t nsects;
+  uint32_t flags;
+};
+
+struct rcd_segment_command_64 {
+  uint32_t cmd;
+  uint32_t cmdsize;
+  char segname[16];
+  uint64_t vmaddr;
+  uint64_t vmsize;
+  uint64_t fileoff;
+  uint64_t filesize;
+  int32_t maxprot;
+  int32_t initprot;
+  uint32_t nsects;
+  uint32_t flags;
+};
+
+struct rcd_section {
+  char sectname[16];
+  char segname[16];
+  uint32_t addr;
+  uint32_t size;
+  uint32_t offset;
+  uint32_t align;
+  uint32_t reloff;
+  uint32_t nreloc;
+  uint32_t flags;
+  uint32_t reserved1;
+  uint32_t reserved2;
+};
+
+struct rcd_section_64 {
+  char sectname[16];
+  char segname[16];
+  uint64_t addr;
+  uint64_t size;
+  uint32_t offset;
+  uint32_t align;
+  uint32_t reloff;
+  uint32_t nreloc;
+  uint32_t flags;
+  uint32_t reserved1;
+  uint32_t reserved2;
+  uint32_t reserved3;
+};
+
+struct rcd_symtab_command {
+  uint32_t cmd;
+  uint32_t cmdsize;
+  uint32_t symoff;
+  uint32_t nsyms;
+  uint32_t stroff;
+  uint32_t strsize;
+};
+
+struct rcd_dysymtab_command {
+  uint32_t cmd;
+  uint32_t cmdsize;
+  uint32_t ilocalsym;
+  uint32_t nlocalsym;
+  uint32_t iextdefsym;
+  uint32_t nextdefsym;
+  uint32_t iundefsym;
+  uint32_t nundefsym;
+  uint32_t tocoff;
+  uint32_t ntoc;
+  uint32_t modtaboff;
+  uint32_t nmodtab;
+  uint32_t extrefsymoff;
+  uint32_t nextrefsyms;
+  uint32_t indirectsymoff;
+  uint32_t nindirectsyms;
+  uint32_t extreloff;
+  uint32_t nextrel;
+  uint32_t locreloff;
+  uint32_t nlocrel;
+};
+
+static bool rcd_macho_segment_is_data(const char segname[16]) {
+  return strncmp(segname, "__DATA", 16) == 0 || strncmp(segname, "__DATA_CONST", 16) == 0;
+}
+
+static int rcd_macho_add_pointer_section(struct rcd_macho_image_info *info,
+                                         const char segname[16],
+                                         uint64_t addr,
+                                         uint64_t size,
+                                         uint64_t offset,
+                                         uint32_t flags,
+                                         uint32_t reserved1) {
+  uint32_t type = flags & RCD_SECTION_TYPE;
+  if (type != RCD_S_LAZY_SYMBOL_POINTERS && type != RCD_S_NON_LAZY_SYMBOL_POINTERS) {
+    return 0;
+  }
+  if (info->pointer_sections_count == info->pointer_sections_capacity) {
+    size_t capacity = info->pointer_sections_capacity ? info->pointer_sections_capacity * 2 : 8;
+    struct rcd_macho_pointer_section *sections =
+      (struct rcd_macho_pointer_section *)realloc(info->pointer_sections, capacity * sizeof(*sections));
+    if (!sections) {
+      return -1;
+    }
+    info->pointer_sections = sections;
+    info->pointer_sections_capacity = capacity;
+  }
+  struct rcd_macho_pointer_section *section = &info->pointer_sections[info->pointer_sections_count++];
+  memcpy(section->segname, segname, sizeof(section->segname));
+  section->addr = addr;
+  section->size = size;
+  section->offset = offset;
+  section->indirect_symbol_index = reserved1;
+  return 0;
+}
+
+void rcd_macho_image_info_destroy(struct rcd_macho_image_info *info) {
+  free(info->pointer_sections);
+  info->pointer_sections = NULL;
+  info->pointer_sections_count = 0;
+  info->pointer_sections_capacity = 0;
+}
+
+static int rcd_macho_parse_load_commands(const void *header, size_t image_size, struct rcd_macho_image_info *info) {
+  const bool checked = image_size != 0;
+  const uint8_t *base = (const uint8_t *)header;
+
+  struct rcd_mach_header mach_header;
+  if (checked && image_size < sizeof(mach_header)) {
+    return -1;
+  }
+  memcpy(&mach_header, base, sizeof(mach_header));
+  if (mach_header.magic == RCD_MH_MAGIC_64) {
+    info->is_64 = true;
+    info->pointer_size = 8;
+  } else if (mach_header.magic == RCD_MH_MAGIC) {
+    info->is_64 = false;
+    info->pointer_size = 4;
+  } else {
+    return -1;
+  }
+
+  size_t offset = info->is_64 ? sizeof(mach_header) + sizeof(uint32_t) : sizeof(mach_header);
+  bool found_linkedit = false, found_symtab = false, found_dysymtab = false;
+
+  for (uint32_t i = 0; i < mach_header.ncmds; i++) {
+    struct rcd_load_command load_command;
+    if (checked && (offset > image_size || image_size - offset < sizeof(load_command))) {
+      return -1;
+    }
+    memcpy(&load_command, base + offset, sizeof(load_command));
+    if (load_command.cmdsize < sizeof(load_command) ||
+        (checked && image_size - offset < load_command.cmdsize)) {
+      return -1;
+    }
+    const uint8_t *command = base + offset;
+
+    if (load_command.cmd == RCD_LC_SEGMENT_64 && info->is_64) {
+      struct rcd_segment_command_64 segment;
+      if (load_command.cmdsize < sizeof(segment)) {
+        return -1;
+      }
+      memcpy(&segment, command, sizeof(segment));
+      if (strncmp(segment.segname, "__LINKEDIT", 16) == 0) {
+        info->linkedit_vmaddr = segment.vmaddr;
+        info->linkedit_fileoff = segment.fileoff;
+        found_linkedit = true;
+      } else if (rcd_macho_segment_is_data(segment.segname)) {
+        if ((load_command.cmdsize - sizeof(segment)) / sizeof(struct rcd_section_64) < segment.nsects) {
+          return -1;
+        }
+        for (uint32_t j = 0; j < segment.nsects; j++) {
+          struct rcd_section_64 section;
+          memcpy(&section, command + sizeof(segment) + j * sizeof(section), sizeof(section));
+          if (rcd_macho_add_pointer_section(info, segment.segname, section.addr, section.size,
+                                            section.offset, section.flags, section.reserved1) != 0) {
+            return -1;
+          }
+        }
+      }
+    } else if (load_command.cmd == RCD_LC_SEGMENT && !info->is_64) {
+      struct rcd_segment_command segment;
+      if (load_command.cmdsize < sizeof(segment)) {
+        return -1;
+      }
+      memcpy(&segment, command, sizeof(segment));
+      if (strncmp(segment.segname, "__LINKEDIT", 16) == 0) {
+        info->linkedit_vmaddr = segment.vmaddr;
+        info->linkedit_fileoff = segment.fileoff;
+        found_linkedit = true;
+      } else if (rcd_macho_segment_is_data(segment.segname)) {
+        if ((load_command.cmdsize - sizeof(segment)) / sizeof(struct rcd_section) < segment.nsects) {
+          return -1;
+        }
+        for (uint32_t j = 0; j < segment.nsects; j++) {
+          struct rcd_section section;
+          memcpy(&section, command + sizeof(segment) + j * sizeof(section), sizeof(section));
+          if (rcd_macho_add_pointer_section(info, segment.segname, section.addr, section.size,
+                                            section.offset, section.flags, section.reserved1) != 0) {
+            return -1;
+          }
+        }
+      }
+    } else if (load_command.cmd == RCD_LC_SYMTAB) {
+      struct rcd_symtab_command symtab;
+      if (load_command.cmdsize < sizeof(symtab)) {
+        return -1;
+      }
+      memcpy(&symtab, command, sizeof(symtab));
+      info->symoff = symtab.symoff;
+      info->nsyms = symtab.nsyms;
+      info->stroff = symtab.stroff;
+      info->strsize = symtab.strsize;
+      found_symtab = true;
+    } else if (load_command.cmd == RCD_LC_DYSYMTAB) {
+      struct rcd_dysymtab_command dysymtab;
+      if (load_command.cmdsize < sizeof(dysymtab)) {
+        return -1;
+      }
+      memcpy(&dysymtab, command, sizeof(dysymtab));
+      info->indirectsymoff = dysymtab.indirectsymoff;
+      info->nindirectsyms = dysymtab.nindirectsyms;
+      found_dysymtab = true;
+    }
+
+    offset += load_command.cmdsize;
+  }
+
+  if (!found_linkedit || !found_symtab || !found_dysymtab || !info->nindirectsyms) {
+    return -1;
+  }
+
+  if (checked) {
+    const uint64_t nlist_size = info->is_64 ? 16 : 12;
+    if ((uint64_t)info->symoff + (uint64_t)info->nsyms * nlist_size > image_size ||
+        (uint64_t)info->stroff + info->strsize > image_size ||
+        (uint64_t)info->indirectsymoff + (uint64_t)info->nindirectsyms * sizeof(uint32_t) > image_size) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int rcd_macho_parse_image(const void *header, size_t image_size, struct rcd_macho_image_info *info) {
+  memset(info, 0, sizeof(*info));
+  if (rcd_macho_parse_load_commands(header, image_size, info) != 0) {
+    rcd_macho_image_info_destroy(info);
+    return -1;
+  }
+  return 0;
+}
+
+const char *rcd_macho_indirect_symbol_name(const struct rcd_macho_image_info *info,
+                                           const void *symtab,
+                                           const char *strtab,
+                                           const uint32_t *indirect_symtab,
+                                           uint32_t indirect_index) {
+  if (indirect_index >= info->nindirectsyms) {
+    return NULL;
+  }
+  uint32_t symtab_index = indirect_symtab[indirect_index];
+  if (symtab_index & (RCD_INDIRECT_SYMBOL_LOCAL | RCD_INDIRECT_SYMBOL_ABS)) {
+    return NULL;
+  }
+  if (symtab_index >= info->nsyms) {
+    return NULL;
+  }
+  // n_strx is the first field of both nlist and nlist_64
+  uint32_t strtab_offset;
+  memcpy(&strtab_offset,
+         (const uint8_t *)symtab + (size_t)symtab_index * (info->is_64 ? 16 : 12),
+         sizeof(strtab_offset));
+  if (strtab_offset >= info->strsize) {
+    return NULL;
+  }
+  return strtab + strtab_offset;
+}
+
+int rcd_symbol_index_init(struct rcd_symbol_index *index, size_t count) {
+  size_t capacity = 16;
+  while (capacity < count * 2) {
+    capacity <<= 1;
+  }
+  index->entries = (struct rcd_symbol_index_entry *)calloc(capacity, sizeof(struct rcd_symbol_index_entry));
+  if (!index->entries) {
+    index->capacity = 0;
+    index->count = 0;
+    return -1;
+  }
+  index->capacity = capacity;
+  index->count = 0;
+  return 0;
+}
+
+void rcd_symbol_index_destroy(struct rcd_symbol_index *index) {
+  free(index->entries);
+  index->entries = NULL;
+  index->capacity = 0;
+  index->count = 0;
+}
+
+int rcd_symbol_index_insert(struct rcd_symbol_index *index, const char *name, void *value) {
+  if (!index->entries || (index->count + 1) * 2 > index->capacity) {
+    return 0;
+  }
+  uint32_t hash = rcd_macho_symbol_hash(name);
+  size_t mask = index->capacity - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    struct rcd_symbol_index_entry *entry = &index->entries[slot];
+    if (!entry->name) {
+      entry->hash = hash;
+      entry->name = name;
+      entry->value = value;
+      index->count++;
+      return 1;
+    }
+    if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+      return 0;
+    }
+  }
+}
+
+void *rcd_symbol_index_lookup(const struct rcd_symbol_index *index, const char *name, uint32_t hash) {
+  if (!index->count) {
+    return NULL;
+  }
+  size_t mask = index->capacity - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    const struct rcd_symbol_index_entry *entry = &index->entries[slot];
+    if (!entry->name) {
+      return NULL;
+    }
+    if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+      return entry->value;
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/**
+* Copyright (c) 2016-present, Facebook, Inc.
+* All rights reserved.
+*
+* This source code is licensed under the BSD-style license found in the
+* LICENSE file in the root directory of this source tree.
+*/
+
+#ifndef rcd_fishhook_macho_h
+#define rcd_fishhook_macho_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif //__cplusplus
+
+/*
+ * Mach-O parsing and rebinding lookup used by rcd_fishhook. Images are only
+ * read through the pointer they are passed by, so the same code parses images
+ * loaded by dyld and Mach-O files read from disk.
+ */
+
+/*
+ * Section holding pointers to external symbols (lazy or non lazy symbol
+ * pointers), with one entry in the indirect symbol table per pointer.
+ */
+struct rcd_macho_pointer_section {
+  char segname[16];
+  uint64_t addr;
+  uint64_t size;
+  uint64_t offset;
+  uint32_t indirect_symbol_index;
+};
+
+struct rcd_macho_image_info {
+  bool is_64;
+  uint32_t pointer_size;
+
+  // Address where __LINKEDIT is mapped, minus its file offset. Offsets below are file offsets.
+  uint64_t linkedit_vmaddr;
+  uint64_t linkedit_fileoff;
+
+  uint32_t symoff;
+  uint32_t nsyms;
+  uint32_t stroff;
+  uint32_t strsize;
+  uint32_t indirectsymoff;
+  uint32_t nindirectsyms;
+
+  // Grows with the image, there is no limit on the number of sections
+  size_t pointer_sections_count;
+  size_t pointer_sections_capacity;
+  struct rcd_macho_pointer_section *pointer_sections;
+};
+
+/*
+ * Parses load commands of an image. When image_size is not 0, header is
+ * treated as untrusted (for example a file read from disk) and every load
+ * command is bounds checked. Returns 0 on success, -1 if the image is not a
+ * Mach-O image, has nothing to rebind, or we ran out of memory. On success,
+ * info has to be destroyed with rcd_macho_image_info_destroy.
+ */
+int rcd_macho_parse_image(const void *header, size_t image_size, struct rcd_macho_image_info *info);
+void rcd_macho_image_info_destroy(struct rcd_macho_image_info *info);
+
+/*
+ * Returns the name of the symbol the indirect symbol table entry refers to,
+ * or NULL for local and absolute entries. Bounds are checked against info.
+ */
+const char *rcd_macho_indirect_symbol_name(const struct rcd_macho_image_info *info,
+                                           const void *symtab,
+                                           const char *strtab,
+                                           const uint32_t *indirect_symtab,
+                                           uint32_t indirect_index);
+
+/*
+ * FNV-1a hash of a symbol name, used to index rebindings.
+ */
+static inline uint32_t rcd_macho_symbol_hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  for (const unsigned char *c = (const unsigned char *)name; *c; c++) {
+    hash = (hash ^ *c) * 16777619u;
+  }
+  return hash;
+}
+
+/*
+ * Open addressing hash table from symbol name to an opaque value (a rebinding
+ * for rcd_fishhook). Capacity is always a power of two, at least twice the
+ * number of entries.
+ */
+struct rcd_symbol_index_entry {
+  uint32_t hash;
+  const char *name;
+  void *value;
+};
+
+struct rcd_symbol_index {
+  struct rcd_symbol_index_entry *entries;
+  size_t capacity;
+  size_t count;
+};
+
+/*
+ * Creates an index with room for given number of entries. Returns -1 if out
+ * of memory.
+ */
+int rcd_symbol_index_init(struct rcd_symbol_index *index, size_t count);
+void rcd_symbol_index_destroy(struct rcd_symbol_index *index);
+
+/*
+ * Inserts an entry unless one with the same name is already there. The name
+ * is not copied. Returns 1 if inserted, 0 if the name was already present.
+ */
+int rcd_symbol_index_insert(struct rcd_symbol_index *index, const char *name, void *value);
+
+void *rcd_symbol_index_lookup(const struct rcd_symbol_index *index, const char *name, uint32_t hash);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif //rcd_fishhook_macho_h
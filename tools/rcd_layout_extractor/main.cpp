@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ Reads strong layouts of Objective-C classes from an app binary and writes them as a table that
+ +[FBClassLayoutPrewarmer loadPrecompiledLayoutsFromData:] loads at runtime. Runs on any platform:
+
+   c++ -std=c++14 -O2 -I FBRetainCycleDetector/Layout/Classes/Precompiled \
+     tools/rcd_layout_extractor/main.cpp -o rcd_layout_extractor
+   rcd_layout_extractor [--arch arm64|x86_64] <binary> <output>
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "FBMachOImage.h"
+#include "FBObjCLayoutExtractor.h"
+#include "FBPrecompiledLayoutTable.h"
+
+using namespace FB::RetainCycleDetector;
+
+static int usage(const char *program) {
+  fprintf(stderr, "usage: %s [--arch arm64|x86_64] <binary> <output>\n", program);
+  return 64;
+}
+
+int main(int argc, const char *argv[]) {
+  uint32_t cpuType = kMachOCPUTypeARM64;
+  std::vector<const char *> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--arch") == 0 && i + 1 < argc) {
+      const char *arch = argv[++i];
+      if (strcmp(arch, "arm64") == 0) {
+        cpuType = kMachOCPUTypeARM64;
+      } else if (strcmp(arch, "x86_64") == 0) {
+        cpuType = kMachOCPUTypeX86_64;
+      } else {
+        return usage(argv[0]);
+      }
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.size() != 2) {
+    return usage(argv[0]);
+  }
+
+  std::ifstream input(paths[0], std::ios::binary);
+  if (!input) {
+    fprintf(stderr, "%s: can't read %s\n", argv[0], paths[0]);
+    return 1;
+  }
+  std::vector<uint8_t> binary((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  MachOImage image;
+  std::string error;
+  if (!image.parse(binary.data(), binary.size(), cpuType, error)) {
+    fprintf(stderr, "%s: %s: %s\n", argv[0], paths[0], error.c_str());
+    return 1;
+  }
+
+  std::vector<PrecompiledClassLayout> layouts;
+  const size_t skippedCount = extractObjCClassLayouts(image, layouts);
+
+  PrecompiledLayoutWriter writer(ObjCLayoutExtraction::kPointerSize);
+  size_t slotCount = 0;
+  for (const auto &layout: layouts) {
+    writer.addClass(layout);
+    slotCount += layout.slots.size();
+  }
+  const std::vector<uint8_t> table = writer.finish();
+
+  std::ofstream output(paths[1], std::ios::binary | std::ios::trunc);
+  if (!output.write((const char *)table.data(), table.size())) {
+    fprintf(stderr, "%s: can't write %s\n", argv[0], paths[1]);
+    return 1;
+  }
+  fprintf(stderr, "%zu classes, %zu strong slots, %zu classes skipped, %zu bytes\n",
+          layouts.size(), slotCount, skippedCount, table.size());
+  return 0;
+}
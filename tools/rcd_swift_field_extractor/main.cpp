@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ Classifies ownership of fields of Swift classes and of closure captures from reflection metadata of an app binary,
+ and writes them as a table that +[FBClassLayoutPrewarmer loadPrecompiledSwiftFieldsFromData:] loads at runtime. Run
+ it before reflection metadata is stripped. Runs on any platform:
+
+   c++ -std=c++14 -O2 -I FBRetainCycleDetector/Layout/Classes/Precompiled \
+     tools/rcd_swift_field_extractor/main.cpp -o rcd_swift_field_extractor
+   rcd_swift_field_extractor [--arch arm64|x86_64] <binary> <output>
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "FBMachOImage.h"
+#include "FBPrecompiledSwiftFieldTable.h"
+#include "FBSwiftFieldExtractor.h"
+
+using namespace FB::RetainCycleDetector;
+
+static int usage(const char *program) {
+  fprintf(stderr, "usage: %s [--arch arm64|x86_64] <binary> <output>\n", program);
+  return 64;
+}
+
+int main(int argc, const char *argv[]) {
+  uint32_t cpuType = kMachOCPUTypeARM64;
+  std::vector<const char *> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--arch") == 0 && i + 1 < argc) {
+      const char *arch = argv[++i];
+      if (strcmp(arch, "arm64") == 0) {
+        cpuType = kMachOCPUTypeARM64;
+      } else if (strcmp(arch, "x86_64") == 0) {
+        cpuType = kMachOCPUTypeX86_64;
+      } else {
+        return usage(argv[0]);
+      }
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.size() != 2) {
+    return usage(argv[0]);
+  }
+
+  std::ifstream input(paths[0], std::ios::binary);
+  if (!input) {
+    fprintf(stderr, "%s: can't read %s\n", argv[0], paths[0]);
+    return 1;
+  }
+  std::vector<uint8_t> binary((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  MachOImage image;
+  std::string error;
+  uint8_t uuid[16];
+  if (!image.parse(binary.data(), binary.size(), cpuType, error)) {
+    fprintf(stderr, "%s: %s: %s\n", argv[0], paths[0], error.c_str());
+    return 1;
+  }
+  // Tables are matched to loaded images by UUID
+  if (!image.getUUID(uuid)) {
+    fprintf(stderr, "%s: %s: Binary has no UUID\n", argv[0], paths[0]);
+    return 1;
+  }
+  if (!image.findSection(nullptr, "__swift5_fieldmd")) {
+    fprintf(stderr, "%s: %s: Binary has no reflection metadata\n", argv[0], paths[0]);
+    return 1;
+  }
+
+  std::vector<PrecompiledSwiftType> types;
+  std::vector<PrecompiledSwiftCaptures> captures;
+  extractSwiftFields(image, types, captures);
+
+  PrecompiledSwiftFieldWriter writer(uuid);
+  size_t fieldCount = 0, unresolvedTypeCount = 0;
+  for (const auto &type: types) {
+    writer.addType(type);
+    fieldCount += type.fields.size();
+    if (type.flags & kPrecompiledSwiftTypeHasUnresolvedFields) {
+      unresolvedTypeCount++;
+    }
+  }
+  for (const auto &capture: captures) {
+    writer.addCaptures(capture);
+  }
+  const std::vector<uint8_t> table = writer.finish();
+
+  std::ofstream output(paths[1], std::ios::binary | std::ios::trunc);
+  if (!output.write((const char *)table.data(), table.size())) {
+    fprintf(stderr, "%s: can't write %s\n", argv[0], paths[1]);
+    return 1;
+  }
+  fprintf(stderr, "%zu classes, %zu reference fields, %zu classes with unresolved fields, %zu closure contexts, %zu bytes\n",
+          types.size(), fieldCount, unresolvedTypeCount, captures.size(), table.size());
+  return 0;
+}
@@ -32,5 +32,8 @@ sed -E -i '' 's/(rebind_symbols(_image)?|prepend_rebindings|perform_rebinding_wi
 mv fishhook.h rcd_fishhook.h
 mv fishhook.c rcd_fishhook.c
 
+# Reapply local changes. rcd_fishhook_macho.* and the patch are not upstream files, so the steps above keep them.
+patch -p1 < rcd_fishhook_local.patch
+
 # Clean up.
 rm -rf "$git_fishhook"